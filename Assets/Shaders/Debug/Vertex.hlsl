@@ -3,10 +3,17 @@
 // > Create Time: 2024-12-03 18:49:03
 //
 
-struct VertexIn
+struct LineVertex
 {
-    float3 Position : POSITION;
-    float3 Color : COLOR;
+    float3 Position;
+    float3 Color;
+};
+
+struct ShapeInstance
+{
+    column_major float4x4 Transform;
+    float3 Color;
+    float Pad;
 };
 
 struct VertexOut
@@ -19,16 +26,36 @@ struct Settings
 {
     column_major float4x4 Projection;
     column_major float4x4 View;
+    int Lines;
+    int Shapes; // -1 when drawing plain lines
+    int ShapeVertices;
+    int ShapeOffset;
 };
 
 ConstantBuffer<Settings> PushConstants : register(b0);
 
-VertexOut VSMain(VertexIn Input)
+VertexOut VSMain(uint VertexID : SV_VertexID, uint InstanceID : SV_InstanceID)
 {
+    float3 position;
+    float3 color;
+    if (PushConstants.Shapes == -1) {
+        StructuredBuffer<LineVertex> lines = ResourceDescriptorHeap[PushConstants.Lines];
+        position = lines[VertexID].Position;
+        color = lines[VertexID].Color;
+    } else {
+        StructuredBuffer<ShapeInstance> shapes = ResourceDescriptorHeap[PushConstants.Shapes];
+        StructuredBuffer<float3> vertices = ResourceDescriptorHeap[PushConstants.ShapeVertices];
+
+        // Frustums are the inverse view projection, so divide by w
+        float4 world = mul(shapes[InstanceID].Transform, float4(vertices[PushConstants.ShapeOffset + VertexID], 1.0));
+        position = world.xyz / world.w;
+        color = shapes[InstanceID].Color;
+    }
+
     VertexOut Output = (VertexOut)0;
-    Output.Position = float4(Input.Position, 1.0);
+    Output.Position = float4(position, 1.0);
     Output.Position = mul(PushConstants.View, Output.Position);
     Output.Position = mul(PushConstants.Projection, Output.Position);
-    Output.Color = Input.Color;
+    Output.Color = color;
     return Output;
 }
@@ -17,6 +17,7 @@ struct FragmentIn
     float3 Normal : NORMAL;
     float4 FragPosWorld : POSITION;
     float4 FragPosView : POSITION1;
+    float Occlusion : OCCLUSION;
 };
 
 struct Settings
@@ -38,6 +39,14 @@ struct Settings
 
     // Acceleration structures
     int AccelStructure;
+
+    // Point and spot light shadows
+    int ShadowAtlasIndex;
+    int ShadowViewIndex;
+
+    // Material occlusion in R, -1 without one. BakedOcclusion turns the per-vertex one on.
+    int OcclusionIndex;
+    int BakedOcclusion;
 };
 
 struct Model
@@ -51,13 +60,17 @@ ConstantBuffer<Settings> PushConstants : register(b0);
 
 float3 GetNormal(FragmentIn Input)
 {
-    if (PushConstants.NormalIndex == -1)
-        return normalize(Input.Normal);
+#if !NORMAL_MAP
+    return normalize(Input.Normal);
+#else
 
     Texture2D NormalTexture = ResourceDescriptorHeap[PushConstants.NormalIndex];
     SamplerState Sampler = SamplerDescriptorHeap[PushConstants.SamplerIndex];
 
-    float3 tangentNormal = NormalTexture.Sample(Sampler, Input.UV.xy).rgb * 2.0 - 1.0;
+    // Cooked normal maps are BC5, rebuild Z from XY
+    float3 tangentNormal;
+    tangentNormal.xy = NormalTexture.Sample(Sampler, Input.UV.xy).rg * 2.0 - 1.0;
+    tangentNormal.z = sqrt(saturate(1.0 - dot(tangentNormal.xy, tangentNormal.xy)));
     float3 normal = normalize(Input.Normal);
 
     float3 Q1 = ddx(Input.Position.xyz);
@@ -96,6 +109,20 @@ float3 GetNormal(FragmentIn Input)
     }
 
     return normalize(result);
+#endif
+}
+
+float GetOcclusion(FragmentIn Input)
+{
+    float occlusion = PushConstants.BakedOcclusion ? Input.Occlusion : 1.0;
+    if (PushConstants.OcclusionIndex != -1) {
+        Texture2D OcclusionTexture = ResourceDescriptorHeap[PushConstants.OcclusionIndex];
+        SamplerState Sampler = SamplerDescriptorHeap[PushConstants.SamplerIndex];
+
+        // Both describe the same surface, the texture has the detail and the vertices see the rest of the model
+        occlusion = min(occlusion, OcclusionTexture.Sample(Sampler, Input.UV).r);
+    }
+    return occlusion;
 }
 
 float CalculateShadowCascade(FragmentIn input, DirectionalLight Light, int layer)
@@ -127,31 +154,29 @@ float CalculateShadowCascade(FragmentIn input, DirectionalLight Light, int layer
 
 float CalculateShadowPoint(FragmentIn input, PointLight light)
 {
-    ConstantBuffer<Camera> Cam = ResourceDescriptorHeap[PushConstants.CameraIndex];
-    SamplerState sampler = SamplerDescriptorHeap[PushConstants.ClampSamplerIndex];
-    TextureCube<float> shadowMap = ResourceDescriptorHeap[light.ShadowCubemap];
-    float3 N = GetNormal(input);
-    
-    return PCFPoint(shadowMap,
+    ConstantBuffer<ShadowViewBuffer> views = ResourceDescriptorHeap[PushConstants.ShadowViewIndex];
+    SamplerComparisonState sampler = SamplerDescriptorHeap[PushConstants.ShadowSamplerIndex];
+    Texture2D<float> shadowAtlas = ResourceDescriptorHeap[PushConstants.ShadowAtlasIndex];
+
+    int face = GetPointShadowFace(input.FragPosWorld.xyz - light.Position);
+    return PCFPoint(shadowAtlas,
                     sampler,
+                    views.Views[light.ShadowView + face],
                     input.FragPosWorld,
-                    Cam.Position,
                     light.Position,
                     1);
 }
 
 float CalculateShadowSpot(FragmentIn input, SpotLight light)
 {
-    ConstantBuffer<Camera> Cam = ResourceDescriptorHeap[PushConstants.CameraIndex];
+    ConstantBuffer<ShadowViewBuffer> views = ResourceDescriptorHeap[PushConstants.ShadowViewIndex];
     SamplerComparisonState sampler = SamplerDescriptorHeap[PushConstants.ShadowSamplerIndex];
-    Texture2D<float> shadowMap = ResourceDescriptorHeap[light.ShadowMap];
-    float3 N = GetNormal(input);
-    
-    return PCFSpot(shadowMap,
+    Texture2D<float> shadowAtlas = ResourceDescriptorHeap[PushConstants.ShadowAtlasIndex];
+
+    return PCFSpot(shadowAtlas,
                    sampler,
-                   input.FragPosWorld,
-                   light.LightView,
-                   light.LightProj);
+                   views.Views[light.ShadowView],
+                   input.FragPosWorld);
 }
 
 float3 CalculatePoint(PointLight Light, FragmentIn Input, float3 Albedo)
@@ -162,14 +187,14 @@ float3 CalculatePoint(PointLight Light, FragmentIn Input, float3 Albedo)
 
     float3 N = GetNormal(Input);
     float Distance = length(Light.Position - Input.FragPosWorld.xyz);
-    float Attenuation = 1.0 / (Distance * Distance);
+    float Attenuation = GetRangeWindow(Distance, Light.Radius) / (Distance * Distance);
 
     if (Attenuation > 0.0) {
         float3 LightDirection = normalize(Light.Position - Input.FragPosWorld.xyz);
         float NdotL = max(dot(N, LightDirection) * Light.Radius, AMBIENT);
         return (NdotL * Albedo * Attenuation * Light.Color.xyz) * shadow;
     } else {
-        return Albedo * AMBIENT;
+        return 0.0;
     }
 }
 
@@ -183,16 +208,16 @@ float3 CalculateSpot(SpotLight light, FragmentIn input, float3 Albedo)
     float distance = length(light.Position - input.FragPosWorld.xyz);
 
     // Shadow calculation
-    float shadow = CalculateShadowSpot(input, light);
+    float shadow = light.CastShadows ? CalculateShadowSpot(input, light) : 1.0;
     float theta = dot(L, normalize(-light.Direction));
     float smoothFactor = smoothstep(cos(light.OuterRadius), cos(light.Radius), theta);
-    float intensity = smoothFactor;
+    float intensity = smoothFactor * GetRangeWindow(distance, SPOT_LIGHT_RANGE);
     if (theta > cos(light.OuterRadius)) {
         float NdotL = max(dot(N, L), AMBIENT);
         return (NdotL * Albedo * intensity * light.Color.xyz) * shadow;
     } else {
-        // Return ambient lighting outside the spotlight
-        return Albedo * AMBIENT;
+        // The ambient term is added once per pixel, not per light
+        return 0.0;
     }
 }
 
@@ -237,22 +262,32 @@ FragOutput PSMain(FragmentIn Input)
     // Get texture data
     Texture2D Albedo = ResourceDescriptorHeap[PushConstants.TextureIndex];
     SamplerState Sampler = SamplerDescriptorHeap[PushConstants.SamplerIndex];
-    float4 Color = Albedo.Sample(Sampler, Input.UV) * Instance.MaterialColor;
+    float4 Color = Albedo.Sample(Sampler, Input.UV);
+#if ALPHA_TEST
+    if (Color.a < 0.5)
+        discard;
+#endif
+    Color *= Instance.MaterialColor;
     
     // Get light data
     ConstantBuffer<LightData> Lights = ResourceDescriptorHeap[PushConstants.LightIndex];
     StructuredBuffer<PointLight> PointLights = ResourceDescriptorHeap[Lights.PointLightSRV];
     StructuredBuffer<SpotLight> SpotLights = ResourceDescriptorHeap[Lights.SpotLightSRV];
+    StructuredBuffer<LightCluster> Clusters = ResourceDescriptorHeap[Lights.ClusterSRV];
+    StructuredBuffer<uint> LightIndices = ResourceDescriptorHeap[Lights.LightIndexSRV];
     
-    float3 Lo = Color.xyz * AMBIENT;
+    float3 Lo = Color.xyz * AMBIENT * GetOcclusion(Input);
     if (Lights.UseSun) {
         Lo += CalculateSun(Lights.Sun, Input, Color.xyz, layer) * 0.5;
     }
-    for (int i = 0; i < Lights.PointLightCount; i++) {
-        Lo += CalculatePoint(PointLights[i], Input, Color.xyz);
+
+    // Only the lights binned into this pixel's cluster
+    LightCluster Cluster = Clusters[GetClusterIndex(Lights, Input.Position.xy, abs(Input.FragPosView.z))];
+    for (uint i = 0; i < Cluster.PointCount; i++) {
+        Lo += CalculatePoint(PointLights[LightIndices[Cluster.Offset + i]], Input, Color.xyz);
     }
-    for (int i = 0; i < Lights.SpotLightCount; i++) {
-        Lo += CalculateSpot(SpotLights[i], Input, Color.xyz);
+    for (uint j = 0; j < Cluster.SpotCount; j++) {
+        Lo += CalculateSpot(SpotLights[LightIndices[Cluster.Offset + Cluster.PointCount + j]], Input, Color.xyz);
     }
 
     float3 N = GetNormal(Input);
@@ -10,6 +10,7 @@ struct VertexIn
     float3 Position : POSITION;
     float2 UV : TEXCOORD;
     float3 Normal : NORMAL;
+    float Occlusion : OCCLUSION;
 };
 
 struct VertexOut
@@ -19,6 +20,7 @@ struct VertexOut
     float3 Normal : NORMAL;
     float4 FragPosWorld : POSITION;
     float4 FragPosView : POSITION1;
+    float Occlusion : OCCLUSION;
 };
 
 struct Model
@@ -74,5 +76,6 @@ VertexOut VSMain(VertexIn Input)
     Output.Normal = normalize(float4(mul(transpose(Instance.InvTransform), float4(Input.Normal, 1.0))).xyz);
     Output.FragPosWorld = WorldPosition;
     Output.FragPosView = ViewPosition;
+    Output.Occlusion = Input.Occlusion;
     return Output;
 }
@@ -3,12 +3,6 @@
 // > Create Time: 2024-12-21 04:36:05
 //
 
-#include "Assets/Shaders/Lights.hlsl"
-#include "Assets/Shaders/Camera.hlsl"
-#include "Assets/Shaders/Cascade.hlsl"
-
-#define DEFERRED 1
-
 struct FragmentIn
 {
     float4 Position : SV_Position;
@@ -39,7 +33,7 @@ struct FragmentOut
 
 ConstantBuffer<Settings> PushConstants : register(b0);
 
-#if DEFERRED
+#if ALPHA_TEST
 FragmentOut PSMain(FragmentIn Input)
 {
     Texture2D Albedo = ResourceDescriptorHeap[PushConstants.TextureIndex];
@@ -57,11 +51,5 @@ FragmentOut PSMain(FragmentIn Input)
 #else
 void PSMain(FragmentIn Input)
 {
-    Texture2D Albedo = ResourceDescriptorHeap[PushConstants.TextureIndex];
-    SamplerState Sampler = SamplerDescriptorHeap[PushConstants.SamplerIndex];
-
-    float4 Color = Albedo.Sample(Sampler, Input.UV);
-    if (Color.a < 0.5)
-        discard;
 }
 #endif
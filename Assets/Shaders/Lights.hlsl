@@ -3,12 +3,18 @@
 // > Create Time: 2024-12-07 17:41:08
 //
 
+// Matches World/LightClusters.hpp
+static const uint CLUSTER_X = 16;
+static const uint CLUSTER_Y = 9;
+static const uint CLUSTER_Z = 24;
+static const float SPOT_LIGHT_RANGE = 25.0;
+
 struct SpotLight
 {
     float3 Position;
     float Radius;
     float3 Direction;
-    int ShadowMap;
+    int ShadowView;
     float3 Color;
     bool CastShadows;
     float OuterRadius;
@@ -23,7 +29,7 @@ struct PointLight
     float3 Position;
     float Radius;
     float3 Color;
-    int ShadowCubemap;
+    int ShadowView;
 
     bool CastShadows;
     int3 Pad;
@@ -46,5 +52,35 @@ struct LightData
     int SpotLightCount;
 
     int UseSun;
-    int3 Pad;
-};
\ No newline at end of file
+    int ClusterSRV;
+    int LightIndexSRV;
+    float ClusterScale;
+
+    float ClusterBias;
+    float2 ClusterTileScale;
+    float Pad;
+};
+
+// Point light indices first, then spot light indices
+struct LightCluster
+{
+    uint Offset;
+    uint PointCount;
+    uint SpotCount;
+    uint Pad;
+};
+
+uint GetClusterIndex(LightData lights, float2 pixel, float viewDepth)
+{
+    uint2 tile = min(uint2(pixel * lights.ClusterTileScale), uint2(CLUSTER_X - 1, CLUSTER_Y - 1));
+    uint slice = uint(clamp(log(viewDepth) * lights.ClusterScale + lights.ClusterBias, 0.0, CLUSTER_Z - 1));
+    return tile.x + tile.y * CLUSTER_X + slice * CLUSTER_X * CLUSTER_Y;
+}
+
+// Fades a light out before the edge of the volume it was binned with
+float GetRangeWindow(float distance, float range)
+{
+    float ratio = distance / range;
+    float window = saturate(1.0 - ratio * ratio * ratio * ratio);
+    return window * window;
+}
\ No newline at end of file
@@ -58,85 +58,98 @@ float PCFCascade(
     return shadow;
 }
 
-float PCFPoint(
-    TextureCube<float> ShadowMap,
-    SamplerState comparisonSampler,
-    float4 WorldSpacePosition,
-    float3 CameraPosition,
-    float3 LightPosition,
+// Matches Renderer/Techniques/Shadows.hpp
+static const int MAX_SHADOW_VIEWS = 512;
+
+struct ShadowAtlasView
+{
+    column_major float4x4 ViewProj;
+    // Offset in xy, scale in zw. The scale is zero when the view didn't fit in the atlas
+    float4 Rect;
+};
+
+struct ShadowViewBuffer
+{
+    ShadowAtlasView Views[MAX_SHADOW_VIEWS];
+};
+
+// +X -X +Y -Y +Z -Z, the order the faces are rendered in
+int GetPointShadowFace(float3 lightToFrag)
+{
+    float3 axis = abs(lightToFrag);
+    if (axis.x >= axis.y && axis.x >= axis.z)
+        return lightToFrag.x > 0.0 ? 0 : 1;
+    if (axis.y >= axis.z)
+        return lightToFrag.y > 0.0 ? 2 : 3;
+    return lightToFrag.z > 0.0 ? 4 : 5;
+}
+
+float SampleShadowAtlas(
+    Texture2D<float> ShadowAtlas,
+    SamplerComparisonState comparisonSampler,
+    ShadowAtlasView view,
+    float2 uv,
+    float depth,
     int kernelSize)
 {
-    float3 fragToLight = WorldSpacePosition.xyz - LightPosition;
-    fragToLight.y = -fragToLight.y;
+    uint atlasWidth, atlasHeight;
+    ShadowAtlas.GetDimensions(atlasWidth, atlasHeight);
+    float2 texelSize = 1.0 / float2(atlasWidth, atlasHeight);
 
-    float currentDepth = length(fragToLight);
+    // Samples stay inside the tile, the neighbours belong to other lights
+    float2 tileMin = view.Rect.xy + texelSize * 0.5;
+    float2 tileMax = view.Rect.xy + view.Rect.zw - texelSize * 0.5;
+    float2 atlasUV = view.Rect.xy + uv * view.Rect.zw;
 
     float shadow = 0.0;
-    float bias = 0.05;
-
-    // Define an offset array for 2x2 sampling (cheap PCF)
-    float3 offset[4] = {
-        float3( 0.5,  0.5, 0.0),
-        float3(-0.5,  0.5, 0.0),
-        float3( 0.5, -0.5, 0.0),
-        float3(-0.5, -0.5, 0.0)
-    };
-
-    // Sample multiple points within the kernel
-    for (int i = 0; i < 4; ++i)
-    {
-        float3 sampleDirection = fragToLight + offset[i] * 0.01; // Small jitter for sampling
-        float closestDepth = ShadowMap.Sample(comparisonSampler, sampleDirection).r;
-        closestDepth *= 25;
-
-        // Accumulate shadow contribution
-        if (currentDepth - bias <= closestDepth) {
-            shadow += 0.25; // Weight of each sample (1/4 for 2x2 PCF)
+    int sampleCount = 0;
+    for (int x = -kernelSize; x <= kernelSize; x++) {
+        for (int y = -kernelSize; y <= kernelSize; y++) {
+            float2 offsetUV = clamp(atlasUV + float2(x, y) * texelSize, tileMin, tileMax);
+            shadow += ShadowAtlas.SampleCmpLevelZero(comparisonSampler, offsetUV, depth);
+            sampleCount++;
         }
     }
-
-    return shadow;
+    return shadow / sampleCount;
 }
 
-float PCFSpot(
-    Texture2D<float> ShadowMap,
+float PCFPoint(
+    Texture2D<float> ShadowAtlas,
     SamplerComparisonState comparisonSampler,
+    ShadowAtlasView view,
     float4 WorldSpacePosition,
-    column_major float4x4 LightView,
-    column_major float4x4 LightProj)
+    float3 LightPosition,
+    int kernelSize)
 {
-    float4 lightSpacePos = mul(LightProj, mul(LightView, WorldSpacePosition));
-    float3 lightSpaceNDC = lightSpacePos.xyz / lightSpacePos.w;
-
-    float2 shadowMapUV = lightSpaceNDC.xy * 0.5 + 0.5;
-    shadowMapUV.y = 1.0 - shadowMapUV.y;
+    if (view.Rect.z == 0.0)
+        return 1.0;
 
-    float shadow = 0.0f;
-    float depth = lightSpaceNDC.z;
+    float4 clipPosition = mul(view.ViewProj, WorldSpacePosition);
+    float2 uv = clipPosition.xy / clipPosition.w * 0.5 + 0.5;
+    uv.y = 1.0 - uv.y;
 
-    uint shadowMapWidth, shadowMapHeight;
-    ShadowMap.GetDimensions(shadowMapWidth, shadowMapHeight);
+    // The faces hold the distance to the light over the far plane
+    float currentDepth = length(WorldSpacePosition.xyz - LightPosition) / 25.0;
+    float bias = 0.05 / 25.0;
+    return SampleShadowAtlas(ShadowAtlas, comparisonSampler, view, uv, currentDepth - bias, kernelSize);
+}
 
-    float2 texelSize = float2(1.0 / shadowMapWidth, 1.0 / shadowMapHeight);
-    float2 pcfKernel[4] = {
-        float2(-1.0, -1.0) * texelSize, 
-        float2(1.0, -1.0) * texelSize,
-        float2(-1.0, 1.0) * texelSize, 
-        float2(1.0, 1.0) * texelSize
-    };
+float PCFSpot(
+    Texture2D<float> ShadowAtlas,
+    SamplerComparisonState comparisonSampler,
+    ShadowAtlasView view,
+    float4 WorldSpacePosition)
+{
+    if (view.Rect.z == 0.0)
+        return 1.0;
 
-    int sampleCount = 0;
-    for (int x = -2; x <= 2; x++) {
-        for (int y = -2; y <= 2; y++) {
-            // Offset UV coordinates for sampling
-            float2 offsetUV = shadowMapUV + float2(x, y) * texelSize;
+    float4 lightSpacePos = mul(view.ViewProj, WorldSpacePosition);
+    float3 lightSpaceNDC = lightSpacePos.xyz / lightSpacePos.w;
+    if (lightSpaceNDC.z > 1.0)
+        return 1.0;
 
-            // Use the comparison sampler to perform the depth test
-            shadow += ShadowMap.SampleCmpLevelZero(comparisonSampler, offsetUV, depth - 0.005);
-            sampleCount++;
-        }
-    }
-    shadow /= sampleCount;
+    float2 shadowMapUV = lightSpaceNDC.xy * 0.5 + 0.5;
+    shadowMapUV.y = 1.0 - shadowMapUV.y;
 
-    return shadow; 
+    return SampleShadowAtlas(ShadowAtlas, comparisonSampler, view, shadowMapUV, lightSpaceNDC.z - 0.005, 2);
 }
@@ -5,11 +5,17 @@
 
 #include <Asset/AssetCacher.hpp>
 #include <Core/Logger.hpp>
+#include <Core/Timer.hpp>
+#include <Core/Jobs.hpp>
+#include <Core/Profiler.hpp>
 
+#include <CGLTF/cgltf.h>
 #include <filesystem>
+#include <atomic>
 
 AssetCacher::Data AssetCacher::sData;
 
+#if defined(_WIN32)
 class NVTTErrorHandler : nvtt::ErrorHandler
 {
 public:
@@ -77,12 +83,186 @@ private:
     Vector<UInt8>* mBytes;
 };
 
+bool AssetCacher::CacheTexture(const String& normalPath, TextureSemantic semantic, AssetFile& file)
+{
+    PROFILE_SCOPE("Cook Texture");
+    nvtt::Surface image;
+    if (!image.load(normalPath.c_str())) {
+        LOG_ERROR("Failed to load texture {0}", normalPath);
+        return false;
+    }
+
+    int sourceWidth = image.width();
+    int sourceHeight = image.height();
+
+    // GLTF metallic roughness only uses G and B, so occlusion goes in R. An image that is its own occlusion source already
+    // has it there, and without any source R is never sampled.
+    auto occlusionPath = sData.mPackedOcclusion.find(normalPath);
+    if (semantic == TextureSemantic::PackedPBR && occlusionPath != sData.mPackedOcclusion.end() && occlusionPath->second != normalPath) {
+        nvtt::Surface occlusion;
+        if (occlusion.load(occlusionPath->second.c_str())) {
+            if (occlusion.width() != sourceWidth || occlusion.height() != sourceHeight) {
+                occlusion.resize(sourceWidth, sourceHeight, 1, nvtt::ResizeFilter_Kaiser);
+            }
+        } else {
+            LOG_WARN("Failed to load occlusion {0} for {1}, packing none", occlusionPath->second, normalPath);
+            occlusion.setImage(sourceWidth, sourceHeight, 1);
+            occlusion.fill(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        image.copyChannel(occlusion, 0, 0);
+    }
+
+    // BC needs the top level to be a multiple of the 4x4 block size. Resample rather than pad so UVs stay valid.
+    int imageWidth = glm::max(4, (sourceWidth + 3) & ~3);
+    int imageHeight = glm::max(4, (sourceHeight + 3) & ~3);
+    if (imageWidth != sourceWidth || imageHeight != sourceHeight) {
+        if (semantic == TextureSemantic::Color) {
+            image.toLinearFromSrgb();
+            image.premultiplyAlpha();
+        }
+        image.resize(imageWidth, imageHeight, 1, nvtt::ResizeFilter_Kaiser);
+        if (semantic == TextureSemantic::Color) {
+            image.demultiplyAlpha();
+            image.toSrgb();
+        }
+    }
+
+    nvtt::Format format = nvtt::Format_BC7;
+    file.Header.TextureHeader.Format = TextureFormat::BC7;
+    if (semantic == TextureSemantic::Normal) {
+        format = nvtt::Format_BC5;
+        file.Header.TextureHeader.Format = TextureFormat::BC5;
+    } else if (semantic == TextureSemantic::Mask) {
+        format = nvtt::Format_BC4;
+        file.Header.TextureHeader.Format = TextureFormat::BC4;
+    }
+
+    // Full chain down to 1x1, matching D3D12's max(1, dim >> level) for rectangular textures.
+    int mipCount = image.countMipmaps();
+
+    file.Header.TextureHeader.Width = imageWidth;
+    file.Header.TextureHeader.Height = imageHeight;
+    file.Header.TextureHeader.Levels = mipCount;
+    LOG_INFO("Caching texture {0} ({1}, {2}, {3})", normalPath, imageWidth, imageHeight, mipCount);
+
+    CompressMipChain(image, semantic, format, file.Bytes);
+
+    // Non-square textures used to be skipped here and loaded as a single RGBA8 level instead.
+    if (sourceWidth != sourceHeight) {
+        sData.mStats.PromotedTextures++;
+        sData.mStats.PromotedUncompressedBytes += UInt64(sourceWidth) * UInt64(sourceHeight) * 4;
+        sData.mStats.PromotedCompressedBytes += file.Bytes.size();
+    }
+    sData.mStats.CookedTextures++;
+    return true;
+}
+
+void AssetCacher::CompressMipChain(nvtt::Surface& image, TextureSemantic semantic, nvtt::Format format, Vector<UInt8>& bytes)
+{
+    TextureWriter writer(&bytes);
+    NVTTErrorHandler errorHandler;
+
+    nvtt::OutputOptions outputOptions;
+    outputOptions.setErrorHandler(reinterpret_cast<nvtt::ErrorHandler*>(&errorHandler));
+    outputOptions.setOutputHandler(reinterpret_cast<nvtt::OutputHandler*>(&writer));
+
+    nvtt::CompressionOptions compressionOptions;
+    compressionOptions.setFormat(format);
+
+    // Colors are filtered in linear, premultiplied space, normals as signed vectors. Everything else is already linear.
+    nvtt::Surface working = image;
+    if (semantic == TextureSemantic::Color) {
+        working.toLinearFromSrgb();
+        working.premultiplyAlpha();
+    } else if (semantic == TextureSemantic::Normal) {
+        working.setNormalMap(true);
+        working.expandNormals();
+    }
+
+    int mipCount = image.countMipmaps();
+    for (int i = 0; i < mipCount; i++) {
+        nvtt::Surface mip = working;
+        if (semantic == TextureSemantic::Color) {
+            mip.demultiplyAlpha();
+            mip.toSrgb();
+        } else if (semantic == TextureSemantic::Normal) {
+            mip.normalizeNormalMap();
+            mip.packNormals();
+        }
+
+        if (!sData.mContext.compress(mip, 0, i, compressionOptions, outputOptions)) {
+            LOG_ERROR("Failed to compress texture!");
+        }
+
+        if (i + 1 < mipCount) {
+            working.buildNextMipmap(semantic == TextureSemantic::Color ? nvtt::MipmapFilter_Kaiser : nvtt::MipmapFilter_Box);
+        }
+    }
+}
+#else
+bool AssetCacher::CacheTexture(const String& normalPath, TextureSemantic semantic, AssetFile& file)
+{
+    // The nvtt in ThirdParty is Windows only. Textures cooked there still load, the rest go through Image uncompressed.
+    return false;
+}
+#endif
+
+void AssetCacher::ScanMaterials(const String& gltfPath)
+{
+    cgltf_options options = {};
+    cgltf_data* data = nullptr;
+    if (cgltf_parse_file(&options, gltfPath.c_str(), &data) != cgltf_result_success) {
+        LOG_WARN("Failed to parse {0} for texture semantics", gltfPath);
+        return;
+    }
+
+    String directory = gltfPath.substr(0, gltfPath.find_last_of('/'));
+    auto imagePath = [&](const cgltf_texture_view& view) -> String {
+        if (!view.texture || !view.texture->image || !view.texture->image->uri) {
+            return "";
+        }
+        return directory + '/' + String(view.texture->image->uri);
+    };
+
+    for (int i = 0; i < data->materials_count; i++) {
+        cgltf_material& material = data->materials[i];
+
+        Data::MaterialReport report;
+        report.Name = gltfPath + ":" + (material.name ? String(material.name) : std::to_string(i));
+        auto add = [&](const String& path, TextureSemantic semantic) {
+            if (path.empty()) {
+                return;
+            }
+            sData.mSemantics.emplace(path, semantic);
+            report.Textures.push_back(path);
+        };
+
+        String albedo = imagePath(material.pbr_metallic_roughness.base_color_texture);
+        String metallicRoughness = imagePath(material.pbr_metallic_roughness.metallic_roughness_texture);
+        String occlusion = imagePath(material.occlusion_texture);
+
+        add(albedo, TextureSemantic::Color);
+        add(imagePath(material.normal_texture), TextureSemantic::Normal);
+        add(metallicRoughness, TextureSemantic::PackedPBR);
+        if (!metallicRoughness.empty() && !occlusion.empty()) {
+            // Also recorded when both are the same image, which is then already packed
+            sData.mPackedOcclusion.emplace(metallicRoughness, occlusion);
+        } else {
+            add(occlusion, TextureSemantic::Mask);
+        }
+
+        sData.mMaterials.push_back(report);
+    }
+
+    cgltf_free(data);
+}
+
 String AssetCacher::GetCachedAsset(const String& normalPath)
 {
     const UInt64 m = 0xc6a4a7935bd1e995ULL;
     const UInt32 r = 47;
 
-    UInt64 h = 1000 ^ (normalPath.size() * m);
+    UInt64 h = (1000 + ASSET_CACHE_VERSION) ^ (normalPath.size() * m);
     const UInt64 * data = (const UInt64 *)normalPath.data();
     const UInt64 * end = data + (normalPath.size() / 8);
     while (data != end) {
@@ -122,14 +302,14 @@ AssetFile AssetCacher::ReadAsset(const String& path)
     
     AssetFile result = {};
 
-    UInt8* Bytes = (UInt8*)File::ReadBytes(cached);
-    memcpy(&result.Header, Bytes, sizeof(AssetFile::Header));
-
-    UInt64 size = File::GetFileSize(cached);
-    result.Bytes.resize(size - sizeof(AssetFile::Header));
-    memcpy(result.Bytes.data(), Bytes + sizeof(AssetFile::Header), result.Bytes.size());
-
-    delete[] Bytes;
+    // Mapped, so the payload is copied once straight out of the page cache
+    MappedFile file(cached);
+    if (file.GetSize() < sizeof(AssetFile::Header)) {
+        LOG_ERROR("Cached asset {0} for {1} is truncated!", cached, path);
+        return result;
+    }
+    memcpy(&result.Header, file.GetData(), sizeof(AssetFile::Header));
+    result.Bytes.assign(file.GetData() + sizeof(AssetFile::Header), file.GetData() + file.GetSize());
     return result;
 }
 
@@ -214,20 +394,33 @@ AssetType AssetCacher::GetAssetTypeFromPath(const String& normalPath)
     return AssetType::None;
 }
 
-void AssetCacher::CacheAsset(const String& normalPath)
+bool AssetCacher::CacheAsset(const String& normalPath, bool force)
 {
     AssetType type = GetAssetTypeFromPath(normalPath);
     if (type == AssetType::None) {
-        return;
+        return false;
+    }
+
+    if (type == AssetType::Shader) {
+        return CacheShader(normalPath, {}, force);
     }
 
     File::Filetime assetFiletime = File::GetLastModified(normalPath);
+    auto occlusion = sData.mPackedOcclusion.find(normalPath);
+    if (occlusion != sData.mPackedOcclusion.end()) {
+        // Packed textures are stale as soon as either source changes
+        File::Filetime occlusionFiletime = File::GetLastModified(occlusion->second);
+        if (occlusionFiletime.High > assetFiletime.High || (occlusionFiletime.High == assetFiletime.High && occlusionFiletime.Low > assetFiletime.Low)) {
+            assetFiletime = occlusionFiletime;
+        }
+    }
+
     String cached = GetCachedAsset(normalPath);
-    if (File::Exists(cached)) {
+    if (File::Exists(cached) && !force) {
         // Read only the header
         AssetFile cachedFile = ReadAssetHeader(normalPath);
         if (assetFiletime == cachedFile.Header.Filetime) {
-            return;
+            return false;
         }
     }
 
@@ -236,66 +429,84 @@ void AssetCacher::CacheAsset(const String& normalPath)
 
     switch (type) {
         case AssetType::Texture: {
-            nvtt::Surface image;
-            if (!image.load(normalPath.c_str())) {
-                LOG_ERROR("Failed to load texture {0}", normalPath);
-                return;
+            auto semantic = sData.mSemantics.find(normalPath);
+            if (!CacheTexture(normalPath, semantic != sData.mSemantics.end() ? semantic->second : TextureSemantic::Color, file)) {
+                return false;
             }
+            break;
+        }
+    }
 
-            int imageWidth = image.width();
-            int imageHeight = image.height();
-            if (imageWidth != imageHeight) {
-                LOG_WARN("Image {0} cannot be compressed due to dimensions that are not squares of 2.", normalPath);
-                return;
-            }
-            int mipCount = image.countMipmaps();
-            int finalMipCount = glm::max(1, mipCount - 2); // (Remove mip 2x2 and 1x1)
-
-            file.Header.TextureHeader.Width = imageWidth;
-            file.Header.TextureHeader.Height = imageHeight;
-            file.Header.TextureHeader.Levels = finalMipCount;
-            LOG_INFO("Caching texture {0} ({1}, {2}, {3})", normalPath, imageWidth, imageHeight, finalMipCount);
+    WriteAsset(cached, file);
+    return true;
+}
 
-            TextureWriter writer(&file.Bytes);
-            NVTTErrorHandler errorHandler;
+bool AssetCacher::CacheShader(const String& normalPath, const Vector<String>& defines, bool force)
+{
+    PROFILE_SCOPE("Cook Shader");
+    // Shaders are keyed on their contents, includes and defines rather than the timestamp of the file itself
+    ShaderType type = GetShaderTypeFromPath(normalPath);
+    if (type == ShaderType::None) {
+        return false;
+    }
+    String entry = GetEntryPointFromShaderType(type);
+    UInt64 key = ShaderCompiler::GetCacheKey(normalPath, entry, type, defines);
+
+    String name = GetPermutationName(normalPath, defines);
+    String cached = GetCachedAsset(name);
+    if (File::Exists(cached) && !force) {
+        AssetFile cachedFile = ReadAssetHeader(name);
+        if (cachedFile.Header.ShaderHeader.Key == key) {
+            return false;
+        }
+    }
 
-            nvtt::OutputOptions outputOptions;
-            outputOptions.setErrorHandler(reinterpret_cast<nvtt::ErrorHandler*>(&errorHandler));
-            outputOptions.setOutputHandler(reinterpret_cast<nvtt::OutputHandler*>(&writer));
+    LOG_INFO("Caching shader {0}", name);
+    Shader shader = ShaderCompiler::Compile(normalPath, entry, type, defines);
+    if (!shader.Valid) {
+        return false;
+    }
 
-            nvtt::CompressionOptions compressionOptions;
-            compressionOptions.setFormat(nvtt::Format::Format_BC7);
+    AssetFile file;
+    file.Header.Filetime = File::GetLastModified(normalPath);
+    file.Header.Type = AssetType::Shader;
+    file.Header.ShaderHeader.Type = type;
+    file.Header.ShaderHeader.Key = key;
+    file.Bytes = shader.Bytecode;
+
+    WriteAsset(cached, file);
+    return true;
+}
 
-            for (int i = 0; i < finalMipCount; i++) {
-                if (!sData.mContext.compress(image, 0, i, compressionOptions, outputOptions)) {
-                    LOG_ERROR("Failed to compress texture!");
-                }
+Shader AssetCacher::GetShaderPermutation(const String& normalPath, const Vector<String>& defines)
+{
+    String name = GetPermutationName(normalPath, defines);
+    CacheShader(normalPath, defines);
+    if (!File::Exists(GetCachedAsset(name))) {
+        LOG_ERROR("Failed to compile permutation {0}", name);
+        return {};
+    }
 
-                // Prepare the next mip:
-                image.toLinearFromSrgb();
-                image.premultiplyAlpha();
+    AssetFile file = ReadAsset(name);
 
-                image.buildNextMipmap(nvtt::MipmapFilter_Box);
+    Shader shader = {};
+    shader.Valid = true;
+    shader.Type = file.Header.ShaderHeader.Type;
+    shader.Bytecode = file.Bytes;
+    return shader;
+}
 
-                image.demultiplyAlpha();
-                image.toSrgb();
-            }
-            break;
-        }
-        case AssetType::Shader: {
-            ShaderType type = GetShaderTypeFromPath(normalPath);
-            file.Header.ShaderHeader.Type = type;
-            if (type == ShaderType::None)
-                return;
-            
-            LOG_INFO("Caching shader {0}", normalPath);
-            Shader shader = ShaderCompiler::Compile(normalPath, GetEntryPointFromShaderType(type), type);
-            file.Bytes.resize(shader.Bytecode.size());
-            memcpy(file.Bytes.data(), shader.Bytecode.data(), shader.Bytecode.size());
-            break;
-        }
+String AssetCacher::GetPermutationName(const String& normalPath, const Vector<String>& defines)
+{
+    String name = normalPath;
+    for (int i = 0; i < defines.size(); i++) {
+        name += (i == 0 ? "|" : ",") + defines[i];
     }
+    return name;
+}
 
+void AssetCacher::WriteAsset(const String& cached, const AssetFile& file)
+{
     Vector<UInt8> bytesToWrite;
     bytesToWrite.resize(sizeof(AssetFile::Header));
     memcpy(bytesToWrite.data(), &file.Header, sizeof(AssetFile::Header));
@@ -304,6 +515,76 @@ void AssetCacher::CacheAsset(const String& normalPath)
     File::WriteBytes(cached, bytesToWrite.data(), bytesToWrite.size());
 }
 
+void AssetCacher::CacheShaders(bool force)
+{
+    Vector<String> shaders;
+    for (const auto& dirEntry : std::filesystem::recursive_directory_iterator(sData.mAssetDirectory)) {
+        String entryPath = dirEntry.path().string();
+        std::replace(entryPath.begin(), entryPath.end(), '\\', '/');
+
+        if (GetAssetTypeFromPath(entryPath) == AssetType::Shader) {
+            shaders.push_back(entryPath);
+        }
+    }
+
+    // Every shader writes its own cache file. One per job since compile times vary a lot between them.
+    std::atomic<UInt32> compiled = 0;
+
+    Timer timer;
+    UInt32 threadCount = std::min(Jobs::GetThreadCount(), (UInt32)shaders.size());
+    Jobs::ParallelFor(shaders.size(), [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            if (CacheAsset(shaders[i], force)) {
+                compiled++;
+            }
+        }
+    }, 1);
+
+    LOG_INFO("[Shader Cache] {0} shaders ({1} compiled, {2} up to date) in {3} ms on {4} threads{5}",
+             shaders.size(),
+             compiled.load(),
+             shaders.size() - compiled.load(),
+             timer.GetElapsed(),
+             threadCount,
+             force ? " (cold)" : "");
+}
+
+bool AssetCacher::ReadOcclusion(const String& gltfPath, UInt32 vertexCount, UInt32 rayCount, float distance, Vector<UInt8>& occlusion)
+{
+    String name = gltfPath + "|Occlusion";
+    if (!File::Exists(GetCachedAsset(name))) {
+        return false;
+    }
+
+    AssetFile cachedFile = ReadAssetHeader(name);
+    if (cachedFile.Header.Filetime != File::GetLastModified(gltfPath) ||
+        cachedFile.Header.OcclusionHeader.VertexCount != vertexCount ||
+        cachedFile.Header.OcclusionHeader.RayCount != rayCount ||
+        cachedFile.Header.OcclusionHeader.Distance != distance) {
+        return false;
+    }
+
+    AssetFile file = ReadAsset(name);
+    if (file.Bytes.size() != vertexCount) {
+        return false;
+    }
+    occlusion = std::move(file.Bytes);
+    return true;
+}
+
+void AssetCacher::WriteOcclusion(const String& gltfPath, UInt32 rayCount, float distance, const Vector<UInt8>& occlusion)
+{
+    AssetFile file = {};
+    file.Header.Filetime = File::GetLastModified(gltfPath);
+    file.Header.Type = AssetType::GLTF;
+    file.Header.OcclusionHeader.VertexCount = occlusion.size();
+    file.Header.OcclusionHeader.RayCount = rayCount;
+    file.Header.OcclusionHeader.Distance = distance;
+    file.Bytes = occlusion;
+
+    WriteAsset(GetCachedAsset(gltfPath + "|Occlusion"), file);
+}
+
 bool AssetCacher::IsCached(const String& normalPath)
 {
     if (File::Exists(GetCachedAsset(normalPath)))
@@ -317,12 +598,52 @@ void AssetCacher::Init(const String& assetDirectory)
         File::CreateDirectoryFromPath(".cache");
     }
 
+#if defined(_WIN32)
     sData.mContext.enableCudaAcceleration(true);
+#endif
+    sData.mAssetDirectory = assetDirectory;
+    sData.mStats = {};
+    sData.mSemantics.clear();
+    sData.mPackedOcclusion.clear();
+    sData.mMaterials.clear();
+
+    // Find out what every texture is used for before cooking anything
+    for (const auto& dirEntry : std::filesystem::recursive_directory_iterator(assetDirectory)) {
+        String entryPath = dirEntry.path().string();
+        std::replace(entryPath.begin(), entryPath.end(), '\\', '/');
 
+        if (File::GetFileExtension(entryPath) == ".gltf") {
+            ScanMaterials(entryPath);
+        }
+    }
+
+    // nvtt's context isn't thread safe, so textures are cooked one by one and shaders separately afterwards
     for (const auto& dirEntry : std::filesystem::recursive_directory_iterator(assetDirectory)) {
         String entryPath = dirEntry.path().string();
         std::replace(entryPath.begin(), entryPath.end(), '\\', '/');
     
-        CacheAsset(entryPath);
+        if (GetAssetTypeFromPath(entryPath) != AssetType::Shader) {
+            CacheAsset(entryPath);
+        }
+    }
+    CacheShaders();
+
+    for (auto& material : sData.mMaterials) {
+        UInt64 cookedBytes = 0;
+        for (auto& texture : material.Textures) {
+            String cached = GetCachedAsset(texture);
+            if (File::Exists(cached)) {
+                cookedBytes += File::GetFileSize(cached) - sizeof(AssetFile::Header);
+            }
+        }
+        LOG_INFO("Material {0}: {1} textures, {2} KB cooked", material.Name, material.Textures.size(), cookedBytes / 1024);
+    }
+
+    if (sData.mStats.PromotedTextures > 0) {
+        LOG_INFO("Cooked {0} textures, {1} of which moved from uncompressed RGBA8 to BC ({2} MB -> {3} MB, mips included)",
+                 sData.mStats.CookedTextures,
+                 sData.mStats.PromotedTextures,
+                 sData.mStats.PromotedUncompressedBytes / 1024.0f / 1024.0f,
+                 sData.mStats.PromotedCompressedBytes / 1024.0f / 1024.0f);
     }
 }
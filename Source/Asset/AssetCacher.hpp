@@ -12,7 +12,21 @@
 
 #include <Core/File.hpp>
 
-#include <nvtt/nvtt.h>
+#if defined(_WIN32)
+    #include <nvtt/nvtt.h>
+#endif
+
+// Bump whenever the header layout or the way assets are cooked changes, so stale cache files get ignored.
+#define ASSET_CACHE_VERSION 5
+
+// Decided by which GLTF material slot references the image
+enum class TextureSemantic
+{
+    Color,     // BC7
+    Normal,    // BC5, XY only, Z is reconstructed in the shader
+    Mask,      // BC4
+    PackedPBR  // BC7, R = occlusion, G = roughness, B = metallic
+};
 
 struct AssetFile
 {
@@ -25,11 +39,19 @@ struct AssetFile
             int Width;
             int Height;
             int Levels;
+            TextureFormat Format;
         } TextureHeader;
 
         struct {
             ShaderType Type;
+            UInt64 Key;
         } ShaderHeader;
+
+        struct {
+            UInt32 VertexCount;
+            UInt32 RayCount;
+            float Distance;
+        } OcclusionHeader;
     } Header;
     Vector<UInt8> Bytes;
 };
@@ -38,18 +60,56 @@ class AssetCacher
 {
 public:
     static void Init(const String& assetDirectory);
-    static void CacheAsset(const String& normalPath);
+    // Returns true if the asset had to be (re)cooked
+    static bool CacheAsset(const String& normalPath, bool force = false);
+    // Compiles every shader under the asset directory across all cores. force ignores the cache.
+    static void CacheShaders(bool force = false);
+    // Compiled on first use and cached under the permutation's own name
+    static Shader GetShaderPermutation(const String& normalPath, const Vector<String>& defines);
     static bool IsCached(const String& normalPath);
 
+    // Per-vertex occlusion baked by the GLTF loader, one byte per vertex in the order it loads them. False when there is
+    // none or it was baked from another version of the model or with other settings.
+    static bool ReadOcclusion(const String& gltfPath, UInt32 vertexCount, UInt32 rayCount, float distance, Vector<UInt8>& occlusion);
+    static void WriteOcclusion(const String& gltfPath, UInt32 rayCount, float distance, const Vector<UInt8>& occlusion);
+
     static AssetFile ReadAsset(const String& path);
 private:
     friend class AssetManager;
 
     static struct Data
     {
+#if defined(_WIN32)
         nvtt::Context mContext;
+#endif
+        String mAssetDirectory;
+
+        UnorderedMap<String, TextureSemantic> mSemantics;
+        UnorderedMap<String, String> mPackedOcclusion;
+
+        struct MaterialReport {
+            String Name;
+            Vector<String> Textures;
+        };
+        Vector<MaterialReport> mMaterials;
+
+        struct {
+            UInt32 CookedTextures;
+            UInt32 PromotedTextures;
+            UInt64 PromotedUncompressedBytes;
+            UInt64 PromotedCompressedBytes;
+        } mStats;
     } sData;
 
+    static void ScanMaterials(const String& gltfPath);
+    static bool CacheTexture(const String& normalPath, TextureSemantic semantic, AssetFile& file);
+    static bool CacheShader(const String& normalPath, const Vector<String>& defines, bool force = false);
+    static String GetPermutationName(const String& normalPath, const Vector<String>& defines);
+    static void WriteAsset(const String& cached, const AssetFile& file);
+#if defined(_WIN32)
+    static void CompressMipChain(nvtt::Surface& image, TextureSemantic semantic, nvtt::Format format, Vector<UInt8>& bytes);
+#endif
+
     static AssetFile ReadAssetHeader(const String& path);
     static String GetEntryPointFromShaderType(ShaderType type);
     static ShaderType GetShaderTypeFromPath(const String& path);
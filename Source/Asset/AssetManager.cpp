@@ -7,6 +7,7 @@
 #include <Asset/AssetCacher.hpp>
 
 #include <Core/Logger.hpp>
+#include <Core/Profiler.hpp>
 #include <RHI/Uploader.hpp>
 
 AssetManager::Data AssetManager::sData;
@@ -21,7 +22,7 @@ void AssetManager::Clean()
     sData.mAssets.clear();
 }
 
-Asset::Handle AssetManager::Get(const String& path, AssetType type)
+Asset::Handle AssetManager::Get(const String& path, AssetType type, const TextureLoadHints& hints)
 {
     if (sData.mAssets.count(path) > 0) {
         sData.mAssets[path]->RefCount++;
@@ -35,11 +36,13 @@ Asset::Handle AssetManager::Get(const String& path, AssetType type)
 
     switch (type) {
         case AssetType::GLTF: {
+            PROFILE_SCOPE("Load GLTF");
             LOG_DEBUG("Loading GLTF {0}", path);
             asset->Model.Load(sData.mRHI, path);
             break;
         }
         case AssetType::Texture: {
+            PROFILE_SCOPE("Load Texture");
             LOG_DEBUG("Loading texture {0}", path);
 
             if (AssetCacher::IsCached(path) && true) {
@@ -51,7 +54,7 @@ Asset::Handle AssetManager::Get(const String& path, AssetType type)
                 desc.Levels = file.Header.TextureHeader.Levels;
                 desc.Depth = 1;
                 desc.Name = path;
-                desc.Format = TextureFormat::BC7;
+                desc.Format = file.Header.TextureHeader.Format;
                 desc.Usage = TextureUsage::ShaderResource;
                 asset->Texture = sData.mRHI->CreateTexture(desc);
 
@@ -59,6 +62,7 @@ Asset::Handle AssetManager::Get(const String& path, AssetType type)
             } else {
                 Image image;
                 image.Load(path);
+                image.GenerateMips(hints.SRGB, hints.AlphaTested ? hints.AlphaCutoff : 0.0f);
 
                 TextureDesc desc;
                 desc.Width = image.Width;
@@ -75,6 +79,7 @@ Asset::Handle AssetManager::Get(const String& path, AssetType type)
             break;
         }
         case AssetType::Shader: {
+            PROFILE_SCOPE("Load Shader");
             LOG_DEBUG("Loading shader {0}", path);
 
             if (AssetCacher::IsCached(path) && true) {
@@ -26,21 +26,29 @@ struct Asset
     AssetType Type;
 
     GLTF Model;
-    Texture::Ref Texture;
-    Shader Shader;
+    ::Texture::Ref Texture;
+    ::Shader Shader;
 
     UInt32 RefCount;
 
     using Handle = Ref<Asset>;
 };
 
+// Only used when a texture isn't in the cache and goes through Image
+struct TextureLoadHints
+{
+    bool SRGB = true;
+    bool AlphaTested = false;
+    float AlphaCutoff = 0.5f;
+};
+
 class AssetManager
 {
 public:
     static void Init(RHI::Ref rhi);
     static void Clean();
 
-    static Asset::Handle Get(const String& path, AssetType type);
+    static Asset::Handle Get(const String& path, AssetType type, const TextureLoadHints& hints = {});
     static void Free(Asset::Handle handle);
 private:
     static struct Data
@@ -5,7 +5,12 @@
 
 #include <Asset/GLTF.hpp>
 #include <Asset/AssetManager.hpp>
+#include <Asset/AssetCacher.hpp>
 #include <Core/Assert.hpp>
+#include <Core/Jobs.hpp>
+#include <Core/Profiler.hpp>
+#include <Core/Logger.hpp>
+#include <Physics/OcclusionBaker.hpp>
 #include <RHI/Uploader.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -38,6 +43,87 @@ void GLTF::Load(RHI::Ref rhi,const String& path)
 
         ProcessNode(scene->nodes[i], Root->Children[i]);
     }
+
+    {
+        PROFILE_SCOPE("Build Mesh BVHs");
+        Jobs::ParallelFor(mPendingGeometry.size(), [&](UInt32 begin, UInt32 end) {
+            for (UInt32 i = begin; i < end; i++) {
+                PendingGeometry& pending = mPendingGeometry[i];
+                pending.Geometry->Build(pending.Positions, pending.Indices);
+            }
+        }, 1);
+    }
+
+    BakeOcclusion();
+    for (PendingGeometry& pending : mPendingGeometry) {
+        Uploader::EnqueueBufferUpload(pending.Vertices.data(), pending.VertexBuffer->GetSize(), pending.VertexBuffer);
+    }
+    mPendingGeometry.clear();
+}
+
+void GLTF::BakeOcclusion()
+{
+    PROFILE_SCOPE("Bake Occlusion");
+
+    UInt32 vertexCount = 0;
+    for (PendingGeometry& pending : mPendingGeometry) {
+        vertexCount += pending.Vertices.size();
+    }
+
+    // The whole model occludes itself, so nodes are placed where the scene puts them relative to the root
+    Vector<SceneBVH::Instance> instances;
+    instances.reserve(mPendingGeometry.size());
+    for (PendingGeometry& pending : mPendingGeometry) {
+        glm::mat4 transform = pending.Node->Transform;
+        for (GLTFNode* parent = pending.Node->Parent; parent; parent = parent->Parent) {
+            transform = parent->Transform * transform;
+        }
+        instances.push_back({ pending.Geometry.get(), transform, glm::inverse(transform) });
+    }
+
+    SceneBVH scene;
+    scene.Build(instances);
+    Box bounds = scene.GetBounds();
+    float distance = scene.IsEmpty() ? 0.0f : glm::length(bounds.Max - bounds.Min) * OCCLUSION_DISTANCE;
+
+    Vector<UInt8> baked;
+    if (!AssetCacher::ReadOcclusion(Path, vertexCount, OCCLUSION_RAY_COUNT, distance, baked)) {
+        Vector<OcclusionBaker::Sample> samples;
+        samples.reserve(vertexCount);
+        for (UInt32 i = 0; i < mPendingGeometry.size(); i++) {
+            const SceneBVH::Instance& instance = instances[i];
+            glm::mat4 normalMatrix = glm::transpose(instance.InvTransform);
+            for (const Vertex& vertex : mPendingGeometry[i].Vertices) {
+                OcclusionBaker::Sample sample;
+                sample.Position = glm::vec3(instance.Transform * glm::vec4(vertex.Position, 1.0f));
+                sample.Normal = glm::vec3(normalMatrix * glm::vec4(vertex.Normal, 0.0f));
+                samples.push_back(sample);
+            }
+        }
+
+        Vector<float> occlusion;
+        OcclusionBaker::Stats stats = OcclusionBaker::Bake(scene, samples, distance, occlusion);
+        LOG_INFO("[Occlusion] Baked {0}: {1} vertices, {2} rays in {3:.1f} ms on {4} threads ({5:.2f} Mrays/s)",
+                 Path,
+                 stats.Samples,
+                 stats.Rays,
+                 stats.Milliseconds,
+                 stats.Threads,
+                 stats.Rays / (std::max(stats.Milliseconds, 1e-3f) * 1000.0f));
+
+        baked.resize(vertexCount);
+        for (UInt32 i = 0; i < vertexCount; i++) {
+            baked[i] = UInt8(glm::clamp(occlusion[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+        AssetCacher::WriteOcclusion(Path, OCCLUSION_RAY_COUNT, distance, baked);
+    }
+
+    UInt32 offset = 0;
+    for (PendingGeometry& pending : mPendingGeometry) {
+        for (Vertex& vertex : pending.Vertices) {
+            vertex.Occlusion = baked[offset++] / 255.0f;
+        }
+    }
 }
 
 GLTF::~GLTF()
@@ -156,6 +242,7 @@ void GLTF::ProcessPrimitive(cgltf_primitive *primitive, GLTFNode *node)
         if (!cgltf_accessor_read_float(normAttribute->data, i, glm::value_ptr(vertex.Normal), 4)) {
             vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
         }
+        vertex.Occlusion = 1.0f;
 
         out.AABB.Min = glm::min(vertex.Position, out.AABB.Min);
         out.AABB.Max = glm::max(vertex.Position, out.AABB.Max);
@@ -173,17 +260,21 @@ void GLTF::ProcessPrimitive(cgltf_primitive *primitive, GLTFNode *node)
     /// @note(ame): create buffers
     out.VertexBuffer = mRHI->CreateBuffer(vertices.size() * sizeof(Vertex), sizeof(Vertex), BufferType::Vertex, node->Name + " Vertex Buffer");
     out.IndexBuffer = mRHI->CreateBuffer(indices.size() * sizeof(UInt32), sizeof(UInt32), BufferType::Index, node->Name + " Index Buffer");
-    out.GeometryStructure = mRHI->CreateBLAS(out.VertexBuffer, out.IndexBuffer, out.VertexCount, out.IndexCount, node->Name + " BLAS");
 
-    Uploader::EnqueueBufferUpload(vertices.data(), out.VertexBuffer->GetSize(), out.VertexBuffer);
     Uploader::EnqueueBufferUpload(indices.data(), out.IndexBuffer->GetSize(), out.IndexBuffer);
 
-    // out.Instance = {};
-    // out.Instance.AccelerationStructure = out.GeometryStructure->GetAddress();
-    // out.Instance.InstanceMask = 1;
-    // out.Instance.InstanceID = 0;
-    // out.Instance.Transform = glm::mat3x4(glm::transpose(node->Transform));
-    // out.Instance.Flags = 0x4;
+    PendingGeometry pending;
+    pending.Geometry = MakeRef<MeshBVH>();
+    pending.Node = node;
+    pending.VertexBuffer = out.VertexBuffer;
+    pending.Positions.reserve(vertices.size());
+    for (const Vertex& vertex : vertices) {
+        pending.Positions.push_back(vertex.Position);
+    }
+    pending.Vertices = std::move(vertices);
+    pending.Indices = std::move(indices);
+    out.Geometry = pending.Geometry;
+    mPendingGeometry.push_back(std::move(pending));
 
     cgltf_material *material = primitive->material;
     
@@ -204,15 +295,41 @@ void GLTF::ProcessPrimitive(cgltf_primitive *primitive, GLTFNode *node)
     if (material && material->pbr_metallic_roughness.base_color_texture.texture) {
         std::string path = Directory + '/' + std::string(material->pbr_metallic_roughness.base_color_texture.texture->image->uri);
     
-        outMaterial.Albedo = AssetManager::Get(path, AssetType::Texture);
+        TextureLoadHints hints;
+        hints.AlphaTested = outMaterial.AlphaTested;
+        hints.AlphaCutoff = outMaterial.AlphaCutoff;
+
+        outMaterial.Albedo = AssetManager::Get(path, AssetType::Texture, hints);
         outMaterial.AlbedoView = mRHI->CreateView(outMaterial.Albedo->Texture, ViewType::ShaderResource);
     }
     if (material && material->normal_texture.texture) {
         std::string path = Directory + '/' + std::string(material->normal_texture.texture->image->uri);
     
-        outMaterial.Normal = AssetManager::Get(path, AssetType::Texture);
+        TextureLoadHints hints;
+        hints.SRGB = false;
+
+        outMaterial.Normal = AssetManager::Get(path, AssetType::Texture, hints);
         outMaterial.NormalView = mRHI->CreateView(outMaterial.Normal->Texture, ViewType::ShaderResource);
     }
+    if (material && material->pbr_metallic_roughness.metallic_roughness_texture.texture) {
+        std::string path = Directory + '/' + std::string(material->pbr_metallic_roughness.metallic_roughness_texture.texture->image->uri);
+
+        TextureLoadHints hints;
+        hints.SRGB = false;
+
+        outMaterial.PBR = AssetManager::Get(path, AssetType::Texture, hints);
+        outMaterial.PBRView = mRHI->CreateView(outMaterial.PBR->Texture, ViewType::ShaderResource);
+        outMaterial.PackedOcclusion = material->occlusion_texture.texture && AssetCacher::IsCached(path);
+    }
+    if (material && material->occlusion_texture.texture && !outMaterial.PackedOcclusion) {
+        std::string path = Directory + '/' + std::string(material->occlusion_texture.texture->image->uri);
+
+        TextureLoadHints hints;
+        hints.SRGB = false;
+
+        outMaterial.Occlusion = AssetManager::Get(path, AssetType::Texture, hints);
+        outMaterial.OcclusionView = mRHI->CreateView(outMaterial.Occlusion->Texture, ViewType::ShaderResource);
+    }
 
     VertexCount += out.VertexCount;
     IndexCount += out.IndexCount;
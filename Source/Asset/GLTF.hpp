@@ -7,11 +7,10 @@
 
 #include <Core/Common.hpp>
 #include <RHI/RHI.hpp>
-#include <RHI/BLAS.hpp>
-#include <RHI/TLAS.hpp>
 #include <Physics/Volume.hpp>
+#include <Physics/MeshBVH.hpp>
 
-#include <cgltf/cgltf.h>
+#include <CGLTF/cgltf.h>
 #include <glm/glm.hpp>
 #include <functional>
 
@@ -22,6 +21,8 @@ struct Vertex
     glm::vec3 Position;
     glm::vec2 UV;
     glm::vec3 Normal;
+    // Baked ambient occlusion from the rest of the model, 1 is fully open
+    float Occlusion;
 };
 
 struct GLTFMaterial
@@ -32,6 +33,16 @@ struct GLTFMaterial
     Ref<Asset> Normal;
     View::Ref NormalView;
 
+    // R = occlusion (when PackedOcclusion is set), G = roughness, B = metallic
+    Ref<Asset> PBR;
+    View::Ref PBRView;
+
+    // Only loaded when occlusion couldn't be packed into PBR
+    Ref<Asset> Occlusion;
+    View::Ref OcclusionView;
+
+    bool PackedOcclusion;
+
     bool AlphaTested;
     float AlphaCutoff;
 
@@ -43,8 +54,8 @@ struct GLTFPrimitive
     Buffer::Ref VertexBuffer;
     Buffer::Ref IndexBuffer;
 
-    RaytracingInstance Instance;
-    BLAS::Ref GeometryStructure;
+    // Object space triangles for CPU ray queries
+    MeshBVH::Ref Geometry;
 
     UInt32 VertexCount;
     UInt32 IndexCount;
@@ -83,9 +94,24 @@ public:
 
     void TraverseNode(GLTFNode* root, const std::function<void(GLTFNode*)>& fn);
 private:
+    // Triangles kept from loading until the mesh BVHs are built, all at once on the job system. Vertices are uploaded
+    // once their occlusion is baked.
+    struct PendingGeometry
+    {
+        MeshBVH::Ref Geometry;
+        GLTFNode* Node;
+        Buffer::Ref VertexBuffer;
+        Vector<Vertex> Vertices;
+        Vector<glm::vec3> Positions;
+        Vector<UInt32> Indices;
+    };
+
     RHI::Ref mRHI;
+    Vector<PendingGeometry> mPendingGeometry;
 
     void ProcessPrimitive(cgltf_primitive *primitive, GLTFNode *node);
     void ProcessNode(cgltf_node *node, GLTFNode *mnode);
+    // From the cache, or traced against the whole model when the model or the bake settings changed
+    void BakeOcclusion();
     void FreeNodes(GLTFNode* node);
 };
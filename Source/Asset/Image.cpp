@@ -5,9 +5,315 @@
 
 #include <Asset/Image.hpp>
 #include <Core/Logger.hpp>
+#include <Core/Timer.hpp>
+#include <Core/Jobs.hpp>
 
 #include <stb/stb_image.h>
 
+#include <immintrin.h>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#define ENCODE_LUT_SIZE 8192
+#define PARALLEL_PIXEL_THRESHOLD 65536
+
+namespace
+{
+    struct ColorLUT
+    {
+        float Decode[256];
+        UInt8 Encode[ENCODE_LUT_SIZE];
+
+        ColorLUT(bool srgb)
+        {
+            for (int i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                Decode[i] = srgb ? (c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f)) : c;
+            }
+            for (int i = 0; i < ENCODE_LUT_SIZE; i++) {
+                float c = i / float(ENCODE_LUT_SIZE - 1);
+                float e = srgb ? (c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f) : c;
+                Encode[i] = UInt8(std::clamp(int(e * 255.0f + 0.5f), 0, 255));
+            }
+        }
+    };
+
+    const ColorLUT& GetLUT(bool srgb)
+    {
+        static ColorLUT srgbLUT(true);
+        static ColorLUT linearLUT(false);
+        return srgb ? srgbLUT : linearLUT;
+    }
+
+    // Box filter footprint of one destination texel. Odd sizes straddle up to four source texels.
+    struct FilterTaps
+    {
+        int Index[4];
+        float Weight[4];
+        int Count;
+    };
+
+    Vector<FilterTaps> BuildBoxTaps(int srcSize, int dstSize)
+    {
+        Vector<FilterTaps> taps(dstSize);
+
+        double ratio = double(srcSize) / double(dstSize);
+        for (int i = 0; i < dstSize; i++) {
+            double start = i * ratio;
+            double end = (i + 1) * ratio;
+
+            FilterTaps& tap = taps[i];
+            tap.Count = 0;
+            for (int j = int(std::floor(start)); j < std::min(srcSize, int(std::ceil(end))) && tap.Count < 4; j++) {
+                double overlap = std::min(end, double(j + 1)) - std::max(start, double(j));
+                if (overlap <= 0.0)
+                    continue;
+                tap.Index[tap.Count] = j;
+                tap.Weight[tap.Count] = float(overlap / ratio);
+                tap.Count++;
+            }
+        }
+        return taps;
+    }
+
+    void ParallelRows(int rows, int rowPixels, const std::function<void(int, int)>& fn)
+    {
+        if (rows * rowPixels < PARALLEL_PIXEL_THRESHOLD) {
+            fn(0, rows);
+            return;
+        }
+
+        // Keep every range above a few thousand pixels so small mips don't drown in scheduling
+        UInt32 grain = std::max<UInt32>({ 1u, UInt32(4096 / std::max(rowPixels, 1)), rows / (Jobs::GetThreadCount() * 8) });
+        Jobs::ParallelFor(rows, [&](UInt32 begin, UInt32 end) {
+            fn(int(begin), int(end));
+        }, grain);
+    }
+
+    // RGBA8 -> linear premultiplied float4
+    void DecodePixels(const UInt8* src, float* dst, int count, const ColorLUT& lut, bool simd)
+    {
+        if (simd) {
+            const __m128 inv255 = _mm_set1_ps(1.0f / 255.0f);
+            for (int i = 0; i < count; i++, src += 4, dst += 4) {
+                __m128 color = _mm_setr_ps(lut.Decode[src[0]], lut.Decode[src[1]], lut.Decode[src[2]], 1.0f);
+                __m128 alpha = _mm_mul_ps(_mm_set1_ps(float(src[3])), inv255);
+                _mm_storeu_ps(dst, _mm_mul_ps(color, alpha));
+            }
+            return;
+        }
+
+        for (int i = 0; i < count; i++, src += 4, dst += 4) {
+            float alpha = src[3] / 255.0f;
+            dst[0] = lut.Decode[src[0]] * alpha;
+            dst[1] = lut.Decode[src[1]] * alpha;
+            dst[2] = lut.Decode[src[2]] * alpha;
+            dst[3] = alpha;
+        }
+    }
+
+    // Linear premultiplied float4 -> RGBA8
+    void EncodePixels(const float* src, UInt8* dst, int count, const ColorLUT& lut, bool simd)
+    {
+        if (simd) {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 rgbMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+            const __m128 alphaOne = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+            const __m128 range = _mm_setr_ps(ENCODE_LUT_SIZE - 1, ENCODE_LUT_SIZE - 1, ENCODE_LUT_SIZE - 1, 255.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+
+            alignas(16) Int32 indices[4];
+            for (int i = 0; i < count; i++, src += 4, dst += 4) {
+                __m128 pixel = _mm_loadu_ps(src);
+                __m128 alpha = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+
+                // Demultiply RGB, leave alpha untouched
+                __m128 inverse = _mm_and_ps(_mm_div_ps(one, alpha), _mm_cmpgt_ps(alpha, zero));
+                __m128 scale = _mm_or_ps(_mm_and_ps(inverse, rgbMask), alphaOne);
+                __m128 color = _mm_min_ps(_mm_max_ps(_mm_mul_ps(pixel, scale), zero), one);
+
+                _mm_store_si128((__m128i*)indices, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(color, range), half)));
+                dst[0] = lut.Encode[indices[0]];
+                dst[1] = lut.Encode[indices[1]];
+                dst[2] = lut.Encode[indices[2]];
+                dst[3] = UInt8(indices[3]);
+            }
+            return;
+        }
+
+        for (int i = 0; i < count; i++, src += 4, dst += 4) {
+            float alpha = std::clamp(src[3], 0.0f, 1.0f);
+            float inverse = alpha > 0.0f ? 1.0f / src[3] : 0.0f;
+            for (int c = 0; c < 3; c++) {
+                float value = std::clamp(src[c] * inverse, 0.0f, 1.0f);
+                dst[c] = lut.Encode[int(value * (ENCODE_LUT_SIZE - 1) + 0.5f)];
+            }
+            dst[3] = UInt8(alpha * 255.0f + 0.5f);
+        }
+    }
+
+    // Weighted sum of up to four source rows into one row of floats.
+    void FilterRows(const float* src, int rowFloats, const FilterTaps& taps, float* dst, bool simd)
+    {
+        const float* rows[4];
+        for (int t = 0; t < taps.Count; t++) {
+            rows[t] = src + UInt64(taps.Index[t]) * rowFloats;
+        }
+
+        int i = 0;
+        if (simd) {
+#ifdef __AVX2__
+            for (; i + 8 <= rowFloats; i += 8) {
+                __m256 acc = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), _mm256_set1_ps(taps.Weight[0]));
+                for (int t = 1; t < taps.Count; t++) {
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(rows[t] + i), _mm256_set1_ps(taps.Weight[t])));
+                }
+                _mm256_storeu_ps(dst + i, acc);
+            }
+#endif
+            for (; i + 4 <= rowFloats; i += 4) {
+                __m128 acc = _mm_mul_ps(_mm_loadu_ps(rows[0] + i), _mm_set1_ps(taps.Weight[0]));
+                for (int t = 1; t < taps.Count; t++) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(rows[t] + i), _mm_set1_ps(taps.Weight[t])));
+                }
+                _mm_storeu_ps(dst + i, acc);
+            }
+        }
+        for (; i < rowFloats; i++) {
+            float acc = 0.0f;
+            for (int t = 0; t < taps.Count; t++) {
+                acc += rows[t][i] * taps.Weight[t];
+            }
+            dst[i] = acc;
+        }
+    }
+
+    // Weighted sum of up to four texels along a row.
+    void FilterColumns(const float* src, const Vector<FilterTaps>& taps, float* dst, bool simd)
+    {
+        for (int x = 0; x < taps.size(); x++, dst += 4) {
+            const FilterTaps& tap = taps[x];
+            if (simd) {
+                __m128 acc = _mm_setzero_ps();
+                for (int t = 0; t < tap.Count; t++) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + tap.Index[t] * 4), _mm_set1_ps(tap.Weight[t])));
+                }
+                _mm_storeu_ps(dst, acc);
+            } else {
+                for (int c = 0; c < 4; c++) {
+                    float acc = 0.0f;
+                    for (int t = 0; t < tap.Count; t++) {
+                        acc += src[tap.Index[t] * 4 + c] * tap.Weight[t];
+                    }
+                    dst[c] = acc;
+                }
+            }
+        }
+    }
+
+    void Downsample(const float* src, int srcWidth, int srcHeight, float* dst, int dstWidth, int dstHeight, bool simd)
+    {
+        Vector<FilterTaps> columnTaps = BuildBoxTaps(srcWidth, dstWidth);
+        Vector<FilterTaps> rowTaps = BuildBoxTaps(srcHeight, dstHeight);
+
+        ParallelRows(dstHeight, srcWidth * 2, [&](int begin, int end) {
+            Vector<float> row(UInt64(srcWidth) * 4);
+            for (int y = begin; y < end; y++) {
+                FilterRows(src, srcWidth * 4, rowTaps[y], row.data(), simd);
+                FilterColumns(row.data(), columnTaps, dst + UInt64(y) * dstWidth * 4, simd);
+            }
+        });
+    }
+
+    float ComputeAlphaCoverage(const UInt8* pixels, int count, float cutoff)
+    {
+        int reference = int(std::ceil(cutoff * 255.0f));
+        UInt64 passing = 0;
+        for (int i = 0; i < count; i++) {
+            passing += pixels[i * 4 + 3] >= reference;
+        }
+        return float(passing) / float(count);
+    }
+
+    // Scales alpha so that the same fraction of texels passes the test as in the top level.
+    void ScaleAlphaToCoverage(UInt8* pixels, int count, float coverage, float cutoff)
+    {
+        UInt32 histogram[256] = {};
+        for (int i = 0; i < count; i++) {
+            histogram[pixels[i * 4 + 3]]++;
+        }
+
+        float target = coverage * count;
+        float accumulated = 0.0f;
+        int threshold = 0;
+        for (int i = 255; i > 0; i--) {
+            accumulated += histogram[i];
+            if (accumulated >= target) {
+                threshold = i;
+                break;
+            }
+        }
+        if (threshold == 0) {
+            return;
+        }
+
+        float scale = (cutoff * 255.0f) / threshold;
+        for (int i = 0; i < count; i++) {
+            UInt8& alpha = pixels[i * 4 + 3];
+            alpha = UInt8(std::min(255.0f, std::ceil(alpha * scale - 0.001f)));
+        }
+    }
+
+    void BuildMipChain(Image& image, bool srgb, float alphaCutoff, bool simd)
+    {
+        if (image.Compressed || image.Levels > 1 || image.Pixels.empty()) {
+            return;
+        }
+
+        const ColorLUT& lut = GetLUT(srgb);
+
+        int levels = 1 + int(std::floor(std::log2(std::max(image.Width, image.Height))));
+        UInt64 totalSize = 0;
+        for (int i = 0; i < levels; i++) {
+            totalSize += UInt64(std::max(1, image.Width >> i)) * std::max(1, image.Height >> i) * 4;
+        }
+        image.Pixels.resize(totalSize);
+
+        int width = image.Width;
+        int height = image.Height;
+        Vector<float> current(UInt64(width) * height * 4);
+        Vector<float> next;
+
+        ParallelRows(height, width, [&](int begin, int end) {
+            DecodePixels(image.Pixels.data() + UInt64(begin) * width * 4, current.data() + UInt64(begin) * width * 4, (end - begin) * width, lut, simd);
+        });
+        float coverage = alphaCutoff > 0.0f ? ComputeAlphaCoverage(image.Pixels.data(), width * height, alphaCutoff) : 0.0f;
+
+        UInt8* level = image.Pixels.data() + UInt64(width) * height * 4;
+        for (int i = 1; i < levels; i++) {
+            int nextWidth = std::max(1, width / 2);
+            int nextHeight = std::max(1, height / 2);
+
+            next.resize(UInt64(nextWidth) * nextHeight * 4);
+            Downsample(current.data(), width, height, next.data(), nextWidth, nextHeight, simd);
+            ParallelRows(nextHeight, nextWidth, [&](int begin, int end) {
+                EncodePixels(next.data() + UInt64(begin) * nextWidth * 4, level + UInt64(begin) * nextWidth * 4, (end - begin) * nextWidth, lut, simd);
+            });
+            if (alphaCutoff > 0.0f) {
+                ScaleAlphaToCoverage(level, nextWidth * nextHeight, coverage, alphaCutoff);
+            }
+
+            level += UInt64(nextWidth) * nextHeight * 4;
+            width = nextWidth;
+            height = nextHeight;
+            std::swap(current, next);
+        }
+        image.Levels = levels;
+    }
+}
+
 void Image::Load(const String& path)
 {
     int channels = 0;
@@ -22,3 +328,51 @@ void Image::Load(const String& path)
     memcpy(Pixels.data(), buffer, Pixels.size());
     delete buffer;
 }
+
+void Image::GenerateMips(bool srgb, float alphaCutoff)
+{
+    BuildMipChain(*this, srgb, alphaCutoff, true);
+}
+
+void Image::BenchmarkMips(int width, int height, int iterations)
+{
+    Image source;
+    source.Width = width;
+    source.Height = height;
+    source.Levels = 1;
+    source.Pixels.resize(UInt64(width) * height * 4);
+
+    UInt32 state = 0x9E3779B9;
+    for (auto& byte : source.Pixels) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        byte = UInt8(state);
+    }
+
+    auto run = [&](bool simd) {
+        float total = 0.0f;
+        for (int i = 0; i < iterations; i++) {
+            Image image = source;
+
+            Timer timer;
+            BuildMipChain(image, true, 0.5f, simd);
+            total += timer.GetElapsed();
+        }
+        return total / iterations;
+    };
+
+#ifdef __AVX2__
+    const char* instructionSet = "AVX2";
+#else
+    const char* instructionSet = "SSE";
+#endif
+
+    float scalar = run(false);
+    float vectorized = run(true);
+    float megapixels = (width * (float)height) / 1000000.0f;
+    LOG_INFO("[Image] Mip chain {0}x{1}: scalar {2} ms ({3} MP/s), {4} {5} ms ({6} MP/s)",
+             width, height,
+             scalar, megapixels / (TO_SECONDS(scalar)),
+             instructionSet, vectorized, megapixels / (TO_SECONDS(vectorized)));
+}
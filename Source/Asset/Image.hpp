@@ -16,4 +16,9 @@ struct Image
     Vector<UInt8> Pixels;
 
     void Load(const String& path);
+
+    // Appends the full mip chain to Pixels, level after level. alphaCutoff > 0 preserves alpha test coverage.
+    void GenerateMips(bool srgb = true, float alphaCutoff = 0.0f);
+
+    static void BenchmarkMips(int width = 4096, int height = 4096, int iterations = 4);
 };
@@ -6,12 +6,49 @@
 #include <Asset/Shader.hpp>
 
 #include <Core/File.hpp>
+#include <Core/Hash.hpp>
 #include <Core/Logger.hpp>
 #include <Core/Assert.hpp>
-#include <RHI/Utilities.hpp>
 
-#include <DXC/dxcapi.h>
-#include <wrl/client.h>
+#if defined(_WIN32)
+    #include <DXC/dxcapi.h>
+#else
+    #include <dxc/dxcapi.h>
+#endif
+#include <algorithm>
+
+// Not D3DUtils::Release, off Windows DXC and D3D12 each define their own IUnknown
+template<typename T>
+static void Release(T* object)
+{
+    if (object) {
+        object->Release();
+    }
+}
+
+// One set of DXC objects per thread, created on first use. They're not safe to share, but they're expensive to recreate.
+struct DXCInstance
+{
+    IDxcUtils* Utils = nullptr;
+    IDxcCompiler* Compiler = nullptr;
+    IDxcIncludeHandler* IncludeHandler = nullptr;
+
+    DXCInstance()
+    {
+        ASSERT(SUCCEEDED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&Utils))), "Failed to create DXC utils!");
+        ASSERT(SUCCEEDED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&Compiler))), "Failed too create DXC compiler!");
+        ASSERT(SUCCEEDED(Utils->CreateDefaultIncludeHandler(&IncludeHandler)), "Failed to create default include handler!");
+    }
+
+    ~DXCInstance()
+    {
+        Release(IncludeHandler);
+        Release(Compiler);
+        Release(Utils);
+    }
+};
+
+static thread_local DXCInstance sDXC;
 
 const char* GetProfileFromType(ShaderType type)
 {
@@ -44,26 +81,34 @@ const char* GetProfileFromType(ShaderType type)
     return "???";
 }
 
-Shader ShaderCompiler::Compile(const String& path, const String& entry, ShaderType type)
+Shader ShaderCompiler::Compile(const String& path, const String& entry, ShaderType type, const Vector<String>& defines)
 {
     Shader result = {};
 
     String wrappedSource = File::ReadFile(path); 
     const char* source = wrappedSource.c_str();
 
-    wchar_t wideTarget[512];
-    swprintf_s(wideTarget, 512, L"%hs", GetProfileFromType(type));
-    
-    wchar_t wideEntry[512];
-    swprintf_s(wideEntry, 512, L"%hs", entry.c_str());
-
-    IDxcUtils* pUtils = nullptr;
-    IDxcCompiler* pCompiler = nullptr;
-    ASSERT(SUCCEEDED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&pUtils))), "Failed to create DXC utils!");
-    ASSERT(SUCCEEDED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler))), "Failed too create DXC compiler!");
-
-    IDxcIncludeHandler* pIncludeHandler = nullptr;
-    ASSERT(SUCCEEDED(pUtils->CreateDefaultIncludeHandler(&pIncludeHandler)), "Failed to create default include handler!");
+    String target = GetProfileFromType(type);
+    WideString wideTarget(target.begin(), target.end());
+    WideString wideEntry(entry.begin(), entry.end());
+
+    IDxcUtils* pUtils = sDXC.Utils;
+    IDxcCompiler* pCompiler = sDXC.Compiler;
+    IDxcIncludeHandler* pIncludeHandler = sDXC.IncludeHandler;
+
+    // DxcDefine only points at the strings, so keep them alive until the compile is done
+    Vector<WideString> defineNames(defines.size());
+    Vector<WideString> defineValues(defines.size());
+    Vector<DxcDefine> dxcDefines(defines.size());
+    for (int i = 0; i < defines.size(); i++) {
+        UInt64 equals = defines[i].find('=');
+        String name = defines[i].substr(0, equals);
+        String value = equals != String::npos ? defines[i].substr(equals + 1) : "1";
+
+        defineNames[i] = WideString(name.begin(), name.end());
+        defineValues[i] = WideString(value.begin(), value.end());
+        dxcDefines[i] = { defineNames[i].c_str(), defineValues[i].c_str() };
+    }
 
     IDxcBlobEncoding* pSourceBlob = nullptr;
     ASSERT(SUCCEEDED(pUtils->CreateBlob(source, wrappedSource.size(), 0, &pSourceBlob)), "Failed to create source blob!");
@@ -78,7 +123,7 @@ Shader ShaderCompiler::Compile(const String& path, const String& entry, ShaderTy
     };
 
     IDxcOperationResult* pResult = nullptr;
-    ASSERT(SUCCEEDED(pCompiler->Compile(pSourceBlob, L"Shader", wideEntry, wideTarget, pArgs, ARRAYSIZE(pArgs), nullptr, 0, pIncludeHandler, &pResult)), "Failed to create result blob!");
+    ASSERT(SUCCEEDED(pCompiler->Compile(pSourceBlob, L"Shader", wideEntry.c_str(), wideTarget.c_str(), pArgs, sizeof(pArgs) / sizeof(pArgs[0]), dxcDefines.data(), (UINT32)dxcDefines.size(), pIncludeHandler, &pResult)), "Failed to create result blob!");
 
     IDxcBlobEncoding* pErrors = nullptr;
     pResult->GetErrorBuffer(&pErrors);
@@ -98,24 +143,100 @@ Shader ShaderCompiler::Compile(const String& path, const String& entry, ShaderTy
     IDxcBlob* pShaderBlob = nullptr;
     pResult->GetResult(&pShaderBlob);
 
+    result.Valid = true;
     result.Type = type;
     result.Bytecode.resize(pShaderBlob->GetBufferSize());
     memcpy(result.Bytecode.data(), pShaderBlob->GetBufferPointer(), pShaderBlob->GetBufferSize());
     LOG_DEBUG("Compiled shader {0}", path.c_str());
 
-    D3DUtils::Release(pShaderBlob);
-    D3DUtils::Release(pErrors);
-    D3DUtils::Release(pResult);
-    D3DUtils::Release(pSourceBlob);
-    D3DUtils::Release(pIncludeHandler);
-    D3DUtils::Release(pCompiler);
-    D3DUtils::Release(pUtils);
+    Release(pShaderBlob);
+    Release(pErrors);
+    Release(pResult);
+    Release(pSourceBlob);
     return result;
 }
 
+UInt64 ShaderCompiler::GetCacheKey(const String& path, const String& entry, ShaderType type, const Vector<String>& defines)
+{
+    UInt64 hash = HASH_SEED;
+
+    Vector<String> visited;
+    hash = HashIncludes(path, hash, visited);
+
+    // Define order doesn't change the output
+    Vector<String> sortedDefines = defines;
+    std::sort(sortedDefines.begin(), sortedDefines.end());
+    for (auto& define : sortedDefines) {
+        hash = HashBytes(define.data(), define.size() + 1, hash);
+    }
+
+    const char* profile = GetProfileFromType(type);
+    hash = HashBytes(profile, strlen(profile), hash);
+    hash = HashBytes(entry.data(), entry.size(), hash);
+
+    UInt64 version = GetCompilerVersion();
+    return HashBytes(&version, sizeof(version), hash);
+}
+
+UInt64 ShaderCompiler::HashIncludes(const String& path, UInt64 hash, Vector<String>& visited)
+{
+    if (std::find(visited.begin(), visited.end(), path) != visited.end()) {
+        return hash;
+    }
+    visited.push_back(path);
+
+    String source = File::ReadFile(path);
+    hash = HashBytes(path.data(), path.size(), hash);
+    hash = HashBytes(source.data(), source.size(), hash);
+
+    String directory = path.substr(0, path.find_last_of('/'));
+    UInt64 cursor = 0;
+    while ((cursor = source.find("#include", cursor)) != String::npos) {
+        UInt64 open = source.find_first_of("\"<", cursor);
+        UInt64 lineEnd = source.find('\n', cursor);
+        cursor += 8;
+        if (open == String::npos || open > lineEnd) {
+            continue;
+        }
+        UInt64 close = source.find_first_of("\">", open + 1);
+        if (close == String::npos || close > lineEnd) {
+            continue;
+        }
+
+        // The include handler resolves from the working directory (every shader includes "Assets/Shaders/...") and falls back to the includer's folder
+        String include = source.substr(open + 1, close - open - 1);
+        if (!File::Exists(include)) {
+            include = directory + '/' + include;
+        }
+        if (!File::Exists(include)) {
+            LOG_WARN("[DXC] Couldn't find include {0} from {1}, cache key won't track it", source.substr(open + 1, close - open - 1), path);
+            continue;
+        }
+        hash = HashIncludes(include, hash, visited);
+    }
+    return hash;
+}
+
+UInt64 ShaderCompiler::GetCompilerVersion()
+{
+    static UInt64 version = []() {
+        UInt32 major = 0;
+        UInt32 minor = 0;
+
+        IDxcVersionInfo* pInfo = nullptr;
+        if (SUCCEEDED(sDXC.Compiler->QueryInterface(IID_PPV_ARGS(&pInfo)))) {
+            pInfo->GetVersion(&major, &minor);
+            pInfo->Release();
+        }
+        return (UInt64(major) << 32) | minor;
+    }();
+    return version;
+}
+
 ID3D12ShaderReflection* ShaderCompiler::Reflect(Shader shader)
 {
     ID3D12ShaderReflection* pReflection = nullptr;
+#if defined(_WIN32)
     
     IDxcUtils* pUtils = nullptr;
     DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&pUtils));
@@ -126,5 +247,6 @@ ID3D12ShaderReflection* ShaderCompiler::Reflect(Shader shader)
     
     ASSERT(SUCCEEDED(pUtils->CreateReflection(&ShaderBuffer, IID_PPV_ARGS(&pReflection))), "Failed to get shader reflection!");
     pUtils->Release();
+#endif
     return pReflection;
 }
@@ -6,7 +6,12 @@
 #pragma once
 
 #include <Core/Common.hpp>
-#include <Agility/d3d12shader.h>
+#if defined(_WIN32)
+    #include <Agility/d3d12shader.h>
+#else
+    // DXC brings its own Windows type stand-ins off Windows, which clash with the D3D12 ones
+    struct ID3D12ShaderReflection;
+#endif
 
 enum class ShaderType
 {
@@ -31,6 +36,14 @@ struct Shader
 class ShaderCompiler
 {
 public:
-    static Shader Compile(const String& path, const String& entry, ShaderType type);
+    // Defines are either "NAME" or "NAME=VALUE"
+    static Shader Compile(const String& path, const String& entry, ShaderType type, const Vector<String>& defines = {});
+    // Null off Windows, only the D3D12 backend reflects
     static ID3D12ShaderReflection* Reflect(Shader shader);
+
+    // Covers the source, every file it includes (transitively), the defines, the profile and the compiler version
+    static UInt64 GetCacheKey(const String& path, const String& entry, ShaderType type, const Vector<String>& defines = {});
+private:
+    static UInt64 HashIncludes(const String& path, UInt64 hash, Vector<String>& visited);
+    static UInt64 GetCompilerVersion();
 };
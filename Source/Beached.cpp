@@ -7,118 +7,377 @@
 
 #include <Core/Random.hpp>
 #include <Core/Logger.hpp>
+#include <Core/Jobs.hpp>
+#include <Core/Profiler.hpp>
+#include <Core/File.hpp>
 #include <UI/Helpers.hpp>
+#include <UI/ProfilerWindow.hpp>
 #include <Asset/AssetCacher.hpp>
 #include <Renderer/PassManager.hpp>
 #include <Renderer/Techniques/Debug.hpp>
+#include <Physics/OcclusionBaker.hpp>
 
 #include <Statistics.hpp>
+#include <SelfTests.hpp>
 #include <imgui.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <sstream>
 
-Beached::Beached()
+Beached::Beached(const Benchmark::Options& benchmark)
+    : mBenchmark(benchmark)
 {
     Timer startupTimer;
     {
         Logger::Init();
+        Profiler::Init();
+        Jobs::Init();
 
-        mWindow = MakeRef<Window>(1920, 1080, "Beached");
-        mRHI = MakeRef<RHI>(mWindow);
+        // Nothing reaches the screen with the null backend, so it doesn't get a real window either
+        mWindow = MakeRef<Window>(1920, 1080, "Beached", mBenchmark.NullRHI);
+        mRHI = MakeRef<RHI>(mWindow, mBenchmark.NullRHI ? RHIBackend::Null : RHIBackend::D3D12);
 
         AssetManager::Init(mRHI);
         AssetCacher::Init("Assets");
         PassManager::Init(mRHI, mWindow);
 
-        mRenderer = MakeRef<Renderer>(mRHI);
-
         // Loading and setup
         Settings::Get().SceneUseSun = true;
-
-        mScene.Models.push_back(AssetManager::Get("Assets/Models/Sponza/Sponza.gltf", AssetType::GLTF));
-        mScene.Sun.Direction = glm::vec3(0.1f, -1.0f, 0.1f);
-        mScene.Sun.Color = glm::vec4(1.0f);
-        mScene.Sun.Strength = 1.0f;
-
-        mScene.Init(mRHI);
-        mRenderer->Bake(mScene);
-        Uploader::Flush();
+        if (mBenchmark.Scenes.empty()) {
+            mBenchmark.Scenes.push_back("Assets/Models/Sponza/Sponza.gltf");
+        }
+        LoadScene(mBenchmark.Scenes[0]);
     }
     LOG_INFO("Starting renderer. Startup took {0} seconds", TO_SECONDS(startupTimer.GetElapsed()));
 }
 
 Beached::~Beached()
 {
-    
+    Jobs::Shutdown();
 }
 
 void Beached::Run()
 {
+    // A headless window never closes
+    if (mWindow->IsHeadless()) {
+        LOG_ERROR("There's nothing to interact with headless, --null-rhi only runs with --benchmark");
+        return;
+    }
+
     while (mWindow->IsOpen()) {
         // Calculate DT
         float time = mTimer.GetElapsed();
         float dt = time - mLastFrame;
         mLastFrame = time;
         dt /= 1000.0f;
-        
-        // Update window
-        mWindow->PollEvents();
 
-        // Handle settings and do camera input
-        mScene.Camera.FreezeFrustum(Settings::Get().FreezeFrustum);
-        if (!Settings::Get().FreezeFrustum) {
-            mFrozenView = mScene.Camera.View();
-            mFrozenProj = mScene.Camera.Projection();
-        } else {
-            Debug::DrawFrustum(mFrozenProj * mFrozenView, glm::vec3(1.0f, 0.0f, 0.0f));
+        Tick(dt, true);
+
+        // Keys a tenth of a second apart, the spline fills in between
+        if (mRecording) {
+            mRecordTime += dt;
+            if (mRecordedPath.IsEmpty() || mRecordTime - mRecordedPath.GetKeys().back().Time >= 0.1f) {
+                mRecordedPath.AddKey(mRecordTime, mScene.Camera.Position(), mScene.Camera.Yaw(), mScene.Camera.Pitch());
+            }
         }
-        if (Settings::Get().DebugDrawSceneOOB) {
-            Debug::DrawBox(glm::mat4(1.0f), mScene.SceneOBB.Min, mScene.SceneOBB.Max, glm::vec3(1.0f, 1.0f, 0.0f));
+    }
+    Jobs::Wait(&mSimulation);
+    mRHI->Wait();
+}
+
+bool Beached::RunBenchmark()
+{
+    Vector<Benchmark::Result> results;
+    for (UInt32 i = 0; i < mBenchmark.Scenes.size() && mWindow->IsOpen(); i++) {
+        if (i > 0) {
+            LoadScene(mBenchmark.Scenes[i]);
         }
 
-        mScene.Camera.Begin();
-        if (ImGui::IsKeyPressed(ImGuiKey_F1, false)) {
-            mUI = !mUI;
+        CameraPath path;
+        if (mBenchmark.CameraPath.empty() || !path.Load(mBenchmark.CameraPath)) {
+            path = CameraPath::Orbit(mScene.SceneOBB, 20.0f);
         }
 
-        // Start frame
-        Frame frame = mRHI->Begin();
-        frame.CommandBuffer->Begin();
+        Benchmark::Result result;
+        result.Scene = mBenchmark.Scenes[i];
+        result.LoadTime = mLoadTime;
 
-        // Render
-        {
-            mScene.Update(frame, frame.FrameIndex);
-            mRenderer->Render(frame, mScene);
+        SampleHistory cpuTimes(mBenchmark.Frames);
+        SampleHistory gpuTimes(mBenchmark.Frames);
+        UInt64 hitches = 0;
+        LOG_INFO("[Benchmark] {0}: {1} frames after {2} warmup frames", result.Scene, mBenchmark.Frames, mBenchmark.Warmup);
+
+        // Fixed timestep, so every run sees the same camera on the same frame. The path loops if it's shorter than the run.
+        for (UInt32 frame = 0; frame < mBenchmark.Warmup + mBenchmark.Frames && mWindow->IsOpen(); frame++) {
+            float time = frame * mBenchmark.Timestep;
+            if (path.GetDuration() > 0.0f) {
+                time = std::fmod(time, path.GetDuration());
+            }
+
+            int width, height;
+            mWindow->PollSize(width, height);
+            CameraPath::Key key = path.Evaluate(time);
+            mScene.Camera.SetPose(key.Position, key.Yaw, key.Pitch, width, height);
+
+            Tick(mBenchmark.Timestep, false);
+
+            Statistics& stats = Statistics::Get();
+            if (frame < mBenchmark.Warmup) {
+                hitches = stats.HitchCount;
+                continue;
+            }
+
+            const SceneSnapshot& snapshot = mScene.Current();
+            cpuTimes.Push(stats.CriticalPath);
+            gpuTimes.Push(mRHI->GetGPUTime());
+            result.Instances += snapshot.Instances.size();
+            result.VisibleInstances += snapshot.Visible.size();
+            result.CulledInstances += snapshot.CulledInstances;
+            result.CulledTriangles += snapshot.CulledTriangles;
+            result.DrawCalls += stats.DrawCallCount;
+            result.Dispatches += stats.DispatchCount;
+
+            Statistics::Update();
+            result.PeakRAM = std::max(result.PeakRAM, stats.UsedRAM);
+            result.PeakVRAM = std::max(result.PeakVRAM, stats.UsedVRAM);
+            result.Frames++;
         }
 
-        // UI
-        {
-            frame.CommandBuffer->BeginMarker("ImGui");
-            frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::ColorWrite);
-            frame.CommandBuffer->SetRenderTargets({ frame.BackbufferView }, nullptr);
-            frame.CommandBuffer->BeginGUI(frame.Width, frame.Height);
-            if (mUI) {
-                UI(frame);
-            } else {
-                Overlay();
-            }
-            frame.CommandBuffer->EndGUI();
-            frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::Present);
-            frame.CommandBuffer->EndMarker();
-        }
-        
-        // End frame
-        frame.CommandBuffer->End();
+        if (result.Frames) {
+            result.Instances /= result.Frames;
+            result.VisibleInstances /= result.Frames;
+            result.CulledInstances /= result.Frames;
+            result.CulledTriangles /= result.Frames;
+            result.DrawCalls /= result.Frames;
+            result.Dispatches /= result.Frames;
+        }
+        result.CPUMean = cpuTimes.GetAverage();
+        result.CPUP50 = cpuTimes.GetPercentile(50.0f);
+        result.CPUP95 = cpuTimes.GetPercentile(95.0f);
+        result.CPUP99 = cpuTimes.GetPercentile(99.0f);
+        result.CPUMax = cpuTimes.GetMax();
+        result.GPUMean = gpuTimes.GetAverage();
+        result.GPUP50 = gpuTimes.GetPercentile(50.0f);
+        result.GPUP95 = gpuTimes.GetPercentile(95.0f);
+        result.GPUP99 = gpuTimes.GetPercentile(99.0f);
+        result.GPUMax = gpuTimes.GetMax();
+        result.Hitches = Statistics::Get().HitchCount - hitches;
+
+        LOG_INFO("[Benchmark] {0}: CPU {1} ms avg, {2} ms p99 / GPU {3} ms avg, {4} ms p99 / {5} hitches", result.Scene, result.CPUMean, result.CPUP99, result.GPUMean, result.GPUP99, result.Hitches);
+        results.push_back(result);
+    }
+
+    Jobs::Wait(&mSimulation);
+    mRHI->Wait();
+    return results.size() == mBenchmark.Scenes.size() && Benchmark::WriteReport(mBenchmark.Report, mBenchmark, results);
+}
+
+void Beached::Tick(float dt, bool interactive)
+{
+    Profiler::NewFrame();
+
+    Statistics& stats = Statistics::Get();
+    Timer frameTimer;
+    Timer stageTimer;
+
+    // Update window
+    {
+        PROFILE_SCOPE("Poll Events");
+        mWindow->PollEvents();
+
+        // Anything the workers handed back to the main thread
+        Jobs::PumpMain();
+    }
+
+    // The instances this frame renders were transformed and culled while the last one recorded
+    stageTimer.Restart();
+    {
+        PROFILE_SCOPE("Wait Simulation");
+        Jobs::Wait(&mSimulation);
+        if (mSimulating) {
+            mScene.Swap();
+            mSimulating = false;
+        }
+    }
+    stats.SimulateWait = stageTimer.GetElapsed();
+
+    // Camera input for this frame. Scripted runs placed it already.
+    if (interactive) {
+        int width, height;
+        mWindow->PollSize(width, height);
+        if (!ImGui::GetIO().WantCaptureMouse) {
+            mScene.Camera.Update(dt, width, height);
+            if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
+                ImVec2 mouse = ImGui::GetMousePos();
+                Pick(mouse.x / width, mouse.y / height);
+            }
+        }
+        mScene.Camera.Begin();
+    }
+
+    // Handle settings and do camera input
+    mScene.Camera.FreezeFrustum(Settings::Get().FreezeFrustum);
+    if (!Settings::Get().FreezeFrustum) {
+        mFrozenView = mScene.Camera.View();
+        mFrozenProj = mScene.Camera.Projection();
+    } else {
+        Debug::DrawFrustum(mFrozenProj * mFrozenView, glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+    if (Settings::Get().DebugDrawSceneOOB) {
+        Debug::DrawBox(glm::mat4(1.0f), mScene.SceneOBB.Min, mScene.SceneOBB.Max, glm::vec3(1.0f, 1.0f, 0.0f));
+    }
+
+    // Instance indices stay the same from one snapshot to the next
+    if (mPicked < mScene.Current().Instances.size()) {
+        const SceneInstance& picked = mScene.Current().Instances[mPicked];
+        Debug::DrawBox(picked.Transform, picked.Primitive->AABB.Min, picked.Primitive->AABB.Max, glm::vec3(1.0f, 0.0f, 1.0f));
+        Debug::DrawRings(mPickPoint, 0.05f, glm::vec3(1.0f, 0.0f, 1.0f), 8);
+    }
+
+    if (ImGui::IsKeyPressed(ImGuiKey_F1, false)) {
+        mUI = !mUI;
+    }
+
+    // Snapshot the state, then transform and cull it on a worker while this frame records from the previous snapshot.
+    // Without pipelining it happens right here and this frame renders it.
+    mScene.Capture();
+    if (Settings::Get().PipelineFrames) {
+        Jobs::Kick([this]() { mScene.Simulate(); }, &mSimulation);
+        mSimulating = true;
+    } else {
+        stageTimer.Restart();
+        mScene.Simulate();
+        mScene.Swap();
+        stats.SimulateWait += stageTimer.GetElapsed();
+    }
+    stats.SimulateTime = mScene.Current().SimulateTime;
+
+    // Either way this frame views the scene from the camera the input just moved, only the culling can lag a frame behind
+    mScene.Refresh();
+
+    // Start frame
+    stageTimer.Restart();
+    Frame frame = mRHI->Begin();
+    if (mCaptureStream) {
+        frame.CommandBuffer->SetRecording(true);
+    }
+    frame.CommandBuffer->Begin();
+
+    // Render
+    {
+        PROFILE_SCOPE("Render");
+        mScene.Update(frame, frame.FrameIndex);
+        mRenderer->Render(frame, mScene);
+    }
+
+    // UI
+    {
+        PROFILE_SCOPE("UI");
+        frame.CommandBuffer->BeginMarker("ImGui");
+        frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::ColorWrite);
+        frame.CommandBuffer->SetRenderTargets({ frame.BackbufferView }, nullptr);
+        frame.CommandBuffer->BeginGUI(frame.Width, frame.Height);
+        if (mUI) {
+            UI(frame);
+        } else {
+            Overlay();
+        }
+        frame.CommandBuffer->EndGUI();
+        frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::Present);
+        frame.CommandBuffer->EndMarker();
+    }
+    
+    // End frame
+    frame.CommandBuffer->End();
+    stats.RecordTime = stageTimer.GetElapsed();
+
+    if (mCaptureStream) {
+        String dump = frame.CommandBuffer->GetStream().Dump();
+        File::WriteBytes("commands.txt", dump.data(), dump.size());
+        LOG_INFO("Captured {0} commands ({1} bytes) to commands.txt", frame.CommandBuffer->GetStream().GetCommandCount(), frame.CommandBuffer->GetStream().GetSize());
+
+        frame.CommandBuffer->SetRecording(mRHI->GetBackend() == RHIBackend::Null);
+        mCaptureStream = false;
+    }
+
+    stageTimer.Restart();
+    {
+        PROFILE_SCOPE("Submit");
         mRHI->Submit({ frame.CommandBuffer });
+    }
+    stats.SubmitTime = stageTimer.GetElapsed();
+
+    stageTimer.Restart();
+    {
+        PROFILE_SCOPE("GPU Wait");
         mRHI->End();
-        mRHI->Present(false);
+    }
+    stats.GPUWait = stageTimer.GetElapsed();
 
-        ImGuiIO& io = ImGui::GetIO();
-        if (!io.WantCaptureMouse)
-            mScene.Camera.Update(dt, frame.Width, frame.Height);
+    stageTimer.Restart();
+    {
+        PROFILE_SCOPE("Present");
+        mRHI->Present(false);
     }
+    stats.PresentTime = stageTimer.GetElapsed();
+
+    stats.CriticalPath = frameTimer.GetElapsed();
+    Statistics::EndFrame(stats.CriticalPath, mRHI->GetGPUTime());
+}
+
+void Beached::LoadScene(const String& path)
+{
+    Timer timer;
+
+    // Nothing can still be reading the old scene
+    Jobs::Wait(&mSimulation);
+    mSimulating = false;
     mRHI->Wait();
+
+    // The passes keep scene state from their bake, they start over too
+    mScene = Scene();
+    mRenderer = MakeRef<Renderer>(mRHI);
+    mPicked = UINT32_MAX;
+
+    mScene.Models.push_back(AssetManager::Get(path, AssetType::GLTF));
+    mScene.Sun.Direction = glm::vec3(0.1f, -1.0f, 0.1f);
+    mScene.Sun.Color = glm::vec4(1.0f);
+    mScene.Sun.Strength = 1.0f;
+
+    mScene.Init(mRHI);
+    mRenderer->Bake(mScene);
+    Uploader::Flush();
+
+    // The first frame has nothing simulated ahead of it
+    mScene.Capture();
+    mScene.Simulate();
+    mScene.Swap();
+
+    mLoadTime = TO_SECONDS(timer.GetElapsed());
+    LOG_INFO("Loaded {0} in {1} seconds", path, mLoadTime);
+}
+
+void Beached::Pick(float x, float y)
+{
+    // Through the snapshot on screen, the other one may be simulating
+    const SceneSnapshot& snapshot = mScene.Current();
+    glm::mat4 invProjView = glm::inverse(snapshot.Camera.Projection() * snapshot.Camera.View());
+    glm::vec2 ndc = glm::vec2(x * 2.0f - 1.0f, 1.0f - y * 2.0f);
+    glm::vec4 nearPoint = invProjView * glm::vec4(ndc, 0.0f, 1.0f);
+    glm::vec4 farPoint = invProjView * glm::vec4(ndc, 1.0f, 1.0f);
+
+    Ray ray;
+    ray.Origin = glm::vec3(nearPoint) / nearPoint.w;
+    ray.Direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - ray.Origin);
+
+    Timer timer;
+    RayHit hit;
+    mPicked = UINT32_MAX;
+    if (snapshot.Rays.Intersect(ray, hit)) {
+        mPicked = hit.Instance;
+        mPickPoint = ray.Origin + ray.Direction * hit.T;
+        LOG_INFO("Picked {0}, triangle {1}, {2:.2f} units away in {3:.3f} ms", snapshot.Instances[hit.Instance].Node->Name, hit.Primitive, hit.T, timer.GetElapsed());
+    }
 }
 
 void Beached::Overlay()
@@ -146,6 +405,59 @@ void Beached::UI(const Frame& frame)
             if (ImGui::MenuItem("Statistics")) {
                 mStatisticsUI = !mStatisticsUI;
             }
+            if (ImGui::MenuItem("Profiler")) {
+                mProfilerUI = !mProfilerUI;
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Tools")) {
+            if (ImGui::MenuItem("Benchmark Mip Generation")) {
+                Image::BenchmarkMips();
+            }
+            if (ImGui::MenuItem("Benchmark Shader Cache")) {
+                AssetCacher::CacheShaders(true);
+                AssetCacher::CacheShaders(false);
+            }
+            if (ImGui::MenuItem("Benchmark Job System")) {
+                // It restarts the pool, nothing can be in flight
+                Jobs::Wait(&mSimulation);
+                Jobs::Benchmark();
+            }
+            if (ImGui::MenuItem("Benchmark File IO")) {
+                File::Benchmark();
+            }
+            if (ImGui::MenuItem("Benchmark Light Clusters")) {
+                LightClusters::Benchmark();
+            }
+            if (ImGui::MenuItem("Benchmark Profiler")) {
+                Profiler::Benchmark();
+            }
+            if (ImGui::MenuItem("Benchmark Debug Draws")) {
+                Debug::Benchmark();
+            }
+            if (ImGui::MenuItem("Benchmark Ray Queries")) {
+                const SceneSnapshot& snapshot = mScene.Current();
+                SceneBVH::Benchmark(snapshot.Rays, snapshot.Camera.View(), snapshot.Camera.Projection(), snapshot.Sun.Direction);
+            }
+            if (ImGui::MenuItem("Benchmark Occlusion Bake")) {
+                OcclusionBaker::Benchmark(mScene.Current().Rays);
+            }
+            if (ImGui::MenuItem("Run Self Tests")) {
+                SelfTests::Run();
+            }
+            if (ImGui::MenuItem("Capture Command Stream")) {
+                mCaptureStream = true;
+            }
+            if (ImGui::MenuItem(mRecording ? "Stop Recording Camera Path" : "Record Camera Path")) {
+                // Saved where --camera can pick it up
+                if (mRecording) {
+                    mRecordedPath.Save("camera_path.txt");
+                } else {
+                    mRecordedPath.Clear();
+                    mRecordTime = 0.0f;
+                }
+                mRecording = !mRecording;
+            }
             ImGui::EndMenu();
         }
 
@@ -154,24 +466,133 @@ void Beached::UI(const Frame& frame)
 
     UI::BeginCornerOverlay();
     ImGui::Text("Version 0.0.1");
-    ImGui::Text("Renderer: Direct3D 12");
+    ImGui::Text(mRHI->GetBackend() == RHIBackend::Null ? "Renderer: Null" : "Renderer: Direct3D 12");
     ImGui::End();
 
     mRenderer->UI(frame, &mRendererUI);
+    ProfilerWindow::Draw(&mProfilerUI);
 
     if (mStatisticsUI) {
         Statistics::Update();
         ImGui::Begin("Statistics", &mStatisticsUI);
 
-        // TODO: Frame times
+        // Frame stages
+        ImGui::Text("Main Thread : %.2f ms", Statistics::Get().CriticalPath);
+        ImGui::Text("  Simulate Wait : %.2f ms", Statistics::Get().SimulateWait);
+        ImGui::Text("  Record : %.2f ms", Statistics::Get().RecordTime);
+        ImGui::Text("  Submit : %.2f ms", Statistics::Get().SubmitTime);
+        ImGui::Text("  GPU Wait : %.2f ms", Statistics::Get().GPUWait);
+        ImGui::Text("  Present : %.2f ms", Statistics::Get().PresentTime);
+        ImGui::Text("Simulate : %.2f ms (%s)", Statistics::Get().SimulateTime, Settings::Get().PipelineFrames ? "worker" : "main thread");
+
+        //
+        ImGui::Separator();
+        //
+
+        // Frame history
+        {
+            Statistics& stats = Statistics::Get();
+            Vector<float> cpuTimes = stats.CPUTimes.GetOrdered();
+            ImGui::PlotLines("##CPUTimes", cpuTimes.data(), cpuTimes.size(), 0, "CPU (ms)", 0.0f, stats.CPUTimes.GetMax() * 1.1f, ImVec2(0, 60));
+
+            if (ImGui::BeginTable("Frame Times", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp)) {
+                ImGui::TableSetupColumn("");
+                ImGui::TableSetupColumn("Mean");
+                ImGui::TableSetupColumn("P50");
+                ImGui::TableSetupColumn("P95");
+                ImGui::TableSetupColumn("P99");
+                ImGui::TableSetupColumn("Max");
+                ImGui::TableHeadersRow();
+
+                auto row = [](const char* name, const SampleHistory& history) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(name);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", history.GetAverage());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", history.GetPercentile(50.0f));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", history.GetPercentile(95.0f));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", history.GetPercentile(99.0f));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", history.GetMax());
+                };
+                row("CPU (ms)", stats.CPUTimes);
+                row("GPU (ms)", stats.GPUTimes);
+                ImGui::EndTable();
+            }
+
+            ImGui::Text("Hitches : %llu (last on frame %llu)", stats.HitchCount, stats.LastHitch);
+            ImGui::SliderFloat("Hitch Factor", &stats.HitchFactor, 1.1f, 5.0f, "%.1fx median");
+            if (ImGui::Button("Export CSV")) {
+                Statistics::ExportCSV("frames.csv");
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Export JSON")) {
+                Statistics::ExportJSON("frames.json");
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Clear")) {
+                Statistics::ClearHistory();
+            }
+        }
+
+        //
+        ImGui::Separator();
+        //
+
+        // GPU passes, in tree order. Passes that haven't run for a second are hidden.
+        const TimingTree& gpu = mRHI->GetGPUTimings();
+        if (ImGui::BeginTable("GPU Passes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp)) {
+            ImGui::TableSetupColumn("GPU Pass");
+            ImGui::TableSetupColumn("Last (ms)");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableSetupColumn("P95 (ms)");
+            ImGui::TableSetupColumn("Max (ms)");
+            ImGui::TableHeadersRow();
+
+            Vector<UInt32> stack(gpu.GetRoots().rbegin(), gpu.GetRoots().rend());
+            while (!stack.empty()) {
+                const TimingTree::Node& node = gpu.GetNodes()[stack.back()];
+                stack.pop_back();
+                if (node.LastFrame + 60 < gpu.GetFrameCount()) {
+                    continue;
+                }
+                stack.insert(stack.end(), node.Children.rbegin(), node.Children.rend());
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::SetCursorPosX(ImGui::GetCursorPosX() + node.Depth * 10.0f);
+                ImGui::TextUnformatted(node.Name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", node.History.GetLast());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", node.History.GetAverage());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", node.History.GetPercentile(95.0f));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", node.History.GetMax());
+            }
+            ImGui::EndTable();
+        }
+
+        //
+        ImGui::Separator();
+        //
 
         // Geometry and RHI
-        ImGui::Text("Instance Count : %llu", Statistics::Get().InstanceCount);
-        ImGui::Text("Culled Instances : %llu", Statistics::Get().CulledInstances);
-        ImGui::Text("Triangle Count : %llu", Statistics::Get().TriangleCount);
-        ImGui::Text("Culled Triangles : %llu", Statistics::Get().CulledTriangles);
-        ImGui::Text("Draw Call Count : %llu", Statistics::Get().DrawCallCount);
-        ImGui::Text("Dispatch Count : %llu", Statistics::Get().DispatchCount);
+        ImGui::Text("Instance Count : %llu", Statistics::Get().InstanceCount.load());
+        ImGui::Text("Culled Instances : %llu", Statistics::Get().CulledInstances.load());
+        ImGui::Text("Triangle Count : %llu", Statistics::Get().TriangleCount.load());
+        ImGui::Text("Culled Triangles : %llu", Statistics::Get().CulledTriangles.load());
+        ImGui::Text("Lights : %zu point, %zu spot (%zu cluster indices)", mScene.Current().PointLights.size(), mScene.Current().SpotLights.size(), mScene.Current().Clusters.GetIndices().size());
+        ImGui::Text("Draw Call Count : %llu", Statistics::Get().DrawCallCount.load());
+        ImGui::Text("Dispatch Count : %llu", Statistics::Get().DispatchCount.load());
+        ImGui::Text("Barriers : %llu in %llu calls", Statistics::Get().BarrierCount.load(), Statistics::Get().BarrierCalls.load());
+        ImGui::Text("Copies : %llu (%.2f kb uploaded)", Statistics::Get().CopyCount.load(), Statistics::Get().UploadBytes.load() / 1024.0f);
+        ImGui::Text("Shadow Views : %llu rendered, %llu reused", Statistics::Get().ShadowViewsRendered.load(), Statistics::Get().ShadowViewsReused.load());
 
         //
         ImGui::Separator();
@@ -7,11 +7,13 @@
 
 #include <Core/Window.hpp>
 #include <Core/Timer.hpp>
+#include <Core/Jobs.hpp>
 
 #include <Asset/AssetManager.hpp>
 
 #include <World/Camera.hpp>
 #include <World/Scene.hpp>
+#include <World/CameraPath.hpp>
 
 #include <RHI/RHI.hpp>
 #include <RHI/Uploader.hpp>
@@ -20,15 +22,24 @@
 #include <Renderer/Renderer.hpp>
 
 #include <Settings.hpp>
+#include <Benchmark.hpp>
 
 class Beached
 {
 public:
-    Beached();
+    Beached(const Benchmark::Options& benchmark = {});
     ~Beached();
 
     void Run();
+    // Goes through the scene list and writes the report. False if it got cut short or the report couldn't be written.
+    // Needs a GPU unless the benchmark runs on the null backend.
+    bool RunBenchmark();
 private:
+    void Tick(float dt, bool interactive);
+    void LoadScene(const String& path);
+    // Selects the instance under a point of the window, in 0-1 from the top left
+    void Pick(float x, float y);
+
     void Overlay();
     void UI(const Frame& frame);
 
@@ -39,13 +50,30 @@ private:
     Timer mTimer;
     float mLastFrame;
     Scene mScene;
+    float mLoadTime = 0.0f;
+
+    Benchmark::Options mBenchmark;
+    bool mRecording = false;
+    float mRecordTime = 0.0f;
+    CameraPath mRecordedPath;
+    // Dumps the next frame's commands
+    bool mCaptureStream = false;
+
+    // Simulation of the next frame, running while the current one records
+    Jobs::Counter mSimulation;
+    bool mSimulating = false;
 
     // UI settings
     bool mUI = false;
     bool mRendererUI = false;
     bool mStatisticsUI = false;
+    bool mProfilerUI = false;
 
     // Saved data
     glm::mat4 mFrozenProj;
     glm::mat4 mFrozenView;
+
+    // Right clicked instance, drawn until the next pick
+    UInt32 mPicked = UINT32_MAX;
+    glm::vec3 mPickPoint;
 };
@@ -0,0 +1,98 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:06:45
+//
+
+#include <Benchmark.hpp>
+#include <Core/Logger.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+Benchmark::Options Benchmark::Parse(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--benchmark") {
+            options.Enabled = true;
+        } else if (arg == "--scene" && hasValue) {
+            options.Scenes.push_back(argv[++i]);
+        } else if (arg == "--camera" && hasValue) {
+            options.CameraPath = argv[++i];
+        } else if (arg == "--frames" && hasValue) {
+            options.Frames = std::max(std::stoul(argv[++i]), 1ul);
+        } else if (arg == "--warmup" && hasValue) {
+            options.Warmup = std::stoul(argv[++i]);
+        } else if (arg == "--timestep" && hasValue) {
+            options.Timestep = std::stof(argv[++i]);
+        } else if (arg == "--report" && hasValue) {
+            options.Report = argv[++i];
+        } else if (arg == "--null-rhi") {
+            options.NullRHI = true;
+        } else {
+            LOG_WARN("[Benchmark] Ignoring argument {0}", arg);
+        }
+    }
+#if !defined(_WIN32)
+    // D3D12 needs Windows, everywhere else the benchmark can only measure the CPU side of the frame
+    if (options.Enabled) {
+        options.NullRHI = true;
+    }
+#endif
+    return options;
+}
+
+bool Benchmark::WriteReport(const String& path, const Options& options, const Vector<Result>& results)
+{
+    std::ofstream stream(path);
+    if (!stream.is_open()) {
+        LOG_ERROR("[Benchmark] Failed to open {0}", path);
+        return false;
+    }
+
+    auto escape = [](const String& text) {
+        String result;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result;
+    };
+
+    stream << "{\"backend\":\"" << (options.NullRHI ? "null" : "d3d12") << "\""
+           << ",\"frames\":" << options.Frames
+           << ",\"warmup\":" << options.Warmup
+           << ",\"timestep\":" << options.Timestep
+           << ",\"camera\":\"" << escape(options.CameraPath.empty() ? "orbit" : options.CameraPath) << "\""
+           << ",\n\"scenes\":[\n";
+    for (UInt32 i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        stream << "{\"scene\":\"" << escape(result.Scene) << "\""
+               << ",\"load_s\":" << result.LoadTime
+               << ",\"frames\":" << result.Frames
+               << ",\"cpu_ms\":{\"mean\":" << result.CPUMean << ",\"p50\":" << result.CPUP50 << ",\"p95\":" << result.CPUP95 << ",\"p99\":" << result.CPUP99 << ",\"max\":" << result.CPUMax << "}"
+               << ",\"gpu_ms\":{\"mean\":" << result.GPUMean << ",\"p50\":" << result.GPUP50 << ",\"p95\":" << result.GPUP95 << ",\"p99\":" << result.GPUP99 << ",\"max\":" << result.GPUMax << "}"
+               << ",\"hitches\":" << result.Hitches
+               << ",\"instances\":" << result.Instances
+               << ",\"visible_instances\":" << result.VisibleInstances
+               << ",\"culled_instances\":" << result.CulledInstances
+               << ",\"culled_triangles\":" << result.CulledTriangles
+               << ",\"draw_calls\":" << result.DrawCalls
+               << ",\"dispatches\":" << result.Dispatches
+               << ",\"peak_ram\":" << result.PeakRAM
+               << ",\"peak_vram\":" << result.PeakVRAM << "}";
+        if (i + 1 < results.size()) {
+            stream << ",";
+        }
+        stream << "\n";
+    }
+    stream << "]}\n";
+
+    LOG_INFO("[Benchmark] Wrote the report for {0} scenes to {1}", results.size(), path);
+    return true;
+}
@@ -0,0 +1,62 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:03:12
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+// Plays a camera path through every scene of a list at a fixed timestep, then writes what it measured.
+// Off Windows it always runs on the null backend, which is how Linux CI tracks culling and draw list building.
+class Benchmark
+{
+public:
+    struct Options
+    {
+        bool Enabled = false;
+        Vector<String> Scenes;
+        // Recorded path, an orbit of the scene bounds when empty
+        String CameraPath;
+        UInt32 Frames = 600;
+        UInt32 Warmup = 60;
+        float Timestep = 1.0f / 60.0f;
+        String Report = "benchmark.json";
+        // Headless and GPU-less, only the CPU side of the frame is measured. Always on for benchmarks off Windows.
+        bool NullRHI = false;
+    };
+
+    // Milliseconds for the times, per frame averages for the counters
+    struct Result
+    {
+        String Scene;
+        float LoadTime = 0.0f;
+        UInt32 Frames = 0;
+
+        float CPUMean = 0.0f;
+        float CPUP50 = 0.0f;
+        float CPUP95 = 0.0f;
+        float CPUP99 = 0.0f;
+        float CPUMax = 0.0f;
+        float GPUMean = 0.0f;
+        float GPUP50 = 0.0f;
+        float GPUP95 = 0.0f;
+        float GPUP99 = 0.0f;
+        float GPUMax = 0.0f;
+        UInt64 Hitches = 0;
+
+        double Instances = 0.0;
+        double VisibleInstances = 0.0;
+        double CulledInstances = 0.0;
+        double CulledTriangles = 0.0;
+        double DrawCalls = 0.0;
+        double Dispatches = 0.0;
+
+        UInt64 PeakRAM = 0;
+        UInt64 PeakVRAM = 0;
+    };
+
+    // --benchmark [--scene path]... [--camera path] [--frames n] [--warmup n] [--timestep seconds] [--report path] [--null-rhi]
+    static Options Parse(int argc, char** argv);
+    static bool WriteReport(const String& path, const Options& options, const Vector<Result>& results);
+};
@@ -3,7 +3,10 @@
 // > Create Time: 2024-12-03 05:54:34
 //
 
-#include <Windows.h>
+#if defined(_WIN32)
+    #include <Windows.h>
+#endif
+#include <cstdlib>
 #include <sstream>
 
 #include <Core/Assert.hpp>
@@ -13,7 +16,11 @@ void Assert::Check(bool condition, const String& fileName, const String& functio
 {
     if (!condition) {
         LOG_CRITICAL("ASSERTION FAILED ({0}:{1} - line {2}): {3}", fileName, function, line, message);
+#if defined(_WIN32)
         MessageBoxA(nullptr, "Assertion Failed! Check output or log files. for details.", "BEACHED", MB_OK | MB_ICONERROR);
         __debugbreak();
+#else
+        std::abort();
+#endif
     }
 }
@@ -0,0 +1,30 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:31:24
+//
+
+#include <Core/Checks.hpp>
+#include <Core/Logger.hpp>
+
+Checks::Checks(const String& name)
+    : mName(name)
+{
+}
+
+void Checks::operator()(bool condition, const char* what)
+{
+    if (!condition) {
+        LOG_ERROR("[{0}] FAILED: {1}", mName, what);
+        mFailures++;
+    }
+}
+
+bool Checks::Finish() const
+{
+    if (Passed()) {
+        LOG_INFO("[{0}] Self test passed", mName);
+    } else {
+        LOG_ERROR("[{0}] Self test failed {1} checks", mName, mFailures);
+    }
+    return Passed();
+}
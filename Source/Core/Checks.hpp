@@ -0,0 +1,24 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:31:08
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+// What the static SelfTest() functions check with. Every failed check is logged under the test's name.
+class Checks
+{
+public:
+    Checks(const String& name);
+
+    void operator()(bool condition, const char* what);
+
+    bool Passed() const { return mFailures == 0; }
+    // Logs a line when every check passed, for tests with nothing more to say
+    bool Finish() const;
+private:
+    String mName;
+    UInt32 mFailures = 0;
+};
@@ -6,13 +6,159 @@
 #include <Core/File.hpp>
 #include <Core/Logger.hpp>
 #include <Core/Assert.hpp>
+#include <Core/Hash.hpp>
 
 #include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <filesystem>
 
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <Windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__)
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+#endif
+
+// Reads never go over this in one call, Win32 takes a DWORD and io_uring a 32-bit length
+constexpr UInt64 MAX_READ_CHUNK = 1ull << 30;
+
+#if defined(_WIN32)
+
+using NativeFile = HANDLE;
+static const NativeFile INVALID_FILE = INVALID_HANDLE_VALUE;
+
+static NativeFile OpenForRead(const String& path)
+{
+    return CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+}
+
+static UInt64 GetNativeSize(NativeFile file)
+{
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size)) {
+        return 0;
+    }
+    return size.QuadPart;
+}
+
+// False on an I/O error. Reaching the end of the file early isn't one, total says how far it got either way.
+static bool ReadAt(NativeFile file, void* data, UInt64 size, UInt64 offset, UInt64& total)
+{
+    total = 0;
+    while (total < size) {
+        UInt64 position = offset + total;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = UInt32(position);
+        overlapped.OffsetHigh = UInt32(position >> 32);
+
+        DWORD read = 0;
+        DWORD chunk = DWORD(std::min(size - total, MAX_READ_CHUNK));
+        if (!::ReadFile(file, static_cast<UInt8*>(data) + total, chunk, &read, &overlapped)) {
+            return GetLastError() == ERROR_HANDLE_EOF;
+        }
+        if (read == 0) {
+            break;
+        }
+        total += read;
+    }
+    return true;
+}
+
+static void CloseNative(NativeFile file)
+{
+    CloseHandle(file);
+}
+
+#else
+
+using NativeFile = int;
+static const NativeFile INVALID_FILE = -1;
+
+static NativeFile OpenForRead(const String& path)
+{
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+static UInt64 GetNativeSize(NativeFile file)
+{
+    struct stat statistics;
+    if (fstat(file, &statistics) == -1) {
+        return 0;
+    }
+    return statistics.st_size;
+}
+
+// False on an I/O error. Reaching the end of the file early isn't one, total says how far it got either way.
+static bool ReadAt(NativeFile file, void* data, UInt64 size, UInt64 offset, UInt64& total)
+{
+    total = 0;
+    while (total < size) {
+        ssize_t read = pread(file, static_cast<UInt8*>(data) + total, std::min(size - total, MAX_READ_CHUNK), offset + total);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read < 0) {
+            return false;
+        }
+        if (read == 0) {
+            break;
+        }
+        total += read;
+    }
+    return true;
+}
+
+static void CloseNative(NativeFile file)
+{
+    close(file);
+}
+
+#endif
+
+// Opens the request's file and sizes its buffer, the one place both read paths agree on what a request means
+static NativeFile PrepareRequest(File::ReadRequest& request)
+{
+    request.Succeeded = false;
+    request.Data.clear();
+
+    NativeFile file = OpenForRead(request.Path);
+    if (file == INVALID_FILE) {
+        LOG_ERROR("File {0} does not exist and cannot be read!", request.Path);
+        return INVALID_FILE;
+    }
+
+    UInt64 available = GetNativeSize(file);
+    available = available > request.Offset ? available - request.Offset : 0;
+    request.Data.resize(request.Size ? std::min(request.Size, available) : available);
+    return file;
+}
+
+static void ReadRequestNow(File::ReadRequest& request)
+{
+    NativeFile file = PrepareRequest(request);
+    if (file == INVALID_FILE) {
+        return;
+    }
+    UInt64 read = 0;
+    request.Succeeded = ReadAt(file, request.Data.data(), request.Data.size(), request.Offset, read);
+    request.Data.resize(read);
+    if (!request.Succeeded) {
+        LOG_ERROR("Failed to read {0}!", request.Path);
+    }
+    CloseNative(file);
+}
 
 bool File::Exists(const String& path)
 {
@@ -30,10 +176,79 @@ bool File::IsDirectory(const String& path)
     return (statistics.st_mode & S_IFDIR) != 0;
 }
 
+String File::GetFileExtension(const String& path)
+{
+    std::filesystem::path fsPath(path);
+    return fsPath.extension().string();
+}
+
+String File::ReadFile(const String& path)
+{
+    NativeFile file = OpenForRead(path);
+    if (file == INVALID_FILE) {
+        LOG_ERROR("File {0} does not exist and cannot be read!", path);
+        return String("");
+    }
+    UInt64 size = GetNativeSize(file);
+    if (size == 0) {
+        LOG_ERROR("File {0} has a size of 0, thus cannot be read!", path);
+        CloseNative(file);
+        return String("");
+    }
+
+    String result(size, '\0');
+    UInt64 read = 0;
+    if (!ReadAt(file, result.data(), size, 0, read)) {
+        LOG_ERROR("Failed to read {0}!", path);
+    }
+    result.resize(read);
+    CloseNative(file);
+    return result;
+}
+
+bool File::ReadBytes(const String& path, void *data, UInt64 size)
+{
+    NativeFile file = OpenForRead(path);
+    if (file == INVALID_FILE) {
+        LOG_ERROR("File {0} does not exist and cannot be read!", path);
+        return false;
+    }
+    UInt64 read = 0;
+    bool succeeded = ReadAt(file, data, size, 0, read);
+    CloseNative(file);
+    return succeeded && read == size;
+}
+
+void *File::ReadBytes(const String& path)
+{
+    NativeFile file = OpenForRead(path);
+    if (file == INVALID_FILE) {
+        LOG_ERROR("File {0} does not exist and cannot be read!", path);
+        return nullptr;
+    }
+    UInt64 size = GetNativeSize(file);
+    if (size == 0) {
+        LOG_ERROR("File {0} has a size of 0, thus cannot be read!", path);
+        CloseNative(file);
+        return nullptr;
+    }
+
+    char *buffer = new char[size + 1];
+    UInt64 read = 0;
+    if (!ReadAt(file, buffer, size, 0, read)) {
+        LOG_ERROR("Failed to read {0}!", path);
+    }
+    buffer[read] = '\0';
+    CloseNative(file);
+    return buffer;
+}
+
+#if defined(_WIN32)
+
 void File::CreateFileFromPath(const String& path)
 {
     HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (!handle) {
+    if (handle == INVALID_HANDLE_VALUE) {
         LOG_ERROR("Error when creating file {0}", path.c_str());
         return;
     }
@@ -83,94 +298,670 @@ void File::Copy(const String& oldPath, const String& newPath, bool overwrite)
     }
 }
 
-String File::GetFileExtension(const String& path)
+UInt64 File::GetFileSize(const String& path)
 {
-    std::filesystem::path fsPath(path);
-    return fsPath.extension().string();
+    // Straight from the directory entry, no need to open the file
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) {
+        LOG_ERROR("File {0} does not exist!", path.c_str());
+        return 0;
+    }
+    return (UInt64(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
 }
 
-int File::GetFileSize(const String& path)
+void File::WriteBytes(const String& path, const void* data, UInt64 size)
 {
-    int result = 0;
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    ASSERT(handle != INVALID_HANDLE_VALUE, "Failed to create file for writing!");
 
-    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (!handle) {
-        LOG_ERROR("File {0} does not exist!", path.c_str());
-        return 0;
+    UInt64 total = 0;
+    while (total < size) {
+        DWORD written = 0;
+        DWORD chunk = DWORD(std::min(size - total, MAX_READ_CHUNK));
+        if (!::WriteFile(handle, static_cast<const UInt8*>(data) + total, chunk, &written, nullptr) || written == 0) {
+            LOG_ERROR("Failed to write {0}", path);
+            break;
+        }
+        total += written;
     }
-    result = ::GetFileSize(handle, nullptr);
     CloseHandle(handle);
+}
+
+File::Filetime File::GetLastModified(const String& path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+    GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes);
+
+    File::Filetime result;
+    result.High = attributes.ftLastWriteTime.dwHighDateTime;
+    result.Low = attributes.ftLastWriteTime.dwLowDateTime;
     return result;
 }
 
-String File::ReadFile(const String& path)
+MappedFile::MappedFile(const String& path)
 {
-    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (!handle) {
-        LOG_ERROR("File {0} does not exist and cannot be read!", path);
-        return String("");
+    HANDLE file = OpenForRead(path);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("File {0} does not exist and cannot be mapped!", path);
+        return;
     }
-    int size = File::GetFileSize(path);
-    if (size == 0) {
-        LOG_ERROR("File {0} has a size of 0, thus cannot be read!", path);
-        return String("");
+    mSize = GetNativeSize(file);
+    if (mSize == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+        mData = static_cast<const UInt8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    if (!mData) {
+        LOG_ERROR("Failed to map file {0}", path);
+        mSize = 0;
     }
-    int bytesRead = 0;
-    char *buffer = new char[size + 1];
-    ::ReadFile(handle, reinterpret_cast<LPVOID>(buffer), size, reinterpret_cast<LPDWORD>(&bytesRead), nullptr);
-    buffer[size] = '\0';
-    CloseHandle(handle);
-    return String(buffer);
 }
 
-void File::ReadBytes(const String& path, void *data, UInt64 size)
+MappedFile::~MappedFile()
 {
-    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (!handle) {
-        LOG_ERROR("File {0} does not exist and cannot be read!", path);
+    if (mData) {
+        UnmapViewOfFile(mData);
     }
-    int bytesRead = 0;
-    ::ReadFile(handle, data, size, reinterpret_cast<LPDWORD>(&bytesRead), nullptr);
-    CloseHandle(handle);
 }
 
-void *File::ReadBytes(const String& path)
+#else
+
+void File::CreateFileFromPath(const String& path)
 {
-    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    if (!handle) {
-        LOG_ERROR("File {0} does not exist and cannot be read!", path);
-        return nullptr;
+    int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file == -1) {
+        LOG_ERROR("Error when creating file {0}", path.c_str());
+        return;
     }
-    int size = File::GetFileSize(path);
-    if (size == 0) {
-        LOG_ERROR("File {0} has a size of 0, thus cannot be read!", path);
-        return nullptr;
+    close(file);
+}
+
+void File::CreateDirectoryFromPath(const String& path)
+{
+    if (mkdir(path.c_str(), 0755) == -1) {
+        LOG_ERROR("Error when creating directory {0}", path.c_str());
     }
-    int bytesRead = 0;
-    char *buffer = new char[size + 1];
-    ::ReadFile(handle, reinterpret_cast<LPVOID>(buffer), size, reinterpret_cast<LPDWORD>(&bytesRead), nullptr);
-    CloseHandle(handle);
-    return buffer;
+}
+
+void File::Delete(const String& path)
+{
+    if (!Exists(path)) {
+        LOG_WARN("Trying to delete file {0} that doesn't exist!", path.c_str());
+        return;
+    }
+
+    if (unlink(path.c_str()) == -1) {
+        LOG_ERROR("Failed to delete file {0}", path.c_str());
+    }
+}
+
+void File::Move(const String& oldPath, const String& newPath)
+{
+    if (!Exists(oldPath)) {
+        LOG_WARN("Trying to move file {0} that doesn't exist!", oldPath.c_str());
+        return;
+    }
+
+    if (rename(oldPath.c_str(), newPath.c_str()) == -1) {
+        LOG_ERROR("Failed to move file {0} to {1}", oldPath.c_str(), newPath.c_str());
+    }
+}
+
+void File::Copy(const String& oldPath, const String& newPath, bool overwrite)
+{
+    if (!Exists(oldPath)) {
+        LOG_WARN("Trying to copy file {0} that doesn't exist!", oldPath.c_str());
+        return;
+    }
+
+    std::error_code error;
+    auto options = overwrite ? std::filesystem::copy_options::overwrite_existing : std::filesystem::copy_options::none;
+    if (!std::filesystem::copy_file(oldPath, newPath, options, error)) {
+        LOG_ERROR("Failed to copy file {0} to {1}", oldPath.c_str(), newPath.c_str());
+    }
+}
+
+UInt64 File::GetFileSize(const String& path)
+{
+    struct stat statistics;
+    if (stat(path.c_str(), &statistics) == -1) {
+        LOG_ERROR("File {0} does not exist!", path.c_str());
+        return 0;
+    }
+    return statistics.st_size;
 }
 
 void File::WriteBytes(const String& path, const void* data, UInt64 size)
 {
-    HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_WRITE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-    ASSERT(handle, "Failed to create file for writing!");
-    int bytesWritten = 0;
-    ::WriteFile(handle, reinterpret_cast<LPCVOID>(data), size, reinterpret_cast<LPDWORD>(&bytesWritten), nullptr);
-    CloseHandle(handle);
+    int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    ASSERT(file != -1, "Failed to create file for writing!");
+
+    UInt64 total = 0;
+    while (total < size) {
+        ssize_t written = write(file, static_cast<const UInt8*>(data) + total, std::min(size - total, MAX_READ_CHUNK));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            LOG_ERROR("Failed to write {0}", path);
+            break;
+        }
+        total += written;
+    }
+    close(file);
 }
 
 File::Filetime File::GetLastModified(const String& path)
 {
-    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
-    FILETIME temp;
-    GetFileTime(handle, nullptr, nullptr, &temp);
-    CloseHandle(handle);
+    struct stat statistics = {};
+    stat(path.c_str(), &statistics);
+
+    // Only ever compared, nanoseconds since the epoch split like a FILETIME
+    UInt64 time = UInt64(statistics.st_mtim.tv_sec) * 1'000'000'000ull + statistics.st_mtim.tv_nsec;
 
     File::Filetime result;
-    result.High = temp.dwHighDateTime;
-    result.Low = temp.dwLowDateTime;
+    result.High = UInt32(time >> 32);
+    result.Low = UInt32(time);
     return result;
 }
+
+MappedFile::MappedFile(const String& path)
+{
+    int file = OpenForRead(path);
+    if (file == -1) {
+        LOG_ERROR("File {0} does not exist and cannot be mapped!", path);
+        return;
+    }
+    mSize = GetNativeSize(file);
+    if (mSize == 0) {
+        close(file);
+        return;
+    }
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("Failed to map file {0}", path);
+        mSize = 0;
+        return;
+    }
+    mData = static_cast<const UInt8*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData) {
+        munmap(const_cast<UInt8*>(mData), mSize);
+    }
+}
+
+#endif
+
+#if defined(__linux__)
+
+// Just enough of io_uring for reads, straight on the syscalls so there's no liburing to ship
+class ReadRing
+{
+public:
+    ReadRing(UInt32 entries)
+    {
+        io_uring_params params = {};
+        mDescriptor = syscall(__NR_io_uring_setup, entries, &params);
+        if (mDescriptor < 0) {
+            return;
+        }
+
+        mSQSize = params.sq_off.array + params.sq_entries * sizeof(UInt32);
+        mCQSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            mSQSize = mCQSize = std::max(mSQSize, mCQSize);
+        }
+
+        mSQ = mmap(nullptr, mSQSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mDescriptor, IORING_OFF_SQ_RING);
+        mCQ = single ? mSQ : mmap(nullptr, mCQSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mDescriptor, IORING_OFF_CQ_RING);
+        mSQESize = params.sq_entries * sizeof(io_uring_sqe);
+        mSQEs = static_cast<io_uring_sqe*>(mmap(nullptr, mSQESize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mDescriptor, IORING_OFF_SQES));
+        if (mSQ == MAP_FAILED || mCQ == MAP_FAILED || mSQEs == MAP_FAILED) {
+            Release();
+            return;
+        }
+
+        UInt8* sq = static_cast<UInt8*>(mSQ);
+        mSQHead = reinterpret_cast<UInt32*>(sq + params.sq_off.head);
+        mSQTail = reinterpret_cast<UInt32*>(sq + params.sq_off.tail);
+        mSQMask = *reinterpret_cast<UInt32*>(sq + params.sq_off.ring_mask);
+        mSQArray = reinterpret_cast<UInt32*>(sq + params.sq_off.array);
+        mSQEntries = params.sq_entries;
+
+        UInt8* cq = static_cast<UInt8*>(mCQ);
+        mCQHead = reinterpret_cast<UInt32*>(cq + params.cq_off.head);
+        mCQTail = reinterpret_cast<UInt32*>(cq + params.cq_off.tail);
+        mCQMask = *reinterpret_cast<UInt32*>(cq + params.cq_off.ring_mask);
+        mCQEntries = params.cq_entries;
+        mCQEs = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        mTail = *mSQTail;
+        mSubmitted = mTail;
+    }
+
+    ~ReadRing()
+    {
+        Release();
+    }
+
+    bool IsValid() const { return mDescriptor >= 0; }
+    // More reads than this in flight can overflow the completion queue, and kernels without IORING_FEAT_NODROP drop what doesn't fit
+    UInt32 GetCompletionCapacity() const { return mCQEntries; }
+
+    // False when the submission queue is full
+    bool QueueRead(int file, void* data, UInt32 size, UInt64 offset, UInt64 tag)
+    {
+        if (mTail - __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE) >= mSQEntries) {
+            return false;
+        }
+
+        UInt32 index = mTail & mSQMask;
+        io_uring_sqe* sqe = &mSQEs[index];
+        memset(sqe, 0, sizeof(io_uring_sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = file;
+        sqe->addr = reinterpret_cast<UInt64>(data);
+        sqe->len = size;
+        sqe->off = offset;
+        sqe->user_data = tag;
+
+        mSQArray[index] = index;
+        mTail++;
+        return true;
+    }
+
+    // Hands what was queued to the kernel and waits for at least wait completions. Negative errno on failure.
+    int Submit(UInt32 wait)
+    {
+        __atomic_store_n(mSQTail, mTail, __ATOMIC_RELEASE);
+        int result = syscall(__NR_io_uring_enter, mDescriptor, mTail - mSubmitted, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (result < 0) {
+            return -errno;
+        }
+        mSubmitted += result;
+        return result;
+    }
+
+    // Waits for completions without submitting anything. Negative errno on failure.
+    int Wait(UInt32 count)
+    {
+        int result = syscall(__NR_io_uring_enter, mDescriptor, 0, count, IORING_ENTER_GETEVENTS, nullptr, 0);
+        return result < 0 ? -errno : result;
+    }
+
+    // Queued but not taken by the kernel yet, these never complete
+    UInt32 GetUnsubmitted() const { return mTail - __atomic_load_n(mSQHead, __ATOMIC_ACQUIRE); }
+
+    bool PopCompletion(io_uring_cqe& completion)
+    {
+        UInt32 head = *mCQHead;
+        if (head == __atomic_load_n(mCQTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        completion = mCQEs[head & mCQMask];
+        __atomic_store_n(mCQHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+private:
+    void Release()
+    {
+        if (mSQEs && mSQEs != MAP_FAILED) munmap(mSQEs, mSQESize);
+        if (mCQ && mCQ != MAP_FAILED && mCQ != mSQ) munmap(mCQ, mCQSize);
+        if (mSQ && mSQ != MAP_FAILED) munmap(mSQ, mSQSize);
+        if (mDescriptor >= 0) close(mDescriptor);
+        mDescriptor = -1;
+        mSQ = mCQ = nullptr;
+        mSQEs = nullptr;
+    }
+
+    int mDescriptor = -1;
+    void* mSQ = nullptr;
+    void* mCQ = nullptr;
+    io_uring_sqe* mSQEs = nullptr;
+    size_t mSQSize = 0;
+    size_t mCQSize = 0;
+    size_t mSQESize = 0;
+
+    UInt32* mSQHead = nullptr;
+    UInt32* mSQTail = nullptr;
+    UInt32* mSQArray = nullptr;
+    UInt32 mSQMask = 0;
+    UInt32 mSQEntries = 0;
+    UInt32* mCQHead = nullptr;
+    UInt32* mCQTail = nullptr;
+    io_uring_cqe* mCQEs = nullptr;
+    UInt32 mCQMask = 0;
+    UInt32 mCQEntries = 0;
+
+    // Queued up to mTail, the kernel has everything before mSubmitted
+    UInt32 mTail = 0;
+    UInt32 mSubmitted = 0;
+};
+
+bool File::ReadBatchRing(Vector<ReadRequest>& requests)
+{
+    ReadRing ring(256);
+    if (!ring.IsValid()) {
+        return false;
+    }
+
+    struct Progress
+    {
+        int Descriptor = -1;
+        UInt64 Done = 0;
+    };
+    Vector<Progress> progress(requests.size());
+    std::deque<UInt32> queue;
+    for (UInt32 i = 0; i < requests.size(); i++) {
+        progress[i].Descriptor = PrepareRequest(requests[i]);
+        if (progress[i].Descriptor == -1) {
+            continue;
+        }
+        if (requests[i].Data.empty()) {
+            requests[i].Succeeded = true;
+            continue;
+        }
+        queue.push_back(i);
+    }
+
+    // Long reads come back short and go around again for the rest
+    UInt32 inFlight = 0;
+    while (!queue.empty() || inFlight) {
+        while (!queue.empty() && inFlight < ring.GetCompletionCapacity()) {
+            UInt32 index = queue.front();
+            ReadRequest& request = requests[index];
+            UInt64 done = progress[index].Done;
+            UInt32 size = UInt32(std::min(request.Data.size() - done, MAX_READ_CHUNK));
+            if (!ring.QueueRead(progress[index].Descriptor, request.Data.data() + done, size, request.Offset + done, index)) {
+                break;
+            }
+            queue.pop_front();
+            inFlight++;
+        }
+
+        // EBUSY means the completion queue is full and keeps coming back until it's reaped, so retries reap first
+        int result = ring.Submit(1);
+        bool retry = result == -EINTR || result == -EAGAIN || result == -EBUSY;
+        if (result < 0 && !retry) {
+            // Whatever the kernel already took can still land in the buffers. Wait for all of it before the descriptors
+            // close, then let the threaded path redo the batch from scratch.
+            LOG_ERROR("[File] io_uring submission failed ({0}), falling back to threaded reads", -result);
+            UInt32 owned = inFlight - ring.GetUnsubmitted();
+            io_uring_cqe completion;
+            while (owned > 0) {
+                if (ring.PopCompletion(completion)) {
+                    owned--;
+                } else if (ring.Wait(1) < 0) {
+                    std::this_thread::yield();
+                }
+            }
+            for (Progress& state : progress) {
+                if (state.Descriptor != -1) {
+                    close(state.Descriptor);
+                }
+            }
+            return false;
+        }
+
+        io_uring_cqe completion;
+        bool reaped = false;
+        while (ring.PopCompletion(completion)) {
+            reaped = true;
+            inFlight--;
+            UInt32 index = UInt32(completion.user_data);
+            ReadRequest& request = requests[index];
+            Progress& state = progress[index];
+
+            if (completion.res == -EINTR || completion.res == -EAGAIN) {
+                queue.push_back(index);
+            } else if (completion.res < 0) {
+                // Old kernels don't know IORING_OP_READ, a plain read still works. A real I/O error fails it again.
+                UInt64 read = 0;
+                request.Succeeded = ReadAt(state.Descriptor, request.Data.data() + state.Done, request.Data.size() - state.Done, request.Offset + state.Done, read);
+                request.Data.resize(state.Done + read);
+                if (!request.Succeeded) {
+                    LOG_ERROR("Failed to read {0}!", request.Path);
+                }
+            } else if (completion.res == 0) {
+                // The file got shorter since it was opened, what's there was read in full
+                request.Data.resize(state.Done);
+                request.Succeeded = true;
+            } else {
+                state.Done += completion.res;
+                if (state.Done < request.Data.size()) {
+                    queue.push_back(index);
+                } else {
+                    request.Succeeded = true;
+                }
+            }
+        }
+        if (retry && !reaped) {
+            std::this_thread::yield();
+        }
+    }
+
+    for (Progress& state : progress) {
+        if (state.Descriptor != -1) {
+            close(state.Descriptor);
+        }
+    }
+    return true;
+}
+
+#else
+
+bool File::ReadBatchRing(Vector<ReadRequest>& requests)
+{
+    return false;
+}
+
+#endif
+
+void File::ReadBatchThreaded(Vector<ReadRequest>& requests)
+{
+    // Every read blocks its thread, so one request per job keeps them all busy
+    Jobs::ParallelFor(requests.size(), [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            ReadRequestNow(requests[i]);
+        }
+    }, 1);
+}
+
+void File::ReadBatch(Vector<ReadRequest>& requests)
+{
+    if (requests.empty()) {
+        return;
+    }
+    if (!ReadBatchRing(requests)) {
+        ReadBatchThreaded(requests);
+    }
+}
+
+void File::ReadBatchAsync(Vector<ReadRequest>& requests, Jobs::Counter* counter)
+{
+    Jobs::Kick([&requests]() {
+        ReadBatch(requests);
+    }, counter);
+}
+
+void File::Benchmark()
+{
+    auto milliseconds = [](auto start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    // Megabytes per second
+    auto throughput = [](UInt64 bytes, float ms) {
+        return ms > 0.0f ? float(double(bytes) / 1000.0 / ms) : 0.0f;
+    };
+
+    constexpr UInt64 LARGE_SIZE = 256ull * 1024 * 1024;
+    constexpr UInt64 LARGE_CHUNK = 16ull * 1024 * 1024;
+    constexpr UInt32 SMALL_COUNT = 2048;
+    constexpr UInt64 SMALL_SIZE = 16 * 1024;
+
+    String directory = ".cache/file_benchmark";
+    if (!Exists(".cache")) {
+        CreateDirectoryFromPath(".cache");
+    }
+    if (!Exists(directory)) {
+        CreateDirectoryFromPath(directory);
+    }
+
+    // Cheap noise so nothing compresses or dedupes along the way
+    UInt64 state = 0x9E3779B97F4A7C15ull;
+    auto fill = [&](Vector<UInt8>& bytes) {
+        for (UInt64 i = 0; i + 8 <= bytes.size(); i += 8) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            memcpy(bytes.data() + i, &state, 8);
+        }
+    };
+
+    String largePath = directory + "/large.bin";
+    UInt64 largeHash = 0;
+    {
+        Vector<UInt8> bytes(LARGE_SIZE);
+        fill(bytes);
+        largeHash = HashBytes(bytes.data(), bytes.size());
+        WriteBytes(largePath, bytes.data(), bytes.size());
+    }
+
+    Vector<String> smallPaths;
+    Vector<UInt64> smallHashes;
+    {
+        Vector<UInt8> bytes(SMALL_SIZE);
+        for (UInt32 i = 0; i < SMALL_COUNT; i++) {
+            fill(bytes);
+            smallPaths.push_back(directory + "/small_" + std::to_string(i) + ".bin");
+            smallHashes.push_back(HashBytes(bytes.data(), bytes.size()));
+            WriteBytes(smallPaths.back(), bytes.data(), bytes.size());
+        }
+    }
+
+    bool passed = true;
+
+    // Large file: one read, mapped, then chunked batches through each path
+    {
+        Vector<UInt8> bytes(LARGE_SIZE);
+        auto start = std::chrono::steady_clock::now();
+        passed &= ReadBytes(largePath, bytes.data(), bytes.size());
+        float single = milliseconds(start);
+        passed &= HashBytes(bytes.data(), bytes.size()) == largeHash;
+
+        start = std::chrono::steady_clock::now();
+        float mapped = 0.0f;
+        {
+            MappedFile file(largePath);
+            // Touch every page, mapping alone reads nothing
+            UInt64 touched = 0;
+            for (UInt64 i = 0; i < file.GetSize(); i += 4096) {
+                touched += file.GetData()[i];
+            }
+            mapped = milliseconds(start);
+            passed &= file.GetSize() == LARGE_SIZE && touched != UINT64_MAX && HashBytes(file.GetData(), file.GetSize()) == largeHash;
+        }
+
+        auto chunked = [&]() {
+            Vector<ReadRequest> requests(LARGE_SIZE / LARGE_CHUNK);
+            for (UInt64 i = 0; i < requests.size(); i++) {
+                requests[i].Path = largePath;
+                requests[i].Offset = i * LARGE_CHUNK;
+                requests[i].Size = LARGE_CHUNK;
+            }
+            return requests;
+        };
+        auto check = [&](const Vector<ReadRequest>& requests) {
+            UInt64 hash = HASH_SEED;
+            for (const ReadRequest& request : requests) {
+                if (!request.Succeeded) {
+                    return false;
+                }
+                hash = HashBytes(request.Data.data(), request.Data.size(), hash);
+            }
+            return hash == largeHash;
+        };
+
+        Vector<ReadRequest> requests = chunked();
+        start = std::chrono::steady_clock::now();
+        ReadBatchThreaded(requests);
+        float threaded = milliseconds(start);
+        passed &= check(requests);
+
+        requests = chunked();
+        start = std::chrono::steady_clock::now();
+        bool ringUsed = ReadBatchRing(requests);
+        float ringed = milliseconds(start);
+        passed &= !ringUsed || check(requests);
+
+        LOG_INFO("[File] {0} MB file: single read {1:.0f} MB/s, mapped {2:.0f} MB/s, {3} threads {4:.0f} MB/s, io_uring {5}",
+                 LARGE_SIZE >> 20, throughput(LARGE_SIZE, single), throughput(LARGE_SIZE, mapped), Jobs::GetThreadCount(), throughput(LARGE_SIZE, threaded),
+                 ringUsed ? std::to_string(UInt32(throughput(LARGE_SIZE, ringed))) + " MB/s" : String("unavailable"));
+    }
+
+    // Small files: one after the other, then batched
+    {
+        UInt64 total = SMALL_COUNT * SMALL_SIZE;
+        Vector<UInt8> bytes(SMALL_SIZE);
+        auto start = std::chrono::steady_clock::now();
+        for (UInt32 i = 0; i < SMALL_COUNT; i++) {
+            passed &= ReadBytes(smallPaths[i], bytes.data(), bytes.size());
+            passed &= HashBytes(bytes.data(), bytes.size()) == smallHashes[i];
+        }
+        float sequential = milliseconds(start);
+
+        auto batch = [&]() {
+            Vector<ReadRequest> requests(SMALL_COUNT);
+            for (UInt32 i = 0; i < SMALL_COUNT; i++) {
+                requests[i].Path = smallPaths[i];
+            }
+            return requests;
+        };
+        auto check = [&](const Vector<ReadRequest>& requests) {
+            for (UInt32 i = 0; i < SMALL_COUNT; i++) {
+                if (!requests[i].Succeeded || HashBytes(requests[i].Data.data(), requests[i].Data.size()) != smallHashes[i]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        Vector<ReadRequest> requests = batch();
+        start = std::chrono::steady_clock::now();
+        ReadBatchThreaded(requests);
+        float threaded = milliseconds(start);
+        passed &= check(requests);
+
+        requests = batch();
+        start = std::chrono::steady_clock::now();
+        bool ringUsed = ReadBatchRing(requests);
+        float ringed = milliseconds(start);
+        passed &= !ringUsed || check(requests);
+
+        LOG_INFO("[File] {0} files of {1} KB: sequential {2:.0f} MB/s ({3:.1f} us/file), threaded {4:.0f} MB/s, io_uring {5}",
+                 SMALL_COUNT, SMALL_SIZE >> 10, throughput(total, sequential), sequential * 1000.0f / SMALL_COUNT, throughput(total, threaded),
+                 ringUsed ? std::to_string(UInt32(throughput(total, ringed))) + " MB/s" : String("unavailable"));
+    }
+
+    // Freshly written, so all of it comes out of the page cache. This measures the read paths, not the disk.
+    Delete(largePath);
+    for (const String& path : smallPaths) {
+        Delete(path);
+    }
+
+    if (passed) {
+        LOG_INFO("[File] Benchmark passed");
+    } else {
+        LOG_ERROR("[File] Benchmark read back wrong data!");
+    }
+}
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <Core/Common.hpp>
+#include <Core/Jobs.hpp>
 
 class File
 {
@@ -24,6 +25,17 @@ public:
         }
     };
 
+    // One read of a batch. A size of 0 reads to the end of the file, Data is shrunk if the file ends early.
+    struct ReadRequest
+    {
+        String Path;
+        UInt64 Offset = 0;
+        UInt64 Size = 0;
+
+        Vector<UInt8> Data;
+        bool Succeeded = false;
+    };
+
     static bool Exists(const String& path);
     static bool IsDirectory(const String& path);
     
@@ -36,11 +48,45 @@ public:
 
     static String GetFileExtension(const String& path);
 
-    static int32_t GetFileSize(const String& path);
+    static UInt64 GetFileSize(const String& path);
     static String ReadFile(const String& path);
-    static void ReadBytes(const String& path, void *data, UInt64 size);
+    // Reads at most size bytes from the start, false if the file couldn't be opened or came up short
+    static bool ReadBytes(const String& path, void *data, UInt64 size);
+    // Caller frees it with delete[]. Null terminated, like ReadFile.
     static void *ReadBytes(const String& path);
     static void WriteBytes(const String& path, const void* data, UInt64 size);
 
     static Filetime GetLastModified(const String& path);
+
+    // Reads every request, through io_uring on Linux when the kernel allows it and on the job system otherwise
+    static void ReadBatch(Vector<ReadRequest>& requests);
+    // Same thing on a worker, the requests have to stay alive until the counter is done
+    static void ReadBatchAsync(Vector<ReadRequest>& requests, Jobs::Counter* counter);
+
+    // One large file and a lot of small ones through every read path, checks the contents and logs the throughput
+    static void Benchmark();
+private:
+    static void ReadBatchThreaded(Vector<ReadRequest>& requests);
+    // False when there's no ring to use, nothing has been read then
+    static bool ReadBatchRing(Vector<ReadRequest>& requests);
+};
+
+// A whole file mapped read-only instead of read. The view lives as long as the object.
+class MappedFile
+{
+public:
+    MappedFile(const String& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Empty files don't map either
+    bool IsValid() const { return mData != nullptr; }
+    const UInt8* GetData() const { return mData; }
+    UInt64 GetSize() const { return mSize; }
+private:
+    // The handles are closed once the view exists, it keeps the file alive on its own
+    const UInt8* mData = nullptr;
+    UInt64 mSize = 0;
 };
@@ -0,0 +1,27 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-22 14:08:51
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+// FNV-1a. Stable across runs and machines, so it's safe to persist.
+inline UInt64 HashBytes(const void* data, UInt64 size, UInt64 hash = HASH_SEED)
+{
+    const UInt8* bytes = (const UInt8*)data;
+    for (UInt64 i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template<typename T>
+inline UInt64 HashValue(const T& value, UInt64 hash = HASH_SEED)
+{
+    return HashBytes(&value, sizeof(T), hash);
+}
@@ -0,0 +1,450 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 16:52:37
+//
+
+#include <Core/Jobs.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Profiler.hpp>
+#include <Core/Checks.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+Jobs::Data Jobs::sData;
+
+// -1 for threads outside the pool
+static thread_local Int32 sThreadIndex = -1;
+static thread_local UInt32 sRandom = 0x9E3779B9;
+
+// Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models". Fixed size, a full deque makes the owner run the
+// job itself.
+class Jobs::Deque
+{
+public:
+    static constexpr Int64 CAPACITY = 8192;
+
+    bool Push(Entry* entry)
+    {
+        Int64 bottom = mBottom.load(std::memory_order_relaxed);
+        Int64 top = mTop.load(std::memory_order_acquire);
+        if (bottom - top >= CAPACITY) {
+            return false;
+        }
+
+        mBuffer[bottom & (CAPACITY - 1)].store(entry, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    Entry* Pop()
+    {
+        Int64 bottom = mBottom.load(std::memory_order_relaxed) - 1;
+        mBottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Int64 top = mTop.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Entry* entry = mBuffer[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last one, race the thieves for it
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                entry = nullptr;
+            }
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return entry;
+    }
+
+    Entry* Steal()
+    {
+        Int64 top = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Int64 bottom = mBottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        Entry* entry = mBuffer[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return entry;
+    }
+private:
+    alignas(64) std::atomic<Int64> mTop = 0;
+    alignas(64) std::atomic<Int64> mBottom = 0;
+    std::atomic<Entry*> mBuffer[CAPACITY];
+};
+
+void Jobs::Init(UInt32 workers)
+{
+    if (workers == 0) {
+        workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    Start(workers);
+}
+
+void Jobs::Start(UInt32 workers)
+{
+    sData.Running = true;
+    sData.MainThread = std::this_thread::get_id();
+    sThreadIndex = 0;
+    for (UInt32 i = 0; i <= workers; i++) {
+        sData.Deques.push_back(MakeRef<Deque>());
+    }
+    for (UInt32 i = 0; i < workers; i++) {
+        sData.Workers.emplace_back(WorkerLoop, i + 1);
+    }
+
+    LOG_INFO("[Jobs] Started {0} worker threads", workers);
+}
+
+void Jobs::Shutdown()
+{
+    // Whatever is still queued runs here, nothing gets dropped
+    while (TryRun(sThreadIndex)) {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sData.SleepLock);
+        sData.Running = false;
+    }
+    sData.Wake.notify_all();
+
+    for (auto& worker : sData.Workers) {
+        worker.join();
+    }
+    sData.Workers.clear();
+    sData.Deques.clear();
+}
+
+bool Jobs::IsMainThread()
+{
+    return std::this_thread::get_id() == sData.MainThread;
+}
+
+void Jobs::Kick(const Job& job, Counter* counter, Counter* dependency)
+{
+    if (counter) {
+        counter->Pending++;
+    }
+
+    Entry* entry = new Entry{ job, counter };
+    if (dependency) {
+        std::lock_guard<std::mutex> lock(dependency->Lock);
+        if (dependency->Pending > 0) {
+            dependency->Waiters.push_back(entry);
+            return;
+        }
+    }
+    Enqueue(entry);
+}
+
+void Jobs::KickOnMain(const Job& job, Counter* counter)
+{
+    if (counter) {
+        counter->Pending++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sData.MainLock);
+        sData.MainOnly.push_back(new Entry{ job, counter });
+    }
+}
+
+void Jobs::Wait(Counter* counter)
+{
+    while (counter->Pending > 0 || counter->Busy > 0) {
+        if (!TryRun(sThreadIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Jobs::PumpMain()
+{
+    while (true) {
+        Entry* entry = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(sData.MainLock);
+            if (sData.MainOnly.empty()) {
+                return;
+            }
+            entry = sData.MainOnly.front();
+            sData.MainOnly.pop_front();
+        }
+        Execute(entry);
+    }
+}
+
+void Jobs::ParallelFor(UInt32 count, const RangeFunction& function, UInt32 grain)
+{
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = std::max(1u, count / (GetThreadCount() * 8));
+    }
+
+    Counter counter;
+    std::function<void(UInt32, UInt32)> split = [&](UInt32 begin, UInt32 end) {
+        while (end - begin > grain) {
+            UInt32 middle = begin + (end - begin) / 2;
+            Kick([&split, middle, end]() { split(middle, end); }, &counter);
+            end = middle;
+        }
+        function(begin, end);
+    };
+    split(0, count);
+    Wait(&counter);
+}
+
+void Jobs::Enqueue(Entry* entry)
+{
+    // No pool, or the deque is full
+    if (sData.Workers.empty()) {
+        Execute(entry);
+        return;
+    }
+
+    // Counted before it's visible so a thief never takes it below zero
+    sData.Queued++;
+    if (sThreadIndex < 0) {
+        std::lock_guard<std::mutex> lock(sData.InjectionLock);
+        sData.Injected.push_back(entry);
+    } else if (!sData.Deques[sThreadIndex]->Push(entry)) {
+        sData.Queued--;
+        Execute(entry);
+        return;
+    }
+
+    // Only pay for the lock when someone is actually asleep
+    if (sData.Sleeping > 0) {
+        std::lock_guard<std::mutex> lock(sData.SleepLock);
+        sData.Wake.notify_one();
+    }
+}
+
+void Jobs::Execute(Entry* entry)
+{
+    entry->Function();
+    if (entry->Batch) {
+        Finish(entry->Batch);
+    }
+    delete entry;
+}
+
+void Jobs::Finish(Counter* counter)
+{
+    counter->Busy++;
+    if (counter->Pending.fetch_sub(1) == 1) {
+        Vector<Entry*> waiters;
+        {
+            std::lock_guard<std::mutex> lock(counter->Lock);
+            waiters.swap(counter->Waiters);
+        }
+        for (Entry* waiter : waiters) {
+            Enqueue(waiter);
+        }
+    }
+    counter->Busy--;
+}
+
+bool Jobs::TryRun(Int32 index)
+{
+    if (sData.Deques.empty()) {
+        return false;
+    }
+
+    Entry* entry = nullptr;
+    if (index == 0) {
+        // Popped under the lock but run outside of it, the job may kick or wait on main-thread work itself
+        {
+            std::lock_guard<std::mutex> lock(sData.MainLock);
+            if (!sData.MainOnly.empty()) {
+                entry = sData.MainOnly.front();
+                sData.MainOnly.pop_front();
+            }
+        }
+        if (entry) {
+            Execute(entry);
+            return true;
+        }
+    }
+
+    if (index >= 0) {
+        entry = sData.Deques[index]->Pop();
+    }
+    if (!entry) {
+        std::lock_guard<std::mutex> lock(sData.InjectionLock);
+        if (!sData.Injected.empty()) {
+            entry = sData.Injected.front();
+            sData.Injected.pop_front();
+        }
+    }
+    if (!entry) {
+        // Random victim so thieves don't all line up behind the same deque
+        sRandom ^= sRandom << 13;
+        sRandom ^= sRandom >> 17;
+        sRandom ^= sRandom << 5;
+
+        UInt32 count = sData.Deques.size();
+        UInt32 start = sRandom % count;
+        for (UInt32 i = 0; i < count && !entry; i++) {
+            UInt32 victim = (start + i) % count;
+            if (static_cast<Int32>(victim) != index) {
+                entry = sData.Deques[victim]->Steal();
+            }
+        }
+    }
+    if (!entry) {
+        return false;
+    }
+
+    sData.Queued--;
+    Execute(entry);
+    return true;
+}
+
+void Jobs::WorkerLoop(Int32 index)
+{
+    sThreadIndex = index;
+    sRandom ^= index * 0x85EBCA6B;
+    Profiler::SetThreadName("Worker " + std::to_string(index));
+    while (true) {
+        if (TryRun(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sData.SleepLock);
+        sData.Sleeping++;
+        sData.Wake.wait(lock, [] { return sData.Queued > 0 || !sData.Running; });
+        sData.Sleeping--;
+        if (!sData.Running) {
+            return;
+        }
+    }
+}
+
+Jobs::Timings Jobs::RunWorkloads(UInt32 elements, UInt32 chainLength, UInt32 tinyJobs, Checks& check)
+{
+    auto milliseconds = [](auto start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    Timings timings;
+
+    // Fork-join over a large range
+    Vector<UInt32> values(elements);
+    auto start = std::chrono::steady_clock::now();
+    ParallelFor(elements, [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            values[i] = i * 3 + 1;
+        }
+    });
+    timings.ForkJoin = milliseconds(start);
+    bool filled = true;
+    for (UInt32 i = 0; i < elements && filled; i++) {
+        filled = values[i] == i * 3 + 1;
+    }
+    check(filled, "fork-join covers the range once");
+
+    // Nested fork-join, every outer job waits on its own inner batch
+    std::atomic<UInt64> nestedSum = 0;
+    start = std::chrono::steady_clock::now();
+    ParallelFor(256, [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            ParallelFor(1024, [&](UInt32 innerBegin, UInt32 innerEnd) {
+                nestedSum += innerEnd - innerBegin;
+            }, 64);
+        }
+    }, 1);
+    timings.Nested = milliseconds(start);
+    check(nestedSum == 256 * 1024, "nested fork-join");
+
+    // Dependency chain, each job only starts once the previous one is done
+    Vector<Counter> chain(chainLength);
+    UInt32 sequence = 0;
+    bool ordered = true;
+    start = std::chrono::steady_clock::now();
+    for (UInt32 i = 0; i < chainLength; i++) {
+        Kick([&, i]() {
+            ordered = ordered && sequence == i;
+            sequence++;
+        }, &chain[i], i > 0 ? &chain[i - 1] : nullptr);
+    }
+    Wait(&chain.back());
+    timings.Dependencies = milliseconds(start);
+    check(ordered && sequence == chainLength, "dependency chain runs in order");
+
+    // Contention, lots of tiny jobs on a single counter
+    std::atomic<UInt32> ran = 0;
+    Counter counter;
+    start = std::chrono::steady_clock::now();
+    for (UInt32 i = 0; i < tinyJobs; i++) {
+        Kick([&]() { ran++; }, &counter);
+    }
+    Wait(&counter);
+    timings.Contention = milliseconds(start);
+    check(ran == tinyJobs, "every tiny job ran");
+
+    return timings;
+}
+
+void Jobs::ForEachPoolSize(const std::function<void(UInt32 threads)>& function)
+{
+    UInt32 previous = sData.Workers.size();
+    for (UInt32 threads : { 1u, 2u, 4u, 8u, 16u, 32u, 64u }) {
+        Shutdown();
+        Start(threads - 1);
+        function(threads);
+    }
+
+    Shutdown();
+    Start(previous);
+}
+
+void Jobs::Benchmark()
+{
+    Checks check("Jobs");
+    ForEachPoolSize([&](UInt32 threads) {
+        constexpr UInt32 CHAIN = 4096;
+        constexpr UInt32 TINY = 200000;
+        Timings timings = RunWorkloads(1 << 22, CHAIN, TINY, check);
+
+        LOG_INFO("[Jobs] {0} threads: fork-join {1:.2f} ms, nested {2:.2f} ms, chain of {3} {4:.2f} ms, {5} tiny jobs {6:.2f} ms ({7:.1f} M jobs/s)",
+                 threads, timings.ForkJoin, timings.Nested, CHAIN, timings.Dependencies, TINY, timings.Contention, TINY / timings.Contention / 1000.0f);
+    });
+
+    if (check.Passed()) {
+        LOG_INFO("[Jobs] Benchmark passed");
+    } else {
+        LOG_ERROR("[Jobs] Benchmark produced wrong results!");
+    }
+}
+
+bool Jobs::SelfTest()
+{
+    Checks check("Jobs");
+    ForEachPoolSize([&](UInt32 threads) {
+        RunWorkloads(1 << 16, 512, 20000, check);
+
+        // A main thread job that queues more main thread work and forks, then waits on both
+        Counter outer;
+        Counter inner;
+        std::atomic<UInt32> ran = 0;
+        KickOnMain([&]() {
+            KickOnMain([&]() { ran++; }, &inner);
+            ParallelFor(1000, [&](UInt32 begin, UInt32 end) { ran += end - begin; }, 10);
+            Wait(&inner);
+        }, &outer);
+        Wait(&outer);
+        check(ran == 1001, "main thread jobs can wait on other jobs");
+    });
+    return check.Finish();
+}
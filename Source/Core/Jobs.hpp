@@ -0,0 +1,110 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 16:40:12
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class Checks;
+
+// A pool of worker threads. Every worker, and the main thread, owns a Chase-Lev deque: the owner pushes and pops at the
+// bottom without locking, idle threads steal from the top of someone else's. Threads that aren't part of the pool go through
+// a locked injection queue. Wait() runs jobs on the calling thread instead of sleeping.
+class Jobs
+{
+private:
+    struct Entry;
+public:
+    using Job = std::function<void()>;
+    using RangeFunction = std::function<void(UInt32 begin, UInt32 end)>;
+
+    // Number of jobs of a batch that haven't finished yet. Jobs kicked with it as a dependency start once it hits zero.
+    struct Counter
+    {
+        std::atomic<UInt32> Pending = 0;
+        // Threads still inside a decrement, the counter can't go away before they're out
+        std::atomic<UInt32> Busy = 0;
+
+        std::mutex Lock;
+        Vector<Entry*> Waiters;
+    };
+
+    // 0 workers means one per core, minus the calling thread which becomes the main thread
+    static void Init(UInt32 workers = 0);
+    static void Shutdown();
+
+    static void Kick(const Job& job, Counter* counter = nullptr, Counter* dependency = nullptr);
+    // For work that has to happen on the main thread, like most D3D12 calls. Runs during Wait() or PumpMain() on it.
+    static void KickOnMain(const Job& job, Counter* counter = nullptr);
+    static void Wait(Counter* counter);
+    static void PumpMain();
+
+    // Calls function over [0, count) in ranges of at most grain items, split in halves so thieves take the big chunks first.
+    // A grain of 0 picks one from the thread count.
+    static void ParallelFor(UInt32 count, const RangeFunction& function, UInt32 grain = 0);
+
+    // Workers plus the main thread
+    static UInt32 GetThreadCount() { return sData.Workers.size() + 1; }
+    static bool IsMainThread();
+
+    // Fork-join, dependency chains and contention from 1 to 64 threads, checks the results and logs the timings
+    static void Benchmark();
+    // The same workloads at a smaller size plus main thread jobs that wait on others, from 1 to 64 threads. Only checks.
+    static bool SelfTest();
+private:
+    struct Entry
+    {
+        Job Function;
+        Counter* Batch = nullptr;
+    };
+
+    // Milliseconds of each workload
+    struct Timings
+    {
+        float ForkJoin;
+        float Nested;
+        float Dependencies;
+        float Contention;
+    };
+    // One pass of the workloads on the current pool
+    static Timings RunWorkloads(UInt32 elements, UInt32 chainLength, UInt32 tinyJobs, Checks& check);
+
+    class Deque;
+
+    static void Start(UInt32 workers);
+    static void Enqueue(Entry* entry);
+    static void Execute(Entry* entry);
+    static void Finish(Counter* counter);
+    static bool TryRun(Int32 index);
+    static void WorkerLoop(Int32 index);
+    // Pools of 1 to 64 threads, the current one comes back after
+    static void ForEachPoolSize(const std::function<void(UInt32 threads)>& function);
+
+    static struct Data
+    {
+        Vector<std::thread> Workers;
+        // Deque 0 belongs to the main thread
+        Vector<::Ref<Deque>> Deques;
+        std::thread::id MainThread;
+
+        std::mutex InjectionLock;
+        std::deque<Entry*> Injected;
+        std::mutex MainLock;
+        std::deque<Entry*> MainOnly;
+
+        std::atomic<bool> Running = false;
+        std::atomic<UInt32> Queued = 0;
+        std::atomic<UInt32> Sleeping = 0;
+        std::mutex SleepLock;
+        std::condition_variable Wake;
+    } sData;
+};
@@ -0,0 +1,350 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 18:05:26
+//
+
+#include <Core/Profiler.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Jobs.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+Profiler::Data Profiler::sData;
+
+// Hands the buffer back when the thread exits, so restarting the job system doesn't grow the list forever
+struct ProfilerThreadSlot
+{
+    Profiler::ThreadBuffer* Buffer = nullptr;
+
+    ~ProfilerThreadSlot()
+    {
+        if (Buffer) {
+            Profiler::ReleaseThreadBuffer(Buffer);
+        }
+    }
+};
+static thread_local ProfilerThreadSlot sSlot;
+
+void Profiler::Init()
+{
+    sData.Origin = std::chrono::steady_clock::now();
+    sData.FrameBegin = Now();
+    SetThreadName("Main");
+}
+
+UInt64 Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sData.Origin).count();
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    if (sSlot.Buffer) {
+        return sSlot.Buffer;
+    }
+
+    std::lock_guard<std::mutex> lock(sData.Lock);
+    for (auto& buffer : sData.Threads) {
+        if (!buffer->Alive) {
+            buffer->Alive = true;
+            buffer->Depth = 0;
+            sSlot.Buffer = buffer.get();
+            return sSlot.Buffer;
+        }
+    }
+
+    ::Ref<ThreadBuffer> buffer = MakeRef<ThreadBuffer>();
+    buffer->Index = sData.Threads.size();
+    buffer->Name = "Thread " + std::to_string(buffer->Index);
+    sData.Threads.push_back(buffer);
+    sSlot.Buffer = buffer.get();
+    return sSlot.Buffer;
+}
+
+void Profiler::ReleaseThreadBuffer(ThreadBuffer* buffer)
+{
+    std::lock_guard<std::mutex> lock(sData.Lock);
+    buffer->Alive = false;
+}
+
+void Profiler::Begin(const char* name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (buffer->Depth < MAX_DEPTH) {
+        buffer->Stack[buffer->Depth] = { name, Now() };
+    }
+    buffer->Depth++;
+}
+
+void Profiler::End()
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    buffer->Depth--;
+    if (buffer->Depth >= MAX_DEPTH) {
+        return;
+    }
+
+    // Single writer, the reader only looks below Head
+    UInt64 head = buffer->Head.load(std::memory_order_relaxed);
+    auto& [name, begin] = buffer->Stack[buffer->Depth];
+    buffer->Zones[head % RING_SIZE] = { name, begin, Now(), buffer->Depth, buffer->Index };
+    buffer->Head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const String& name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(sData.Lock);
+    buffer->Name = name;
+}
+
+String Profiler::GetThreadName(UInt32 thread)
+{
+    std::lock_guard<std::mutex> lock(sData.Lock);
+    return thread < sData.Threads.size() ? sData.Threads[thread]->Name : "Unknown";
+}
+
+const char* Profiler::Intern(const String& name)
+{
+    std::lock_guard<std::mutex> lock(sData.Lock);
+    return sData.Interned.insert(name).first->c_str();
+}
+
+void Profiler::NewFrame()
+{
+    UInt64 now = Now();
+    bool keep = !sData.Paused;
+
+    FrameCapture& frame = sData.History[sData.HistoryHead];
+    frame.Zones.clear();
+
+    Vector<ThreadBuffer*> threads;
+    {
+        std::lock_guard<std::mutex> lock(sData.Lock);
+        for (auto& buffer : sData.Threads) {
+            threads.push_back(buffer.get());
+        }
+    }
+    for (ThreadBuffer* buffer : threads) {
+        UInt64 head = buffer->Head.load(std::memory_order_acquire);
+        // A thread that wrote more than a ring's worth since last frame loses its oldest zones
+        UInt64 tail = std::max(buffer->Tail, head > RING_SIZE ? head - RING_SIZE : 0);
+        if (keep) {
+            for (UInt64 i = tail; i < head; i++) {
+                frame.Zones.push_back(buffer->Zones[i % RING_SIZE]);
+            }
+        }
+        buffer->Tail = head;
+    }
+
+    if (keep) {
+        frame.Index = sData.FrameIndex;
+        frame.Begin = sData.FrameBegin;
+        frame.End = now;
+        Aggregate(frame);
+
+        sData.HistoryHead = (sData.HistoryHead + 1) % HISTORY;
+        sData.FrameCount = std::min(sData.FrameCount + 1, HISTORY);
+    }
+    sData.FrameIndex++;
+    sData.FrameBegin = now;
+}
+
+const Profiler::FrameCapture& Profiler::GetFrame(UInt32 age)
+{
+    return sData.History[(sData.HistoryHead + HISTORY - 1 - age) % HISTORY];
+}
+
+void Profiler::Aggregate(FrameCapture& frame)
+{
+    frame.Tree.clear();
+    frame.Roots.clear();
+
+    // Parents start before their children, and on a tie they're the shallower one
+    std::sort(frame.Zones.begin(), frame.Zones.end(), [](const Zone& a, const Zone& b) {
+        if (a.Thread != b.Thread) return a.Thread < b.Thread;
+        if (a.Begin != b.Begin) return a.Begin < b.Begin;
+        return a.Depth < b.Depth;
+    });
+
+    // Children are few enough that a linear walk beats hashing
+    Vector<Int32> lastChild;
+    auto findChild = [&](Int32 parent, const char* name, UInt32 thread, UInt32 depth) -> Int32 {
+        for (Int32 child = frame.Tree[parent].FirstChild; child != -1; child = frame.Tree[child].NextSibling) {
+            if (frame.Tree[child].Name == name || !strcmp(frame.Tree[child].Name, name)) {
+                return child;
+            }
+        }
+
+        Node node = {};
+        node.Name = name;
+        node.Thread = thread;
+        node.Depth = depth;
+        Int32 index = frame.Tree.size();
+        frame.Tree.push_back(node);
+        lastChild.push_back(-1);
+
+        if (lastChild[parent] == -1) {
+            frame.Tree[parent].FirstChild = index;
+        } else {
+            frame.Tree[lastChild[parent]].NextSibling = index;
+        }
+        lastChild[parent] = index;
+        return index;
+    };
+
+    // Open node at every depth of the thread being walked. A zone whose parent began in an earlier frame hangs off the root.
+    Vector<Int32> path;
+    Int32 root = -1;
+    UInt32 thread = UINT32_MAX;
+    for (const Zone& zone : frame.Zones) {
+        if (zone.Thread != thread) {
+            thread = zone.Thread;
+
+            Node node = {};
+            node.Name = Intern(GetThreadName(thread));
+            node.Thread = thread;
+            root = frame.Tree.size();
+            frame.Tree.push_back(node);
+            lastChild.push_back(-1);
+            frame.Roots.push_back(root);
+            path.clear();
+        }
+
+        Int32 parent = root;
+        if (zone.Depth > 0 && zone.Depth <= path.size() && path[zone.Depth - 1] != -1) {
+            parent = path[zone.Depth - 1];
+        }
+
+        Int32 index = findChild(parent, zone.Name, thread, frame.Tree[parent].Depth + 1);
+        float milliseconds = (zone.End - zone.Begin) / 1000000.0f;
+        frame.Tree[index].Calls++;
+        frame.Tree[index].Milliseconds += milliseconds;
+        if (parent == root) {
+            frame.Tree[root].Milliseconds += milliseconds;
+        }
+
+        path.resize(std::max<size_t>(path.size(), zone.Depth + 1), -1);
+        path[zone.Depth] = index;
+        std::fill(path.begin() + zone.Depth + 1, path.end(), -1);
+    }
+}
+
+bool Profiler::ExportChromeTrace(const String& path)
+{
+    std::ofstream stream(path);
+    if (!stream.is_open()) {
+        LOG_ERROR("[Profiler] Failed to open {0}", path);
+        return false;
+    }
+
+    auto escape = [](const char* name) {
+        String result;
+        for (const char* c = name; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                result += '\\';
+            }
+            result += *c;
+        }
+        return result;
+    };
+
+    stream << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) {
+            stream << ",\n";
+        }
+        first = false;
+    };
+
+    UInt32 threadCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(sData.Lock);
+        threadCount = sData.Threads.size();
+    }
+    for (UInt32 i = 0; i < threadCount; i++) {
+        separator();
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":\"" << escape(GetThreadName(i).c_str()) << "\"}}";
+    }
+
+    UInt32 zones = 0;
+    for (Int32 age = sData.FrameCount - 1; age >= 0; age--) {
+        const FrameCapture& frame = GetFrame(age);
+        separator();
+        stream << "{\"name\":\"Frame " << frame.Index << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << frame.Begin / 1000.0 << "}";
+        for (const Zone& zone : frame.Zones) {
+            separator();
+            stream << "{\"name\":\"" << escape(zone.Name) << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << zone.Thread
+                   << ",\"ts\":" << zone.Begin / 1000.0 << ",\"dur\":" << (zone.End - zone.Begin) / 1000.0 << "}";
+            zones++;
+        }
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    LOG_INFO("[Profiler] Exported {0} zones over {1} frames to {2}", zones, sData.FrameCount, path);
+    return true;
+}
+
+void Profiler::Benchmark()
+{
+    constexpr UInt32 ITERATIONS = 1000000;
+
+    // Nothing the benchmark writes should end up in the history
+    bool paused = sData.Paused;
+    sData.Paused = true;
+    NewFrame();
+
+    UInt64 start = Now();
+    for (UInt32 i = 0; i < ITERATIONS; i++) {
+        Now();
+    }
+    float clock = float(Now() - start) / ITERATIONS;
+
+    start = Now();
+    for (UInt32 i = 0; i < ITERATIONS; i++) {
+        PROFILE_SCOPE("Benchmark");
+    }
+    float single = float(Now() - start) / ITERATIONS;
+    NewFrame();
+
+    // Same thing on every thread at once, the buffers shouldn't share anything
+    UInt32 threads = Jobs::GetThreadCount();
+    start = Now();
+    Jobs::ParallelFor(threads, [&](UInt32 begin, UInt32 end) {
+        for (UInt32 t = begin; t < end; t++) {
+            for (UInt32 i = 0; i < ITERATIONS / 4; i++) {
+                PROFILE_SCOPE("Benchmark");
+            }
+        }
+    }, 1);
+    float parallel = float(Now() - start) / (ITERATIONS / 4);
+    NewFrame();
+
+    // A busy frame: a few thousand nested zones per thread
+    Jobs::ParallelFor(threads, [&](UInt32 begin, UInt32 end) {
+        for (UInt32 t = begin; t < end; t++) {
+            for (UInt32 i = 0; i < 256; i++) {
+                PROFILE_SCOPE("Outer");
+                for (UInt32 j = 0; j < 8; j++) {
+                    PROFILE_SCOPE("Inner");
+                }
+            }
+        }
+    }, 1);
+    sData.Paused = false;
+    start = Now();
+    NewFrame();
+    float drain = (Now() - start) / 1000000.0f;
+    UInt32 drained = GetFrame(0).Zones.size();
+
+    // Drop the synthetic frame again
+    sData.HistoryHead = (sData.HistoryHead + HISTORY - 1) % HISTORY;
+    sData.FrameCount--;
+    sData.Paused = paused;
+
+    LOG_INFO("[Profiler] Clock read {0:.1f} ns, zone {1:.1f} ns on one thread, {2:.1f} ns per zone and thread with {3} threads, {4} zone frame drained in {5:.3f} ms",
+             clock, single, parallel, threads, drained, drain);
+}
@@ -0,0 +1,136 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 18:04:51
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_set>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Names have to outlive the capture, so string literals or Profiler::Intern()
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+
+// Always on. Every thread writes its zones to its own ring buffer without locking, NewFrame() drains them all once per frame
+// and builds the call tree. The last few seconds of frames are kept for the timeline and the trace export.
+class Profiler
+{
+public:
+    static constexpr UInt32 RING_SIZE = 8192;
+    static constexpr UInt32 MAX_DEPTH = 64;
+    static constexpr UInt32 HISTORY = 240;
+
+    struct Zone
+    {
+        const char* Name;
+        // Nanoseconds since Init()
+        UInt64 Begin;
+        UInt64 End;
+        UInt32 Depth;
+        UInt32 Thread;
+    };
+
+    // Zones merged by call path. Every thread with zones in the frame gets a root named after it.
+    struct Node
+    {
+        const char* Name;
+        UInt32 Thread;
+        UInt32 Depth;
+        UInt32 Calls = 0;
+        float Milliseconds = 0.0f;
+
+        Int32 FirstChild = -1;
+        Int32 NextSibling = -1;
+    };
+
+    struct FrameCapture
+    {
+        UInt64 Index = 0;
+        UInt64 Begin = 0;
+        UInt64 End = 0;
+        Vector<Zone> Zones;
+        Vector<Node> Tree;
+        Vector<UInt32> Roots;
+    };
+
+    static void Init();
+
+    // Closes the frame in progress. Main thread, once per frame.
+    static void NewFrame();
+
+    static void Begin(const char* name);
+    static void End();
+
+    static void SetThreadName(const String& name);
+    static String GetThreadName(UInt32 thread);
+    static const char* Intern(const String& name);
+
+    // Zones are still recorded while paused, just not kept
+    static void SetPaused(bool paused) { sData.Paused = paused; }
+    static bool IsPaused() { return sData.Paused; }
+
+    static UInt64 Now();
+    // 0 is the last complete frame
+    static UInt32 GetFrameCount() { return sData.FrameCount; }
+    static const FrameCapture& GetFrame(UInt32 age);
+
+    // Chrome's trace event format, which Perfetto and about://tracing both open
+    static bool ExportChromeTrace(const String& path);
+
+    // Cost of a zone on one and on every thread, and of draining a frame
+    static void Benchmark();
+private:
+    struct ThreadBuffer
+    {
+        String Name;
+        UInt32 Index = 0;
+        bool Alive = true;
+
+        Vector<Zone> Zones = Vector<Zone>(RING_SIZE);
+        std::atomic<UInt64> Head = 0;
+        // Only touched by NewFrame()
+        UInt64 Tail = 0;
+
+        // Only touched by the owner
+        Array<Pair<const char*, UInt64>, MAX_DEPTH> Stack;
+        UInt32 Depth = 0;
+    };
+
+    static ThreadBuffer* GetThreadBuffer();
+    static void ReleaseThreadBuffer(ThreadBuffer* buffer);
+    static void Aggregate(FrameCapture& frame);
+
+    friend struct ProfilerThreadSlot;
+
+    static struct Data
+    {
+        std::chrono::steady_clock::time_point Origin = std::chrono::steady_clock::now();
+
+        std::mutex Lock;
+        Vector<::Ref<ThreadBuffer>> Threads;
+        std::unordered_set<String> Interned;
+
+        Array<FrameCapture, HISTORY> History;
+        UInt32 HistoryHead = 0;
+        UInt32 FrameCount = 0;
+        UInt64 FrameIndex = 0;
+        UInt64 FrameBegin = 0;
+
+        std::atomic<bool> Paused = false;
+    } sData;
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(const char* name) { Profiler::Begin(name); }
+    ~ProfileScope() { Profiler::End(); }
+};
@@ -0,0 +1,95 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:21:08
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// The last few samples of a value, oldest overwritten first
+class SampleHistory
+{
+public:
+    SampleHistory(UInt32 capacity = 256)
+        : mSamples(std::max(capacity, 1u))
+    {
+    }
+
+    void Push(float sample)
+    {
+        mSamples[mHead] = sample;
+        mHead = (mHead + 1) % mSamples.size();
+        mCount = std::min<UInt32>(mCount + 1, mSamples.size());
+    }
+
+    void Clear()
+    {
+        mHead = 0;
+        mCount = 0;
+    }
+
+    UInt32 GetCount() const { return mCount; }
+    UInt32 GetCapacity() const { return mSamples.size(); }
+
+    float GetLast() const
+    {
+        return mCount ? mSamples[(mHead + mSamples.size() - 1) % mSamples.size()] : 0.0f;
+    }
+
+    float GetAverage() const
+    {
+        if (!mCount) {
+            return 0.0f;
+        }
+
+        double sum = 0.0;
+        for (UInt32 i = 0; i < mCount; i++) {
+            sum += mSamples[i];
+        }
+        return float(sum / mCount);
+    }
+
+    float GetMin() const
+    {
+        return mCount ? *std::min_element(mSamples.begin(), mSamples.begin() + mCount) : 0.0f;
+    }
+
+    float GetMax() const
+    {
+        return mCount ? *std::max_element(mSamples.begin(), mSamples.begin() + mCount) : 0.0f;
+    }
+
+    // Nearest rank, percentile goes from 0 to 100
+    float GetPercentile(float percentile) const
+    {
+        if (!mCount) {
+            return 0.0f;
+        }
+
+        Vector<float> sorted(mSamples.begin(), mSamples.begin() + mCount);
+        UInt32 rank = (UInt32)std::ceil(std::clamp(percentile, 0.0f, 100.0f) / 100.0f * mCount);
+        UInt32 index = std::clamp<UInt32>(rank, 1, mCount) - 1;
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+
+    // Oldest first
+    Vector<float> GetOrdered() const
+    {
+        Vector<float> ordered;
+        ordered.reserve(mCount);
+        UInt32 start = (mHead + mSamples.size() - mCount) % mSamples.size();
+        for (UInt32 i = 0; i < mCount; i++) {
+            ordered.push_back(mSamples[(start + i) % mSamples.size()]);
+        }
+        return ordered;
+    }
+private:
+    Vector<float> mSamples;
+    UInt32 mHead = 0;
+    UInt32 mCount = 0;
+};
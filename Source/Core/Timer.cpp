@@ -5,6 +5,8 @@
 
 #include <Core/Timer.hpp>
 
+#if defined(_WIN32)
+
 Timer::Timer()
 {
     QueryPerformanceFrequency(&mFrequency);
@@ -24,3 +26,22 @@ void Timer::Restart()
 {
     QueryPerformanceCounter(&mStart);
 }
+
+#else
+
+Timer::Timer()
+    : mStart(std::chrono::steady_clock::now())
+{
+}
+
+float Timer::GetElapsed()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+}
+
+void Timer::Restart()
+{
+    mStart = std::chrono::steady_clock::now();
+}
+
+#endif
@@ -7,7 +7,11 @@
 
 #define TO_SECONDS(Value) Value / 1000.0f
 
-#include <Windows.h>
+#if defined(_WIN32)
+    #include <Windows.h>
+#else
+    #include <chrono>
+#endif
 
 class Timer
 {
@@ -17,6 +21,10 @@ public:
     float GetElapsed();
     void Restart();
 private:
+#if defined(_WIN32)
     LARGE_INTEGER mFrequency;
     LARGE_INTEGER mStart;
+#else
+    std::chrono::steady_clock::time_point mStart;
+#endif
 };
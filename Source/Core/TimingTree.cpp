@@ -0,0 +1,180 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:25:37
+//
+
+#include <Core/TimingTree.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Checks.hpp>
+
+TimingTree::TimingTree(UInt32 history)
+    : mHistory(history)
+{
+}
+
+void TimingTree::Clear()
+{
+    mNodes.clear();
+    mRoots.clear();
+    mFrame = 0;
+}
+
+UInt32 TimingTree::FindOrAdd(Int32 parent, const String& name, UInt32 depth)
+{
+    const Vector<UInt32>& siblings = parent == -1 ? mRoots : mNodes[parent].Children;
+    for (UInt32 index : siblings) {
+        if (mNodes[index].Name == name) {
+            return index;
+        }
+    }
+
+    Node node;
+    node.Name = name;
+    node.Parent = parent;
+    node.Depth = depth;
+    node.History = SampleHistory(mHistory);
+
+    UInt32 index = mNodes.size();
+    mNodes.push_back(node);
+    if (parent == -1) {
+        mRoots.push_back(index);
+    } else {
+        mNodes[parent].Children.push_back(index);
+    }
+    return index;
+}
+
+void TimingTree::AddFrame(const Vector<Marker>& markers)
+{
+    mFrame++;
+
+    Vector<float> totals(mNodes.size(), 0.0f);
+    Vector<bool> seen(mNodes.size(), false);
+    Vector<UInt32> path;
+    for (const Marker& marker : markers) {
+        // Whatever was open at the depth above is the parent. Without one it goes to the top.
+        Int32 parent = -1;
+        UInt32 depth = 0;
+        if (marker.Depth > 0 && !path.empty()) {
+            depth = std::min<UInt32>(marker.Depth, path.size());
+            parent = path[depth - 1];
+        }
+
+        UInt32 index = FindOrAdd(parent, marker.Name, depth);
+        if (index >= totals.size()) {
+            totals.resize(index + 1, 0.0f);
+            seen.resize(index + 1, false);
+        }
+        totals[index] += marker.Milliseconds;
+        seen[index] = true;
+
+        path.resize(depth + 1);
+        path[depth] = index;
+    }
+
+    for (UInt32 i = 0; i < mNodes.size(); i++) {
+        if (seen[i]) {
+            mNodes[i].History.Push(totals[i]);
+            mNodes[i].LastFrame = mFrame;
+        }
+    }
+}
+
+bool TimingTree::SelfTest()
+{
+    Checks check("Timing Tree");
+    auto close = [](float a, float b) {
+        return std::abs(a - b) < 0.0001f;
+    };
+    auto find = [](const TimingTree& tree, const String& path) -> const Node* {
+        const Node* node = nullptr;
+        UInt64 start = 0;
+        while (start <= path.size()) {
+            UInt64 end = path.find('/', start);
+            String name = path.substr(start, end == String::npos ? String::npos : end - start);
+
+            const Vector<UInt32>& siblings = node ? node->Children : tree.GetRoots();
+            const Node* next = nullptr;
+            for (UInt32 index : siblings) {
+                if (tree.GetNodes()[index].Name == name) {
+                    next = &tree.GetNodes()[index];
+                }
+            }
+            if (!next) {
+                return nullptr;
+            }
+            node = next;
+            if (end == String::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+        return node;
+    };
+
+    // Nesting and repeats under the same parent
+    {
+        TimingTree tree;
+        tree.AddFrame({
+            { "Shadows", 0, 5.0f },
+            { "Cascade", 1, 2.0f },
+            { "Point", 1, 1.0f },
+            { "Cascade", 1, 1.0f },
+            { "GBuffer", 0, 3.0f },
+            { "Draws", 1, 2.5f },
+        });
+
+        check(tree.GetRoots().size() == 2, "two roots");
+        check(find(tree, "Shadows") && close(find(tree, "Shadows")->History.GetLast(), 5.0f), "root time");
+        check(find(tree, "Shadows/Cascade") && close(find(tree, "Shadows/Cascade")->History.GetLast(), 3.0f), "repeats add up");
+        check(find(tree, "Shadows/Point") && close(find(tree, "Shadows/Point")->History.GetLast(), 1.0f), "sibling");
+        check(find(tree, "GBuffer/Draws") && find(tree, "GBuffer/Draws")->Depth == 1, "second root's child");
+        check(!find(tree, "Shadows/Draws"), "no leaking across roots");
+    }
+
+    // A marker deeper than anything open hangs off the deepest open one
+    {
+        TimingTree tree;
+        tree.AddFrame({ { "Orphan", 3, 1.0f } });
+        tree.AddFrame({ { "Root", 0, 2.0f }, { "Deep", 4, 1.0f } });
+
+        check(find(tree, "Orphan") != nullptr, "stray depth goes to the top");
+        check(find(tree, "Root/Deep") && find(tree, "Root/Deep")->Depth == 1, "stray depth clamps to its parent");
+    }
+
+    // Rolling statistics, and frames a marker skipped
+    {
+        TimingTree tree(10);
+        for (int i = 1; i <= 100; i++) {
+            Vector<Marker> markers = { { "Pass", 0, float(i) } };
+            if (i % 2 == 0) {
+                markers.push_back({ "Even", 0, 1.0f });
+            }
+            tree.AddFrame(markers);
+        }
+
+        const Node* pass = find(tree, "Pass");
+        check(pass && pass->History.GetCount() == 10, "history is capped");
+        check(pass && close(pass->History.GetAverage(), 95.5f), "average of the window");
+        check(pass && close(pass->History.GetPercentile(95.0f), 100.0f), "p95 of the window");
+        check(pass && close(pass->History.GetPercentile(50.0f), 95.0f), "median of the window");
+        check(pass && close(pass->History.GetMax(), 100.0f) && close(pass->History.GetMin(), 91.0f), "min and max");
+        check(pass && pass->History.GetOrdered().front() == 91.0f && pass->History.GetOrdered().back() == 100.0f, "oldest first");
+
+        const Node* even = find(tree, "Even");
+        check(even && even->LastFrame == 100 && even->History.GetCount() == 10, "skipped frames don't push samples");
+    }
+
+    // Percentiles on a longer window
+    {
+        SampleHistory history(1000);
+        for (int i = 1; i <= 1000; i++) {
+            history.Push(float(i));
+        }
+        check(close(history.GetPercentile(95.0f), 950.0f), "p95 nearest rank");
+        check(close(history.GetPercentile(99.0f), 990.0f), "p99 nearest rank");
+        check(close(history.GetPercentile(0.0f), 1.0f) && close(history.GetPercentile(100.0f), 1000.0f), "percentile bounds");
+    }
+
+    return check.Finish();
+}
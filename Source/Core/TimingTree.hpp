@@ -0,0 +1,53 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:24:51
+//
+
+#pragma once
+
+#include <Core/SampleHistory.hpp>
+
+// Rolling timings of nested markers, merged by path. A marker showing up several times under the same parent in one frame
+// counts as the sum of its occurrences.
+class TimingTree
+{
+public:
+    // In the order they began
+    struct Marker
+    {
+        String Name;
+        UInt32 Depth;
+        float Milliseconds;
+    };
+
+    struct Node
+    {
+        String Name;
+        Int32 Parent = -1;
+        UInt32 Depth = 0;
+        Vector<UInt32> Children;
+
+        SampleHistory History;
+        // Frame it last showed up in
+        UInt64 LastFrame = 0;
+    };
+
+    TimingTree(UInt32 history = 256);
+
+    void AddFrame(const Vector<Marker>& markers);
+    void Clear();
+
+    const Vector<Node>& GetNodes() const { return mNodes; }
+    const Vector<UInt32>& GetRoots() const { return mRoots; }
+    UInt64 GetFrameCount() const { return mFrame; }
+
+    // Nesting, repeats, stray depths and the rolling statistics against known results
+    static bool SelfTest();
+private:
+    UInt32 FindOrAdd(Int32 parent, const String& name, UInt32 depth);
+
+    UInt32 mHistory;
+    Vector<Node> mNodes;
+    Vector<UInt32> mRoots;
+    UInt64 mFrame = 0;
+};
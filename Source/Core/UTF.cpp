@@ -6,6 +6,7 @@
 #include <Core/UTF.hpp>
 
 #include <codecvt>
+#include <locale>
 
 String UTF::WideToAscii(const wchar_t* psText)
 {
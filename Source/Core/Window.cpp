@@ -6,6 +6,7 @@
 #include <Core/Window.hpp>
 #include <Core/Assert.hpp>
 
+#if defined(_WIN32)
 extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 LRESULT CALLBACK WindowCallback(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
@@ -15,9 +16,16 @@ LRESULT CALLBACK WindowCallback(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lpara
 
     return ::DefWindowProcA(hwnd, msg, wparam, lparam);
 }
+#endif
 
-Window::Window(UInt32 width, UInt32 height, const String& title)
+Window::Window(UInt32 width, UInt32 height, const String& title, bool headless)
+    : mHeadless(headless), mWidth(width), mHeight(height)
 {
+    if (mHeadless) {
+        return;
+    }
+
+#if defined(_WIN32)
     WNDCLASSA windowClass = {};
     windowClass.lpszClassName = "Beached Window Class";
     windowClass.hInstance = ::GetModuleHandleA(nullptr);
@@ -41,31 +49,51 @@ Window::Window(UInt32 width, UInt32 height, const String& title)
     ASSERT(mWindow, "Failed to create window!");
 
     ShowWindow(mWindow, SW_SHOW);
+#else
+    ASSERT(false, "Only headless windows exist off Windows!");
+#endif
 }
 
 Window::~Window()
 {
-    DestroyWindow(mWindow);
+#if defined(_WIN32)
+    if (mWindow) {
+        DestroyWindow(mWindow);
+    }
+#endif
 }
 
 bool Window::IsOpen()
 {
-    return IsWindowVisible(mWindow);
+#if defined(_WIN32)
+    if (!mHeadless) {
+        return IsWindowVisible(mWindow);
+    }
+#endif
+    return true;
 }
 
 void Window::PollEvents()
 {
+#if defined(_WIN32)
     MSG message;
-    while (PeekMessageA(&message, mWindow, 0, 0, PM_REMOVE)) {
+    while (!mHeadless && PeekMessageA(&message, mWindow, 0, 0, PM_REMOVE)) {
         TranslateMessage(&message);
         DispatchMessage(&message);
     }
+#endif
 }
 
 void Window::PollSize(int& width, int& height)
 {
-    RECT rect;
-    GetClientRect(mWindow, &rect);
-    width = rect.right - rect.left;
-    height = rect.bottom - rect.top;
+    width = mWidth;
+    height = mHeight;
+#if defined(_WIN32)
+    if (!mHeadless) {
+        RECT rect;
+        GetClientRect(mWindow, &rect);
+        width = rect.right - rect.left;
+        height = rect.bottom - rect.top;
+    }
+#endif
 }
@@ -5,24 +5,35 @@
 
 #pragma once
 
-#include <Windows.h>
+#if defined(_WIN32)
+    #include <Windows.h>
+#endif
 #include <string>
 
 #include <Core/Common.hpp>
 
+// Headless windows never show up: they stay open at the size they were made with, for the null backend. They're the only kind off Windows.
 class Window
 {
 public:
-    using Ref = Ref<Window>;
+    using Ref = ::Ref<Window>;
 
-    Window(UInt32 width, UInt32 height, const String& title);
+    Window(UInt32 width, UInt32 height, const String& title, bool headless = false);
     ~Window();
 
     bool IsOpen();
     void PollEvents();
     void PollSize(int& width, int& height);
 
+    bool IsHeadless() const { return mHeadless; }
+#if defined(_WIN32)
     HWND GetHandle() { return mWindow; }
+#endif
 private:
-    HWND mWindow;
+    bool mHeadless;
+    UInt32 mWidth;
+    UInt32 mHeight;
+#if defined(_WIN32)
+    HWND mWindow = nullptr;
+#endif
 };
@@ -0,0 +1,215 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:14:40
+//
+
+#include <Physics/BVH.hpp>
+
+#include <algorithm>
+
+static float SurfaceArea(const Box& box)
+{
+    glm::vec3 d = glm::max(box.Max - box.Min, glm::vec3(0.0f));
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static void Grow(Box& box, const Box& other)
+{
+    box.Min = glm::min(box.Min, other.Min);
+    box.Max = glm::max(box.Max, other.Max);
+}
+
+static Box EmptyBox()
+{
+    return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+}
+
+void BVH::Clear()
+{
+    mNodes.clear();
+    mIndices.clear();
+    mBounds = EmptyBox();
+    mDepth = 0;
+}
+
+void BVH::Build(const Vector<Box>& bounds)
+{
+    Clear();
+    if (bounds.empty()) {
+        return;
+    }
+
+    Vector<glm::vec3> centers(bounds.size());
+    mIndices.resize(bounds.size());
+    for (UInt32 i = 0; i < bounds.size(); i++) {
+        centers[i] = (bounds[i].Min + bounds[i].Max) * 0.5f;
+        mIndices[i] = i;
+        Grow(mBounds, bounds[i]);
+    }
+
+    // A binary tree has at most 2n - 1 nodes
+    Vector<BuildNode> nodes;
+    nodes.reserve(bounds.size() * 2);
+    UInt32 root = Split(nodes, bounds, centers, 0, bounds.size(), 0);
+
+    // Collapsing only ever removes levels, so the depth bound of the binary tree holds
+    mNodes.reserve(nodes.size() / 2 + 1);
+    Collapse(nodes, root, 1);
+}
+
+UInt32 BVH::Split(Vector<BuildNode>& nodes, const Vector<Box>& bounds, const Vector<glm::vec3>& centers, UInt32 first, UInt32 count, UInt32 depth)
+{
+    UInt32 index = nodes.size();
+    nodes.push_back({ EmptyBox(), 0, 0, first, count });
+
+    Box centerBounds = EmptyBox();
+    for (UInt32 i = first; i < first + count; i++) {
+        Grow(nodes[index].Bounds, bounds[mIndices[i]]);
+        centerBounds.Min = glm::min(centerBounds.Min, centers[mIndices[i]]);
+        centerBounds.Max = glm::max(centerBounds.Max, centers[mIndices[i]]);
+    }
+    if (count <= MAX_LEAF_SIZE) {
+        return index;
+    }
+
+    // SAH can peel a few primitives off per level on very uneven input. Deep down, halving on the widest axis caps the depth.
+    glm::vec3 extent = centerBounds.Max - centerBounds.Min;
+    if (depth >= MAX_SAH_DEPTH) {
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        UInt32 middle = first + count / 2;
+        std::nth_element(mIndices.data() + first, mIndices.data() + middle, mIndices.data() + first + count, [&](UInt32 a, UInt32 b) {
+            return centers[a][axis] < centers[b][axis];
+        });
+
+        UInt32 left = Split(nodes, bounds, centers, first, middle - first, depth + 1);
+        UInt32 right = Split(nodes, bounds, centers, middle, first + count - middle, depth + 1);
+        nodes[index].Left = left;
+        nodes[index].Right = right;
+        nodes[index].Count = 0;
+        return index;
+    }
+
+    // Binned SAH on every axis, the split goes between two bins
+    int bestAxis = -1;
+    UInt32 bestSplit = 0;
+    float bestCost = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+        if (extent[axis] <= 1e-6f) {
+            continue;
+        }
+
+        Box binBounds[BINS];
+        UInt32 binCounts[BINS] = {};
+        for (UInt32 b = 0; b < BINS; b++) {
+            binBounds[b] = EmptyBox();
+        }
+        float scale = BINS / extent[axis];
+        for (UInt32 i = first; i < first + count; i++) {
+            UInt32 b = std::min(UInt32((centers[mIndices[i]][axis] - centerBounds.Min[axis]) * scale), BINS - 1);
+            binCounts[b]++;
+            Grow(binBounds[b], bounds[mIndices[i]]);
+        }
+
+        // Right to left sweep first, then left to right picks the cheapest split
+        float rightAreas[BINS];
+        UInt32 rightCounts[BINS];
+        Box right = EmptyBox();
+        UInt32 rightCount = 0;
+        for (UInt32 b = BINS - 1; b > 0; b--) {
+            Grow(right, binBounds[b]);
+            rightCount += binCounts[b];
+            rightAreas[b] = SurfaceArea(right);
+            rightCounts[b] = rightCount;
+        }
+
+        Box left = EmptyBox();
+        UInt32 leftCount = 0;
+        for (UInt32 b = 0; b < BINS - 1; b++) {
+            Grow(left, binBounds[b]);
+            leftCount += binCounts[b];
+            if (!leftCount || !rightCounts[b + 1]) {
+                continue;
+            }
+            float cost = leftCount * SurfaceArea(left) + rightCounts[b + 1] * rightAreas[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    // No split when the centers are all on top of each other, the range is halved as it is
+    UInt32 middle = first + count / 2;
+    if (bestAxis >= 0) {
+        float scale = BINS / extent[bestAxis];
+        float minimum = centerBounds.Min[bestAxis];
+        UInt32* split = std::partition(mIndices.data() + first, mIndices.data() + first + count, [&](UInt32 i) {
+            return std::min(UInt32((centers[i][bestAxis] - minimum) * scale), BINS - 1) < bestSplit;
+        });
+        middle = split - mIndices.data();
+    }
+
+    UInt32 left = Split(nodes, bounds, centers, first, middle - first, depth + 1);
+    UInt32 right = Split(nodes, bounds, centers, middle, first + count - middle, depth + 1);
+    nodes[index].Left = left;
+    nodes[index].Right = right;
+    nodes[index].Count = 0;
+    return index;
+}
+
+UInt32 BVH::Collapse(const Vector<BuildNode>& nodes, UInt32 index, UInt32 depth)
+{
+    mDepth = std::max(mDepth, depth);
+
+    // Open the biggest inner child until there are four, or only leaves are left
+    UInt32 children[WIDTH];
+    UInt32 size = 0;
+    if (nodes[index].Count) {
+        children[size++] = index;
+    } else {
+        children[size++] = nodes[index].Left;
+        children[size++] = nodes[index].Right;
+        while (size < WIDTH) {
+            int best = -1;
+            float bestArea = -1.0f;
+            for (UInt32 i = 0; i < size; i++) {
+                const BuildNode& child = nodes[children[i]];
+                if (!child.Count && SurfaceArea(child.Bounds) > bestArea) {
+                    bestArea = SurfaceArea(child.Bounds);
+                    best = i;
+                }
+            }
+            if (best < 0) {
+                break;
+            }
+
+            UInt32 open = children[best];
+            children[best] = nodes[open].Left;
+            children[size++] = nodes[open].Right;
+        }
+    }
+
+    UInt32 nodeIndex = mNodes.size();
+    mNodes.emplace_back();
+
+    Node node = {};
+    node.Size = size;
+    for (UInt32 i = 0; i < size; i++) {
+        const BuildNode& child = nodes[children[i]];
+        node.MinX[i] = child.Bounds.Min.x;
+        node.MinY[i] = child.Bounds.Min.y;
+        node.MinZ[i] = child.Bounds.Min.z;
+        node.MaxX[i] = child.Bounds.Max.x;
+        node.MaxY[i] = child.Bounds.Max.y;
+        node.MaxZ[i] = child.Bounds.Max.z;
+        if (child.Count) {
+            node.Child[i] = child.First;
+            node.Count[i] = child.Count;
+        } else {
+            node.Child[i] = Collapse(nodes, children[i], depth + 1);
+        }
+    }
+    mNodes[nodeIndex] = node;
+    return nodeIndex;
+}
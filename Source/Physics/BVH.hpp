@@ -0,0 +1,260 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:14:02
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+#include <Physics/Ray.hpp>
+#include <Physics/Volume.hpp>
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// Four wide bounding volume hierarchy over boxes. Built top down into a binary tree with binned SAH, then collapsed so every
+// node holds up to four children whose bounds are tested with one SSE slab test. It doesn't know what it indexes: the leaf
+// callbacks given to Traverse intersect the actual primitives.
+class BVH
+{
+public:
+    static constexpr UInt32 WIDTH = 4;
+    static constexpr UInt32 MAX_LEAF_SIZE = 4;
+    static constexpr UInt32 BINS = 16;
+    static constexpr UInt32 STACK_SIZE = 256;
+    // Past this depth the build splits at the median instead, which adds at most 32 more levels for 32-bit counts
+    static constexpr UInt32 MAX_SAH_DEPTH = 48;
+    // Every level of traversal pushes at most WIDTH - 1 siblings that wait for later
+    static_assert((MAX_SAH_DEPTH + 32 + 1) * (WIDTH - 1) + 1 < STACK_SIZE, "BVH can get too deep for the traversal stack!");
+
+    // Two cache lines. Children are packed at the front, the slots past Size are garbage.
+    struct alignas(64) Node
+    {
+        float MinX[WIDTH];
+        float MinY[WIDTH];
+        float MinZ[WIDTH];
+        float MaxX[WIDTH];
+        float MaxY[WIDTH];
+        float MaxZ[WIDTH];
+        // Node index of inner children, first primitive of leaves
+        UInt32 Child[WIDTH];
+        // Primitives in a leaf, 0 for inner children
+        UInt16 Count[WIDTH];
+        UInt32 Size;
+        UInt32 Pad;
+    };
+
+    // Slab test constants of one ray, splatted for the four children
+    struct RaySetup
+    {
+        __m128 OriginX, OriginY, OriginZ;
+        __m128 InvX, InvY, InvZ;
+        __m128 TMin;
+    };
+
+    // Primitives end up reordered, GetIndices() maps the ranges leaves refer to back to the boxes given here
+    void Build(const Vector<Box>& bounds);
+    void Clear();
+
+    bool IsEmpty() const { return mNodes.empty(); }
+    const Vector<UInt32>& GetIndices() const { return mIndices; }
+    const Vector<Node>& GetNodes() const { return mNodes; }
+    Box GetBounds() const { return mBounds; }
+    UInt32 GetDepth() const { return mDepth; }
+
+    static RaySetup Setup(const Ray& ray);
+    // Bit i is set when child i is entered before tMax, at tNear[i]
+    static int IntersectChildren(const Node& node, const RaySetup& ray, float tMax, float* tNear);
+
+    // Visits the leaves the ray reaches front to back. leaf(first, count) intersects primitives [first, first + count),
+    // lowers tMax on a hit and returns true to stop early.
+    template<typename Leaf>
+    void Traverse(const Ray& ray, float& tMax, Leaf&& leaf) const;
+
+    // Same for up to RAY_PACKET_SIZE rays sharing node fetches. leaf(first, count, mask) only looks at the rays in mask and
+    // returns the ones that are done, like occluded rays.
+    template<typename Leaf>
+    void Traverse(const Ray* rays, UInt32 count, float* tMax, Leaf&& leaf) const;
+private:
+    struct BuildNode
+    {
+        Box Bounds;
+        // Children for inner nodes, a range of mIndices for leaves
+        UInt32 Left;
+        UInt32 Right;
+        UInt32 First;
+        UInt32 Count;
+    };
+
+    UInt32 Split(Vector<BuildNode>& nodes, const Vector<Box>& bounds, const Vector<glm::vec3>& centers, UInt32 first, UInt32 count, UInt32 depth);
+    UInt32 Collapse(const Vector<BuildNode>& nodes, UInt32 index, UInt32 depth);
+
+    Vector<Node> mNodes;
+    Vector<UInt32> mIndices;
+    Box mBounds = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    UInt32 mDepth = 0;
+};
+
+inline BVH::RaySetup BVH::Setup(const Ray& ray)
+{
+    // Keep zero components finite, 0 * inf on a slab plane would be NaN
+    auto inverse = [](float d) {
+        return 1.0f / (std::abs(d) > 1e-20f ? d : (d < 0.0f ? -1e-20f : 1e-20f));
+    };
+
+    RaySetup setup;
+    setup.OriginX = _mm_set1_ps(ray.Origin.x);
+    setup.OriginY = _mm_set1_ps(ray.Origin.y);
+    setup.OriginZ = _mm_set1_ps(ray.Origin.z);
+    setup.InvX = _mm_set1_ps(inverse(ray.Direction.x));
+    setup.InvY = _mm_set1_ps(inverse(ray.Direction.y));
+    setup.InvZ = _mm_set1_ps(inverse(ray.Direction.z));
+    setup.TMin = _mm_set1_ps(ray.TMin);
+    return setup;
+}
+
+inline int BVH::IntersectChildren(const Node& node, const RaySetup& ray, float tMax, float* tNear)
+{
+    __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinX), ray.OriginX), ray.InvX);
+    __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinY), ray.OriginY), ray.InvY);
+    __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinZ), ray.OriginZ), ray.InvZ);
+    __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxX), ray.OriginX), ray.InvX);
+    __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxY), ray.OriginY), ray.InvY);
+    __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxZ), ray.OriginZ), ray.InvZ);
+
+    __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), ray.TMin));
+    __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(tMax)));
+    _mm_storeu_ps(tNear, enter);
+    return _mm_movemask_ps(_mm_cmple_ps(enter, exit)) & ((1 << node.Size) - 1);
+}
+
+template<typename Leaf>
+void BVH::Traverse(const Ray& ray, float& tMax, Leaf&& leaf) const
+{
+    if (mNodes.empty()) {
+        return;
+    }
+
+    struct Entry
+    {
+        UInt32 Child;
+        UInt32 Count;
+        float T;
+    };
+
+    RaySetup setup = Setup(ray);
+    Entry stack[STACK_SIZE];
+    UInt32 size = 0;
+    stack[size++] = { 0, 0, ray.TMin };
+    while (size) {
+        Entry entry = stack[--size];
+        if (entry.T > tMax) {
+            continue;
+        }
+        if (entry.Count) {
+            if (leaf(entry.Child, entry.Count)) {
+                return;
+            }
+            continue;
+        }
+
+        const Node& node = mNodes[entry.Child];
+        float tNear[WIDTH];
+        int mask = IntersectChildren(node, setup, tMax, tNear);
+
+        // Sorted far to near, so the nearest child is popped first
+        Entry hits[WIDTH];
+        UInt32 count = 0;
+        while (mask) {
+            int i = std::countr_zero(UInt32(mask));
+            mask &= mask - 1;
+
+            Entry hit = { node.Child[i], node.Count[i], tNear[i] };
+            UInt32 j = count++;
+            for (; j > 0 && hits[j - 1].T < hit.T; j--) {
+                hits[j] = hits[j - 1];
+            }
+            hits[j] = hit;
+        }
+        for (UInt32 i = 0; i < count; i++) {
+            stack[size++] = hits[i];
+        }
+    }
+}
+
+template<typename Leaf>
+void BVH::Traverse(const Ray* rays, UInt32 count, float* tMax, Leaf&& leaf) const
+{
+    if (mNodes.empty() || !count) {
+        return;
+    }
+
+    struct Entry
+    {
+        UInt32 Child;
+        UInt32 Count;
+        UInt32 Mask;
+        float T;
+    };
+
+    RaySetup setups[RAY_PACKET_SIZE];
+    for (UInt32 r = 0; r < count; r++) {
+        setups[r] = Setup(rays[r]);
+    }
+
+    UInt32 active = count >= 32 ? UINT32_MAX : (1u << count) - 1;
+    Entry stack[STACK_SIZE];
+    UInt32 size = 0;
+    stack[size++] = { 0, 0, active, 0.0f };
+    while (size) {
+        Entry entry = stack[--size];
+        UInt32 mask = entry.Mask & active;
+        if (!mask) {
+            continue;
+        }
+        if (entry.Count) {
+            active &= ~leaf(entry.Child, entry.Count, mask);
+            if (!active) {
+                return;
+            }
+            continue;
+        }
+
+        // One node fetch for every ray still in the packet
+        const Node& node = mNodes[entry.Child];
+        UInt32 childMasks[WIDTH] = {};
+        float childT[WIDTH] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+        while (mask) {
+            UInt32 r = std::countr_zero(mask);
+            mask &= mask - 1;
+
+            float tNear[WIDTH];
+            int hit = IntersectChildren(node, setups[r], tMax[r], tNear);
+            while (hit) {
+                int i = std::countr_zero(UInt32(hit));
+                hit &= hit - 1;
+                childMasks[i] |= 1u << r;
+                childT[i] = std::min(childT[i], tNear[i]);
+            }
+        }
+
+        Entry hits[WIDTH];
+        UInt32 hitCount = 0;
+        for (UInt32 i = 0; i < node.Size; i++) {
+            if (!childMasks[i]) {
+                continue;
+            }
+            Entry hit = { node.Child[i], node.Count[i], childMasks[i], childT[i] };
+            UInt32 j = hitCount++;
+            for (; j > 0 && hits[j - 1].T < hit.T; j--) {
+                hits[j] = hits[j - 1];
+            }
+            hits[j] = hit;
+        }
+        for (UInt32 i = 0; i < hitCount; i++) {
+            stack[size++] = hits[i];
+        }
+    }
+}
@@ -0,0 +1,165 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:16:58
+//
+
+#include <Physics/MeshBVH.hpp>
+
+MeshBVH::MeshBVH(const Vector<glm::vec3>& positions, const Vector<UInt32>& indices)
+{
+    Build(positions, indices);
+}
+
+void MeshBVH::Build(const Vector<glm::vec3>& positions, const Vector<UInt32>& indices)
+{
+    UInt32 count = indices.size() / 3;
+    Vector<Box> bounds(count);
+    for (UInt32 i = 0; i < count; i++) {
+        glm::vec3 a = positions[indices[i * 3 + 0]];
+        glm::vec3 b = positions[indices[i * 3 + 1]];
+        glm::vec3 c = positions[indices[i * 3 + 2]];
+        bounds[i] = { glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c)) };
+    }
+    mBVH.Build(bounds);
+
+    // Leaves point at ranges of the reordered triangles, no indirection while tracing
+    const Vector<UInt32>& order = mBVH.GetIndices();
+    mTriangles.resize(count);
+    mOrder.resize(count);
+    for (UInt32 i = 0; i < count; i++) {
+        UInt32 primitive = order[i];
+        glm::vec3 a = positions[indices[primitive * 3 + 0]];
+        glm::vec3 b = positions[indices[primitive * 3 + 1]];
+        glm::vec3 c = positions[indices[primitive * 3 + 2]];
+        mTriangles[i] = { a, b - a, c - a, primitive };
+        mOrder[primitive] = i;
+    }
+}
+
+bool MeshBVH::IntersectTriangle(const Triangle& triangle, const Ray& ray, float tMax, float& t, float& u, float& v)
+{
+    // Möller-Trumbore, both sides
+    glm::vec3 p = glm::cross(ray.Direction, triangle.Edge2);
+    float determinant = glm::dot(triangle.Edge1, p);
+    if (std::abs(determinant) < 1e-12f) {
+        return false;
+    }
+    float inverse = 1.0f / determinant;
+
+    glm::vec3 s = ray.Origin - triangle.V0;
+    u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+
+    glm::vec3 q = glm::cross(s, triangle.Edge1);
+    v = glm::dot(ray.Direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+
+    t = glm::dot(triangle.Edge2, q) * inverse;
+    return t >= ray.TMin && t < tMax;
+}
+
+bool MeshBVH::Intersect(const Ray& ray, RayHit& hit) const
+{
+    bool found = false;
+    float tMax = std::min(ray.TMax, hit.T);
+    mBVH.Traverse(ray, tMax, [&](UInt32 first, UInt32 count) {
+        for (UInt32 i = first; i < first + count; i++) {
+            float t, u, v;
+            if (IntersectTriangle(mTriangles[i], ray, tMax, t, u, v)) {
+                tMax = t;
+                hit.T = t;
+                hit.U = u;
+                hit.V = v;
+                hit.Primitive = mTriangles[i].Primitive;
+                found = true;
+            }
+        }
+        return false;
+    });
+    return found;
+}
+
+bool MeshBVH::Occluded(const Ray& ray) const
+{
+    bool occluded = false;
+    float tMax = ray.TMax;
+    mBVH.Traverse(ray, tMax, [&](UInt32 first, UInt32 count) {
+        for (UInt32 i = first; i < first + count; i++) {
+            float t, u, v;
+            if (IntersectTriangle(mTriangles[i], ray, tMax, t, u, v)) {
+                occluded = true;
+                return true;
+            }
+        }
+        return false;
+    });
+    return occluded;
+}
+
+void MeshBVH::Intersect(const Ray* rays, RayHit* hits, UInt32 count) const
+{
+    float tMax[RAY_PACKET_SIZE];
+    for (UInt32 r = 0; r < count; r++) {
+        tMax[r] = std::min(rays[r].TMax, hits[r].T);
+    }
+
+    mBVH.Traverse(rays, count, tMax, [&](UInt32 first, UInt32 size, UInt32 mask) {
+        while (mask) {
+            UInt32 r = std::countr_zero(mask);
+            mask &= mask - 1;
+            for (UInt32 i = first; i < first + size; i++) {
+                float t, u, v;
+                if (IntersectTriangle(mTriangles[i], rays[r], tMax[r], t, u, v)) {
+                    tMax[r] = t;
+                    hits[r].T = t;
+                    hits[r].U = u;
+                    hits[r].V = v;
+                    hits[r].Primitive = mTriangles[i].Primitive;
+                }
+            }
+        }
+        return 0u;
+    });
+}
+
+void MeshBVH::Occluded(const Ray* rays, bool* occluded, UInt32 count) const
+{
+    float tMax[RAY_PACKET_SIZE];
+    for (UInt32 r = 0; r < count; r++) {
+        tMax[r] = rays[r].TMax;
+        occluded[r] = false;
+    }
+
+    mBVH.Traverse(rays, count, tMax, [&](UInt32 first, UInt32 size, UInt32 mask) {
+        UInt32 done = 0;
+        while (mask) {
+            UInt32 r = std::countr_zero(mask);
+            mask &= mask - 1;
+            for (UInt32 i = first; i < first + size; i++) {
+                float t, u, v;
+                if (IntersectTriangle(mTriangles[i], rays[r], tMax[r], t, u, v)) {
+                    occluded[r] = true;
+                    done |= 1u << r;
+                    break;
+                }
+            }
+        }
+        return done;
+    });
+}
+
+glm::vec3 MeshBVH::GetNormal(UInt32 primitive) const
+{
+    const Triangle& triangle = mTriangles[mOrder[primitive]];
+    return glm::cross(triangle.Edge1, triangle.Edge2);
+}
+
+glm::vec3 MeshBVH::GetCentroid(UInt32 primitive) const
+{
+    const Triangle& triangle = mTriangles[mOrder[primitive]];
+    return triangle.V0 + (triangle.Edge1 + triangle.Edge2) / 3.0f;
+}
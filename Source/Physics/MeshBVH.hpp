@@ -0,0 +1,56 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:16:25
+//
+
+#pragma once
+
+#include <Physics/BVH.hpp>
+
+// Bottom level of the CPU ray tracer: the triangles of one primitive in object space, in leaf order.
+class MeshBVH
+{
+public:
+    using Ref = ::Ref<MeshBVH>;
+
+    MeshBVH() = default;
+    MeshBVH(const Vector<glm::vec3>& positions, const Vector<UInt32>& indices);
+    ~MeshBVH() = default;
+
+    // Triangle lists only. Safe on a worker, nothing else may read the mesh meanwhile.
+    void Build(const Vector<glm::vec3>& positions, const Vector<UInt32>& indices);
+
+    // Closest hit, only replaces hit when it is nearer than hit.T
+    bool Intersect(const Ray& ray, RayHit& hit) const;
+    // Any hit, stops at the first one
+    bool Occluded(const Ray& ray) const;
+
+    // Up to RAY_PACKET_SIZE rays at once, hits and occluded line up with rays
+    void Intersect(const Ray* rays, RayHit* hits, UInt32 count) const;
+    void Occluded(const Ray* rays, bool* occluded, UInt32 count) const;
+
+    // Unnormalized, in object space, facing the way the winding does
+    glm::vec3 GetNormal(UInt32 primitive) const;
+    // Object space
+    glm::vec3 GetCentroid(UInt32 primitive) const;
+
+    Box GetBounds() const { return mBVH.GetBounds(); }
+    UInt32 GetTriangleCount() const { return mTriangles.size(); }
+    const BVH& GetBVH() const { return mBVH; }
+private:
+    struct Triangle
+    {
+        glm::vec3 V0;
+        glm::vec3 Edge1;
+        glm::vec3 Edge2;
+        // Position in the index buffer, divided by three
+        UInt32 Primitive;
+    };
+
+    static bool IntersectTriangle(const Triangle& triangle, const Ray& ray, float tMax, float& t, float& u, float& v);
+
+    BVH mBVH;
+    Vector<Triangle> mTriangles;
+    // Where each primitive landed in mTriangles
+    Vector<UInt32> mOrder;
+};
@@ -0,0 +1,285 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:26:41
+//
+
+#include <Physics/OcclusionBaker.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Checks.hpp>
+#include <Core/Jobs.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+
+static float RadicalInverse(UInt32 bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return bits * 2.3283064365386963e-10f;
+}
+
+static UInt32 Hash(UInt32 x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+void OcclusionBaker::BakeSample(const SceneBVH& scene, const Sample& sample, UInt32 index, float distance, UInt32 rayCount, float& occlusion, UInt64& rays)
+{
+    float length = glm::length(sample.Normal);
+    if (!(length > 0.0f)) {
+        occlusion = 1.0f;
+        return;
+    }
+    glm::vec3 normal = sample.Normal / length;
+
+    // Orthonormal basis without a branch on the normal's direction (Duff et al. 2017)
+    float sign = std::copysign(1.0f, normal.z);
+    float a = -1.0f / (sign + normal.z);
+    float b = normal.x * normal.y * a;
+    glm::vec3 tangent = glm::vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    glm::vec3 bitangent = glm::vec3(b, sign + normal.y * normal.y * a, -normal.y);
+
+    // The same Hammersley set for every sample, shifted by a hash of its index so neighbours don't band the same way
+    UInt32 seed = Hash(index);
+    float shiftU = (seed & 0xFFFF) / 65536.0f;
+    float shiftV = (seed >> 16) / 65536.0f;
+
+    // Off the surface so the rays don't start inside the triangles around the sample
+    glm::vec3 origin = sample.Position + normal * (distance * 1e-3f);
+
+    UInt32 hits = 0;
+    Ray packet[RAY_PACKET_SIZE];
+    bool occluded[RAY_PACKET_SIZE];
+    for (UInt32 first = 0; first < rayCount; first += RAY_PACKET_SIZE) {
+        UInt32 size = std::min(RAY_PACKET_SIZE, rayCount - first);
+        for (UInt32 i = 0; i < size; i++) {
+            float u = (first + i + 0.5f) / rayCount + shiftU;
+            float v = RadicalInverse(first + i) + shiftV;
+            u -= std::floor(u);
+            v -= std::floor(v);
+
+            // Cosine weighted, so the fraction of rays that get out is the occlusion itself
+            float radius = std::sqrt(u);
+            float phi = v * 6.28318530718f;
+            float height = std::sqrt(std::max(0.0f, 1.0f - u));
+
+            packet[i].Origin = origin;
+            packet[i].TMin = 0.0f;
+            packet[i].Direction = tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) + normal * height;
+            packet[i].TMax = distance;
+        }
+
+        scene.Occluded(packet, occluded, size);
+        for (UInt32 i = 0; i < size; i++) {
+            hits += occluded[i];
+        }
+    }
+
+    rays += rayCount;
+    occlusion = 1.0f - float(hits) / float(rayCount);
+}
+
+OcclusionBaker::Stats OcclusionBaker::Bake(const SceneBVH& scene, const Vector<Sample>& samples, float distance, Vector<float>& occlusion, UInt32 rayCount, UInt32 threads)
+{
+    Stats stats;
+    stats.Samples = samples.size();
+    stats.Threads = threads ? std::min(threads, Jobs::GetThreadCount()) : Jobs::GetThreadCount();
+
+    occlusion.assign(samples.size(), 1.0f);
+    if (samples.empty() || scene.IsEmpty() || rayCount == 0) {
+        return stats;
+    }
+
+    // One job per thread, each pulling small chunks until there are none left. Corners cost a lot more than open floor, so
+    // fixed ranges would leave most threads idle at the end, and no more than stats.Threads ever run at once.
+    constexpr UInt32 CHUNK_SIZE = 64;
+    UInt32 chunks = (samples.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::atomic<UInt32> next = 0;
+    std::atomic<UInt64> rays = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    Jobs::ParallelFor(stats.Threads, [&](UInt32 begin, UInt32 end) {
+        for (UInt32 job = begin; job < end; job++) {
+            UInt64 traced = 0;
+            for (UInt32 chunk = next++; chunk < chunks; chunk = next++) {
+                UInt32 last = std::min<UInt32>((chunk + 1) * CHUNK_SIZE, samples.size());
+                for (UInt32 i = chunk * CHUNK_SIZE; i < last; i++) {
+                    BakeSample(scene, samples[i], i, distance, rayCount, occlusion[i], traced);
+                }
+            }
+            rays += traced;
+        }
+    }, 1);
+    stats.Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.Rays = rays.load();
+    return stats;
+}
+
+bool OcclusionBaker::SelfTest()
+{
+    Checks check("OcclusionBaker");
+
+    auto quad = [](Vector<glm::vec3>& positions, Vector<UInt32>& indices, glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d) {
+        UInt32 first = positions.size();
+        positions.insert(positions.end(), { a, b, c, d });
+        indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+    };
+    auto sceneOf = [](const MeshBVH& mesh) {
+        SceneBVH scene;
+        scene.Build({ { &mesh, glm::mat4(1.0f), glm::mat4(1.0f) } });
+        return scene;
+    };
+
+    // A floor meeting a wall at x = 0, both much larger than the bake distance
+    Vector<glm::vec3> cornerPositions;
+    Vector<UInt32> cornerIndices;
+    quad(cornerPositions, cornerIndices, glm::vec3(0.0f, 0.0f, -50.0f), glm::vec3(100.0f, 0.0f, -50.0f), glm::vec3(100.0f, 0.0f, 50.0f), glm::vec3(0.0f, 0.0f, 50.0f));
+    quad(cornerPositions, cornerIndices, glm::vec3(0.0f, 0.0f, -50.0f), glm::vec3(0.0f, 100.0f, -50.0f), glm::vec3(0.0f, 100.0f, 50.0f), glm::vec3(0.0f, 0.0f, 50.0f));
+    MeshBVH corner(cornerPositions, cornerIndices);
+    SceneBVH cornerScene = sceneOf(corner);
+
+    // Closed [-1, 1] box
+    Vector<glm::vec3> boxPositions;
+    Vector<UInt32> boxIndices;
+    for (int axis = 0; axis < 3; axis++) {
+        for (float side : { -1.0f, 1.0f }) {
+            glm::vec3 corners[4];
+            for (int i = 0; i < 4; i++) {
+                corners[i][axis] = side;
+                corners[i][(axis + 1) % 3] = (i == 1 || i == 2) ? 1.0f : -1.0f;
+                corners[i][(axis + 2) % 3] = (i >= 2) ? 1.0f : -1.0f;
+            }
+            quad(boxPositions, boxIndices, corners[0], corners[1], corners[2], corners[3]);
+        }
+    }
+    MeshBVH box(boxPositions, boxIndices);
+    SceneBVH boxScene = sceneOf(box);
+
+    Vector<float> occlusion;
+    Bake(cornerScene, {
+        { glm::vec3(50.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+        { glm::vec3(50.0f, 0.0f, 0.0f), glm::vec3(0.0f, -2.0f, 0.0f) },
+        { glm::vec3(0.01f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+        { glm::vec3(5.0f, 5.0f, 0.0f), glm::vec3(0.0f) }
+    }, 10.0f, occlusion, 256);
+    check(occlusion[0] == 1.0f, "open floor is fully open");
+    check(occlusion[1] == 1.0f, "nothing under the floor");
+    check(std::abs(occlusion[2] - 0.5f) < 0.05f, "half of the cosine lobe of a corner is blocked");
+    float cornerOcclusion = occlusion[2];
+    check(occlusion[3] == 1.0f, "samples without a normal stay open");
+
+    Bake(boxScene, {
+        { glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+        { glm::vec3(0.3f, 0.2f, -0.5f), glm::vec3(1.0f, 1.0f, 1.0f) }
+    }, 10.0f, occlusion);
+    check(occlusion[0] == 0.0f && occlusion[1] == 0.0f, "inside of a closed box is fully occluded");
+
+    // The walls are in reach of the flatter rays, the ceiling isn't
+    Bake(boxScene, { { glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) } }, 1.5f, occlusion);
+    check(occlusion[0] > 0.0f && occlusion[0] < 1.0f, "occluders past the distance are ignored");
+
+    // Points all over the corner, the thread count must not change a thing
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    Vector<Sample> samples(2000);
+    for (Sample& sample : samples) {
+        sample.Position = glm::vec3(unit(generator) * 4.0f, 0.0f, unit(generator) * 8.0f - 4.0f);
+        sample.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    Vector<float> single;
+    Vector<float> parallel;
+    Stats singleStats = Bake(cornerScene, samples, 10.0f, single, OCCLUSION_RAY_COUNT, 1);
+    Stats parallelStats = Bake(cornerScene, samples, 10.0f, parallel);
+    check(single == parallel, "results don't depend on the thread count");
+    check(singleStats.Rays == samples.size() * OCCLUSION_RAY_COUNT && parallelStats.Rays == singleStats.Rays, "every sample casts every ray");
+
+    float nearWall = 0.0f;
+    float farFromWall = 0.0f;
+    UInt32 nearCount = 0;
+    UInt32 farCount = 0;
+    for (UInt32 i = 0; i < samples.size(); i++) {
+        if (samples[i].Position.x < 0.5f) {
+            nearWall += single[i];
+            nearCount++;
+        } else if (samples[i].Position.x > 3.5f) {
+            farFromWall += single[i];
+            farCount++;
+        }
+    }
+    check(nearWall / std::max(nearCount, 1u) < farFromWall / std::max(farCount, 1u), "floor opens up away from the wall");
+
+    if (check.Passed()) {
+        LOG_INFO("[OcclusionBaker] Self test passed: corner {0:.3f}, {1} samples match across thread counts", cornerOcclusion, samples.size());
+    }
+    return check.Passed();
+}
+
+void OcclusionBaker::Benchmark(const SceneBVH& scene)
+{
+    if (scene.IsEmpty()) {
+        LOG_WARN("[OcclusionBaker] Nothing to bake");
+        return;
+    }
+
+    // A point on every few triangles, enough that a single thread takes a second or two
+    constexpr UInt64 MAX_SAMPLES = 32768;
+    UInt64 stride = std::max<UInt64>(1, (scene.GetTriangleCount() + MAX_SAMPLES - 1) / MAX_SAMPLES);
+    UInt64 triangle = 0;
+
+    Vector<Sample> samples;
+    for (const SceneBVH::Instance& instance : scene.GetInstances()) {
+        if (!instance.Mesh) {
+            continue;
+        }
+        glm::mat4 normalMatrix = glm::transpose(instance.InvTransform);
+        for (UInt32 i = 0; i < instance.Mesh->GetTriangleCount(); i++, triangle++) {
+            if (triangle % stride) {
+                continue;
+            }
+            Sample sample;
+            sample.Position = glm::vec3(instance.Transform * glm::vec4(instance.Mesh->GetCentroid(i), 1.0f));
+            sample.Normal = glm::vec3(normalMatrix * glm::vec4(instance.Mesh->GetNormal(i), 0.0f));
+            samples.push_back(sample);
+        }
+    }
+
+    Box bounds = scene.GetBounds();
+    float distance = glm::length(bounds.Max - bounds.Min) * OCCLUSION_DISTANCE;
+
+    Vector<UInt32> threadCounts;
+    for (UInt32 threads = 1; threads < Jobs::GetThreadCount(); threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(Jobs::GetThreadCount());
+
+    LOG_INFO("[OcclusionBaker] {0} samples over {1} triangles, {2} rays each, distance {3:.2f}", samples.size(), scene.GetTriangleCount(), OCCLUSION_RAY_COUNT, distance);
+
+    Vector<float> reference;
+    float baseline = 0.0f;
+    for (UInt32 threads : threadCounts) {
+        Vector<float> occlusion;
+        Stats stats = Bake(scene, samples, distance, occlusion, OCCLUSION_RAY_COUNT, threads);
+        if (threads == 1) {
+            reference = occlusion;
+            baseline = stats.Milliseconds;
+        }
+
+        float speedup = baseline / std::max(stats.Milliseconds, 1e-3f);
+        LOG_INFO("[OcclusionBaker] {0} threads: {1:.1f} ms, {2:.2f} Mrays/s, {3:.2f}x ({4:.0f}% of linear){5}",
+                 stats.Threads,
+                 stats.Milliseconds,
+                 stats.Rays / (std::max(stats.Milliseconds, 1e-3f) * 1000.0f),
+                 speedup,
+                 100.0f * speedup / stats.Threads,
+                 occlusion == reference ? "" : " MISMATCH");
+    }
+}
@@ -0,0 +1,44 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:24:05
+//
+
+#pragma once
+
+#include <Physics/SceneBVH.hpp>
+
+// Rays over the hemisphere of each sample, cosine weighted
+constexpr UInt32 OCCLUSION_RAY_COUNT = 64;
+// Occluders further away than this fraction of the baked scene's diagonal don't count
+constexpr float OCCLUSION_DISTANCE = 0.1f;
+
+// Ambient occlusion of points on static geometry, traced on the CPU over the job system. 1 is fully open, 0 fully closed.
+// Samples get the same directions whatever the thread count, so a bake is reproducible.
+class OcclusionBaker
+{
+public:
+    struct Sample
+    {
+        glm::vec3 Position;
+        // Doesn't have to be normalized, zero leaves the sample open
+        glm::vec3 Normal;
+    };
+
+    struct Stats
+    {
+        UInt64 Samples = 0;
+        UInt64 Rays = 0;
+        UInt32 Threads = 0;
+        float Milliseconds = 0.0f;
+    };
+
+    // occlusion lines up with samples. threads caps how many work at once, 0 uses all of them.
+    static Stats Bake(const SceneBVH& scene, const Vector<Sample>& samples, float distance, Vector<float>& occlusion, UInt32 rayCount = OCCLUSION_RAY_COUNT, UInt32 threads = 0);
+
+    // Checks an open plane, a corner and a closed box against their analytic values, and that threads don't change the result
+    static bool SelfTest();
+    // Bakes points spread over the scene's triangles from 1 thread up to all of them, logs the time and speedup of each
+    static void Benchmark(const SceneBVH& scene);
+private:
+    static void BakeSample(const SceneBVH& scene, const Sample& sample, UInt32 index, float distance, UInt32 rayCount, float& occlusion, UInt64& rays);
+};
@@ -0,0 +1,37 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:12:36
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <glm/glm.hpp>
+#include <cfloat>
+
+// Rays traced together share node fetches, they should start close and point roughly the same way
+constexpr UInt32 RAY_PACKET_SIZE = 8;
+
+struct Ray
+{
+    glm::vec3 Origin;
+    float TMin = 0.0f;
+    // Doesn't have to be normalized, T is in multiples of it
+    glm::vec3 Direction;
+    float TMax = FLT_MAX;
+};
+
+struct RayHit
+{
+    float T = FLT_MAX;
+    // Barycentrics of the second and third vertex
+    float U = 0.0f;
+    float V = 0.0f;
+    // Triangle in the mesh's index buffer order
+    UInt32 Primitive = UINT32_MAX;
+    // Index given to the scene BVH, UINT32_MAX for a mesh on its own
+    UInt32 Instance = UINT32_MAX;
+
+    bool IsHit() const { return Primitive != UINT32_MAX; }
+};
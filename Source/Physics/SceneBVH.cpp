@@ -0,0 +1,503 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:18:47
+//
+
+#include <Physics/SceneBVH.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Checks.hpp>
+#include <Core/Jobs.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb/stb_image_write.h>
+#include <chrono>
+#include <random>
+
+static Box TransformBox(const Box& box, const glm::mat4& transform)
+{
+    Box result = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner(i & 1 ? box.Max.x : box.Min.x, i & 2 ? box.Max.y : box.Min.y, i & 4 ? box.Max.z : box.Min.z);
+        corner = glm::vec3(transform * glm::vec4(corner, 1.0f));
+        result.Min = glm::min(result.Min, corner);
+        result.Max = glm::max(result.Max, corner);
+    }
+    return result;
+}
+
+void SceneBVH::Clear()
+{
+    mBVH.Clear();
+    mInstances.clear();
+    mPlaced.clear();
+    mTriangleCount = 0;
+}
+
+void SceneBVH::Build(const Vector<Instance>& instances)
+{
+    mInstances = instances;
+    mTriangleCount = 0;
+
+    Vector<Box> bounds;
+    Vector<UInt32> placed;
+    bounds.reserve(instances.size());
+    placed.reserve(instances.size());
+    for (UInt32 i = 0; i < instances.size(); i++) {
+        const Instance& instance = instances[i];
+        if (!instance.Mesh || !instance.Mesh->GetTriangleCount()) {
+            continue;
+        }
+        bounds.push_back(TransformBox(instance.Mesh->GetBounds(), instance.Transform));
+        placed.push_back(i);
+        mTriangleCount += instance.Mesh->GetTriangleCount();
+    }
+    mBVH.Build(bounds);
+
+    const Vector<UInt32>& order = mBVH.GetIndices();
+    mPlaced.resize(order.size());
+    for (UInt32 i = 0; i < order.size(); i++) {
+        const Instance& instance = instances[placed[order[i]]];
+        mPlaced[i] = { instance.Mesh, instance.InvTransform, placed[order[i]] };
+    }
+}
+
+Ray SceneBVH::ToObject(const Ray& ray, const glm::mat4& invTransform)
+{
+    // The direction isn't renormalized, so T means the same distance on both sides
+    Ray local = ray;
+    local.Origin = glm::vec3(invTransform * glm::vec4(ray.Origin, 1.0f));
+    local.Direction = glm::vec3(invTransform * glm::vec4(ray.Direction, 0.0f));
+    return local;
+}
+
+bool SceneBVH::Intersect(const Ray& ray, RayHit& hit) const
+{
+    bool found = false;
+    float tMax = std::min(ray.TMax, hit.T);
+    mBVH.Traverse(ray, tMax, [&](UInt32 first, UInt32 count) {
+        for (UInt32 i = first; i < first + count; i++) {
+            const Placed& placed = mPlaced[i];
+            Ray local = ToObject(ray, placed.InvTransform);
+            local.TMax = tMax;
+            if (placed.Mesh->Intersect(local, hit)) {
+                hit.Instance = placed.Index;
+                tMax = hit.T;
+                found = true;
+            }
+        }
+        return false;
+    });
+    return found;
+}
+
+bool SceneBVH::Occluded(const Ray& ray) const
+{
+    bool occluded = false;
+    float tMax = ray.TMax;
+    mBVH.Traverse(ray, tMax, [&](UInt32 first, UInt32 count) {
+        for (UInt32 i = first; i < first + count; i++) {
+            const Placed& placed = mPlaced[i];
+            if (placed.Mesh->Occluded(ToObject(ray, placed.InvTransform))) {
+                occluded = true;
+                return true;
+            }
+        }
+        return false;
+    });
+    return occluded;
+}
+
+void SceneBVH::Intersect(const Ray* rays, RayHit* hits, UInt32 count) const
+{
+    for (UInt32 first = 0; first < count; first += RAY_PACKET_SIZE) {
+        const Ray* packet = rays + first;
+        RayHit* packetHits = hits + first;
+        UInt32 size = std::min(RAY_PACKET_SIZE, count - first);
+
+        float tMax[RAY_PACKET_SIZE];
+        for (UInt32 r = 0; r < size; r++) {
+            tMax[r] = std::min(packet[r].TMax, packetHits[r].T);
+        }
+
+        mBVH.Traverse(packet, size, tMax, [&](UInt32 begin, UInt32 leafSize, UInt32 mask) {
+            for (UInt32 i = begin; i < begin + leafSize; i++) {
+                const Placed& placed = mPlaced[i];
+
+                // The rays that reached this instance, as one packet in its object space
+                Ray local[RAY_PACKET_SIZE];
+                RayHit localHits[RAY_PACKET_SIZE];
+                UInt32 lanes[RAY_PACKET_SIZE];
+                UInt32 lanesCount = 0;
+                for (UInt32 bits = mask; bits; bits &= bits - 1) {
+                    UInt32 r = std::countr_zero(bits);
+                    local[lanesCount] = ToObject(packet[r], placed.InvTransform);
+                    local[lanesCount].TMax = tMax[r];
+                    localHits[lanesCount] = packetHits[r];
+                    lanes[lanesCount++] = r;
+                }
+                placed.Mesh->Intersect(local, localHits, lanesCount);
+
+                for (UInt32 k = 0; k < lanesCount; k++) {
+                    UInt32 r = lanes[k];
+                    if (localHits[k].T < tMax[r]) {
+                        packetHits[r] = localHits[k];
+                        packetHits[r].Instance = placed.Index;
+                        tMax[r] = localHits[k].T;
+                    }
+                }
+            }
+            return 0u;
+        });
+    }
+}
+
+void SceneBVH::Occluded(const Ray* rays, bool* occluded, UInt32 count) const
+{
+    for (UInt32 first = 0; first < count; first += RAY_PACKET_SIZE) {
+        const Ray* packet = rays + first;
+        bool* packetOccluded = occluded + first;
+        UInt32 size = std::min(RAY_PACKET_SIZE, count - first);
+
+        float tMax[RAY_PACKET_SIZE];
+        for (UInt32 r = 0; r < size; r++) {
+            tMax[r] = packet[r].TMax;
+            packetOccluded[r] = false;
+        }
+
+        mBVH.Traverse(packet, size, tMax, [&](UInt32 begin, UInt32 leafSize, UInt32 mask) {
+            UInt32 done = 0;
+            for (UInt32 i = begin; i < begin + leafSize && mask; i++) {
+                const Placed& placed = mPlaced[i];
+
+                Ray local[RAY_PACKET_SIZE];
+                bool localOccluded[RAY_PACKET_SIZE];
+                UInt32 lanes[RAY_PACKET_SIZE];
+                UInt32 lanesCount = 0;
+                for (UInt32 bits = mask; bits; bits &= bits - 1) {
+                    UInt32 r = std::countr_zero(bits);
+                    local[lanesCount] = ToObject(packet[r], placed.InvTransform);
+                    lanes[lanesCount++] = r;
+                }
+                placed.Mesh->Occluded(local, localOccluded, lanesCount);
+
+                for (UInt32 k = 0; k < lanesCount; k++) {
+                    if (localOccluded[k]) {
+                        packetOccluded[lanes[k]] = true;
+                        done |= 1u << lanes[k];
+                    }
+                }
+                mask &= ~done;
+            }
+            return done;
+        });
+    }
+}
+
+glm::vec3 SceneBVH::GetNormal(const RayHit& hit) const
+{
+    const Instance& instance = mInstances[hit.Instance];
+    glm::vec3 normal = instance.Mesh->GetNormal(hit.Primitive);
+    return glm::normalize(glm::transpose(glm::mat3(instance.InvTransform)) * normal);
+}
+
+bool SceneBVH::SelfTest()
+{
+    Checks check("SceneBVH");
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    auto random3 = [&]() {
+        return glm::vec3(unit(generator), unit(generator), unit(generator));
+    };
+
+    // Soups of small triangles, the last one flat so some nodes have no extent on an axis
+    constexpr UInt32 MESHES = 3;
+    Vector<Vector<glm::vec3>> soups(MESHES);
+    Vector<MeshBVH::Ref> meshes;
+    for (UInt32 m = 0; m < MESHES; m++) {
+        Vector<UInt32> indices;
+        for (UInt32 i = 0; i < 300; i++) {
+            glm::vec3 center = random3();
+            for (UInt32 v = 0; v < 3; v++) {
+                glm::vec3 position = center + random3() * 0.2f;
+                if (m == MESHES - 1) {
+                    position.z = 0.0f;
+                }
+                indices.push_back(soups[m].size());
+                soups[m].push_back(position);
+            }
+        }
+        meshes.push_back(MakeRef<MeshBVH>(soups[m], indices));
+    }
+
+    // Rotated, unevenly scaled and overlapping, one without a mesh
+    Vector<Instance> instances(24);
+    for (UInt32 i = 0; i < instances.size(); i++) {
+        glm::vec3 scale = glm::vec3(1.25f) + random3() * 0.75f;
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), random3() * 6.0f);
+        transform = glm::rotate(transform, unit(generator) * 3.14f, glm::normalize(random3() + glm::vec3(0.0f, 0.0f, 2.0f)));
+        transform = glm::scale(transform, scale);
+        instances[i] = { i == 5 ? nullptr : meshes[i % MESHES].get(), transform, glm::inverse(transform) };
+    }
+
+    SceneBVH scene;
+    scene.Build(instances);
+    check(scene.GetTriangleCount() == 23 * 300, "meshless instances are left out");
+
+    auto soupOf = [&](const Instance& instance) -> const Vector<glm::vec3>& {
+        for (UInt32 m = 0; m < MESHES; m++) {
+            if (meshes[m].get() == instance.Mesh) {
+                return soups[m];
+            }
+        }
+        return soups[0];
+    };
+
+    // Möller-Trumbore on the raw soup, against every instance
+    auto bruteForce = [&](const Ray& ray, float& closest) {
+        closest = FLT_MAX;
+        for (const Instance& instance : instances) {
+            if (!instance.Mesh) {
+                continue;
+            }
+            Ray local = ToObject(ray, instance.InvTransform);
+            const Vector<glm::vec3>& soup = soupOf(instance);
+            for (UInt32 i = 0; i < soup.size(); i += 3) {
+                glm::vec3 edge1 = soup[i + 1] - soup[i];
+                glm::vec3 edge2 = soup[i + 2] - soup[i];
+                glm::vec3 p = glm::cross(local.Direction, edge2);
+                float determinant = glm::dot(edge1, p);
+                if (std::abs(determinant) < 1e-12f) {
+                    continue;
+                }
+                glm::vec3 s = local.Origin - soup[i];
+                float u = glm::dot(s, p) / determinant;
+                glm::vec3 q = glm::cross(s, edge1);
+                float v = glm::dot(local.Direction, q) / determinant;
+                float t = glm::dot(edge2, q) / determinant;
+                if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= ray.TMin && t < ray.TMax) {
+                    closest = std::min(closest, t);
+                }
+            }
+        }
+    };
+
+    constexpr UInt32 RAYS = 2048;
+    Vector<Ray> rays(RAYS);
+    for (UInt32 i = 0; i < RAYS; i++) {
+        // Half of them short, for any hit queries that have to stop before the geometry
+        rays[i].Origin = random3() * 10.0f;
+        rays[i].Direction = glm::normalize(random3() * 0.3f - rays[i].Origin * 0.1f);
+        rays[i].TMax = i & 1 ? 6.0f : FLT_MAX;
+    }
+
+    UInt32 closestMismatches = 0;
+    UInt32 anyMismatches = 0;
+    UInt32 hitCount = 0;
+    Vector<RayHit> singles(RAYS);
+    Vector<UInt8> singleOccluded(RAYS);
+    for (UInt32 i = 0; i < RAYS; i++) {
+        float expected;
+        bruteForce(rays[i], expected);
+
+        RayHit& hit = singles[i];
+        bool found = scene.Intersect(rays[i], hit);
+        if (found != (expected != FLT_MAX) || (found && std::abs(hit.T - expected) > 1e-4f * std::max(1.0f, expected))) {
+            closestMismatches++;
+        }
+        hitCount += found;
+
+        singleOccluded[i] = scene.Occluded(rays[i]);
+        if (singleOccluded[i] != found) {
+            anyMismatches++;
+        }
+    }
+    check(hitCount > RAYS / 8 && hitCount < RAYS, "the test scene gets hit and missed");
+    check(closestMismatches == 0, "closest hits match brute force");
+    check(anyMismatches == 0, "any hits match closest hits");
+
+    // Packets have to give the very same answers, whatever the last packet's size
+    Vector<RayHit> packets(RAYS - 3);
+    Vector<UInt8> packetOccluded(RAYS - 3);
+    scene.Intersect(rays.data(), packets.data(), packets.size());
+    for (UInt32 first = 0; first < packets.size(); first += RAY_PACKET_SIZE) {
+        bool occluded[RAY_PACKET_SIZE];
+        UInt32 size = std::min(RAY_PACKET_SIZE, UInt32(packets.size()) - first);
+        scene.Occluded(rays.data() + first, occluded, size);
+        for (UInt32 r = 0; r < size; r++) {
+            packetOccluded[first + r] = occluded[r];
+        }
+    }
+
+    bool packetsMatch = true;
+    bool normalsPerpendicular = true;
+    for (UInt32 i = 0; i < packets.size(); i++) {
+        packetsMatch = packetsMatch && packets[i].IsHit() == singles[i].IsHit() && packets[i].T == singles[i].T && packetOccluded[i] == singleOccluded[i];
+        if (!packets[i].IsHit()) {
+            continue;
+        }
+        packetsMatch = packetsMatch && packets[i].Instance == singles[i].Instance;
+
+        // Against the hit triangle's edges taken to world space
+        const Instance& instance = instances[packets[i].Instance];
+        const Vector<glm::vec3>& soup = soupOf(instance);
+        UInt32 first = packets[i].Primitive * 3;
+        glm::vec3 edge1 = glm::normalize(glm::mat3(instance.Transform) * (soup[first + 1] - soup[first]));
+        glm::vec3 edge2 = glm::normalize(glm::mat3(instance.Transform) * (soup[first + 2] - soup[first]));
+        glm::vec3 normal = scene.GetNormal(packets[i]);
+        normalsPerpendicular = normalsPerpendicular && std::abs(glm::dot(normal, edge1)) < 1e-3f && std::abs(glm::dot(normal, edge2)) < 1e-3f;
+    }
+    check(packetsMatch, "packets match single rays");
+    check(normalsPerpendicular, "normals are perpendicular to the hit triangle");
+
+    if (check.Passed()) {
+        LOG_INFO("[SceneBVH] Self test passed: {0} rays, {1} hits, depth {2}", RAYS, hitCount, scene.mBVH.GetDepth());
+    }
+    return check.Passed();
+}
+
+void SceneBVH::Benchmark(const SceneBVH& scene, const glm::mat4& view, const glm::mat4& projection, glm::vec3 sunDirection)
+{
+    if (scene.IsEmpty()) {
+        LOG_WARN("[SceneBVH] Nothing to trace");
+        return;
+    }
+
+    auto milliseconds = [](auto start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // 4x2 pixel tiles, so the rays of a packet are neighbours
+    constexpr UInt32 IMAGE_WIDTH = 1280;
+    constexpr UInt32 IMAGE_HEIGHT = 720;
+    glm::mat4 invProjView = glm::inverse(projection * view);
+    glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
+
+    Vector<Ray> rays;
+    Vector<UInt32> pixels;
+    rays.reserve(IMAGE_WIDTH * IMAGE_HEIGHT);
+    pixels.reserve(IMAGE_WIDTH * IMAGE_HEIGHT);
+    for (UInt32 ty = 0; ty < IMAGE_HEIGHT; ty += 2) {
+        for (UInt32 tx = 0; tx < IMAGE_WIDTH; tx += 4) {
+            for (UInt32 i = 0; i < RAY_PACKET_SIZE; i++) {
+                UInt32 x = tx + i % 4;
+                UInt32 y = ty + i / 4;
+                glm::vec2 ndc = glm::vec2((x + 0.5f) / IMAGE_WIDTH * 2.0f - 1.0f, 1.0f - (y + 0.5f) / IMAGE_HEIGHT * 2.0f);
+                glm::vec4 farPoint = invProjView * glm::vec4(ndc, 1.0f, 1.0f);
+
+                Ray ray;
+                ray.Origin = eye;
+                ray.Direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - eye);
+                rays.push_back(ray);
+                pixels.push_back(x + y * IMAGE_WIDTH);
+            }
+        }
+    }
+
+    // Packets of rays spread over every thread
+    auto run = [&](UInt32 count, const std::function<void(UInt32 first, UInt32 size)>& trace) {
+        UInt32 packets = (count + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE;
+        auto start = std::chrono::steady_clock::now();
+        Jobs::ParallelFor(packets, [&](UInt32 begin, UInt32 end) {
+            for (UInt32 p = begin; p < end; p++) {
+                UInt32 first = p * RAY_PACKET_SIZE;
+                trace(first, std::min(RAY_PACKET_SIZE, count - first));
+            }
+        });
+        return milliseconds(start);
+    };
+    auto mrays = [](UInt64 count, float time) {
+        return count / (time * 1000.0f);
+    };
+
+    UInt32 count = rays.size();
+    Vector<RayHit> hits(count);
+    Vector<RayHit> packetHits(count);
+    float closestSingle = run(count, [&](UInt32 first, UInt32 size) {
+        for (UInt32 i = first; i < first + size; i++) {
+            hits[i] = {};
+            scene.Intersect(rays[i], hits[i]);
+        }
+    });
+    float closestPacket = run(count, [&](UInt32 first, UInt32 size) {
+        for (UInt32 i = first; i < first + size; i++) {
+            packetHits[i] = {};
+        }
+        scene.Intersect(rays.data() + first, packetHits.data() + first, size);
+    });
+
+    // Toward the sun from whatever the camera saw, pushed off the surface
+    Vector<Ray> shadowRays;
+    Vector<UInt32> shadowPixels;
+    Vector<glm::vec3> normals(count);
+    UInt32 mismatches = 0;
+    for (UInt32 i = 0; i < count; i++) {
+        if (hits[i].IsHit() != packetHits[i].IsHit() || hits[i].T != packetHits[i].T) {
+            mismatches++;
+        }
+        if (!hits[i].IsHit()) {
+            continue;
+        }
+
+        glm::vec3 normal = scene.GetNormal(hits[i]);
+        if (glm::dot(normal, rays[i].Direction) > 0.0f) {
+            normal = -normal;
+        }
+        normals[i] = normal;
+
+        Ray ray;
+        ray.Origin = rays[i].Origin + rays[i].Direction * hits[i].T + normal * 1e-3f;
+        ray.Direction = -sunDirection;
+        shadowRays.push_back(ray);
+        shadowPixels.push_back(i);
+    }
+
+    UInt32 shadowCount = shadowRays.size();
+    Vector<UInt8> occluded(shadowCount);
+    Vector<UInt8> packetOccluded(shadowCount);
+    float occludedSingle = run(shadowCount, [&](UInt32 first, UInt32 size) {
+        for (UInt32 i = first; i < first + size; i++) {
+            occluded[i] = scene.Occluded(shadowRays[i]);
+        }
+    });
+    float occludedPacket = run(shadowCount, [&](UInt32 first, UInt32 size) {
+        bool packet[RAY_PACKET_SIZE];
+        scene.Occluded(shadowRays.data() + first, packet, size);
+        for (UInt32 r = 0; r < size; r++) {
+            packetOccluded[first + r] = packet[r];
+        }
+    });
+
+    UInt32 shadowed = 0;
+    for (UInt32 i = 0; i < shadowCount; i++) {
+        mismatches += occluded[i] != packetOccluded[i];
+        shadowed += occluded[i];
+    }
+
+    LOG_INFO("[SceneBVH] {0} instances, {1} triangles, {2} threads", scene.mPlaced.size(), scene.mTriangleCount, Jobs::GetThreadCount());
+    LOG_INFO("[SceneBVH] Closest hit: {0:.2f} Mrays/s single, {1:.2f} Mrays/s in packets of {2}", mrays(count, closestSingle), mrays(count, closestPacket), RAY_PACKET_SIZE);
+    LOG_INFO("[SceneBVH] Any hit: {0:.2f} Mrays/s single, {1:.2f} Mrays/s in packets of {2}", mrays(shadowCount, occludedSingle), mrays(shadowCount, occludedPacket), RAY_PACKET_SIZE);
+    if (mismatches) {
+        LOG_ERROR("[SceneBVH] {0} rays disagree between single and packet tracing", mismatches);
+    }
+
+    // Sun visibility from the camera, to hold against the shadow maps: sky, lit by N.L, or in shadow
+    Vector<UInt8> image(IMAGE_WIDTH * IMAGE_HEIGHT * 3);
+    for (UInt32 i = 0; i < count; i++) {
+        UInt8* pixel = image.data() + pixels[i] * 3;
+        pixel[0] = 90;
+        pixel[1] = 140;
+        pixel[2] = 200;
+    }
+    for (UInt32 i = 0; i < shadowCount; i++) {
+        UInt32 ray = shadowPixels[i];
+        float light = occluded[i] ? 0.0f : std::max(glm::dot(normals[ray], -sunDirection), 0.0f);
+        UInt8 value = UInt8(30.0f + 225.0f * light);
+        UInt8* pixel = image.data() + pixels[ray] * 3;
+        pixel[0] = value;
+        pixel[1] = value;
+        pixel[2] = value;
+    }
+    stbi_write_png("ray_shadows.png", IMAGE_WIDTH, IMAGE_HEIGHT, 3, image.data(), IMAGE_WIDTH * 3);
+    LOG_INFO("[SceneBVH] {0:.1f}% of visible surfaces in shadow, written to ray_shadows.png", 100.0f * shadowed / std::max(shadowCount, 1u));
+}
@@ -0,0 +1,61 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:18:10
+//
+
+#pragma once
+
+#include <Physics/MeshBVH.hpp>
+
+// Top level of the CPU ray tracer: mesh BVHs placed in the world. Rays are taken to object space at the instance leaves,
+// so T stays in world units. Cheap enough to rebuild every frame for a few thousand instances.
+class SceneBVH
+{
+public:
+    struct Instance
+    {
+        // Instances without a mesh keep their index but are never hit
+        const MeshBVH* Mesh = nullptr;
+        glm::mat4 Transform;
+        glm::mat4 InvTransform;
+    };
+
+    // RayHit::Instance is the index into instances
+    void Build(const Vector<Instance>& instances);
+    void Clear();
+
+    bool Intersect(const Ray& ray, RayHit& hit) const;
+    bool Occluded(const Ray& ray) const;
+
+    // Any number of rays, traced in packets of RAY_PACKET_SIZE in the order given
+    void Intersect(const Ray* rays, RayHit* hits, UInt32 count) const;
+    void Occluded(const Ray* rays, bool* occluded, UInt32 count) const;
+
+    // World space, normalized
+    glm::vec3 GetNormal(const RayHit& hit) const;
+
+    bool IsEmpty() const { return mBVH.IsEmpty(); }
+    Box GetBounds() const { return mBVH.GetBounds(); }
+    UInt64 GetTriangleCount() const { return mTriangleCount; }
+    const Vector<Instance>& GetInstances() const { return mInstances; }
+
+    // Compares closest and any hits against brute force over every triangle of a small random scene, logs the result
+    static bool SelfTest();
+    // Camera rays and shadow rays toward the sun over the scene, single and packets, in Mrays/s on every thread
+    static void Benchmark(const SceneBVH& scene, const glm::mat4& view, const glm::mat4& projection, glm::vec3 sunDirection);
+private:
+    struct Placed
+    {
+        const MeshBVH* Mesh;
+        glm::mat4 InvTransform;
+        UInt32 Index;
+    };
+
+    static Ray ToObject(const Ray& ray, const glm::mat4& invTransform);
+
+    BVH mBVH;
+    Vector<Instance> mInstances;
+    // Instances that have a mesh, in leaf order
+    Vector<Placed> mPlaced;
+    UInt64 mTriangleCount = 0;
+};
@@ -10,7 +10,7 @@
 class BLAS : public AccelerationStructure
 {
 public:
-    using Ref = Ref<BLAS>;
+    using Ref = ::Ref<BLAS>;
 
     BLAS(Device::Ref device, DescriptorHeaps& heaps, Buffer::Ref vertex, Buffer::Ref index, UInt32 vtxCount, UInt32 idxCount, const String& name = "BLAS");
     ~BLAS() = default;
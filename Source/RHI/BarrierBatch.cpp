@@ -0,0 +1,166 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 14:26:52
+//
+
+#include <RHI/BarrierBatch.hpp>
+
+BarrierBatch::BarrierBatch(const Sink& sink)
+    : mSink(sink)
+{
+}
+
+void BarrierBatch::Transition(Resource* resource, ResourceLayout layout, UInt32 mip)
+{
+    if (mSplits.count(resource)) {
+        EndSplit(resource);
+    }
+    if (resource->GetLayout() == ResourceLayout::Storage && layout == ResourceLayout::Storage && mip == VIEW_ALL_MIPS) {
+        UAV(resource);
+        return;
+    }
+
+    mStats.Requested++;
+    if (resource->GetLayout() == layout && mip == VIEW_ALL_MIPS) {
+        mStats.Dropped++;
+        return;
+    }
+
+    // Nothing ran since the last transition of this resource, so just retarget it
+    auto last = mLast.find(resource);
+    if (mip == VIEW_ALL_MIPS && last != mLast.end()) {
+        D3D12_RESOURCE_BARRIER& barrier = mPending[last->second];
+        if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION &&
+            barrier.Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE &&
+            barrier.Transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) {
+            barrier.Transition.StateAfter = D3D12_RESOURCE_STATES(layout);
+            resource->SetLayout(layout);
+            mStats.Merged++;
+
+            // Went back to where it started, the barrier isn't needed at all
+            if (barrier.Transition.StateBefore == barrier.Transition.StateAfter) {
+                UInt64 removed = last->second;
+                mPending.erase(mPending.begin() + removed);
+                mLast.erase(last);
+                for (auto& [other, index] : mLast) {
+                    if (index > removed) {
+                        index--;
+                    }
+                }
+                mStats.Dropped++;
+            }
+            return;
+        }
+    }
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource = resource->GetResource();
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATES(resource->GetLayout());
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATES(layout);
+    barrier.Transition.Subresource = mip == VIEW_ALL_MIPS ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : mip;
+    Push(barrier, resource);
+
+    resource->SetLayout(layout);
+}
+
+void BarrierBatch::BeginTransition(Resource* resource, ResourceLayout layout)
+{
+    mStats.Requested++;
+    if (mSplits.count(resource)) {
+        EndSplit(resource);
+    }
+    if (resource->GetLayout() == layout) {
+        mStats.Dropped++;
+        return;
+    }
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+    barrier.Transition.pResource = resource->GetResource();
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATES(resource->GetLayout());
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATES(layout);
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    Push(barrier, resource);
+
+    // The tracked layout moves when the transition ends
+    mSplits[resource] = layout;
+    mStats.Split++;
+}
+
+void BarrierBatch::UAV(Resource* resource)
+{
+    mStats.Requested++;
+
+    // One UAV barrier per resource per batch is plenty
+    auto last = mLast.find(resource);
+    if (last != mLast.end() && mPending[last->second].Type == D3D12_RESOURCE_BARRIER_TYPE_UAV) {
+        mStats.Dropped++;
+        return;
+    }
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.UAV.pResource = resource->GetResource();
+    Push(barrier, resource);
+}
+
+void BarrierBatch::Aliasing(Resource* before, Resource* after)
+{
+    mStats.Requested++;
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    barrier.Aliasing.pResourceBefore = before ? before->GetResource() : nullptr;
+    barrier.Aliasing.pResourceAfter = after->GetResource();
+    Push(barrier, after);
+    if (before) {
+        mLast[before] = mPending.size() - 1;
+    }
+}
+
+void BarrierBatch::Flush()
+{
+    if (mPending.empty()) {
+        return;
+    }
+
+    mSink(mPending.data(), mPending.size());
+    mStats.Submitted += mPending.size();
+    mStats.Calls++;
+
+    mPending.clear();
+    mLast.clear();
+}
+
+void BarrierBatch::EndAll()
+{
+    while (!mSplits.empty()) {
+        EndSplit(mSplits.begin()->first);
+    }
+    Flush();
+}
+
+void BarrierBatch::Push(const D3D12_RESOURCE_BARRIER& barrier, Resource* resource)
+{
+    mPending.push_back(barrier);
+    mLast[resource] = mPending.size() - 1;
+}
+
+void BarrierBatch::EndSplit(Resource* resource)
+{
+    ResourceLayout layout = mSplits[resource];
+    mSplits.erase(resource);
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+    barrier.Transition.pResource = resource->GetResource();
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATES(resource->GetLayout());
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATES(layout);
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    Push(barrier, resource);
+
+    resource->SetLayout(layout);
+}
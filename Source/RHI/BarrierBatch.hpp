@@ -0,0 +1,60 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 14:21:09
+//
+
+#pragma once
+
+#include <RHI/Resource.hpp>
+#include <RHI/View.hpp>
+
+#include <functional>
+
+struct BarrierStats
+{
+    // Everything that was asked for, against what actually reached the API
+    UInt64 Requested = 0;
+    UInt64 Dropped = 0;
+    UInt64 Merged = 0;
+    UInt64 Split = 0;
+    UInt64 Submitted = 0;
+    UInt64 Calls = 0;
+};
+
+// Collects barriers until the next piece of GPU work needs them, then hands them out in one go. Transitions to the layout
+// a resource is already in are dropped, and a transition that gets overridden before the flush is folded into the new one.
+// It knows nothing about command lists, the sink decides where the barriers go, so it can run against a recorder.
+class BarrierBatch
+{
+public:
+    using Sink = std::function<void(const D3D12_RESOURCE_BARRIER* barriers, UInt32 count)>;
+
+    BarrierBatch(const Sink& sink);
+    ~BarrierBatch() = default;
+
+    void Transition(Resource* resource, ResourceLayout layout, UInt32 mip = VIEW_ALL_MIPS);
+    // Starts a transition early, the next Transition() of the resource ends it. The resource can't be used in between.
+    void BeginTransition(Resource* resource, ResourceLayout layout);
+    void UAV(Resource* resource);
+    void Aliasing(Resource* before, Resource* after);
+
+    void Flush();
+    // Split barriers can't cross command lists, so this has to run before the list is closed
+    void EndAll();
+
+    bool IsPending() const { return !mPending.empty(); }
+    bool IsSplit(Resource* resource) const { return mSplits.count(resource) > 0; }
+
+    const BarrierStats& GetStats() const { return mStats; }
+    void ResetStats() { mStats = {}; }
+private:
+    void Push(const D3D12_RESOURCE_BARRIER& barrier, Resource* resource);
+    void EndSplit(Resource* resource);
+
+    Sink mSink;
+    Vector<D3D12_RESOURCE_BARRIER> mPending;
+    // Last pending barrier of each resource, only whole resource transitions can be folded
+    UnorderedMap<Resource*, UInt64> mLast;
+    UnorderedMap<Resource*, ResourceLayout> mSplits;
+    BarrierStats mStats;
+};
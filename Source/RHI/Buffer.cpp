@@ -43,6 +43,7 @@ Buffer::Buffer(Device::Ref device, DescriptorHeaps heaps, UInt64 size, UInt64 st
     resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
     if (type == BufferType::Storage || type == BufferType::AccelerationStructure) resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS | D3D12_RESOURCE_FLAG_RAYTRACING_ACCELERATION_STRUCTURE;
     if (type == BufferType::Constant) mLayout = ResourceLayout::GenericRead;
+    if (type == BufferType::Readback) mLayout = ResourceLayout::CopyDest;
     if (type == BufferType::AccelerationStructure) mLayout = ResourceLayout::AccelerationStructure;
 
     CreateResource(&heapProperties, &resourceDesc, D3D12_RESOURCE_STATES(mLayout));
@@ -78,7 +79,8 @@ void Buffer::BuildCBV()
     cbvd.SizeInBytes = mSize;
     if (mCBV.Valid == false)
         mCBV = mHeaps[DescriptorHeapType::ShaderResource]->Allocate();
-    mParentDevice->GetDevice()->CreateConstantBufferView(&cbvd, mCBV.CPU);
+    if (!mParentDevice->IsNull())
+        mParentDevice->GetDevice()->CreateConstantBufferView(&cbvd, mCBV.CPU);
 }
 
 void Buffer::BuildUAV()
@@ -93,7 +95,8 @@ void Buffer::BuildUAV()
     uavd.Buffer.CounterOffsetInBytes = 0;
     if (mUAV.Valid == false)
         mUAV = mHeaps[DescriptorHeapType::ShaderResource]->Allocate();
-    mParentDevice->GetDevice()->CreateUnorderedAccessView(mResource, nullptr, &uavd, mUAV.CPU);
+    if (!mParentDevice->IsNull())
+        mParentDevice->GetDevice()->CreateUnorderedAccessView(mResource, nullptr, &uavd, mUAV.CPU);
 }
 
 void Buffer::BuildSRV()
@@ -108,7 +111,8 @@ void Buffer::BuildSRV()
     srv.Buffer.StructureByteStride = mStride;
     if (mSRV.Valid == false)
         mSRV = mHeaps[DescriptorHeapType::ShaderResource]->Allocate();
-    mParentDevice->GetDevice()->CreateShaderResourceView(mResource, &srv, mSRV.CPU);
+    if (!mParentDevice->IsNull())
+        mParentDevice->GetDevice()->CreateShaderResourceView(mResource, &srv, mSRV.CPU);
 }
 
 void Buffer::Map(int start, int end, void **data)
@@ -117,6 +121,11 @@ void Buffer::Map(int start, int end, void **data)
     range.Begin = start;
     range.End = end;
 
+    if (!mResource) {
+        *data = mMemory.data();
+        return;
+    }
+
     if (range.End > range.Begin) {
         if (FAILED(mResource->Map(0, &range, data))) {
             LOG_ERROR("Failed to map buffer!");
@@ -134,6 +143,10 @@ void Buffer::Unmap(int start, int end)
     range.Begin = start;
     range.End = end;
 
+    if (!mResource) {
+        return;
+    }
+
     if (range.End > range.Begin) {
         mResource->Unmap(0, &range);
     } else {
@@ -23,7 +23,7 @@ enum class BufferType
 class Buffer : public Resource
 {
 public:
-    using Ref = Ref<Buffer>;
+    using Ref = ::Ref<Buffer>;
 
     Buffer(Device::Ref device, DescriptorHeaps heaps, UInt64 size, UInt64 stride, BufferType type, const String& name = "Buffer");
     ~Buffer();
@@ -8,20 +8,42 @@
 #include <Core/Assert.hpp>
 
 #include <imgui.h>
-#include <imgui_impl_dx12.h>
-#include <imgui_impl_win32.h>
-
-#include <PIX/pix3.h>
+#if defined(_WIN32)
+    #include <imgui_impl_dx12.h>
+    #include <imgui_impl_win32.h>
+
+    #include <PIX/pix3.h>
+#else
+    // No PIX off Windows, markers still land in the timestamps and the command stream
+    #define PIX_COLOR_DEFAULT 0
+    #define PIXBeginEvent(...)
+    #define PIXEndEvent(...)
+#endif
 #include <Statistics.hpp>
 
+// Copies out of an upload heap are what the CPU hands to the GPU
+static bool IsUpload(::Ref<Resource> resource)
+{
+    return resource->GetHeapType() == D3D12_HEAP_TYPE_UPLOAD;
+}
+
 CommandBuffer::CommandBuffer(Device::Ref device, Queue::Ref queue, DescriptorHeaps heaps, bool singleTime)
-    : mSingleTime(singleTime), mParentQueue(queue), mHeaps(heaps), mDevice(device)
+    : mSingleTime(singleTime), mParentQueue(queue), mHeaps(heaps), mDevice(device), mBarriers([this](const D3D12_RESOURCE_BARRIER* barriers, UInt32 count) {
+        if (mList) {
+            mList->ResourceBarrier(count, barriers);
+        }
+        Record(CommandOp::FlushBarriers, count);
+        Statistics::Get().BarrierCount += count;
+        Statistics::Get().BarrierCalls++;
+    })
 {
-    HRESULT result = device->GetDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE(queue->GetType()), IID_PPV_ARGS(&mAllocator));
-    ASSERT(SUCCEEDED(result), "Failed to create command allocator!");
+    mRecord = device->IsNull();
+    if (mRecord) {
+        return;
+    }
 
-    result = device->GetDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE(queue->GetType()), mAllocator, nullptr, IID_PPV_ARGS(&mList));
-    ASSERT(SUCCEEDED(result), "Failed to create command list!");
+    CreateList(&mAllocator, &mList);
+    mSegments.push_back({ mAllocator, mList });
 
     if (!singleTime) {
         mList->Close();
@@ -30,17 +52,24 @@ CommandBuffer::CommandBuffer(Device::Ref device, Queue::Ref queue, DescriptorHea
 
 CommandBuffer::~CommandBuffer()
 {
-    D3DUtils::Release(mAllocator);
-    D3DUtils::Release(mList);
+    mChildren.clear();
+    for (auto& [allocator, list] : mSegments) {
+        D3DUtils::Release(allocator);
+        D3DUtils::Release(list);
+    }
 }
 
-void CommandBuffer::Begin()
+void CommandBuffer::CreateList(ID3D12CommandAllocator** allocator, ID3D12GraphicsCommandList10** list)
 {
-    if (!mSingleTime) {
-        mAllocator->Reset();
-        mList->Reset(mAllocator, nullptr);
-    }
+    HRESULT result = mDevice->GetDevice()->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE(mParentQueue->GetType()), IID_PPV_ARGS(allocator));
+    ASSERT(SUCCEEDED(result), "Failed to create command allocator!");
+
+    result = mDevice->GetDevice()->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE(mParentQueue->GetType()), *allocator, nullptr, IID_PPV_ARGS(list));
+    ASSERT(SUCCEEDED(result), "Failed to create command list!");
+}
 
+void CommandBuffer::BindHeaps()
+{
     ID3D12DescriptorHeap* heaps[] = {
         mHeaps[DescriptorHeapType::ShaderResource]->GetHeap(),
         mHeaps[DescriptorHeapType::Sampler]->GetHeap()
@@ -48,34 +77,147 @@ void CommandBuffer::Begin()
     mList->SetDescriptorHeaps(2, heaps);
 }
 
-void CommandBuffer::UAVBarrier(::Ref<Resource> resource)
+void CommandBuffer::Begin()
 {
-    D3D12_RESOURCE_BARRIER Barrier = {};
-    Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-    Barrier.UAV.pResource = resource->GetResource();
+    mSegment = 0;
+    mForked = 0;
+    mJoined = 0;
+    mLists.clear();
+    mMarkers.clear();
+    mOpen.clear();
+    mStream.Clear();
+    if (mQueries && !mChild) {
+        mQueries->Reset();
+    }
+    if (mSegments.empty()) {
+        return;
+    }
 
-    mList->ResourceBarrier(1, &Barrier);
+    mAllocator = mSegments[0].first;
+    mList = mSegments[0].second;
+    if (!mSingleTime) {
+        mAllocator->Reset();
+        mList->Reset(mAllocator, nullptr);
+    }
+    BindHeaps();
 }
 
-void CommandBuffer::Barrier(::Ref<Resource> resource, ResourceLayout layout, UInt32 mip)
+Vector<CommandBuffer::Ref> CommandBuffer::Fork(UInt32 count)
 {
-    D3D12_RESOURCE_BARRIER Barrier = {};
-    Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    Barrier.Transition.pResource = resource->GetResource();
-    Barrier.Transition.StateBefore = D3D12_RESOURCE_STATES(resource->GetLayout());
-    Barrier.Transition.StateAfter = D3D12_RESOURCE_STATES(layout);
-    Barrier.Transition.Subresource = mip == VIEW_ALL_MIPS ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : mip;
-    
-    if (Barrier.Transition.StateBefore == D3D12_RESOURCE_STATE_UNORDERED_ACCESS && Barrier.Transition.StateAfter == D3D12_RESOURCE_STATE_UNORDERED_ACCESS) {
-        Barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
-        Barrier.UAV.pResource = resource->GetResource();
+    ASSERT(mForked == mJoined, "Command buffer forked again before joining!");
+
+    // Split barriers can't cross lists, and what's pending has to land before the forked work
+    mBarriers.EndAll();
+    // PIX events stay within a list, Join() opens them again. The timestamps don't care.
+    if (mList) {
+        for (UInt32 i = 0; i < mOpen.size(); i++) {
+            PIXEndEvent(mList);
+        }
+        mList->Close();
+        mLists.push_back(mList);
+    }
+
+    Vector<Ref> buffers;
+    for (UInt32 i = 0; i < count; i++) {
+        if (mForked == mChildren.size()) {
+            mChildren.push_back(MakeRef<CommandBuffer>(mDevice, mParentQueue, mHeaps));
+        }
+        Ref buffer = mChildren[mForked++];
+        buffer->mQueries = mQueries;
+        buffer->mChild = true;
+        buffer->mBaseDepth = mBaseDepth + mOpen.size();
+        buffer->mRecord = mRecord;
+        buffer->Begin();
+        buffers.push_back(buffer);
+    }
+    return buffers;
+}
+
+void CommandBuffer::Join()
+{
+    for (; mJoined < mForked; mJoined++) {
+        mChildren[mJoined]->End();
+
+        const Vector<ID3D12CommandList*>& lists = mChildren[mJoined]->GetLists();
+        mLists.insert(mLists.end(), lists.begin(), lists.end());
+
+        const Vector<Marker>& markers = mChildren[mJoined]->mMarkers;
+        mMarkers.insert(mMarkers.end(), markers.begin(), markers.end());
+
+        if (mRecord) {
+            mStream.Append(mChildren[mJoined]->mStream);
+        }
+    }
+    if (mSegments.empty()) {
+        return;
+    }
+
+    // The previous segment is closed but not executed yet, so it keeps its allocator
+    mSegment++;
+    if (mSegment == mSegments.size()) {
+        ID3D12CommandAllocator* allocator = nullptr;
+        ID3D12GraphicsCommandList10* list = nullptr;
+        CreateList(&allocator, &list);
+        mSegments.push_back({ allocator, list });
     } else {
-        if (resource->GetLayout() == layout)
-            return;
+        mSegments[mSegment].first->Reset();
+        mSegments[mSegment].second->Reset(mSegments[mSegment].first, nullptr);
+    }
+    mAllocator = mSegments[mSegment].first;
+    mList = mSegments[mSegment].second;
+    BindHeaps();
+
+    for (UInt32 index : mOpen) {
+        PIXBeginEvent(mList, PIX_COLOR_DEFAULT, mMarkers[index].Name.data());
+    }
+}
+
+void CommandBuffer::UAVBarrier(::Ref<Resource> resource)
+{
+    Record(CommandOp::UAVBarrier, resource.get());
+    mBarriers.UAV(resource.get());
+}
+
+void CommandBuffer::Barrier(::Ref<Resource> resource, ResourceLayout layout, UInt32 mip)
+{
+    Record(CommandOp::Barrier, CommandStream::BarrierData{ resource.get(), UInt32(layout), mip });
+    mBarriers.Transition(resource.get(), layout, mip);
+}
+
+void CommandBuffer::Barrier(const BarrierGroup& group)
+{
+    for (auto& [before, after] : group.Aliases) {
+        Record(CommandOp::AliasBarrier, CommandStream::AliasData{ before.get(), after.get() });
+        mBarriers.Aliasing(before.get(), after.get());
+    }
+    for (auto& [resource, layout] : group.Transitions) {
+        Record(CommandOp::Barrier, CommandStream::BarrierData{ resource.get(), UInt32(layout), VIEW_ALL_MIPS });
+        mBarriers.Transition(resource.get(), layout);
+    }
+    for (auto& resource : group.UAVs) {
+        Record(CommandOp::UAVBarrier, resource.get());
+        mBarriers.UAV(resource.get());
+    }
+}
+
+void CommandBuffer::BeginBarrier(::Ref<Resource> resource, ResourceLayout layout)
+{
+    Record(CommandOp::BeginBarrier, CommandStream::BarrierData{ resource.get(), UInt32(layout), VIEW_ALL_MIPS });
+    mBarriers.BeginTransition(resource.get(), layout);
+}
+
+void CommandBuffer::FlushBarriers()
+{
+    mBarriers.Flush();
+}
+
+void CommandBuffer::Discard(::Ref<Resource> resource)
+{
+    mBarriers.Flush();
+    Record(CommandOp::Discard, resource.get());
+    if (mList) {
+        mList->DiscardResource(resource->GetResource(), nullptr);
     }
-    
-    mList->ResourceBarrier(1, &Barrier);
-    resource->SetLayout(layout);
 }
 
 void CommandBuffer::SetViewport(float x, float y, float width, float height)
@@ -89,33 +231,46 @@ void CommandBuffer::SetViewport(float x, float y, float width, float height)
     Viewport.TopLeftY = y;
 
     D3D12_RECT Rect = {};
-    Rect.right = width;
-    Rect.bottom = height;
-    Rect.top = 0.0f;
-    Rect.left = 0.0f;
+    Rect.right = x + width;
+    Rect.bottom = y + height;
+    Rect.top = y;
+    Rect.left = x;
 
     if (Rect.right < 0 || Rect.bottom < 0)
         return;
 
-    mList->RSSetViewports(1, &Viewport);
-    mList->RSSetScissorRects(1, &Rect);
+    Record(CommandOp::SetViewport, CommandStream::ViewportData{ x, y, width, height });
+    if (mList) {
+        mList->RSSetViewports(1, &Viewport);
+        mList->RSSetScissorRects(1, &Rect);
+    }
 }
 
 void CommandBuffer::SetTopology(Topology topology)
 {
-    mList->IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY(topology));
+    mTopology = topology;
+    Record(CommandOp::SetTopology, UInt32(topology));
+    if (mList) {
+        mList->IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY(topology));
+    }
 }
 
 void CommandBuffer::SetGraphicsPipeline(GraphicsPipeline::Ref pipeline)
 {
-    mList->SetPipelineState(pipeline->GetPipeline());
-    mList->SetGraphicsRootSignature(pipeline->GetRootSignature()->GetSignature());
+    Record(CommandOp::SetGraphicsPipeline, pipeline.get());
+    if (mList) {
+        mList->SetPipelineState(pipeline->GetPipeline());
+        mList->SetGraphicsRootSignature(pipeline->GetRootSignature()->GetSignature());
+    }
 }
 
 void CommandBuffer::SetComputePipeline(ComputePipeline::Ref pipeline)
 {
-    mList->SetPipelineState(pipeline->GetPipeline());
-    mList->SetComputeRootSignature(pipeline->GetSignature()->GetSignature());
+    Record(CommandOp::SetComputePipeline, pipeline.get());
+    if (mList) {
+        mList->SetPipelineState(pipeline->GetPipeline());
+        mList->SetComputeRootSignature(pipeline->GetSignature()->GetSignature());
+    }
 }
 
 void CommandBuffer::SetRenderTargets(const Vector<View::Ref> targets, View::Ref depth)
@@ -127,66 +282,183 @@ void CommandBuffer::SetRenderTargets(const Vector<View::Ref> targets, View::Ref
     D3D12_CPU_DESCRIPTOR_HANDLE depth_cpu = {};
     if (depth) depth_cpu = depth->GetDescriptor().CPU;
 
-    mList->OMSetRenderTargets(cpus.size(), cpus.data(), false, depth ? &depth_cpu : nullptr);
+    if (mRecord) {
+        CommandStream::RenderTargetsData data = {};
+        data.Count = std::min<UInt32>(targets.size(), CommandStream::MAX_RENDER_TARGETS);
+        data.Depth = depth.get();
+        for (UInt32 i = 0; i < data.Count; i++) {
+            data.Targets[i] = targets[i].get();
+        }
+        mStream.Write(CommandOp::SetRenderTargets, data);
+    }
+    if (mList) {
+        mList->OMSetRenderTargets(cpus.size(), cpus.data(), false, depth ? &depth_cpu : nullptr);
+    }
 }
 
 void CommandBuffer::SetVertexBuffer(Buffer::Ref buffer)
 {
-    mList->IASetVertexBuffers(0, 1, &buffer->mVBV);
+    Record(CommandOp::SetVertexBuffer, static_cast<Resource*>(buffer.get()));
+    if (mList) {
+        mList->IASetVertexBuffers(0, 1, &buffer->mVBV);
+    }
 }
 
 void CommandBuffer::SetIndexBuffer(Buffer::Ref buffer)
 {
-    mList->IASetIndexBuffer(&buffer->mIBV);
+    Record(CommandOp::SetIndexBuffer, static_cast<Resource*>(buffer.get()));
+    if (mList) {
+        mList->IASetIndexBuffer(&buffer->mIBV);
+    }
+}
+
+void CommandBuffer::RecordPushConstants(CommandOp op, const void* data, UInt32 size, int index)
+{
+    if (!mRecord) {
+        return;
+    }
+
+    // Root constants can't go over 64 DWORDs
+    UInt8 payload[sizeof(Int32) + 256];
+    ASSERT(size <= 256, "Push constants are too big!");
+    Int32 root = index;
+    memcpy(payload, &root, sizeof(Int32));
+    memcpy(payload + sizeof(Int32), data, size);
+    mStream.Write(op, payload, sizeof(Int32) + size);
 }
 
 void CommandBuffer::GraphicsPushConstants(const void *data, UInt32 size, int index)
 {
-    mList->SetGraphicsRoot32BitConstants(index, size / 4, data, 0);
+    RecordPushConstants(CommandOp::GraphicsPushConstants, data, size, index);
+    if (mList) {
+        mList->SetGraphicsRoot32BitConstants(index, size / 4, data, 0);
+    }
 }
 
 void CommandBuffer::ComputePushConstants(const void *data, UInt32 size, int index)
 {
-    mList->SetComputeRoot32BitConstants(index, size / 4, data, 0);
+    RecordPushConstants(CommandOp::ComputePushConstants, data, size, index);
+    if (mList) {
+        mList->SetComputeRoot32BitConstants(index, size / 4, data, 0);
+    }
 }
 
 void CommandBuffer::ClearDepth(View::Ref view)
 {
-    mList->ClearDepthStencilView(view->GetDescriptor().CPU, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    mBarriers.Flush();
+    Record(CommandOp::ClearDepth, view.get());
+    if (mList) {
+        mList->ClearDepthStencilView(view->GetDescriptor().CPU, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    }
+}
+
+void CommandBuffer::ClearDepth(View::Ref view, UInt32 x, UInt32 y, UInt32 width, UInt32 height)
+{
+    mBarriers.Flush();
+    Record(CommandOp::ClearDepth, view.get());
+
+    D3D12_RECT rect = { LONG(x), LONG(y), LONG(x + width), LONG(y + height) };
+    if (mList) {
+        mList->ClearDepthStencilView(view->GetDescriptor().CPU, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 1, &rect);
+    }
 }
 
 void CommandBuffer::ClearRenderTarget(View::Ref view, float r, float g, float b)
 {
+    mBarriers.Flush();
+    Record(CommandOp::ClearRenderTarget, CommandStream::ClearData{ view.get(), { r, g, b } });
+
     float clear[] = { r, g, b, 1.0f };
-    mList->ClearRenderTargetView(view->GetDescriptor().CPU, clear, 0, nullptr);
+    if (mList) {
+        mList->ClearRenderTargetView(view->GetDescriptor().CPU, clear, 0, nullptr);
+    }
 }
 
-void CommandBuffer::Draw(int vertexCount)
+void CommandBuffer::Draw(int vertexCount, int instanceCount)
 {
-    mList->DrawInstanced(vertexCount, 1, 0, 0);
+    mBarriers.Flush();
+    // The stream keeps one count per draw, instances are folded into it
+    Record(CommandOp::Draw, UInt32(vertexCount * instanceCount));
+    if (mList) {
+        mList->DrawInstanced(vertexCount, instanceCount, 0, 0);
+    }
+    CountTriangles(vertexCount, instanceCount);
     Statistics::Get().DrawCallCount++;
 }
 
 void CommandBuffer::DrawIndexed(int indexCount)
 {
-    mList->DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
-    Statistics::Get().TriangleCount += indexCount / 3;
+    mBarriers.Flush();
+    Record(CommandOp::DrawIndexed, UInt32(indexCount));
+    if (mList) {
+        mList->DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
+    }
+    CountTriangles(indexCount, 1);
     Statistics::Get().DrawCallCount++;
 }
 
+void CommandBuffer::CountTriangles(UInt32 vertexCount, UInt32 instanceCount)
+{
+    UInt32 triangles = 0;
+    if (mTopology == Topology::TriangleList) {
+        triangles = vertexCount / 3;
+    } else if (mTopology == Topology::TriangleStrip) {
+        triangles = vertexCount > 2 ? vertexCount - 2 : 0;
+    }
+    Statistics::Get().TriangleCount += UInt64(triangles) * instanceCount;
+}
+
 void CommandBuffer::Dispatch(int x, int y, int z)
 {
-    mList->Dispatch(x, y, z);
+    mBarriers.Flush();
+    Record(CommandOp::Dispatch, CommandStream::DispatchData{ UInt32(x), UInt32(y), UInt32(z) });
+    if (mList) {
+        mList->Dispatch(x, y, z);
+    }
     Statistics::Get().DispatchCount += 1;
 }
 
 void CommandBuffer::CopyBufferToBuffer(::Ref<Resource> dst, ::Ref<Resource> src)
 {
+    mBarriers.Flush();
+    Statistics::Get().CopyCount++;
+
+    // Null resources copy whatever memory they have when the queue runs it
+    if (!mList) {
+        UInt64 size = src->GetMemory().size();
+        Record(CommandOp::CopyBufferToBuffer, CommandStream::CopyData{ dst.get(), src.get(), size });
+        if (IsUpload(src)) {
+            Statistics::Get().UploadBytes += size;
+        }
+        return;
+    }
+    Record(CommandOp::CopyBufferToBuffer, CommandStream::CopyData{ dst.get(), src.get(), dst->GetSize() });
     mList->CopyResource(dst->GetResource(), src->GetResource());
+
+    if (IsUpload(src)) {
+        // Textures go through here too, their width isn't in bytes
+        D3D12_RESOURCE_DESC desc = dst->GetResource()->GetDesc();
+        UInt64 size = desc.Width;
+        if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER) {
+            mDevice->GetDevice()->GetCopyableFootprints(&desc, 0, desc.MipLevels * desc.DepthOrArraySize, 0, nullptr, nullptr, nullptr, &size);
+        }
+        Statistics::Get().UploadBytes += size;
+    }
 }
 
 void CommandBuffer::CopyBufferToTexture(::Ref<Resource> dst, ::Ref<Resource> src)
 {
+    mBarriers.Flush();
+    if (!mList) {
+        UInt64 size = src->GetMemory().size();
+        Record(CommandOp::CopyBufferToTexture, CommandStream::CopyData{ dst.get(), src.get(), size });
+        Statistics::Get().CopyCount++;
+        if (IsUpload(src)) {
+            Statistics::Get().UploadBytes += size;
+        }
+        return;
+    }
+
     D3D12_RESOURCE_DESC desc = dst->GetResource()->GetDesc();
 
     Vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(desc.MipLevels);
@@ -209,6 +481,11 @@ void CommandBuffer::CopyBufferToTexture(::Ref<Resource> dst, ::Ref<Resource> src
 
         mList->CopyTextureRegion(&dstCopy, 0, 0, 0, &srcCopy, nullptr);
     }
+    Record(CommandOp::CopyBufferToTexture, CommandStream::CopyData{ dst.get(), src.get(), totalSize });
+    Statistics::Get().CopyCount++;
+    if (IsUpload(src)) {
+        Statistics::Get().UploadBytes += totalSize;
+    }
 }
 
 void CommandBuffer::UpdateTLAS(TLAS::Ref tlas, Buffer::Ref instanceBuffer, int numInstances)
@@ -223,7 +500,11 @@ void CommandBuffer::UpdateTLAS(TLAS::Ref tlas, Buffer::Ref instanceBuffer, int n
     buildDesc.SourceAccelerationStructureData =  tlas->GetAddress();
     buildDesc.ScratchAccelerationStructureData = tlas->mScratch->GetAddress();
 
-    mList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+    mBarriers.Flush();
+    Record(CommandOp::BuildAccelerationStructure, static_cast<Resource*>(tlas.get()));
+    if (mList) {
+        mList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+    }
 }
 
 void CommandBuffer::BuildAccelerationStructure(::Ref<AccelerationStructure> as)
@@ -233,22 +514,91 @@ void CommandBuffer::BuildAccelerationStructure(::Ref<AccelerationStructure> as)
     buildDesc.DestAccelerationStructureData = as->GetAddress();
     buildDesc.ScratchAccelerationStructureData = as->mScratch->GetAddress();
 
-    mList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+    mBarriers.Flush();
+    Record(CommandOp::BuildAccelerationStructure, static_cast<Resource*>(as.get()));
+    if (mList) {
+        mList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+    }
 }
 
 void CommandBuffer::End()
 {
+    ASSERT(mForked == mJoined, "Command buffer ended before joining!");
+
+    mBarriers.EndAll();
+    if (!mList) {
+        return;
+    }
+    if (mQueries && !mChild) {
+        mQueries->Resolve(mList);
+        mResolvedMarkers.swap(mMarkers);
+    }
     mList->Close();
+    mLists.push_back(mList);
 }
 
 void CommandBuffer::BeginMarker(const String& name)
 {
-    PIXBeginEvent(mList, PIX_COLOR_DEFAULT, name.data());
+    Record(CommandOp::BeginMarker, name.data(), name.size());
+    if (mList) {
+        PIXBeginEvent(mList, PIX_COLOR_DEFAULT, name.data());
+    }
+
+    Marker marker;
+    marker.Name = name;
+    marker.Depth = mBaseDepth + mOpen.size();
+    if (mQueries && mList) {
+        marker.Begin = mQueries->Allocate();
+        if (marker.Begin != UINT32_MAX) {
+            mList->EndQuery(mQueries->GetHeap(), D3D12_QUERY_TYPE_TIMESTAMP, marker.Begin);
+        }
+    }
+    mOpen.push_back(mMarkers.size());
+    mMarkers.push_back(marker);
 }
 
 void CommandBuffer::EndMarker()
 {
-    PIXEndEvent(mList);
+    Record(CommandOp::EndMarker);
+    if (mList) {
+        PIXEndEvent(mList);
+    }
+    if (mOpen.empty()) {
+        return;
+    }
+
+    Marker& marker = mMarkers[mOpen.back()];
+    mOpen.pop_back();
+    if (mQueries && marker.Begin != UINT32_MAX) {
+        marker.End = mQueries->Allocate();
+        if (marker.End != UINT32_MAX) {
+            mList->EndQuery(mQueries->GetHeap(), D3D12_QUERY_TYPE_TIMESTAMP, marker.End);
+        }
+    }
+}
+
+void CommandBuffer::EnableTimestamps(QueryHeap::Ref queries)
+{
+    mQueries = queries;
+}
+
+bool CommandBuffer::ReadTimestamps(UInt64 frequency, Vector<TimingTree::Marker>& markers)
+{
+    if (!mQueries || mChild || mResolvedMarkers.empty()) {
+        return false;
+    }
+
+    Vector<UInt64> timestamps;
+    mQueries->Read(timestamps);
+    for (const Marker& marker : mResolvedMarkers) {
+        // Markers past the end of the heap, or never closed, just go without
+        if (marker.Begin >= timestamps.size() || marker.End >= timestamps.size() || timestamps[marker.End] < timestamps[marker.Begin]) {
+            continue;
+        }
+        markers.push_back({ marker.Name, marker.Depth, float(double(timestamps[marker.End] - timestamps[marker.Begin]) * 1000.0 / frequency) });
+    }
+    mResolvedMarkers.clear();
+    return true;
 }
 
 void CommandBuffer::BeginGUI(int width, int height)
@@ -257,8 +607,16 @@ void CommandBuffer::BeginGUI(int width, int height)
     io.DisplaySize.x = width;
     io.DisplaySize.y = height;
 
+    // No platform or renderer backend without D3D12, ImGui still builds its draw data
+    if (!mList) {
+        ImGui::NewFrame();
+        return;
+    }
+
+#if defined(_WIN32)
     ImGui_ImplDX12_NewFrame();
     ImGui_ImplWin32_NewFrame();
+#endif
     ImGui::NewFrame();
 }
 
@@ -266,9 +624,19 @@ void CommandBuffer::EndGUI()
 {
     ImGuiIO& io = ImGui::GetIO();
 
+    if (!mList) {
+        mBarriers.Flush();
+        ImGui::Render();
+        Record(CommandOp::RenderGUI, UInt32(ImGui::GetDrawData()->TotalVtxCount));
+        return;
+    }
+
     ID3D12DescriptorHeap* pHeaps[] = { mHeaps[DescriptorHeapType::ShaderResource]->GetHeap(), mHeaps[DescriptorHeapType::Sampler]->GetHeap() };
     mList->SetDescriptorHeaps(2, pHeaps);
 
+    mBarriers.Flush();
     ImGui::Render();
+#if defined(_WIN32)
     ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), mList);
+#endif
 }
@@ -13,6 +13,11 @@
 #include <RHI/Buffer.hpp>
 #include <RHI/AccelerationStructure.hpp>
 #include <RHI/TLAS.hpp>
+#include <RHI/BarrierBatch.hpp>
+#include <RHI/QueryHeap.hpp>
+#include <RHI/CommandStream.hpp>
+
+#include <Core/TimingTree.hpp>
 
 enum class Topology
 {
@@ -23,10 +28,19 @@ enum class Topology
     TriangleStrip = D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP
 };
 
+// Everything in a group lands in the same barrier batch
+struct BarrierGroup
+{
+    // Before can be null when the previous occupant of the memory isn't known
+    Vector<Pair<::Ref<Resource>, ::Ref<Resource>>> Aliases;
+    Vector<Pair<::Ref<Resource>, ResourceLayout>> Transitions;
+    Vector<::Ref<Resource>> UAVs;
+};
+
 class CommandBuffer
 {
 public:
-    using Ref = Ref<CommandBuffer>;
+    using Ref = ::Ref<CommandBuffer>;
  
     CommandBuffer(Device::Ref device, Queue::Ref queue, DescriptorHeaps heaps, bool singleTime = false);
     ~CommandBuffer();
@@ -34,11 +48,29 @@ public:
     void Begin();
     void End();
 
+    // Hands out count buffers for other threads to record into. They run after everything recorded so far and before
+    // anything recorded after Join(), which has to be called once the workers are done. No state carries over either way.
+    Vector<Ref> Fork(UInt32 count);
+    void Join();
+
+    // With timestamps enabled, every marker also times itself on the GPU
     void BeginMarker(const String& name);
     void EndMarker();
 
+    // Forked buffers share the heap of their parent
+    void EnableTimestamps(QueryHeap::Ref queries);
+    // Marker timings of the last submission of this buffer, once the GPU is done with it. False when there's nothing to read.
+    bool ReadTimestamps(UInt64 frequency, Vector<TimingTree::Marker>& markers);
+
+    // Barriers are batched and only submitted right before the next draw, dispatch, clear or copy
     void UAVBarrier(::Ref<Resource> resource);
     void Barrier(::Ref<Resource> resource, ResourceLayout layout, UInt32 mip = VIEW_ALL_MIPS);
+    void Barrier(const BarrierGroup& group);
+    // Split barrier, ended by the next Barrier() on the resource. Use it when the consumer is a few passes away.
+    void BeginBarrier(::Ref<Resource> resource, ResourceLayout layout);
+    void FlushBarriers();
+    // Contents become undefined, required before the first use of an aliased render or depth target
+    void Discard(::Ref<Resource> resource);
     
     void SetViewport(float x, float y, float width, float height);
     void SetTopology(Topology topology);
@@ -52,9 +84,11 @@ public:
     void ComputePushConstants(const void *data, UInt32 size, int index);
 
     void ClearDepth(View::Ref view);
+    // Only clears the rectangle, for views that share an atlas
+    void ClearDepth(View::Ref view, UInt32 x, UInt32 y, UInt32 width, UInt32 height);
     void ClearRenderTarget(View::Ref view, float r, float g, float b);
 
-    void Draw(int vertexCount);
+    void Draw(int vertexCount, int instanceCount = 1);
     void DrawIndexed(int indexCount);
     void Dispatch(int x, int y, int z);
 
@@ -68,13 +102,72 @@ public:
     void BeginGUI(int width, int height);
     void EndGUI();
 
+    const BarrierStats& GetBarrierStats() const { return mBarriers.GetStats(); }
+
+    // Always on for the null backend, where the stream is all there is. Forked buffers follow their parent.
+    void SetRecording(bool record) { mRecord = record; }
+    // What was recorded since Begin(), joined children included
+    const CommandStream& GetStream() const { return mStream; }
+
+    // Everything recorded since Begin(), in submission order. Complete after End().
+    const Vector<ID3D12CommandList*>& GetLists() const { return mLists; }
+
     ID3D12GraphicsCommandList10* GetList() { return mList; }
     operator ID3D12CommandList*() { return mList; }
 private:
+    struct Marker
+    {
+        String Name;
+        UInt32 Depth;
+        UInt32 Begin = UINT32_MAX;
+        UInt32 End = UINT32_MAX;
+    };
+
+    void CreateList(ID3D12CommandAllocator** allocator, ID3D12GraphicsCommandList10** list);
+    void BindHeaps();
+
+    template<typename T>
+    void Record(CommandOp op, const T& payload)
+    {
+        if (mRecord) {
+            mStream.Write(op, payload);
+        }
+    }
+    void Record(CommandOp op, const void* data = nullptr, UInt32 size = 0)
+    {
+        if (mRecord) {
+            mStream.Write(op, data, size);
+        }
+    }
+    void RecordPushConstants(CommandOp op, const void* data, UInt32 size, int index);
+    // For the statistics, lines and points aren't triangles
+    void CountTriangles(UInt32 vertexCount, UInt32 instanceCount);
+
     bool mSingleTime;
     Device::Ref mDevice = nullptr;
     Queue::Ref mParentQueue = nullptr;
     DescriptorHeaps mHeaps;
     ID3D12CommandAllocator* mAllocator = nullptr;
     ID3D12GraphicsCommandList10* mList = nullptr;
+    BarrierBatch mBarriers;
+    Topology mTopology = Topology::TriangleList;
+
+    // mAllocator and mList are the current segment, Join() moves on to the next one. All of it gets reused every frame.
+    Vector<Pair<ID3D12CommandAllocator*, ID3D12GraphicsCommandList10*>> mSegments;
+    UInt32 mSegment = 0;
+    Vector<Ref> mChildren;
+    UInt32 mForked = 0;
+    UInt32 mJoined = 0;
+    Vector<ID3D12CommandList*> mLists;
+
+    // In the order they began, children's included once joined. mOpen indexes the ones not ended yet.
+    QueryHeap::Ref mQueries = nullptr;
+    bool mChild = false;
+    UInt32 mBaseDepth = 0;
+    Vector<Marker> mMarkers;
+    Vector<UInt32> mOpen;
+    Vector<Marker> mResolvedMarkers;
+
+    bool mRecord = false;
+    CommandStream mStream;
 };
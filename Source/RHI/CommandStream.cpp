@@ -0,0 +1,242 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:29:02
+//
+
+#include <RHI/CommandStream.hpp>
+#include <Core/Assert.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Checks.hpp>
+
+#include <sstream>
+
+// Op, then the payload size
+constexpr UInt32 HEADER_SIZE = 4;
+
+void CommandStream::Clear()
+{
+    mData.clear();
+    mCounts.fill(0);
+}
+
+void CommandStream::Write(CommandOp op, const void* data, UInt32 size)
+{
+    ASSERT(size <= UINT16_MAX, "Command payload is too big!");
+
+    UInt64 offset = mData.size();
+    mData.resize(offset + HEADER_SIZE + size);
+
+    UInt8* header = mData.data() + offset;
+    header[0] = UInt8(op);
+    header[1] = 0;
+    header[2] = UInt8(size & 0xFF);
+    header[3] = UInt8(size >> 8);
+    if (size) {
+        memcpy(header + HEADER_SIZE, data, size);
+    }
+    mCounts[UInt32(op)]++;
+}
+
+void CommandStream::Append(const CommandStream& other)
+{
+    mData.insert(mData.end(), other.mData.begin(), other.mData.end());
+    for (UInt32 i = 0; i < mCounts.size(); i++) {
+        mCounts[i] += other.mCounts[i];
+    }
+}
+
+void CommandStream::Replay(const std::function<void(const Command&)>& visit) const
+{
+    UInt64 offset = 0;
+    while (offset + HEADER_SIZE <= mData.size()) {
+        const UInt8* header = mData.data() + offset;
+
+        Command command;
+        command.Op = CommandOp(header[0]);
+        command.Size = UInt32(header[2]) | (UInt32(header[3]) << 8);
+        command.Data = header + HEADER_SIZE;
+        visit(command);
+
+        offset += HEADER_SIZE + command.Size;
+    }
+}
+
+UInt64 CommandStream::GetCommandCount() const
+{
+    UInt64 count = 0;
+    for (UInt64 value : mCounts) {
+        count += value;
+    }
+    return count;
+}
+
+const char* CommandStream::GetName(CommandOp op)
+{
+    switch (op) {
+        case CommandOp::BeginMarker: return "BeginMarker";
+        case CommandOp::EndMarker: return "EndMarker";
+        case CommandOp::Barrier: return "Barrier";
+        case CommandOp::BeginBarrier: return "BeginBarrier";
+        case CommandOp::UAVBarrier: return "UAVBarrier";
+        case CommandOp::AliasBarrier: return "AliasBarrier";
+        case CommandOp::FlushBarriers: return "FlushBarriers";
+        case CommandOp::Discard: return "Discard";
+        case CommandOp::SetViewport: return "SetViewport";
+        case CommandOp::SetTopology: return "SetTopology";
+        case CommandOp::SetGraphicsPipeline: return "SetGraphicsPipeline";
+        case CommandOp::SetComputePipeline: return "SetComputePipeline";
+        case CommandOp::SetRenderTargets: return "SetRenderTargets";
+        case CommandOp::SetVertexBuffer: return "SetVertexBuffer";
+        case CommandOp::SetIndexBuffer: return "SetIndexBuffer";
+        case CommandOp::GraphicsPushConstants: return "GraphicsPushConstants";
+        case CommandOp::ComputePushConstants: return "ComputePushConstants";
+        case CommandOp::ClearDepth: return "ClearDepth";
+        case CommandOp::ClearRenderTarget: return "ClearRenderTarget";
+        case CommandOp::Draw: return "Draw";
+        case CommandOp::DrawIndexed: return "DrawIndexed";
+        case CommandOp::Dispatch: return "Dispatch";
+        case CommandOp::CopyBufferToBuffer: return "CopyBufferToBuffer";
+        case CommandOp::CopyBufferToTexture: return "CopyBufferToTexture";
+        case CommandOp::BuildAccelerationStructure: return "BuildAccelerationStructure";
+        case CommandOp::RenderGUI: return "RenderGUI";
+        default: return "Unknown";
+    }
+}
+
+String CommandStream::Dump() const
+{
+    std::stringstream stream;
+    UInt32 depth = 0;
+    Replay([&](const Command& command) {
+        if (command.Op == CommandOp::EndMarker && depth) {
+            depth--;
+        }
+        stream << String(depth * 2, ' ') << GetName(command.Op);
+
+        switch (command.Op) {
+            case CommandOp::BeginMarker:
+                stream << " " << String((const char*)command.Data, command.Size);
+                depth++;
+                break;
+            case CommandOp::Barrier:
+            case CommandOp::BeginBarrier: {
+                BarrierData barrier = command.As<BarrierData>();
+                stream << " " << barrier.Target << " -> 0x" << std::hex << barrier.Layout << std::dec;
+                break;
+            }
+            case CommandOp::AliasBarrier: {
+                AliasData alias = command.As<AliasData>();
+                stream << " " << alias.Before << " -> " << alias.After;
+                break;
+            }
+            case CommandOp::SetViewport: {
+                ViewportData viewport = command.As<ViewportData>();
+                stream << " " << viewport.Width << "x" << viewport.Height;
+                break;
+            }
+            case CommandOp::SetRenderTargets:
+                stream << " " << command.As<RenderTargetsData>().Count << " targets";
+                break;
+            case CommandOp::GraphicsPushConstants:
+            case CommandOp::ComputePushConstants:
+                stream << " " << (command.Size - sizeof(Int32)) << " bytes";
+                break;
+            case CommandOp::Draw:
+            case CommandOp::DrawIndexed:
+            case CommandOp::FlushBarriers:
+            case CommandOp::RenderGUI:
+                stream << " " << command.As<UInt32>();
+                break;
+            case CommandOp::Dispatch: {
+                DispatchData dispatch = command.As<DispatchData>();
+                stream << " " << dispatch.X << "x" << dispatch.Y << "x" << dispatch.Z;
+                break;
+            }
+            case CommandOp::CopyBufferToBuffer:
+            case CommandOp::CopyBufferToTexture: {
+                CopyData copy = command.As<CopyData>();
+                stream << " " << copy.Src << " -> " << copy.Dst << " (" << copy.Size << " bytes)";
+                break;
+            }
+            default:
+                break;
+        }
+        stream << "\n";
+    });
+    return stream.str();
+}
+
+bool CommandStream::SelfTest()
+{
+    Checks check("CommandStream");
+
+    CommandStream stream;
+    Resource* a = reinterpret_cast<Resource*>(UInt64(0x1000));
+    Resource* b = reinterpret_cast<Resource*>(UInt64(0x2000));
+
+    String name = "Pass";
+    stream.Write(CommandOp::BeginMarker, name.data(), name.size());
+    stream.Write(CommandOp::Barrier, BarrierData{ a, 4, 2 });
+    stream.Write(CommandOp::SetViewport, ViewportData{ 0.0f, 0.0f, 1920.0f, 1080.0f });
+
+    // Odd sized payload, everything after it is unaligned
+    UInt8 constants[4 + 3] = { 1, 0, 0, 0, 7, 8, 9 };
+    stream.Write(CommandOp::GraphicsPushConstants, constants, sizeof(constants));
+    stream.Write(CommandOp::Draw, UInt32(36));
+    stream.Write(CommandOp::CopyBufferToBuffer, CopyData{ b, a, 256 });
+    stream.Write(CommandOp::EndMarker);
+
+    CommandStream child;
+    child.Write(CommandOp::Dispatch, DispatchData{ 8, 4, 1 });
+    child.Write(CommandOp::Draw, UInt32(3));
+    stream.Append(child);
+
+    check(stream.GetCommandCount() == 9, "command count");
+    check(stream.GetCount(CommandOp::Draw) == 2, "per op count after append");
+    check(stream.GetSize() == 9 * HEADER_SIZE + name.size() + sizeof(BarrierData) + sizeof(ViewportData) + sizeof(constants) + 4 + sizeof(CopyData) + sizeof(DispatchData) + 4, "packed size");
+
+    Vector<CommandOp> ops;
+    UInt32 draws = 0;
+    stream.Replay([&](const Command& command) {
+        ops.push_back(command.Op);
+        switch (command.Op) {
+            case CommandOp::BeginMarker:
+                check(String((const char*)command.Data, command.Size) == "Pass", "marker name");
+                break;
+            case CommandOp::Barrier: {
+                BarrierData barrier = command.As<BarrierData>();
+                check(barrier.Target == a && barrier.Layout == 4 && barrier.Mip == 2, "barrier payload");
+                break;
+            }
+            case CommandOp::SetViewport:
+                check(command.As<ViewportData>().Height == 1080.0f, "viewport payload");
+                break;
+            case CommandOp::GraphicsPushConstants:
+                check(command.Size == sizeof(constants) && command.As<Int32>() == 1 && command.Data[6] == 9, "push constant payload");
+                break;
+            case CommandOp::Draw:
+                draws += command.As<UInt32>();
+                break;
+            case CommandOp::CopyBufferToBuffer: {
+                CopyData copy = command.As<CopyData>();
+                check(copy.Dst == b && copy.Src == a && copy.Size == 256, "unaligned copy payload");
+                break;
+            }
+            case CommandOp::Dispatch: {
+                DispatchData dispatch = command.As<DispatchData>();
+                check(dispatch.X == 8 && dispatch.Y == 4 && dispatch.Z == 1, "appended dispatch payload");
+                break;
+            }
+            default:
+                break;
+        }
+    });
+    check(draws == 39, "draw payloads");
+    check(ops.size() == 9 && ops.front() == CommandOp::BeginMarker && ops[6] == CommandOp::EndMarker && ops.back() == CommandOp::Draw, "replay order");
+    check(stream.Dump().find("  Draw 36") != String::npos, "dump nests under markers");
+
+    stream.Clear();
+    check(stream.GetCommandCount() == 0 && stream.GetSize() == 0, "clear");
+
+    return check.Finish();
+}
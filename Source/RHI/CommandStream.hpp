@@ -0,0 +1,147 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:21:37
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+class Resource;
+class View;
+
+enum class CommandOp : UInt8
+{
+    BeginMarker,
+    EndMarker,
+    Barrier,
+    BeginBarrier,
+    UAVBarrier,
+    AliasBarrier,
+    FlushBarriers,
+    Discard,
+    SetViewport,
+    SetTopology,
+    SetGraphicsPipeline,
+    SetComputePipeline,
+    SetRenderTargets,
+    SetVertexBuffer,
+    SetIndexBuffer,
+    GraphicsPushConstants,
+    ComputePushConstants,
+    ClearDepth,
+    ClearRenderTarget,
+    Draw,
+    DrawIndexed,
+    Dispatch,
+    CopyBufferToBuffer,
+    CopyBufferToTexture,
+    BuildAccelerationStructure,
+    RenderGUI,
+    Count
+};
+
+// What a command buffer recorded, as a 4 byte header per command followed by its payload, packed back to back.
+// Payloads point at the recorded objects, so a stream is only good for as long as the frame keeps them alive.
+class CommandStream
+{
+public:
+    static constexpr UInt32 MAX_RENDER_TARGETS = 8;
+
+    struct BarrierData
+    {
+        Resource* Target;
+        UInt32 Layout;
+        UInt32 Mip;
+    };
+
+    struct AliasData
+    {
+        Resource* Before;
+        Resource* After;
+    };
+
+    struct ViewportData
+    {
+        float X;
+        float Y;
+        float Width;
+        float Height;
+    };
+
+    struct RenderTargetsData
+    {
+        UInt32 Count;
+        View* Depth;
+        View* Targets[MAX_RENDER_TARGETS];
+    };
+
+    struct ClearData
+    {
+        View* Target;
+        float Color[3];
+    };
+
+    struct DispatchData
+    {
+        UInt32 X;
+        UInt32 Y;
+        UInt32 Z;
+    };
+
+    struct CopyData
+    {
+        Resource* Dst;
+        Resource* Src;
+        UInt64 Size;
+    };
+
+    // Push constants are their root index followed by the bytes, markers are just the name
+    struct Command
+    {
+        CommandOp Op;
+        UInt32 Size;
+        const UInt8* Data;
+
+        // Payloads aren't aligned, this copies out
+        template<typename T>
+        T As() const
+        {
+            T value = {};
+            memcpy(&value, Data, std::min<UInt32>(sizeof(T), Size));
+            return value;
+        }
+    };
+
+    void Clear();
+    void Write(CommandOp op, const void* data = nullptr, UInt32 size = 0);
+    template<typename T>
+    void Write(CommandOp op, const T& payload)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Command payloads are copied as bytes");
+        Write(op, &payload, sizeof(T));
+    }
+    // For joining forked buffers, keeps the order
+    void Append(const CommandStream& other);
+
+    // In recording order
+    void Replay(const std::function<void(const Command&)>& visit) const;
+
+    UInt64 GetCount(CommandOp op) const { return mCounts[UInt32(op)]; }
+    UInt64 GetCommandCount() const;
+    UInt64 GetSize() const { return mData.size(); }
+
+    static const char* GetName(CommandOp op);
+    // One line per command
+    String Dump() const;
+
+    // Round trips every payload shape, appends and counts
+    static bool SelfTest();
+private:
+    Vector<UInt8> mData;
+    Array<UInt64, UInt32(CommandOp::Count)> mCounts = {};
+};
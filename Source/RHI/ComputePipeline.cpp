@@ -4,11 +4,16 @@
 //
 
 #include <RHI/ComputePipeline.hpp>
+#include <RHI/Utilities.hpp>
 #include <Core/Logger.hpp>
 
 ComputePipeline::ComputePipeline(Device::Ref device, Shader shader, RootSignature::Ref signature)
     : mSignature(signature)
 {
+    if (device->IsNull()) {
+        return;
+    }
+
     D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
     desc.CS.pShaderBytecode = shader.Bytecode.data();
     desc.CS.BytecodeLength = shader.Bytecode.size();
@@ -23,5 +28,5 @@ ComputePipeline::ComputePipeline(Device::Ref device, Shader shader, RootSignatur
 
 ComputePipeline::~ComputePipeline()
 {
-    mPipeline->Release();
+    D3DUtils::Release(mPipeline);
 }
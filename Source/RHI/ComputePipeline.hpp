@@ -13,7 +13,7 @@
 class ComputePipeline
 {
 public:
-    using Ref = Ref<ComputePipeline>;
+    using Ref = ::Ref<ComputePipeline>;
 
     ComputePipeline(Device::Ref device, Shader shader, RootSignature::Ref signature);
     ~ComputePipeline();
@@ -0,0 +1,23 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:41:02
+//
+
+#pragma once
+
+// Windows gets the Agility SDK and DXGI. Elsewhere DirectX-Headers and its stand-ins for the Windows types are enough to
+// compile the RHI, but there's no runtime behind them: only the null backend runs, and nothing touches DXGI.
+#if defined(_WIN32)
+    #include <Agility/d3d12.h>
+    #include <Agility/d3d12shader.h>
+    #include <dxgi1_6.h>
+#else
+    #include <wsl/winadapter.h>
+    #include <directx/d3d12.h>
+    #include <directx/d3d12shader.h>
+    #include <dxguids/dxguids.h>
+
+    struct IDXGIFactory6;
+    struct IDXGIAdapter1;
+    struct IDXGISwapChain4;
+#endif
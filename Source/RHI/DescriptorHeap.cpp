@@ -18,10 +18,15 @@ DescriptorHeap::DescriptorHeap(Device::Ref device, DescriptorHeapType type, UInt
         mShaderVisible = true;
     }
 
+    mLookupTable.resize(size, false);
+    if (device->IsNull()) {
+        mIncrementSize = 32;
+        return;
+    }
+
     HRESULT result = device->GetDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&mHeap));
     ASSERT(SUCCEEDED(result), "Failed to create descriptor heap!");
 
-    mLookupTable.resize(size, false);
     mIncrementSize = device->GetDevice()->GetDescriptorHandleIncrementSize(desc.Type);
 }
 
@@ -18,7 +18,7 @@ enum class DescriptorHeapType
 class DescriptorHeap
 {
 public:
-    using Ref = Ref<DescriptorHeap>;
+    using Ref = ::Ref<DescriptorHeap>;
 
     struct Descriptor
     {
@@ -33,6 +33,13 @@ public:
         Descriptor(DescriptorHeap* heap, int index)
             : Parent(heap), Index(index), Valid(true)
         {
+            // Null heaps hand out fake handles, they're only ever compared
+            if (!Parent->mHeap) {
+                CPU.ptr = (index + 1) * Parent->mIncrementSize;
+                GPU.ptr = CPU.ptr;
+                return;
+            }
+
             CPU = Parent->mHeap->GetCPUDescriptorHandleForHeapStart();
             CPU.ptr += index * Parent->mIncrementSize;
 
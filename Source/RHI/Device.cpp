@@ -13,6 +13,7 @@
 #include <unordered_map>
 #include <Statistics.hpp>
 
+#if defined(_WIN32)
 extern "C"
 {
     __declspec(dllexport) DWORD NvOptimusEnablement = 0x00000001;
@@ -21,9 +22,26 @@ extern "C"
     __declspec(dllexport) extern const uint32_t D3D12SDKVersion = 614;
     __declspec(dllexport) extern const char* D3D12SDKPath = ".\\D3D12\\";
 }
+#endif
 
-Device::Device()
+Device::Device(RHIBackend backend)
+    : mBackend(backend)
 {
+#if !defined(_WIN32)
+    if (!IsNull()) {
+        LOG_WARN("D3D12 needs Windows, using the null RHI backend instead");
+        mBackend = RHIBackend::Null;
+    }
+#endif
+    if (IsNull()) {
+        LOG_INFO("Selecting null RHI backend");
+
+        // Budget something so the memory stats still read sensibly
+        Statistics::Get().MaxVRAM = 8ull * 1024 * 1024 * 1024;
+        return;
+    }
+
+#if defined(_WIN32)
     // Create factory.
     IDXGIFactory1* tempFactory;
     HRESULT result = CreateDXGIFactory1(IID_PPV_ARGS(&tempFactory));
@@ -102,12 +120,15 @@ Device::Device()
 
     // Set max vram stat
     Statistics::Get().MaxVRAM = desc.DedicatedVideoMemory;
+#endif
 }
 
 Device::~Device()
 {
     D3DUtils::Release(mDevice);
-    D3DUtils::Release(mAdapter);
     D3DUtils::Release(mDebug);
+#if defined(_WIN32)
+    D3DUtils::Release(mAdapter);
     D3DUtils::Release(mFactory);
+#endif
 }
@@ -5,22 +5,31 @@
 
 #pragma once
 
-#include <Agility/d3d12.h>
-#include <dxgi1_6.h>
-
+#include <RHI/D3D12.hpp>
 #include <Core/Common.hpp>
 
+// Null skips DXGI and D3D12 entirely: resources are plain memory and command buffers only record, so the CPU side of the renderer runs headless
+enum class RHIBackend
+{
+    D3D12,
+    Null
+};
+
 class Device
 {
 public:
-    using Ref = Ref<Device>;
+    using Ref = ::Ref<Device>;
 
-    Device();
+    Device(RHIBackend backend = RHIBackend::D3D12);
     ~Device();
 
+    RHIBackend GetBackend() const { return mBackend; }
+    bool IsNull() const { return mBackend == RHIBackend::Null; }
+
     ID3D12Device14* GetDevice() { return mDevice; }
     IDXGIFactory6* GetFactory() { return mFactory; }
 private:
+    RHIBackend mBackend;
     IDXGIFactory6* mFactory = nullptr;
     IDXGIAdapter1* mAdapter = nullptr;
     ID3D12Device14* mDevice = nullptr;
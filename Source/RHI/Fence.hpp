@@ -13,14 +13,15 @@ class Queue;
 class Fence
 {
 public:
-    using Ref = Ref<Fence>;
+    using Ref = ::Ref<Fence>;
 
     Fence(Device::Ref device);
     ~Fence();
 
     void Wait(UInt64 value);
     UInt64 Signal(::Ref<Queue> queue);
-    UInt64 GetCompletedValue() { return mFence->GetCompletedValue(); }
+    // Null fences complete as soon as they're signaled
+    UInt64 GetCompletedValue() { return mFence ? mFence->GetCompletedValue() : mValue; }
 
     ID3D12Fence* GetFence() { return mFence; }
     UInt64 GetValue() { return mValue; }
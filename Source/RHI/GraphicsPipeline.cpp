@@ -4,12 +4,53 @@
 //
 
 #include <RHI/GraphicsPipeline.hpp>
+#include <RHI/PipelineCache.hpp>
 #include <RHI/Utilities.hpp>
 #include <Core/Assert.hpp>
 #include <Core/Logger.hpp>
 
 GraphicsPipeline::GraphicsPipeline(Device::Ref device, GraphicsPipelineSpecs& specs)
 {
+    mSignature = specs.Signature;
+    Create(device, specs, nullptr, 0);
+}
+
+GraphicsPipeline::GraphicsPipeline(Device::Ref device, GraphicsPipelineSpecs& specs, PipelineCache* cache, UInt64 hash, bool async)
+{
+    mSignature = specs.Signature;
+    if (!async) {
+        Create(device, specs, cache, hash);
+        return;
+    }
+
+    // The worker gets its own copy of the specs, the caller's can change before it runs
+    Jobs::Kick([this, device, specs, cache, hash]() {
+        Create(device, specs, cache, hash);
+    }, &mPending);
+}
+
+GraphicsPipeline::~GraphicsPipeline()
+{
+    Wait();
+    D3DUtils::Release(mPipeline);
+}
+
+void GraphicsPipeline::Wait()
+{
+    Jobs::Wait(&mPending);
+}
+
+bool GraphicsPipeline::IsReady()
+{
+    return mPending.Pending == 0 && mPending.Busy == 0;
+}
+
+void GraphicsPipeline::Create(Device::Ref device, GraphicsPipelineSpecs specs, PipelineCache* cache, UInt64 hash)
+{
+    if (device->IsNull()) {
+        return;
+    }
+
     Shader& vertexBytecode = specs.Bytecodes[ShaderType::Vertex];
     Shader& fragmentBytecode = specs.Bytecodes[ShaderType::Fragment];
 
@@ -68,6 +109,10 @@ GraphicsPipeline::GraphicsPipeline(Device::Ref device, GraphicsPipelineSpecs& sp
         D3D12_SIGNATURE_PARAMETER_DESC ParameterDesc = {};
         pVertexReflection->GetInputParameterDesc(ParameterIndex, &ParameterDesc);
 
+        // Vertex and instance IDs are generated, not fetched
+        if (ParameterDesc.SystemValueType != D3D_NAME_UNDEFINED)
+            continue;
+
         InputElementSemanticNames.push_back(ParameterDesc.SemanticName);
 
         D3D12_INPUT_ELEMENT_DESC InputElement = {};
@@ -110,14 +155,13 @@ GraphicsPipeline::GraphicsPipeline(Device::Ref device, GraphicsPipelineSpecs& sp
 
     if (specs.Signature) {
         Desc.pRootSignature = specs.Signature->GetSignature();
-        mSignature = specs.Signature;
+    }
+
+    if (cache) {
+        mPipeline = cache->CreateState(hash, Desc);
+        return;
     }
 
     HRESULT result = device->GetDevice()->CreateGraphicsPipelineState(&Desc, IID_PPV_ARGS(&mPipeline));
     ASSERT(SUCCEEDED(result), "Failed to create graphics pipeline!");
 }
-
-GraphicsPipeline::~GraphicsPipeline()
-{
-    D3DUtils::Release(mPipeline);
-}
@@ -8,6 +8,7 @@
 #include <RHI/RootSignature.hpp>
 #include <RHI/Texture.hpp>
 #include <Asset/Shader.hpp>
+#include <Core/Jobs.hpp>
 
 enum class FillMode
 {
@@ -49,17 +50,27 @@ struct GraphicsPipelineSpecs
     RootSignature::Ref Signature = nullptr;
 };
 
+class PipelineCache;
+
 class GraphicsPipeline
 {
 public:
-    using Ref = Ref<GraphicsPipeline>;
+    using Ref = ::Ref<GraphicsPipeline>;
 
     GraphicsPipeline(Device::Ref device, GraphicsPipelineSpecs& specs);
+    // Goes through the cache's pipeline library. When async, the PSO is created by a job and GetPipeline() helps run jobs until it's there.
+    GraphicsPipeline(Device::Ref device, GraphicsPipelineSpecs& specs, PipelineCache* cache, UInt64 hash, bool async);
     ~GraphicsPipeline();
 
-    ID3D12PipelineState* GetPipeline() { return mPipeline; }
+    void Wait();
+    bool IsReady();
+
+    ID3D12PipelineState* GetPipeline() { Wait(); return mPipeline; }
     RootSignature::Ref GetRootSignature() { return mSignature; }
 private:
+    void Create(Device::Ref device, GraphicsPipelineSpecs specs, PipelineCache* cache, UInt64 hash);
+
     ID3D12PipelineState* mPipeline = nullptr;
     RootSignature::Ref mSignature = nullptr;
+    Jobs::Counter mPending;
 };
@@ -0,0 +1,37 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 09:18:02
+//
+
+#include <RHI/Heap.hpp>
+#include <RHI/Utilities.hpp>
+
+#include <Core/Assert.hpp>
+#include <Core/UTF.hpp>
+
+#include <Statistics.hpp>
+
+Heap::Heap(Device::Ref device, UInt64 size, HeapUsage usage, const String& name)
+    : mSize(size), mUsage(usage)
+{
+    Statistics::Get().UsedVRAM += mSize;
+    if (device->IsNull()) {
+        return;
+    }
+
+    D3D12_HEAP_DESC desc = {};
+    desc.SizeInBytes = size;
+    desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    desc.Flags = D3D12_HEAP_FLAGS(usage);
+
+    HRESULT result = device->GetDevice()->CreateHeap(&desc, IID_PPV_ARGS(&mHeap));
+    ASSERT(SUCCEEDED(result), "Failed to create heap!");
+    mHeap->SetName(UTF::AsciiToWide(name).data());
+}
+
+Heap::~Heap()
+{
+    D3DUtils::Release(mHeap);
+    Statistics::Get().UsedVRAM -= mSize;
+}
@@ -0,0 +1,34 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 09:12:40
+//
+
+#pragma once
+
+#include <RHI/Device.hpp>
+
+// Resource heap tier 1 only lets a heap hold one of these categories
+enum class HeapUsage
+{
+    RenderTargets = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+    Textures = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+    Buffers = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS
+};
+
+// A chunk of GPU memory that placed resources are created into. Resources that never live at the same time can share the same range.
+class Heap
+{
+public:
+    using Ref = ::Ref<Heap>;
+
+    Heap(Device::Ref device, UInt64 size, HeapUsage usage, const String& name = "Heap");
+    ~Heap();
+
+    ID3D12Heap* GetHeap() { return mHeap; }
+    UInt64 GetSize() const { return mSize; }
+    HeapUsage GetUsage() const { return mUsage; }
+private:
+    ID3D12Heap* mHeap = nullptr;
+    UInt64 mSize;
+    HeapUsage mUsage;
+};
@@ -0,0 +1,253 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-22 14:40:12
+//
+
+#include <RHI/PipelineCache.hpp>
+#include <RHI/Utilities.hpp>
+#include <Core/Assert.hpp>
+#include <Core/Checks.hpp>
+#include <Core/File.hpp>
+#include <Core/Hash.hpp>
+#include <Core/Logger.hpp>
+
+static UInt64 HashShader(const GraphicsPipelineSpecs& specs, ShaderType type, UInt64 hash)
+{
+    auto it = specs.Bytecodes.find(type);
+    if (it == specs.Bytecodes.end()) {
+        return HashValue(UInt64(0), hash);
+    }
+    const Vector<UInt8>& bytecode = it->second.Bytecode;
+    hash = HashValue(UInt64(bytecode.size()), hash);
+    return HashBytes(bytecode.data(), bytecode.size(), hash);
+}
+
+PipelineCache::PipelineCache(Device::Ref device, const String& path)
+    : mDevice(device), mPath(path)
+{
+    if (!mDevice || mDevice->IsNull()) {
+        return;
+    }
+
+    if (File::Exists(mPath)) {
+        mLibraryBlob.resize(File::GetFileSize(mPath));
+        File::ReadBytes(mPath, mLibraryBlob.data(), mLibraryBlob.size());
+
+        HRESULT result = mDevice->GetDevice()->CreatePipelineLibrary(mLibraryBlob.data(), mLibraryBlob.size(), IID_PPV_ARGS(&mLibrary));
+        if (FAILED(result)) {
+            // New driver or GPU, the old blob is useless
+            LOG_WARN("[PSO Cache] Discarding {0} (0x{1:x}), starting a new pipeline library", mPath, UInt32(result));
+            mLibraryBlob.clear();
+            mLibrary = nullptr;
+        }
+    }
+    if (!mLibrary) {
+        HRESULT result = mDevice->GetDevice()->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mLibrary));
+        if (FAILED(result)) {
+            LOG_WARN("[PSO Cache] Pipeline libraries aren't supported, pipelines won't persist between runs");
+            mLibrary = nullptr;
+        }
+    }
+}
+
+PipelineCache::~PipelineCache()
+{
+    Save();
+    mPipelines.clear();
+    D3DUtils::Release(mLibrary);
+}
+
+UInt64 PipelineCache::Hash(const GraphicsPipelineSpecs& specs)
+{
+    UInt64 hash = HASH_SEED;
+    hash = HashShader(specs, ShaderType::Vertex, hash);
+    hash = HashShader(specs, ShaderType::Fragment, hash);
+
+    hash = HashValue(specs.Fill, hash);
+    hash = HashValue(specs.Cull, hash);
+    hash = HashValue(specs.CCW, hash);
+    hash = HashValue(specs.Line, hash);
+
+    hash = HashValue(UInt64(specs.Formats.size()), hash);
+    for (auto format : specs.Formats) {
+        hash = HashValue(format, hash);
+    }
+
+    hash = HashValue(specs.DepthEnabled, hash);
+    if (specs.DepthEnabled) {
+        hash = HashValue(specs.Depth, hash);
+        hash = HashValue(specs.DepthFormat, hash);
+        hash = HashValue(specs.DepthClampEnable, hash);
+        hash = HashValue(specs.DepthWrite, hash);
+    }
+
+    return HashValue(specs.Signature ? specs.Signature->GetHash() : UInt64(0), hash);
+}
+
+GraphicsPipeline::Ref PipelineCache::Get(GraphicsPipelineSpecs& specs, bool async)
+{
+    UInt64 hash = Hash(specs);
+    return GetOrCreate(hash, [&]() {
+        return MakeRef<GraphicsPipeline>(mDevice, specs, this, hash, async);
+    });
+}
+
+GraphicsPipeline::Ref PipelineCache::GetOrCreate(UInt64 hash, const std::function<GraphicsPipeline::Ref()>& create)
+{
+    mRequests++;
+
+    std::lock_guard<std::mutex> lock(mPipelineMutex);
+    auto it = mPipelines.find(hash);
+    if (it != mPipelines.end()) {
+        mDeduplicated++;
+        return it->second;
+    }
+
+    GraphicsPipeline::Ref pipeline = create();
+    mPipelines[hash] = pipeline;
+    return pipeline;
+}
+
+ID3D12PipelineState* PipelineCache::CreateState(UInt64 hash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    ID3D12PipelineState* pipeline = nullptr;
+    WideString name = std::to_wstring(hash);
+
+    if (mLibrary) {
+        std::lock_guard<std::mutex> lock(mLibraryMutex);
+        if (SUCCEEDED(mLibrary->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(&pipeline)))) {
+            mLibraryHits++;
+            return pipeline;
+        }
+    }
+
+    // Compile outside the lock, this is the slow part
+    HRESULT result = mDevice->GetDevice()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipeline));
+    ASSERT(SUCCEEDED(result), "Failed to create graphics pipeline!");
+    mCompiled++;
+
+    if (mLibrary) {
+        std::lock_guard<std::mutex> lock(mLibraryMutex);
+        if (SUCCEEDED(mLibrary->StorePipeline(name.c_str(), pipeline))) {
+            mDirty = true;
+        }
+    }
+    return pipeline;
+}
+
+void PipelineCache::Save()
+{
+    // Background compiles still need to land in the library
+    {
+        std::lock_guard<std::mutex> lock(mPipelineMutex);
+        for (auto& [hash, pipeline] : mPipelines) {
+            pipeline->Wait();
+        }
+    }
+
+    PipelineCacheStats stats = GetStats();
+    if (stats.Requests) {
+        LOG_INFO("[PSO Cache] {0} requests, {1} deduplicated, {2} loaded from the library, {3} compiled", stats.Requests, stats.Deduplicated, stats.LibraryHits, stats.Compiled);
+    }
+
+    std::lock_guard<std::mutex> lock(mLibraryMutex);
+    if (!mLibrary || !mDirty) {
+        return;
+    }
+
+    Vector<UInt8> blob(mLibrary->GetSerializedSize());
+    HRESULT result = mLibrary->Serialize(blob.data(), blob.size());
+    if (FAILED(result)) {
+        LOG_ERROR("[PSO Cache] Failed to serialize pipeline library!");
+        return;
+    }
+
+    String directory = mPath.substr(0, mPath.find_last_of('/'));
+    if (directory != mPath && !File::Exists(directory)) {
+        File::CreateDirectoryFromPath(directory);
+    }
+    File::WriteBytes(mPath, blob.data(), blob.size());
+    mDirty = false;
+}
+
+PipelineCacheStats PipelineCache::GetStats()
+{
+    PipelineCacheStats stats;
+    stats.Requests = mRequests;
+    stats.Deduplicated = mDeduplicated;
+    stats.LibraryHits = mLibraryHits;
+    stats.Compiled = mCompiled;
+    return stats;
+}
+
+bool PipelineCache::SelfTest()
+{
+    Checks check("PipelineCache");
+
+    Device::Ref device = MakeRef<Device>(RHIBackend::Null);
+
+    GraphicsPipelineSpecs specs;
+    specs.Cull = CullMode::Back;
+    specs.Formats = { TextureFormat::RGBA8, TextureFormat::RGBA16Float };
+    specs.DepthEnabled = true;
+    specs.Depth = DepthOperation::Less;
+    specs.DepthFormat = TextureFormat::Depth32;
+    specs.Bytecodes[ShaderType::Vertex] = Shader{ true, ShaderType::Vertex, { 1, 2, 3, 4 } };
+    specs.Bytecodes[ShaderType::Fragment] = Shader{ true, ShaderType::Fragment, { 5, 6, 7, 8 } };
+    specs.Signature = MakeRef<RootSignature>(device, Vector<RootType>{ RootType::PushConstant }, 16);
+
+    UInt64 hash = Hash(specs);
+    GraphicsPipelineSpecs same = specs;
+    same.Signature = MakeRef<RootSignature>(device, Vector<RootType>{ RootType::PushConstant }, 16);
+    check(Hash(same) == hash, "equal specs hash the same");
+
+    auto differs = [&](const char* what, const std::function<void(GraphicsPipelineSpecs&)>& change) {
+        GraphicsPipelineSpecs changed = specs;
+        change(changed);
+        check(Hash(changed) != hash, what);
+    };
+    differs("vertex bytecode", [](GraphicsPipelineSpecs& s) { s.Bytecodes[ShaderType::Vertex].Bytecode[2] = 9; });
+    differs("fragment bytecode length", [](GraphicsPipelineSpecs& s) { s.Bytecodes[ShaderType::Fragment].Bytecode.push_back(0); });
+    differs("render target format", [](GraphicsPipelineSpecs& s) { s.Formats[1] = TextureFormat::RGBA8; });
+    differs("render target count", [](GraphicsPipelineSpecs& s) { s.Formats.pop_back(); });
+    differs("cull mode", [](GraphicsPipelineSpecs& s) { s.Cull = CullMode::None; });
+    differs("depth test", [](GraphicsPipelineSpecs& s) { s.DepthEnabled = false; });
+    differs("depth function", [](GraphicsPipelineSpecs& s) { s.Depth = DepthOperation::Greater; });
+    differs("depth format", [](GraphicsPipelineSpecs& s) { s.DepthFormat = TextureFormat::R32Float; });
+    differs("depth write", [](GraphicsPipelineSpecs& s) { s.DepthWrite = false; });
+    differs("root signature", [&](GraphicsPipelineSpecs& s) { s.Signature = MakeRef<RootSignature>(device, Vector<RootType>{ RootType::PushConstant, RootType::Storage }, 16); });
+    differs("push constant size", [&](GraphicsPipelineSpecs& s) { s.Signature = MakeRef<RootSignature>(device, Vector<RootType>{ RootType::PushConstant }, 32); });
+    differs("no root signature", [](GraphicsPipelineSpecs& s) { s.Signature = nullptr; });
+
+    // Depth state that D3D12 ignores shouldn't split pipelines
+    GraphicsPipelineSpecs noDepth = specs;
+    noDepth.DepthEnabled = false;
+    GraphicsPipelineSpecs noDepthGreater = noDepth;
+    noDepthGreater.Depth = DepthOperation::Greater;
+    check(Hash(noDepth) == Hash(noDepthGreater), "depth state is ignored with depth off");
+
+    PipelineCache cache(device, "");
+    GraphicsPipeline::Ref first = cache.Get(specs);
+    check(first != nullptr, "pipeline created");
+    check(cache.Get(same) == first, "equal specs share a pipeline");
+
+    UInt32 created = 0;
+    GraphicsPipeline::Ref found = cache.GetOrCreate(hash, [&]() {
+        created++;
+        return MakeRef<GraphicsPipeline>(device, specs);
+    });
+    check(found == first && created == 0, "GetOrCreate returns the cached pipeline without creating one");
+
+    // Async creation goes through the job system, Wait() has to see it through
+    GraphicsPipeline::Ref background = cache.Get(noDepth, true);
+    background->Wait();
+    check(background != first && background->IsReady(), "async pipeline finishes");
+    check(cache.Get(noDepthGreater, true) == background, "async requests deduplicate too");
+
+    PipelineCacheStats stats = cache.GetStats();
+    check(stats.Requests == 5, "request count");
+    check(stats.Deduplicated == 3, "deduplicated count");
+    check(stats.Compiled == 0 && stats.LibraryHits == 0, "nothing compiled on a null device");
+
+    return check.Finish();
+}
@@ -0,0 +1,64 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-22 14:21:37
+//
+
+#pragma once
+
+#include <RHI/GraphicsPipeline.hpp>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+struct PipelineCacheStats
+{
+    UInt32 Requests = 0;
+    UInt32 Deduplicated = 0;
+    UInt32 LibraryHits = 0;
+    UInt32 Compiled = 0;
+};
+
+// Deduplicates graphics pipelines by a hash of their specs, and keeps the compiled PSOs in an ID3D12PipelineLibrary
+// that gets written to disk so the next run can skip driver compilation.
+class PipelineCache
+{
+public:
+    using Ref = ::Ref<PipelineCache>;
+
+    // device can be null, you only get the hashing and deduplication then
+    PipelineCache(Device::Ref device, const String& path);
+    ~PipelineCache();
+
+    // Only reads the specs: bytecode, formats, raster/depth state and the serialized root signature
+    static UInt64 Hash(const GraphicsPipelineSpecs& specs);
+
+    GraphicsPipeline::Ref Get(GraphicsPipelineSpecs& specs, bool async = false);
+    GraphicsPipeline::Ref GetOrCreate(UInt64 hash, const std::function<GraphicsPipeline::Ref()>& create);
+
+    // Called by GraphicsPipeline, possibly from a worker thread
+    ID3D12PipelineState* CreateState(UInt64 hash, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
+    void Save();
+    PipelineCacheStats GetStats();
+
+    // Hashes of specs that differ in one field, and deduplication of repeated requests, on a null device
+    static bool SelfTest();
+private:
+    Device::Ref mDevice;
+    String mPath;
+
+    // The library reads from this blob for its whole lifetime
+    Vector<UInt8> mLibraryBlob;
+    ID3D12PipelineLibrary* mLibrary = nullptr;
+    std::mutex mLibraryMutex;
+    bool mDirty = false;
+
+    std::mutex mPipelineMutex;
+    UnorderedMap<UInt64, GraphicsPipeline::Ref> mPipelines;
+
+    std::atomic<UInt32> mRequests = 0;
+    std::atomic<UInt32> mDeduplicated = 0;
+    std::atomic<UInt32> mLibraryHits = 0;
+    std::atomic<UInt32> mCompiled = 0;
+};
@@ -0,0 +1,61 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:44:03
+//
+
+#include <RHI/QueryHeap.hpp>
+#include <RHI/Utilities.hpp>
+
+#include <Core/Assert.hpp>
+#include <Core/UTF.hpp>
+
+#include <algorithm>
+
+QueryHeap::QueryHeap(Device::Ref device, DescriptorHeaps heaps, UInt32 count, const String& name)
+    : mCount(count)
+{
+    D3D12_QUERY_HEAP_DESC desc = {};
+    desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    desc.Count = count;
+
+    HRESULT result = device->GetDevice()->CreateQueryHeap(&desc, IID_PPV_ARGS(&mHeap));
+    ASSERT(SUCCEEDED(result), "Failed to create query heap!");
+    mHeap->SetName(UTF::AsciiToWide(name).data());
+
+    mReadback = MakeRef<Buffer>(device, heaps, count * sizeof(UInt64), sizeof(UInt64), BufferType::Readback, name + " Readback");
+}
+
+QueryHeap::~QueryHeap()
+{
+    D3DUtils::Release(mHeap);
+}
+
+UInt32 QueryHeap::Allocate()
+{
+    UInt32 index = mNext++;
+    return index < mCount ? index : UINT32_MAX;
+}
+
+void QueryHeap::Resolve(ID3D12GraphicsCommandList* list)
+{
+    mResolved = std::min(mNext.load(), mCount);
+    if (mResolved) {
+        list->ResolveQueryData(mHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0, mResolved, mReadback->GetResource(), 0);
+    }
+}
+
+void QueryHeap::Read(Vector<UInt64>& timestamps)
+{
+    timestamps.resize(mResolved);
+    if (!mResolved) {
+        return;
+    }
+
+    void* data = nullptr;
+    mReadback->Map(0, mResolved * sizeof(UInt64), &data);
+    if (data) {
+        memcpy(timestamps.data(), data, mResolved * sizeof(UInt64));
+    }
+    mReadback->Unmap(0, 0);
+    mResolved = 0;
+}
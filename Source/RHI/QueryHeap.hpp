@@ -0,0 +1,37 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:42:16
+//
+
+#pragma once
+
+#include <RHI/Buffer.hpp>
+
+#include <atomic>
+
+// GPU timestamps for one frame in flight. Slots are handed out from any recording thread, the whole range gets resolved into
+// a readback buffer at the end of the frame and read once the GPU is done with it.
+class QueryHeap
+{
+public:
+    using Ref = ::Ref<QueryHeap>;
+
+    QueryHeap(Device::Ref device, DescriptorHeaps heaps, UInt32 count, const String& name = "Query Heap");
+    ~QueryHeap();
+
+    // UINT32_MAX once the heap is full
+    UInt32 Allocate();
+    void Reset() { mNext = 0; }
+
+    void Resolve(ID3D12GraphicsCommandList* list);
+    // In ticks of the queue's timestamp frequency. Empty until something was resolved.
+    void Read(Vector<UInt64>& timestamps);
+
+    ID3D12QueryHeap* GetHeap() { return mHeap; }
+private:
+    ID3D12QueryHeap* mHeap = nullptr;
+    Buffer::Ref mReadback;
+    UInt32 mCount;
+    std::atomic<UInt32> mNext = 0;
+    UInt32 mResolved = 0;
+};
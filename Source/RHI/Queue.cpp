@@ -15,11 +15,27 @@ Queue::Queue(Device::Ref device, QueueType type)
 {
     D3D12_COMMAND_QUEUE_DESC desc = {};
     desc.Type = D3D12_COMMAND_LIST_TYPE(type);
+    if (device->IsNull()) {
+        return;
+    }
 
     HRESULT result = device->GetDevice()->CreateCommandQueue(&desc, IID_PPV_ARGS(&mQueue));
     ASSERT(SUCCEEDED(result), "Failed to create queue!");
 }
 
+UInt64 Queue::GetTimestampFrequency()
+{
+    // Null timestamps would be in nanoseconds
+    if (!mQueue) {
+        return 1'000'000'000;
+    }
+
+    UInt64 frequency = 0;
+    HRESULT result = mQueue->GetTimestampFrequency(&frequency);
+    ASSERT(SUCCEEDED(result), "Failed to get timestamp frequency!");
+    return frequency;
+}
+
 Queue::~Queue()
 {
     D3DUtils::Release(mQueue);
@@ -27,19 +43,44 @@ Queue::~Queue()
 
 void Queue::Wait(::Ref<Fence> fence, UInt64 value)
 {
-    mQueue->Wait(fence->GetFence(), value);
+    if (mQueue) {
+        mQueue->Wait(fence->GetFence(), value);
+    }
 }
 
 void Queue::Signal(::Ref<Fence> fence, UInt64 value)
 {
-    mQueue->Signal(fence->GetFence(), value);
+    if (mQueue) {
+        mQueue->Signal(fence->GetFence(), value);
+    }
 }
 
 void Queue::Submit(const Vector<::Ref<CommandBuffer>>& buffers)
 {
+    // Nothing to execute but buffer to buffer copies, which keeps uploads and readbacks coherent
+    if (!mQueue) {
+        for (auto& buffer : buffers) {
+            buffer->GetStream().Replay([](const CommandStream::Command& command) {
+                if (command.Op != CommandOp::CopyBufferToBuffer) {
+                    return;
+                }
+
+                CommandStream::CopyData copy = command.As<CommandStream::CopyData>();
+                Vector<UInt8>& dst = copy.Dst->GetMemory();
+                Vector<UInt8>& src = copy.Src->GetMemory();
+                UInt64 size = std::min({ copy.Size, (UInt64)dst.size(), (UInt64)src.size() });
+                if (size) {
+                    memcpy(dst.data(), src.data(), size);
+                }
+            });
+        }
+        return;
+    }
+
     std::vector<ID3D12CommandList*> lists;
     for (auto& buffer : buffers) {
-        lists.push_back(buffer->GetList());
+        const Vector<ID3D12CommandList*>& recorded = buffer->GetLists();
+        lists.insert(lists.end(), recorded.begin(), recorded.end());
     }
 
     mQueue->ExecuteCommandLists(lists.size(), lists.data());
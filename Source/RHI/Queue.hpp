@@ -22,7 +22,7 @@ enum class QueueType
 class Queue
 {
 public:
-    using Ref = Ref<Queue>;
+    using Ref = ::Ref<Queue>;
 
     Queue(Device::Ref device, QueueType type);
     ~Queue();
@@ -31,6 +31,9 @@ public:
     void Signal(::Ref<Fence> fence, UInt64 value);
     void Submit(const Vector<::Ref<CommandBuffer>>& buffers);
 
+    // Ticks per second of the timestamps written on this queue
+    UInt64 GetTimestampFrequency();
+
     ID3D12CommandQueue* GetQueue() { return mQueue; }
     QueueType GetType() { return mType; }
 private:
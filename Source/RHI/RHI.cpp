@@ -7,15 +7,18 @@
 #include <RHI/Uploader.hpp>
 
 #include <imgui.h>
-#include <imgui_impl_win32.h>
-#include <imgui_impl_dx12.h>
+#if defined(_WIN32)
+    #include <imgui_impl_win32.h>
+    #include <imgui_impl_dx12.h>
+#endif
 
 #include <Statistics.hpp>
 
-RHI::RHI(Window::Ref window)
+RHI::RHI(Window::Ref window, RHIBackend backend)
     : mWindow(window)
 {
-    mDevice = MakeRef<Device>();
+    mDevice = MakeRef<Device>(backend);
+    mPipelineCache = MakeRef<PipelineCache>(mDevice, ".cache/pipelines.bin");
 
     mGraphicsQueue = MakeRef<Queue>(mDevice, QueueType::AllGraphics);
     
@@ -31,7 +34,11 @@ RHI::RHI(Window::Ref window)
     for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
         mFrameValues[i] = 0;
         mCommandBuffers[i] = MakeRef<CommandBuffer>(mDevice, mGraphicsQueue, mDescriptorHeaps);
+        if (!mDevice->IsNull()) {
+            mCommandBuffers[i]->EnableTimestamps(MakeRef<QueryHeap>(mDevice, mDescriptorHeaps, 4096, "Timestamp Queries"));
+        }
     }
+    mTimestampFrequency = mGraphicsQueue->GetTimestampFrequency();
 
     Uploader::Init(this, mDevice, mDescriptorHeaps, mGraphicsQueue);
 
@@ -46,6 +53,13 @@ RHI::RHI(Window::Ref window)
     IO.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;
     IO.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
 
+    // Headless, the font atlas is the only thing ImGui needs to build frames
+    if (mDevice->IsNull()) {
+        IO.Fonts->Build();
+        return;
+    }
+
+#if defined(_WIN32)
     ImGui_ImplWin32_EnableDpiAwareness();
     ImGui_ImplWin32_Init(window->GetHandle());
     ImGui_ImplDX12_Init(mDevice->GetDevice(),
@@ -55,12 +69,17 @@ RHI::RHI(Window::Ref window)
                         mFontDescriptor.CPU,
                         mFontDescriptor.GPU);
     ImGui_ImplDX12_CreateDeviceObjects();
+#endif
 }
 
 RHI::~RHI()
 {
-    ImGui_ImplDX12_Shutdown();
-    ImGui_ImplWin32_Shutdown();
+#if defined(_WIN32)
+    if (!mDevice->IsNull()) {
+        ImGui_ImplDX12_Shutdown();
+        ImGui_ImplWin32_Shutdown();
+    }
+#endif
     ImGui::DestroyContext();
     mFontDescriptor.Parent->Free(mFontDescriptor);
 }
@@ -103,6 +122,19 @@ void RHI::End()
         mFrameFence->Wait(mFrameValues[mFrameIndex]);
     }
     mFrameValues[mFrameIndex] = fenceValue + 1;
+
+    // The frame is done on the GPU, so its timestamps are in. Top level markers run back to back on the one queue.
+    Vector<TimingTree::Marker> markers;
+    if (mCommandBuffers[mFrameIndex]->ReadTimestamps(mTimestampFrequency, markers)) {
+        mGPUTimings.AddFrame(markers);
+
+        mGPUTime = 0.0f;
+        for (const TimingTree::Marker& marker : markers) {
+            if (marker.Depth == 0) {
+                mGPUTime += marker.Milliseconds;
+            }
+        }
+    }
 }
 
 void RHI::Present(bool vsync)
@@ -120,9 +152,9 @@ RootSignature::Ref RHI::CreateRootSignature(const Vector<RootType>& entries, UIn
     return MakeRef<RootSignature>(mDevice, entries, pushConstantSize);
 }
 
-GraphicsPipeline::Ref RHI::CreateGraphicsPipeline(GraphicsPipelineSpecs& specs)
+GraphicsPipeline::Ref RHI::CreateGraphicsPipeline(GraphicsPipelineSpecs& specs, bool async)
 {
-    return MakeRef<GraphicsPipeline>(mDevice, specs);
+    return mPipelineCache->Get(specs, async);
 }
 
 ComputePipeline::Ref RHI::CreateComputePipeline(Shader shader, RootSignature::Ref signature)
@@ -140,6 +172,21 @@ Texture::Ref RHI::CreateTexture(TextureDesc desc)
     return MakeRef<Texture>(mDevice, desc);
 }
 
+Texture::Ref RHI::CreatePlacedTexture(TextureDesc desc, Heap::Ref heap, UInt64 offset)
+{
+    return MakeRef<Texture>(mDevice, desc, heap, offset);
+}
+
+void RHI::GetTextureAllocationInfo(const TextureDesc& desc, UInt64& size, UInt64& alignment)
+{
+    Texture::GetAllocationInfo(mDevice, desc, size, alignment);
+}
+
+Heap::Ref RHI::CreateHeap(UInt64 size, HeapUsage usage, const String& name)
+{
+    return MakeRef<Heap>(mDevice, size, usage, name);
+}
+
 View::Ref RHI::CreateView(::Ref<Resource> resource, ViewType type, ViewDimension dimension, TextureFormat format, UInt64 mip, UInt64 depthSlice)
 {
     return MakeRef<View>(mDevice, mDescriptorHeaps, resource, type, dimension, format, mip, depthSlice);
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <Core/Window.hpp>
+#include <Core/TimingTree.hpp>
 
 #include <RHI/Device.hpp>
 #include <RHI/DescriptorHeap.hpp>
@@ -14,6 +15,7 @@
 #include <RHI/Surface.hpp>
 #include <RHI/CommandBuffer.hpp>
 #include <RHI/GraphicsPipeline.hpp>
+#include <RHI/PipelineCache.hpp>
 #include <RHI/ComputePipeline.hpp>
 #include <RHI/Buffer.hpp>
 #include <RHI/Texture.hpp>
@@ -23,7 +25,7 @@
 
 struct Frame
 {
-    CommandBuffer::Ref CommandBuffer;
+    ::CommandBuffer::Ref CommandBuffer;
     Texture::Ref Backbuffer;
     View::Ref BackbufferView;
     UInt32 FrameIndex;
@@ -35,9 +37,9 @@ struct Frame
 class RHI
 {
 public:
-    using Ref = Ref<RHI>;
+    using Ref = ::Ref<RHI>;
 
-    RHI(Window::Ref window);
+    RHI(Window::Ref window, RHIBackend backend = RHIBackend::D3D12);
     ~RHI();
 
     void Wait();
@@ -47,16 +49,23 @@ public:
     void End();
     void Present(bool vsync);
 
+    RHIBackend GetBackend() const { return mDevice->GetBackend(); }
+
     RootSignature::Ref CreateRootSignature();
     RootSignature::Ref CreateRootSignature(const Vector<RootType>& entries, UInt64 pushConstantSize = 0);
     
-    GraphicsPipeline::Ref CreateGraphicsPipeline(GraphicsPipelineSpecs& specs);
+    // Identical specs give back the same pipeline. async creates the PSO on a worker thread.
+    GraphicsPipeline::Ref CreateGraphicsPipeline(GraphicsPipelineSpecs& specs, bool async = false);
 
     ComputePipeline::Ref CreateComputePipeline(Shader shader, RootSignature::Ref signature);
     
     Buffer::Ref CreateBuffer(UInt64 size, UInt64 stride, BufferType type, const String& name = "Buffer");
     
     Texture::Ref CreateTexture(TextureDesc desc);
+    Texture::Ref CreatePlacedTexture(TextureDesc desc, Heap::Ref heap, UInt64 offset);
+    void GetTextureAllocationInfo(const TextureDesc& desc, UInt64& size, UInt64& alignment);
+
+    Heap::Ref CreateHeap(UInt64 size, HeapUsage usage, const String& name = "Heap");
     
     View::Ref CreateView(::Ref<Resource> resource, ViewType type, ViewDimension dimension = ViewDimension::Texture, TextureFormat format = TextureFormat::Unknown, UInt64 mip = VIEW_ALL_MIPS, UInt64 depthSlice = 0);
     
@@ -64,9 +73,15 @@ public:
 
     BLAS::Ref CreateBLAS(Buffer::Ref vertex, Buffer::Ref index, UInt32 vtxCount, UInt32 idxCount, const String& name = "BLAS");
     TLAS::Ref CreateTLAS(Buffer::Ref instanceBuffer, UInt32 numInstance, const String& name = "TLAS");
+
+    // GPU time of every command buffer marker, by path, over the last few hundred frames
+    const TimingTree& GetGPUTimings() const { return mGPUTimings; }
+    // Milliseconds of the last frame End() waited on
+    float GetGPUTime() const { return mGPUTime; }
 private:
     Window::Ref mWindow = nullptr;
     Device::Ref mDevice = nullptr;
+    PipelineCache::Ref mPipelineCache = nullptr;
     Queue::Ref mGraphicsQueue = nullptr;
     DescriptorHeaps mDescriptorHeaps;
     Surface::Ref mSurface = nullptr;
@@ -76,5 +91,9 @@ private:
     Array<CommandBuffer::Ref, FRAMES_IN_FLIGHT> mCommandBuffers;
     UInt32 mFrameIndex = 0;
 
+    UInt64 mTimestampFrequency = 0;
+    TimingTree mGPUTimings;
+    float mGPUTime = 0.0f;
+
     DescriptorHeap::Descriptor mFontDescriptor;
 };
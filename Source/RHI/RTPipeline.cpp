@@ -4,6 +4,7 @@
 //
 
 #include <RHI/RTPipeline.hpp>
+#include <RHI/Utilities.hpp>
 #include <Core/Logger.hpp>
 
 RTPipeline::RTPipeline(Device::Ref device, DescriptorHeaps& heaps, RTPipelineSpecs specs)
@@ -14,6 +15,9 @@ RTPipeline::RTPipeline(Device::Ref device, DescriptorHeaps& heaps, RTPipelineSpe
     }
 
     mSignature = specs.Signature;
+    if (device->IsNull()) {
+        return;
+    }
 
     D3D12_DXIL_LIBRARY_DESC lib = {};
     lib.DXILLibrary.BytecodeLength = specs.Library.Bytecode.size() * sizeof(uint32_t);
@@ -76,5 +80,5 @@ RTPipeline::RTPipeline(Device::Ref device, DescriptorHeaps& heaps, RTPipelineSpe
 
 RTPipeline::~RTPipeline()
 {
-    mPipeline->Release();
+    D3DUtils::Release(mPipeline);
 }
@@ -22,7 +22,7 @@ struct RTPipelineSpecs
 class RTPipeline
 {
 public:
-    using Ref = Ref<RTPipeline>;
+    using Ref = ::Ref<RTPipeline>;
 
     RTPipeline(Device::Ref device, DescriptorHeaps& heaps, RTPipelineSpecs specs);
     ~RTPipeline();
@@ -27,7 +27,17 @@ Resource::~Resource()
 void Resource::SetName(const String& string)
 {
     mName = string;
-    mResource->SetName(UTF::AsciiToWide(string).data());
+    if (mResource) {
+        mResource->SetName(UTF::AsciiToWide(string).data());
+    }
+}
+
+UInt64 Resource::GetAddress()
+{
+    if (!mResource) {
+        return reinterpret_cast<UInt64>(mMemory.data());
+    }
+    return mResource->GetGPUVirtualAddress();
 }
 
 void Resource::Tag(ResourceTag tag)
@@ -38,9 +48,66 @@ void Resource::Tag(ResourceTag tag)
 void Resource::CreateResource(D3D12_HEAP_PROPERTIES* heapProps, D3D12_RESOURCE_DESC* resourceDesc, D3D12_RESOURCE_STATES state)
 {
     mLayout = ResourceLayout(state);
+    mHeapType = heapProps->Type;
+    if (mParentDevice->IsNull()) {
+        // Buffers get real memory so maps and copies work, textures are only counted
+        mAllocSize = EstimateSize(*resourceDesc);
+        if (resourceDesc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+            mMemory.resize(resourceDesc->Width);
+        }
+        Statistics::Get().UsedVRAM += mAllocSize;
+        return;
+    }
+
     HRESULT result = mParentDevice->GetDevice()->CreateCommittedResource(heapProps, D3D12_HEAP_FLAG_NONE, resourceDesc, state, nullptr, IID_PPV_ARGS(&mResource));
     ASSERT(SUCCEEDED(result), "Failed to allocate resource!");
 
     mParentDevice->GetDevice()->GetCopyableFootprints(resourceDesc, 0, resourceDesc->MipLevels, 0, nullptr, nullptr, nullptr, &mAllocSize);
     Statistics::Get().UsedVRAM += mAllocSize;
 }
+
+void Resource::CreatePlacedResource(::Ref<Heap> heap, UInt64 offset, D3D12_RESOURCE_DESC* resourceDesc, D3D12_RESOURCE_STATES state)
+{
+    mLayout = ResourceLayout(state);
+    mHeap = heap;
+    mAllocSize = 0;
+    if (mParentDevice->IsNull()) {
+        return;
+    }
+    HRESULT result = mParentDevice->GetDevice()->CreatePlacedResource(heap->GetHeap(), offset, resourceDesc, state, nullptr, IID_PPV_ARGS(&mResource));
+    ASSERT(SUCCEEDED(result), "Failed to allocate placed resource!");
+}
+
+UInt64 Resource::EstimateSize(const D3D12_RESOURCE_DESC& resourceDesc)
+{
+    if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+        return resourceDesc.Width;
+    }
+
+    // Bytes per pixel, or per 4x4 block for the compressed formats
+    UInt64 bytes = 4;
+    bool block = false;
+    switch (resourceDesc.Format) {
+        case DXGI_FORMAT_R8_UNORM: bytes = 1; break;
+        case DXGI_FORMAT_R8G8_UNORM: bytes = 2; break;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT: bytes = 8; break;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT: bytes = 16; break;
+        case DXGI_FORMAT_BC4_UNORM: bytes = 8; block = true; break;
+        case DXGI_FORMAT_BC5_UNORM:
+        case DXGI_FORMAT_BC7_UNORM: bytes = 16; block = true; break;
+        default: break;
+    }
+
+    UInt64 size = 0;
+    UInt64 width = resourceDesc.Width;
+    UInt64 height = resourceDesc.Height;
+    for (UInt32 mip = 0; mip < std::max<UInt32>(resourceDesc.MipLevels, 1); mip++) {
+        UInt64 x = block ? (width + 3) / 4 : width;
+        UInt64 y = block ? (height + 3) / 4 : height;
+        size += x * y * bytes;
+
+        width = std::max<UInt64>(width / 2, 1);
+        height = std::max<UInt64>(height / 2, 1);
+    }
+    return size * resourceDesc.DepthOrArraySize;
+}
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <RHI/Device.hpp>
+#include <RHI/Heap.hpp>
 
 // We go through a parent Resource class so it's easier to tag/track them later down the line.
 
@@ -47,7 +48,10 @@ public:
     UInt64 GetSize() const { return mSize; }
     UInt64 GetStride() const { return mStride; }
     ID3D12Resource* GetResource() const { return mResource; }
-    UInt64 GetAddress() { return mResource->GetGPUVirtualAddress(); }
+    UInt64 GetAddress();
+    D3D12_HEAP_TYPE GetHeapType() const { return mHeapType; }
+    // Null backend buffers live here, empty otherwise
+    Vector<UInt8>& GetMemory() { return mMemory; }
     String GetName() { return mName; }
 
     ResourceLayout GetLayout() { return mLayout; };
@@ -60,11 +64,19 @@ protected:
     UInt64 mSize;
     UInt64 mStride;
     ResourceLayout mLayout;
+    D3D12_HEAP_TYPE mHeapType = D3D12_HEAP_TYPE_DEFAULT;
     String mName;
+    Vector<UInt8> mMemory;
 
     Vector<ResourceTag> mTags;
 
     void CreateResource(D3D12_HEAP_PROPERTIES* heapProps, D3D12_RESOURCE_DESC* resourceDesc, D3D12_RESOURCE_STATES state);
+    // The heap owns the memory and counts it, the resource only keeps it alive
+    void CreatePlacedResource(::Ref<Heap> heap, UInt64 offset, D3D12_RESOURCE_DESC* resourceDesc, D3D12_RESOURCE_STATES state);
+
+    // What the null backend counts for a resource, tightly packed with every mip
+    static UInt64 EstimateSize(const D3D12_RESOURCE_DESC& resourceDesc);
 private:
-    UInt64 mAllocSize;
+    UInt64 mAllocSize = 0;
+    ::Ref<Heap> mHeap = nullptr;
 };
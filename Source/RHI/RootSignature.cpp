@@ -6,28 +6,58 @@
 #include <RHI/RootSignature.hpp>
 #include <RHI/Utilities.hpp>
 #include <Core/Assert.hpp>
+#include <Core/Hash.hpp>
 #include <Core/Logger.hpp>
 
+// Serializes and creates the root signature, returns the hash of the serialized blob.
+// The serializer is part of the D3D12 runtime, which only Windows has. The null backend never gets here.
+static UInt64 Build(Device::Ref device, const D3D12_ROOT_SIGNATURE_DESC& desc, ID3D12RootSignature** rootSignature)
+{
+#if defined(_WIN32)
+    ID3DBlob* pRootSignatureBlob = nullptr;
+    ID3DBlob* pErrorBlob = nullptr;
+    D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1_0, &pRootSignatureBlob, &pErrorBlob);
+    if (pErrorBlob) {
+        LOG_ERROR("D3D12 Root Signature error! %s", pErrorBlob->GetBufferPointer());
+    }
+
+    HRESULT Result = device->GetDevice()->CreateRootSignature(0, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(rootSignature));
+    ASSERT(SUCCEEDED(Result), "Failed to create root signature!");
+    UInt64 hash = HashBytes(pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize());
+    pRootSignatureBlob->Release();
+    return hash;
+#else
+    ASSERT(false, "Root signatures need the D3D12 runtime!");
+    return 0;
+#endif
+}
+
 RootSignature::RootSignature(Device::Ref device)
 {
+    if (device->IsNull()) {
+        mHash = HashValue(UInt64(0));
+        return;
+    }
+
     D3D12_ROOT_SIGNATURE_DESC RootSignatureDesc = {};
     RootSignatureDesc.NumParameters = 0;
     RootSignatureDesc.pParameters = nullptr;
     RootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
-    ID3DBlob* pRootSignatureBlob;
-    ID3DBlob* pErrorBlob;
-    D3D12SerializeRootSignature(&RootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &pRootSignatureBlob, &pErrorBlob);
-    if (pErrorBlob) {
-        LOG_ERROR("D3D12 Root Signature error! %s", pErrorBlob->GetBufferPointer());
-    }
-    HRESULT Result = device->GetDevice()->CreateRootSignature(0, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&mRootSignature));
-    ASSERT(SUCCEEDED(Result), "Failed to create root signature!");
-    pRootSignatureBlob->Release();
+    mHash = Build(device, RootSignatureDesc, &mRootSignature);
 }
 
 RootSignature::RootSignature(Device::Ref device, const Vector<RootType>& roots, UInt64 pushConstantSize)
 {
+    // Nothing to serialize, the layout alone keeps pipeline hashes apart
+    if (device->IsNull()) {
+        mHash = HashValue(pushConstantSize, HashValue(UInt64(roots.size())));
+        for (RootType root : roots) {
+            mHash = HashValue(root, mHash);
+        }
+        return;
+    }
+
     std::vector<D3D12_ROOT_PARAMETER> Parameters(roots.size());
     std::vector<D3D12_DESCRIPTOR_RANGE> Ranges(roots.size());
     
@@ -59,15 +89,7 @@ RootSignature::RootSignature(Device::Ref device, const Vector<RootType>& roots,
                             | D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED
                             | D3D12_ROOT_SIGNATURE_FLAG_SAMPLER_HEAP_DIRECTLY_INDEXED;
 
-    ID3DBlob* pRootSignatureBlob;
-    ID3DBlob* pErrorBlob;
-    D3D12SerializeRootSignature(&RootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &pRootSignatureBlob, &pErrorBlob);
-    if (pErrorBlob) {
-        LOG_ERROR("D3D12 Root Signature error! %s", pErrorBlob->GetBufferPointer());
-    }
-    HRESULT Result = device->GetDevice()->CreateRootSignature(0, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&mRootSignature));
-    ASSERT(SUCCEEDED(Result), "Failed to create root signature!");
-    pRootSignatureBlob->Release();
+    mHash = Build(device, RootSignatureDesc, &mRootSignature);
 }
 
 RootSignature::~RootSignature()
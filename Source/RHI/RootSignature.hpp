@@ -19,13 +19,16 @@ enum class RootType
 class RootSignature
 {
 public:
-    using Ref = Ref<RootSignature>;
+    using Ref = ::Ref<RootSignature>;
 
     RootSignature(Device::Ref device);
     RootSignature(Device::Ref device, const Vector<RootType>& roots, UInt64 pushConstantSize = 0);
     ~RootSignature();
 
     ID3D12RootSignature* GetSignature() { return mRootSignature; }
+    // Hash of the serialized description, stable between runs
+    UInt64 GetHash() const { return mHash; }
 private:
     ID3D12RootSignature* mRootSignature = nullptr;
+    UInt64 mHash = 0;
 };
@@ -30,7 +30,8 @@ Sampler::Sampler(Device::Ref device, DescriptorHeaps heaps, SamplerAddress addre
     }
 
     mDescriptor = heaps[DescriptorHeapType::Sampler]->Allocate();
-    device->GetDevice()->CreateSampler(&samplerDesc, mDescriptor.CPU);
+    if (!device->IsNull())
+        device->GetDevice()->CreateSampler(&samplerDesc, mDescriptor.CPU);
 }
 
 Sampler::~Sampler()
@@ -26,7 +26,7 @@ enum class SamplerFilter
 class Sampler
 {
 public:
-    using Ref = Ref<Sampler>;
+    using Ref = ::Ref<Sampler>;
 
     Sampler(Device::Ref device, DescriptorHeaps heaps, SamplerAddress address, SamplerFilter filter, bool mips = false, int anisotropyLevel = 1, bool comparison = false);
     ~Sampler();
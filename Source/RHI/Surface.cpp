@@ -13,6 +13,24 @@ Surface::Surface(Window::Ref window, Device::Ref device, DescriptorHeaps heaps,
     int width, height;
     window->PollSize(width, height);
 
+    // Backbuffers that no swapchain owns, so passes can still target and transition them
+    if (device->IsNull()) {
+        for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+            TextureDesc desc = {};
+            desc.Name = "Backbuffer " + std::to_string(i);
+            desc.Width = width;
+            desc.Height = height;
+            desc.Depth = 1;
+            desc.Levels = 1;
+            desc.Format = TextureFormat::RGBA8;
+            mBackbuffers[i] = MakeRef<Texture>(device, nullptr, desc);
+
+            mBackbufferViews[i] = MakeRef<View>(device, heaps, mBackbuffers[i], ViewType::RenderTarget, ViewDimension::Texture, TextureFormat::RGBA8);
+        }
+        return;
+    }
+
+#if defined(_WIN32)
     DXGI_SWAP_CHAIN_DESC1 desc = {};
     desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     desc.SampleDesc.Count = 1;
@@ -42,14 +60,33 @@ Surface::Surface(Window::Ref window, Device::Ref device, DescriptorHeaps heaps,
 
         mBackbufferViews[i] = MakeRef<View>(device, heaps, mBackbuffers[i], ViewType::RenderTarget, ViewDimension::Texture, TextureFormat::RGBA8);
     }
+#endif
 }
 
 Surface::~Surface()
 {
+#if defined(_WIN32)
     D3DUtils::Release(mSwapchain);
+#endif
+}
+
+UInt32 Surface::GetBackbufferIndex()
+{
+#if defined(_WIN32)
+    if (mSwapchain) {
+        return mSwapchain->GetCurrentBackBufferIndex();
+    }
+#endif
+    return mIndex;
 }
 
 void Surface::Present(bool vsync)
 {
-    mSwapchain->Present(vsync ? 1 : 0, vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
+#if defined(_WIN32)
+    if (mSwapchain) {
+        mSwapchain->Present(vsync ? 1 : 0, vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
+        return;
+    }
+#endif
+    mIndex = (mIndex + 1) % FRAMES_IN_FLIGHT;
 }
@@ -13,18 +13,20 @@ constexpr UInt32 FRAMES_IN_FLIGHT = 3;
 class Surface
 {
 public:
-    using Ref = Ref<Surface>;
+    using Ref = ::Ref<Surface>;
 
     Surface(Window::Ref window, Device::Ref device, DescriptorHeaps heaps, Queue::Ref queue);
     ~Surface();
 
     void Present(bool vsync);
 
-    UInt32 GetBackbufferIndex() { return mSwapchain->GetCurrentBackBufferIndex(); }
+    UInt32 GetBackbufferIndex();
     Texture::Ref GetBackbuffer(UInt32 idx) { return mBackbuffers[idx]; }
     View::Ref GetBackbufferView(UInt32 idx) { return mBackbufferViews[idx]; }
 private:
     IDXGISwapChain4* mSwapchain = nullptr;
+    // Stands in for the swapchain's rotation on the null backend
+    UInt32 mIndex = 0;
     Array<Texture::Ref, FRAMES_IN_FLIGHT> mBackbuffers;
     Array<View::Ref, FRAMES_IN_FLIGHT> mBackbufferViews;
 };
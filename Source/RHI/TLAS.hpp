@@ -21,7 +21,7 @@ struct RaytracingInstance
 class TLAS : public AccelerationStructure
 {
 public:
-    using Ref = Ref<TLAS>;
+    using Ref = ::Ref<TLAS>;
 
     TLAS(Device::Ref device, DescriptorHeaps& heaps, Buffer::Ref instanceBuffer, UInt32 numInstance, const String& name = "TLAS");
     ~TLAS();
@@ -21,6 +21,42 @@ Texture::Texture(Device::Ref device, TextureDesc desc)
     D3D12_HEAP_PROPERTIES heapProperties = {};
     heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
     
+    D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(desc);
+    CreateResource(&heapProperties, &resourceDesc, D3D12_RESOURCE_STATE_COMMON);
+    SetName(desc.Name);
+}
+
+Texture::Texture(Device::Ref device, TextureDesc desc, Heap::Ref heap, UInt64 offset)
+    : Resource(device), mDesc(desc)
+{
+    mShouldFree = true;
+
+    D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(desc);
+    CreatePlacedResource(heap, offset, &resourceDesc, D3D12_RESOURCE_STATE_COMMON);
+    SetName(desc.Name);
+}
+
+Texture::~Texture()
+{
+    // Everything will automatically be cleaned up by Resource::~Resource().
+}
+
+void Texture::GetAllocationInfo(Device::Ref device, const TextureDesc& desc, UInt64& size, UInt64& alignment)
+{
+    D3D12_RESOURCE_DESC resourceDesc = GetResourceDesc(desc);
+    if (device->IsNull()) {
+        alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        size = (EstimateSize(resourceDesc) + alignment - 1) & ~(alignment - 1);
+        return;
+    }
+
+    D3D12_RESOURCE_ALLOCATION_INFO info = device->GetDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc);
+    size = info.SizeInBytes;
+    alignment = info.Alignment;
+}
+
+D3D12_RESOURCE_DESC Texture::GetResourceDesc(const TextureDesc& desc)
+{
     D3D12_RESOURCE_DESC resourceDesc = {};
     resourceDesc.Width = desc.Width;
     resourceDesc.Height = desc.Height;
@@ -39,14 +75,7 @@ Texture::Texture(Device::Ref device, TextureDesc desc)
         resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
     if (desc.Usage & TextureUsage::DepthTarget)
         resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-    
-    CreateResource(&heapProperties, &resourceDesc, D3D12_RESOURCE_STATE_COMMON);
-    SetName(desc.Name);
-}
-
-Texture::~Texture()
-{
-    // Everything will automatically be cleaned up by Resource::~Resource().
+    return resourceDesc;
 }
 
 TextureFormat Texture::StringToFormat(const String& format)
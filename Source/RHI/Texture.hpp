@@ -18,6 +18,8 @@ enum class TextureFormat
     RGB11Float = DXGI_FORMAT_R11G11B10_FLOAT,
     RG8 = DXGI_FORMAT_R8G8_UNORM,
     R8 = DXGI_FORMAT_R8_UNORM,
+    BC4 = DXGI_FORMAT_BC4_UNORM,
+    BC5 = DXGI_FORMAT_BC5_UNORM,
     BC7 = DXGI_FORMAT_BC7_UNORM,
     R32Float = DXGI_FORMAT_R32_FLOAT,
     Depth32 = DXGI_FORMAT_D32_FLOAT
@@ -45,16 +47,20 @@ struct TextureDesc
 class Texture : public Resource
 {
 public:
-    using Ref = Ref<Texture>;
+    using Ref = ::Ref<Texture>;
 
     Texture(Device::Ref device, ID3D12Resource* resource, TextureDesc desc);
     Texture(Device::Ref device, TextureDesc desc);
+    Texture(Device::Ref device, TextureDesc desc, Heap::Ref heap, UInt64 offset);
     ~Texture();
 
     TextureDesc GetDesc() const { return mDesc; }
 
     static TextureFormat StringToFormat(const String& format);
+    static void GetAllocationInfo(Device::Ref device, const TextureDesc& desc, UInt64& size, UInt64& alignment);
 private:
+    static D3D12_RESOURCE_DESC GetResourceDesc(const TextureDesc& desc);
+
     TextureDesc mDesc;
 };
 
@@ -28,6 +28,10 @@ void Uploader::EnqueueTextureUpload(Vector<UInt8> buffer, Ref<Resource> texture)
     UploadRequest request = {};
     request.Type = UploadRequestType::TextureToGPU;
     request.Resource = texture;
+    if (sData.Device->IsNull()) {
+        EnqueueRawTextureUpload(request, buffer.data(), buffer.size());
+        return;
+    }
     
     D3D12_RESOURCE_DESC desc = texture->GetResource()->GetDesc();
     std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(desc.MipLevels);
@@ -64,6 +68,10 @@ void Uploader::EnqueueTextureUpload(Image image, Ref<Resource> buffer)
     UploadRequest request = {};
     request.Type = UploadRequestType::TextureToGPU;
     request.Resource = buffer;
+    if (sData.Device->IsNull()) {
+        EnqueueRawTextureUpload(request, image.Pixels.data(), image.Pixels.size());
+        return;
+    }
     
     D3D12_RESOURCE_DESC desc = buffer->GetResource()->GetDesc();
     std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(desc.MipLevels);
@@ -93,6 +101,18 @@ void Uploader::EnqueueTextureUpload(Image image, Ref<Resource> buffer)
         Flush();
 }
 
+void Uploader::EnqueueRawTextureUpload(UploadRequest& request, const void* data, UInt64 size)
+{
+    request.StagingBuffer = MakeRef<Buffer>(sData.Device, sData.Heaps, size, 0, BufferType::Copy, "Staging Buffer " + request.Resource->GetName());
+    request.StagingBuffer->CopyMapped(const_cast<void*>(data), size);
+
+    sData.Requests.push_back(request);
+
+    sData.UploadBatchSize += size;
+    if (sData.UploadBatchSize >= MAX_UPLOAD_BATCH_SIZE)
+        Flush();
+}
+
 void Uploader::EnqueueBufferUpload(void* data, UInt64 size, Ref<Resource> buffer)
 {
     sData.BufferRequests++;
@@ -166,6 +186,9 @@ void Uploader::Flush()
     sData.CmdBuffer->End();
     sData.UploadQueue->Submit({ sData.CmdBuffer });
 
+    const BarrierStats& barriers = sData.CmdBuffer->GetBarrierStats();
+    LOG_INFO("Upload barriers: {0} requested, {1} submitted in {2} calls", barriers.Requested, barriers.Submitted, barriers.Calls);
+
     // Wait and clear
     sData.Rhi->Wait();
     ClearRequests();
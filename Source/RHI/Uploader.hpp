@@ -44,16 +44,19 @@ private:
     {
         UploadRequestType Type;
 
-        Ref<Resource> Resource = nullptr;
+        Ref<::Resource> Resource = nullptr;
         Ref<Buffer> StagingBuffer = nullptr;
         Ref<AccelerationStructure> Acceleration = nullptr;
     };
 
+    // Null textures have no layout to match, the raw bytes still go through staging so uploads are counted
+    static void EnqueueRawTextureUpload(UploadRequest& request, const void* data, UInt64 size);
+
     static struct Data
     {
         RHI* Rhi = nullptr;
         DescriptorHeaps Heaps;
-        Device::Ref Device = nullptr;
+        ::Device::Ref Device = nullptr;
         Queue::Ref UploadQueue = nullptr;
         CommandBuffer::Ref CmdBuffer = nullptr;
         Vector<UploadRequest> Requests;
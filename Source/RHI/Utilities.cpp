@@ -14,6 +14,7 @@ void D3DUtils::Release(IUnknown* object)
     }
 }
 
+#if defined(_WIN32)
 UInt64 D3DUtils::CalculateAdapterScore(IDXGIAdapter1* adapter)
 {
     ID3D12Device* device;
@@ -55,3 +56,4 @@ UInt64 D3DUtils::CalculateAdapterScore(IDXGIAdapter1* adapter)
 
     return resultScore;
 }
+#endif
@@ -5,8 +5,7 @@
 
 #pragma once
 
-#include <Agility/d3d12.h>
-#include <dxgi1_6.h>
+#include <RHI/D3D12.hpp>
 #include <Core/Common.hpp>
 
 class D3DUtils
@@ -38,7 +38,8 @@ View::View(Device::Ref device, DescriptorHeaps heaps, ::Ref<Resource> resource,
             desc.Buffer.StructureByteStride = resource->GetStride();
         }
 
-        device->GetDevice()->CreateShaderResourceView(resource->GetResource(), &desc, mDescriptor.CPU);
+        if (!device->IsNull())
+            device->GetDevice()->CreateShaderResourceView(resource->GetResource(), &desc, mDescriptor.CPU);
         break;
     }
     case ViewType::Storage: {
@@ -65,7 +66,8 @@ View::View(Device::Ref device, DescriptorHeaps heaps, ::Ref<Resource> resource,
             desc.Buffer.StructureByteStride = 1;
         }
 
-        device->GetDevice()->CreateUnorderedAccessView(resource->GetResource(), nullptr, &desc, mDescriptor.CPU);
+        if (!device->IsNull())
+            device->GetDevice()->CreateUnorderedAccessView(resource->GetResource(), nullptr, &desc, mDescriptor.CPU);
         break;
     }
     case ViewType::RenderTarget: {
@@ -79,7 +81,8 @@ View::View(Device::Ref device, DescriptorHeaps heaps, ::Ref<Resource> resource,
         desc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
         desc.Texture2D.PlaneSlice = depthSlice;
 
-        device->GetDevice()->CreateRenderTargetView(resource->GetResource(), &desc, mDescriptor.CPU);
+        if (!device->IsNull())
+            device->GetDevice()->CreateRenderTargetView(resource->GetResource(), &desc, mDescriptor.CPU);
         break;
     }
     case ViewType::DepthTarget: {
@@ -101,7 +104,8 @@ View::View(Device::Ref device, DescriptorHeaps heaps, ::Ref<Resource> resource,
             desc.Texture2DArray.MipSlice = 0;
         }
         
-        device->GetDevice()->CreateDepthStencilView(resource->GetResource(), &desc, mDescriptor.CPU);
+        if (!device->IsNull())
+            device->GetDevice()->CreateDepthStencilView(resource->GetResource(), &desc, mDescriptor.CPU);
         break;
     }
     }
@@ -30,7 +30,7 @@ constexpr UInt64 VIEW_ALL_MIPS = 0xFFFFFFFF;
 class View
 {
 public:
-    using Ref = Ref<View>;
+    using Ref = ::Ref<View>;
 
     View(Device::Ref device, DescriptorHeaps heaps, ::Ref<Resource> resource, ViewType type, ViewDimension dimension = ViewDimension::Texture, TextureFormat format = TextureFormat::Unknown, UInt64 mip = VIEW_ALL_MIPS, UInt64 depthSlice = 0);
     ~View();
@@ -0,0 +1,190 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:07:45
+//
+
+#include <Renderer/CascadeSchedule.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Checks.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <random>
+
+CascadeSchedule::CascadeSchedule(UInt32 count, UInt32 maxPeriod)
+{
+    // A power of two, so every period divides the cycle
+    mMaxPeriod = std::bit_ceil(std::max(maxPeriod, 1u));
+
+    Vector<UInt32> load(mMaxPeriod, 0);
+    for (UInt32 i = 0; i < count; i++) {
+        UInt32 period = std::min(1u << std::min(i, 31u), mMaxPeriod);
+
+        // Lands on the least busy frames of the cycle
+        UInt32 best = 0;
+        UInt32 bestLoad = UINT32_MAX;
+        for (UInt32 offset = 0; offset < period; offset++) {
+            UInt32 worst = 0;
+            for (UInt32 frame = offset; frame < mMaxPeriod; frame += period) {
+                worst = std::max(worst, load[frame]);
+            }
+            if (worst < bestLoad) {
+                best = offset;
+                bestLoad = worst;
+            }
+        }
+        for (UInt32 frame = best; frame < mMaxPeriod; frame += period) {
+            load[frame]++;
+        }
+
+        mPeriods.push_back(period);
+        mOffsets.push_back(best);
+    }
+}
+
+bool CascadeSchedule::IsDue(UInt32 cascade, UInt64 frame) const
+{
+    return frame % mPeriods[cascade] == mOffsets[cascade];
+}
+
+float CascadeSchedule::GetFitExtent(const glm::vec3& receiverMin, const glm::vec3& receiverMax, float sphereRadius)
+{
+    float step = sphereRadius * 2.0f / 16.0f;
+    float fit = std::max(receiverMax.x - receiverMin.x, receiverMax.y - receiverMin.y);
+    return std::max(std::ceil(fit / step), 1.0f) * step;
+}
+
+CascadeSchedule::Window CascadeSchedule::Fit(const glm::vec3& receiverMin, const glm::vec3& receiverMax, float sphereRadius, UInt32 resolution, float guardBand)
+{
+    float step = sphereRadius * 2.0f / 16.0f;
+    float fit = std::max(receiverMax.x - receiverMin.x, receiverMax.y - receiverMin.y);
+    float guard = fit * guardBand;
+
+    // Snapping moves the origin by up to a texel, it has to stay covered
+    float extent = std::max(std::ceil((fit + guard * 2.0f) / step), 1.0f) * step;
+    if (fit + guard * 2.0f + 2.0f * extent / resolution > extent) {
+        extent += step;
+    }
+    float texel = extent / resolution;
+
+    Window window;
+    glm::vec2 center = (glm::vec2(receiverMin.x, receiverMin.y) + glm::vec2(receiverMax.x, receiverMax.y)) * 0.5f;
+    window.Origin = glm::floor((center - glm::vec2(extent * 0.5f)) / texel) * texel;
+    window.Extent = extent;
+
+    // Light space looks down -Z
+    window.Near = -receiverMax.z - guard;
+    window.Far = std::max(-receiverMin.z + guard, window.Near + sphereRadius * 2.0f);
+    return window;
+}
+
+bool CascadeSchedule::Covers(const Window& cached, const glm::vec3& receiverMin, const glm::vec3& receiverMax, float sphereRadius)
+{
+    if (cached.Extent <= 0.0f)
+        return false;
+
+    bool inside = receiverMin.x >= cached.Origin.x && receiverMax.x <= cached.Origin.x + cached.Extent &&
+                  receiverMin.y >= cached.Origin.y && receiverMax.y <= cached.Origin.y + cached.Extent &&
+                  -receiverMax.z >= cached.Near && -receiverMin.z <= cached.Far;
+    return inside && cached.Extent <= 2.0f * GetFitExtent(receiverMin, receiverMax, sphereRadius);
+}
+
+bool CascadeSchedule::SelfTest()
+{
+    Checks check("CascadeSchedule");
+
+    // Periods double up to the cap, and the far cascades don't pile up on the same frame
+    {
+        CascadeSchedule schedule(4, 4);
+        check(schedule.GetPeriod(0) == 1 && schedule.GetPeriod(1) == 2 && schedule.GetPeriod(2) == 4 && schedule.GetPeriod(3) == 4, "periods are 1, 2, 4, 4");
+
+        Array<UInt32, 4> updates = {};
+        bool even = true;
+        for (UInt64 frame = 0; frame < 64; frame++) {
+            UInt32 due = 0;
+            for (UInt32 i = 0; i < 4; i++) {
+                if (schedule.IsDue(i, frame)) {
+                    updates[i]++;
+                    due++;
+                }
+            }
+            even = even && due == 2;
+        }
+        check(even, "two cascades render every frame");
+        check(updates[0] == 64 && updates[1] == 32 && updates[2] == 16 && updates[3] == 16, "cascades render at their rates");
+    }
+    {
+        CascadeSchedule schedule(4, 1);
+        bool all = true;
+        for (UInt64 frame = 0; frame < 16; frame++) {
+            for (UInt32 i = 0; i < 4; i++) {
+                all = all && schedule.IsDue(i, frame);
+            }
+        }
+        check(all, "a period of one renders everything every frame");
+    }
+    {
+        CascadeSchedule schedule(4, 6);
+        check(schedule.GetPeriod(3) == 8, "the cycle rounds up to a power of two");
+        UInt32 worst = 0;
+        for (UInt64 frame = 0; frame < 64; frame++) {
+            UInt32 due = 0;
+            for (UInt32 i = 0; i < 4; i++) {
+                due += schedule.IsDue(i, frame);
+            }
+            worst = std::max(worst, due);
+        }
+        check(worst <= 2, "far cascades take turns");
+    }
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> random(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> size(1.0f, 40.0f);
+    const UInt32 RESOLUTION = 2048;
+    const float RADIUS = 32.0f;
+
+    bool ownReceivers = true;
+    bool snapped = true;
+    bool scrolls = true;
+    bool guarded = true;
+    bool rejects = true;
+    for (int i = 0; i < 1000; i++) {
+        glm::vec3 receiverMin(random(generator), random(generator), random(generator));
+        glm::vec3 receiverMax = receiverMin + glm::vec3(size(generator), size(generator), size(generator));
+
+        Window window = Fit(receiverMin, receiverMax, RADIUS, RESOLUTION, 0.0f);
+        float texel = window.Extent / RESOLUTION;
+        ownReceivers = ownReceivers && Covers(window, receiverMin, receiverMax, RADIUS);
+
+        // The origin sits on the texel grid, so anything sampled through it doesn't shimmer
+        glm::vec2 cells = window.Origin / texel;
+        snapped = snapped && std::abs(cells.x - std::round(cells.x)) < 1e-2f && std::abs(cells.y - std::round(cells.y)) < 1e-2f;
+
+        // Moving by whole texels moves the window by exactly as many and keeps its size
+        glm::vec3 shift = glm::vec3(std::round(random(generator)) * texel, std::round(random(generator)) * texel, 0.0f);
+        Window moved = Fit(receiverMin + shift, receiverMax + shift, RADIUS, RESOLUTION, 0.0f);
+        glm::vec2 offset = (moved.Origin - window.Origin - glm::vec2(shift.x, shift.y)) / texel;
+        scrolls = scrolls && moved.Extent == window.Extent && std::abs(offset.x) < 1e-2f && std::abs(offset.y) < 1e-2f;
+
+        // Moves inside the guard band keep the cached depth, moves past the window don't
+        Window padded = Fit(receiverMin, receiverMax, RADIUS, RESOLUTION, 0.1f);
+        float fit = std::max(receiverMax.x - receiverMin.x, receiverMax.y - receiverMin.y);
+        glm::vec3 nudge = glm::vec3(fit * 0.09f, -fit * 0.09f, fit * 0.09f);
+        guarded = guarded && Covers(padded, receiverMin + nudge, receiverMax + nudge, RADIUS);
+
+        glm::vec3 away = glm::vec3(padded.Extent, 0.0f, 0.0f);
+        rejects = rejects && !Covers(padded, receiverMin + away, receiverMax + away, RADIUS);
+
+        // Nor when the receivers shrank so much the cached texels are too big
+        glm::vec3 center = (receiverMin + receiverMax) * 0.5f;
+        Window wide = Fit(center - glm::vec3(RADIUS), center + glm::vec3(RADIUS), RADIUS, RESOLUTION, 0.0f);
+        rejects = rejects && !Covers(wide, center - glm::vec3(0.5f), center + glm::vec3(0.5f), RADIUS);
+    }
+    check(ownReceivers, "a window covers the receivers it was fit to");
+    check(snapped, "origins snap to texels");
+    check(scrolls, "windows scroll by whole texels");
+    check(guarded, "the guard band keeps small moves cached");
+    check(rejects, "windows that lost the receivers or too much resolution are rejected");
+
+    return check.Finish();
+}
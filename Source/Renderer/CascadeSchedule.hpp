@@ -0,0 +1,49 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:04:17
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <glm/glm.hpp>
+
+// Decides which shadow cascades render on a frame, and whether the depth a cascade already holds still covers what it has to.
+// A cached cascade keeps the matrices it was rendered with, so sampling it stays exact as long as the receivers are inside
+// its window. Pure CPU.
+class CascadeSchedule
+{
+public:
+    // Light space rectangle and depth range a cascade renders, snapped to its texels
+    struct Window
+    {
+        glm::vec2 Origin = glm::vec2(0.0f);
+        float Extent = 0.0f;
+        float Near = 0.0f;
+        float Far = 0.0f;
+    };
+
+    // The first cascade is due every frame, cascade i every 2^i frames up to maxPeriod. Offsets are spread so the far
+    // cascades take turns instead of landing on the same frame.
+    CascadeSchedule(UInt32 count = 4, UInt32 maxPeriod = 4);
+
+    bool IsDue(UInt32 cascade, UInt64 frame) const;
+    UInt32 GetPeriod(UInt32 cascade) const { return mPeriods[cascade]; }
+
+    // Fits light space receiver bounds. The extent grows in sixteenths of the cascade sphere's diameter, plus a guard band
+    // so small camera moves stay inside, and the origin snaps to texels. Depth keeps at least the sphere's range.
+    static Window Fit(const glm::vec3& receiverMin, const glm::vec3& receiverMax, float sphereRadius, UInt32 resolution, float guardBand);
+    // Whether depth rendered for a window can still be sampled for these receivers, without more than twice the texel size
+    // a fresh fit would get
+    static bool Covers(const Window& cached, const glm::vec3& receiverMin, const glm::vec3& receiverMax, float sphereRadius);
+
+    // Periods, round robin spread, snapping stability and coverage against known results
+    static bool SelfTest();
+private:
+    static float GetFitExtent(const glm::vec3& receiverMin, const glm::vec3& receiverMax, float sphereRadius);
+
+    UInt32 mMaxPeriod;
+    Vector<UInt32> mPeriods;
+    Vector<UInt32> mOffsets;
+};
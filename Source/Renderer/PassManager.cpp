@@ -51,16 +51,12 @@ void PassManager::Init(RHI::Ref rhi, Window::Ref window)
                     io->Desc.Height = std::round(io->Desc.Height / (downsample / 2));
                 }
 
-                LOG_INFO("Creating PassIO {0} (Width = {1}, Height = {2}, Format = {3}, Usage = {4})", name, io->Desc.Width, io->Desc.Height, format, usage);
-                io->Texture = rhi->CreateTexture(io->Desc);
+                io->Transient = info["Transient"].value_or(false);
 
-                if (usage == "Render") {
-                    io->RenderTargetView = rhi->CreateView(io->Texture, ViewType::RenderTarget);
-                    io->ShaderResourceView = rhi->CreateView(io->Texture, ViewType::ShaderResource);
-                    io->UnorderedAccessView = rhi->CreateView(io->Texture, ViewType::Storage);
-                } else {
-                    io->DepthTargetView = rhi->CreateView(io->Texture, ViewType::DepthTarget);
-                    io->ShaderResourceView = rhi->CreateView(io->Texture, ViewType::ShaderResource, ViewDimension::Texture, TextureFormat::R32Float);
+                LOG_INFO("Creating PassIO {0} (Width = {1}, Height = {2}, Format = {3}, Usage = {4}, Transient = {5})", name, io->Desc.Width, io->Desc.Height, format, usage, io->Transient);
+                if (!io->Transient) {
+                    io->Texture = rhi->CreateTexture(io->Desc);
+                    CreateViews(rhi, io);
                 }
             } else if (type == "RingBuffer") {
                 Int64 size = info["Size"].as_integer()->get();
@@ -143,3 +139,28 @@ void PassManager::Init(RHI::Ref rhi, Window::Ref window)
         }
     }
 }
+
+void PassManager::Bind(RHI::Ref rhi, const String& name, Texture::Ref texture)
+{
+    Ref<RenderPassIO> io = sPassIOs[name];
+    io->Texture = texture;
+    io->RenderTargetView = nullptr;
+    io->DepthTargetView = nullptr;
+    io->ShaderResourceView = nullptr;
+    io->UnorderedAccessView = nullptr;
+    if (texture) {
+        CreateViews(rhi, io);
+    }
+}
+
+void PassManager::CreateViews(RHI::Ref rhi, Ref<RenderPassIO> io)
+{
+    if (io->Desc.Usage & TextureUsage::RenderTarget) {
+        io->RenderTargetView = rhi->CreateView(io->Texture, ViewType::RenderTarget);
+        io->ShaderResourceView = rhi->CreateView(io->Texture, ViewType::ShaderResource);
+        io->UnorderedAccessView = rhi->CreateView(io->Texture, ViewType::Storage);
+    } else {
+        io->DepthTargetView = rhi->CreateView(io->Texture, ViewType::DepthTarget);
+        io->ShaderResourceView = rhi->CreateView(io->Texture, ViewType::ShaderResource, ViewDimension::Texture, TextureFormat::R32Float);
+    }
+}
@@ -12,7 +12,8 @@ struct RenderPassIO
 {
     // Texture
     TextureDesc Desc;
-    Texture::Ref Texture;
+    bool Transient = false; // Owned by the render graph, null until Renderer binds it
+    ::Texture::Ref Texture;
     View::Ref RenderTargetView;
     View::Ref DepthTargetView;
     View::Ref ShaderResourceView;
@@ -26,8 +27,13 @@ class PassManager
 {
 public:
     static void Init(RHI::Ref rhi, Window::Ref window);
+    // Hands a transient texture its memory and rebuilds its views
+    static void Bind(RHI::Ref rhi, const String& name, Texture::Ref texture);
 
     static Ref<RenderPassIO> Get(const String& Name) { return sPassIOs[Name]; }
+    static const UnorderedMap<String, Ref<RenderPassIO>>& GetAll() { return sPassIOs; }
 private:
+    static void CreateViews(RHI::Ref rhi, Ref<RenderPassIO> io);
+
     static UnorderedMap<String, Ref<RenderPassIO>> sPassIOs;
 };
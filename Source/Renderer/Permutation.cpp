@@ -4,26 +4,69 @@
 //
 
 #include <Renderer/Permutation.hpp>
-#include <Asset/AssetManager.hpp>
+#include <Asset/AssetCacher.hpp>
+#include <Core/Logger.hpp>
 
-Permutation::Permutation(RHI::Ref rhi, GraphicsPipelineSpecs& specs)
-    : mRHI(rhi), mSpecs(specs)
-{
+static const char* sFeatureDefines[MAX_SHADER_FEATURES] = {
+    "ALPHA_TEST",
+    "NORMAL_MAP",
+    nullptr,
+    nullptr
+};
 
+Permutation::Permutation(RHI::Ref rhi, GraphicsPipelineSpecs& specs, const String& vertex, const String& fragment, ShaderFeatures supported)
+{
+    Init(rhi, specs, vertex, fragment, supported);
 }
 
-void Permutation::Init(RHI::Ref rhi, GraphicsPipelineSpecs& specs)
+void Permutation::Init(RHI::Ref rhi, GraphicsPipelineSpecs& specs, const String& vertex, const String& fragment, ShaderFeatures supported)
 {
     mRHI = rhi;
     mSpecs = specs;
+    mVertex = vertex;
+    mFragment = fragment;
+    mSupported = supported;
 }
 
-void Permutation::AddPermutation(const String& name, const String& vertex, const String& fragment)
+GraphicsPipeline::Ref Permutation::Get(ShaderFeatures features, bool async)
 {
-    Asset::Handle vertexShader = AssetManager::Get(vertex, AssetType::Shader);
-    Asset::Handle pixelShader = AssetManager::Get(fragment, AssetType::Shader);
+    UInt32 index = static_cast<UInt32>(features & mSupported);
+    if (mPermutations[index]) {
+        return mPermutations[index];
+    }
+
+    Vector<String> defines;
+    for (int i = 0; i < MAX_SHADER_FEATURES; i++) {
+        if ((index & BIT(i)) && sFeatureDefines[i]) {
+            defines.push_back(sFeatureDefines[i]);
+        }
+    }
+
+    mSpecs.Bytecodes[ShaderType::Vertex] = AssetCacher::GetShaderPermutation(mVertex, defines);
+    mSpecs.Bytecodes[ShaderType::Fragment] = AssetCacher::GetShaderPermutation(mFragment, defines);
+    mPermutations[index] = mRHI->CreateGraphicsPipeline(mSpecs, async);
+    return mPermutations[index];
+}
 
-    mSpecs.Bytecodes[ShaderType::Vertex] = vertexShader->Shader;
-    mSpecs.Bytecodes[ShaderType::Fragment] = pixelShader->Shader;
-    mPermutations[name] = mRHI->CreateGraphicsPipeline(mSpecs);
+void Permutation::PrecompileAll()
+{
+    // Walk every subset of the supported bits
+    UInt32 supported = static_cast<UInt32>(mSupported);
+    UInt32 subset = 0;
+    do {
+        Get(static_cast<ShaderFeatures>(subset), true);
+        subset = (subset - supported) & supported;
+    } while (subset != 0);
+}
+
+ShaderFeatures Permutation::GetMaterialFeatures(const GLTFMaterial& material)
+{
+    ShaderFeatures features = ShaderFeatures::None;
+    if (material.AlphaTested) {
+        features |= ShaderFeatures::AlphaTest;
+    }
+    if (material.Normal) {
+        features |= ShaderFeatures::NormalMap;
+    }
+    return features;
 }
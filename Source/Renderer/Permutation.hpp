@@ -6,20 +6,57 @@
 #pragma once
 
 #include <RHI/RHI.hpp>
+#include <Asset/GLTF.hpp>
+
+#define MAX_SHADER_FEATURES 4
+
+// Each bit turns on one define when compiling a permutation, see Permutation.cpp for the names
+enum class ShaderFeatures
+{
+    None = 0,
+    AlphaTest = BIT(0),
+    NormalMap = BIT(1)
+};
+
+inline constexpr ShaderFeatures operator&(ShaderFeatures x, ShaderFeatures y)
+{
+    return static_cast<ShaderFeatures>(static_cast<UInt32>(x) & static_cast<UInt32>(y));
+}
+
+inline constexpr ShaderFeatures operator|(ShaderFeatures x, ShaderFeatures y)
+{
+    return static_cast<ShaderFeatures>(static_cast<UInt32>(x) | static_cast<UInt32>(y));
+}
+
+inline ShaderFeatures& operator|=(ShaderFeatures& x, ShaderFeatures y)
+{
+    x = x | y;
+    return x;
+}
 
 class Permutation
 {
 public:
     Permutation() = default;
-    Permutation(RHI::Ref rhi, GraphicsPipelineSpecs& specs);
+    Permutation(RHI::Ref rhi, GraphicsPipelineSpecs& specs, const String& vertex, const String& fragment, ShaderFeatures supported);
     ~Permutation() = default;
 
-    void Init(RHI::Ref rhi, GraphicsPipelineSpecs& specs);
-    void AddPermutation(const String& name, const String& vertex, const String& fragment);
-    GraphicsPipeline::Ref Get(const String& name) { return mPermutations[name]; }
+    // supported masks out features the shaders don't care about, so they share one pipeline
+    void Init(RHI::Ref rhi, GraphicsPipelineSpecs& specs, const String& vertex, const String& fragment, ShaderFeatures supported);
+
+    // Compiles the permutation the first time it's asked for. async leaves the PSO creation to a worker thread.
+    GraphicsPipeline::Ref Get(ShaderFeatures features, bool async = false);
+    // Compiles every combination of the supported features up front, in the background
+    void PrecompileAll();
+
+    static ShaderFeatures GetMaterialFeatures(const GLTFMaterial& material);
 private:
     GraphicsPipelineSpecs mSpecs;
     RHI::Ref mRHI;
-    
-    UnorderedMap<String, GraphicsPipeline::Ref> mPermutations;
+
+    String mVertex;
+    String mFragment;
+    ShaderFeatures mSupported = ShaderFeatures::None;
+
+    Array<GraphicsPipeline::Ref, 1 << MAX_SHADER_FEATURES> mPermutations;
 };
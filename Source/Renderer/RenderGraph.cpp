@@ -0,0 +1,615 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 10:41:55
+//
+
+#include <Renderer/RenderGraph.hpp>
+#include <Core/Assert.hpp>
+#include <Core/Checks.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Profiler.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+// What D3D12 places resources on by default, kept here so sizes can be estimated without the D3D12 headers in the way
+static constexpr UInt64 PLACEMENT_ALIGNMENT = 64 * 1024;
+
+static const char* LayoutToString(ResourceLayout layout)
+{
+    switch (layout) {
+        case ResourceLayout::Common: return "Common";
+        case ResourceLayout::Shader: return "Shader";
+        case ResourceLayout::Storage: return "Storage";
+        case ResourceLayout::DepthWrite: return "DepthWrite";
+        case ResourceLayout::DepthRead: return "DepthRead";
+        case ResourceLayout::ColorWrite: return "ColorWrite";
+        case ResourceLayout::CopySource: return "CopySource";
+        case ResourceLayout::CopyDest: return "CopyDest";
+        case ResourceLayout::GenericRead: return "GenericRead";
+        case ResourceLayout::Vertex: return "Vertex";
+        case ResourceLayout::AccelerationStructure: return "AccelerationStructure";
+        case ResourceLayout::NonPixelShader: return "NonPixelShader";
+        default: return "Unknown";
+    }
+}
+
+static bool IsTarget(const TextureDesc& desc)
+{
+    return (desc.Usage & TextureUsage::RenderTarget) || (desc.Usage & TextureUsage::DepthTarget);
+}
+
+void RenderGraph::Builder::Read(const String& name, ResourceLayout layout)
+{
+    Add(name, layout, false);
+}
+
+void RenderGraph::Builder::Write(const String& name, ResourceLayout layout)
+{
+    Add(name, layout, true);
+}
+
+void RenderGraph::Builder::SideEffect()
+{
+    mGraph->mPasses[mPass].SideEffect = true;
+}
+
+void RenderGraph::Builder::Add(const String& name, ResourceLayout layout, bool write)
+{
+    auto it = mGraph->mTextureLookup.find(name);
+    ASSERT(it != mGraph->mTextureLookup.end(), "Render graph pass uses a texture that was never declared!");
+
+    // One layout per texture per pass, a pass that needs more than that has to split
+    PassNode& pass = mGraph->mPasses[mPass];
+    for (auto& access : pass.Accesses) {
+        if (access.TextureIndex == it->second) {
+            ASSERT(access.Layout == layout, "Render graph pass uses the same texture in two layouts!");
+            access.Write |= write;
+            return;
+        }
+    }
+    pass.Accesses.push_back({ it->second, layout, write });
+}
+
+void RenderGraph::Reset()
+{
+    mTextures.clear();
+    mPasses.clear();
+    mHeaps.clear();
+    mExitTransitions.clear();
+    mTextureLookup.clear();
+    mStats = {};
+}
+
+UInt32 RenderGraph::AddTexture(const String& name, const TextureDesc& desc)
+{
+    ASSERT(mTextureLookup.find(name) == mTextureLookup.end(), "Render graph texture declared twice!");
+
+    TextureNode node;
+    node.Name = name;
+    node.Desc = desc;
+    mTextures.push_back(node);
+    mTextureLookup[name] = mTextures.size() - 1;
+    return mTextures.size() - 1;
+}
+
+void RenderGraph::Import(const String& name, const TextureDesc& desc, Texture::Ref texture, ResourceLayout layout, bool restore)
+{
+    TextureNode& node = mTextures[AddTexture(name, desc)];
+    node.Texture = texture;
+    node.Imported = true;
+    node.Restore = restore;
+    node.Layout = layout;
+}
+
+void RenderGraph::CreateTransient(const String& name, const TextureDesc& desc)
+{
+    AddTexture(name, desc);
+}
+
+void RenderGraph::Bind(const String& name, Texture::Ref texture)
+{
+    auto it = mTextureLookup.find(name);
+    ASSERT(it != mTextureLookup.end() && mTextures[it->second].Imported, "Only imported render graph textures can be bound!");
+    mTextures[it->second].Texture = texture;
+}
+
+void RenderGraph::AddPass(const String& name, const std::function<void(Builder& builder)>& setup, const ExecuteFunction& execute)
+{
+    PassNode node;
+    node.Name = name;
+    node.ProfileName = Profiler::Intern(name);
+    node.Execute = execute;
+    mPasses.push_back(node);
+
+    Builder builder(this, mPasses.size() - 1);
+    setup(builder);
+}
+
+void RenderGraph::Compile(bool cull, const SizeFunction& size)
+{
+    mStats = {};
+    mHeaps.clear();
+    mExitTransitions.clear();
+    for (auto& texture : mTextures) {
+        texture.FirstPass = -1;
+        texture.LastPass = -1;
+        texture.HeapIndex = -1;
+        texture.AliasedFrom = -1;
+        if (!texture.Imported) {
+            texture.Texture = nullptr;
+        }
+    }
+    for (auto& pass : mPasses) {
+        pass.Culled = false;
+        pass.Aliases.clear();
+        pass.Transitions.clear();
+        pass.UAVs.clear();
+        pass.Discards.clear();
+        pass.SplitBegins.clear();
+    }
+
+    // Walk backwards: a pass survives if it has side effects, writes an imported texture or writes something a surviving pass reads
+    Vector<bool> needed(mTextures.size(), false);
+    for (Int32 i = mPasses.size() - 1; i >= 0; i--) {
+        PassNode& pass = mPasses[i];
+
+        bool keep = !cull || pass.SideEffect;
+        for (auto& access : pass.Accesses) {
+            if (access.Write && (mTextures[access.TextureIndex].Imported || needed[access.TextureIndex])) {
+                keep = true;
+            }
+        }
+
+        pass.Culled = !keep;
+        if (!keep) {
+            continue;
+        }
+        for (auto& access : pass.Accesses) {
+            needed[access.TextureIndex] = true;
+        }
+    }
+
+    // Lifetimes, and the layout each texture is in when the frame starts
+    Vector<ResourceLayout> layouts(mTextures.size());
+    for (UInt32 i = 0; i < mTextures.size(); i++) {
+        layouts[i] = mTextures[i].Imported ? mTextures[i].Layout : ResourceLayout::Common;
+    }
+    for (Int32 i = 0; i < mPasses.size(); i++) {
+        if (mPasses[i].Culled) {
+            continue;
+        }
+        mStats.Passes++;
+        for (auto& access : mPasses[i].Accesses) {
+            TextureNode& texture = mTextures[access.TextureIndex];
+            if (texture.FirstPass == -1) {
+                texture.FirstPass = i;
+            }
+            texture.LastPass = i;
+
+            // Transients stay in whatever layout the previous frame left them in
+            if (!texture.Imported) {
+                layouts[access.TextureIndex] = access.Layout;
+            }
+        }
+    }
+    mStats.CulledPasses = mPasses.size() - mStats.Passes;
+
+    // Transitions. When there's at least one pass between the previous user of a texture and the next one, the transition
+    // is split so the GPU can work on it in the meantime.
+    Vector<Int32> kept;
+    for (Int32 i = 0; i < mPasses.size(); i++) {
+        if (!mPasses[i].Culled) {
+            kept.push_back(i);
+        }
+    }
+    auto split = [&](Int32 previous, Int32 next) {
+        return previous != -1 && std::count_if(kept.begin(), kept.end(), [&](Int32 i) { return i > previous && i < next; }) > 0;
+    };
+
+    Vector<bool> storageWritten(mTextures.size(), false);
+    Vector<Int32> lastUser(mTextures.size(), -1);
+    for (Int32 i = 0; i < mPasses.size(); i++) {
+        PassNode& pass = mPasses[i];
+        if (pass.Culled) {
+            continue;
+        }
+        for (auto& access : pass.Accesses) {
+            UInt32 index = access.TextureIndex;
+            if (layouts[index] != access.Layout) {
+                Transition transition = { index, layouts[index], access.Layout };
+                if (split(lastUser[index], i)) {
+                    transition.Split = true;
+                    mPasses[lastUser[index]].SplitBegins.push_back(transition);
+                    mStats.SplitBarriers++;
+                }
+                pass.Transitions.push_back(transition);
+                layouts[index] = access.Layout;
+            } else if (access.Layout == ResourceLayout::Storage && storageWritten[index]) {
+                pass.UAVs.push_back(index);
+            }
+            storageWritten[index] = access.Write && access.Layout == ResourceLayout::Storage;
+            lastUser[index] = i;
+        }
+        mStats.Transitions += pass.Transitions.size();
+    }
+    for (UInt32 i = 0; i < mTextures.size(); i++) {
+        TextureNode& texture = mTextures[i];
+        if (texture.Imported && texture.Restore && layouts[i] != texture.Layout) {
+            Transition transition = { i, layouts[i], texture.Layout };
+            if (split(lastUser[i], mPasses.size())) {
+                transition.Split = true;
+                mPasses[lastUser[i]].SplitBegins.push_back(transition);
+                mStats.SplitBarriers++;
+            }
+            mExitTransitions.push_back(transition);
+        }
+    }
+    mStats.Transitions += mExitTransitions.size();
+
+    Allocate(size);
+
+    for (auto& pass : mPasses) {
+        if (!pass.Aliases.empty() || !pass.Transitions.empty() || !pass.UAVs.empty()) {
+            mStats.BarrierBatches++;
+        }
+    }
+    if (!mExitTransitions.empty()) {
+        mStats.BarrierBatches++;
+    }
+}
+
+void RenderGraph::Allocate(const SizeFunction& size)
+{
+    struct Block
+    {
+        UInt64 Offset;
+        UInt64 Size;
+        UInt32 First;
+        UInt32 Owner;
+    };
+    Vector<Vector<Block>> blocks;
+
+    // First use order, so a block can be handed over as soon as its owner is done with it
+    Vector<UInt32> order;
+    for (UInt32 i = 0; i < mTextures.size(); i++) {
+        if (!mTextures[i].Imported && mTextures[i].FirstPass != -1) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](UInt32 a, UInt32 b) {
+        return mTextures[a].FirstPass < mTextures[b].FirstPass;
+    });
+
+    for (UInt32 index : order) {
+        TextureNode& texture = mTextures[index];
+        if (size) {
+            size(texture.Desc, texture.Size, texture.Alignment);
+        } else {
+            EstimateSize(texture.Desc, texture.Size, texture.Alignment);
+        }
+
+        HeapUsage usage = IsTarget(texture.Desc) ? HeapUsage::RenderTargets : HeapUsage::Textures;
+        Int32 heapIndex = -1;
+        for (Int32 i = 0; i < mHeaps.size(); i++) {
+            if (mHeaps[i].Usage == usage) {
+                heapIndex = i;
+            }
+        }
+        if (heapIndex == -1) {
+            mHeaps.push_back({ usage });
+            blocks.push_back({});
+            heapIndex = mHeaps.size() - 1;
+        }
+
+        // Best fit among the blocks whose owner is already dead
+        Block* best = nullptr;
+        for (auto& block : blocks[heapIndex]) {
+            if (mTextures[block.Owner].LastPass >= texture.FirstPass) {
+                continue;
+            }
+            if (block.Size < texture.Size || block.Offset % texture.Alignment) {
+                continue;
+            }
+            if (!best || block.Size < best->Size) {
+                best = &block;
+            }
+        }
+
+        HeapNode& heap = mHeaps[heapIndex];
+        texture.HeapIndex = heapIndex;
+        if (best) {
+            texture.Offset = best->Offset;
+            texture.AliasedFrom = best->Owner;
+            best->Owner = index;
+        } else {
+            texture.Offset = (heap.Size + texture.Alignment - 1) / texture.Alignment * texture.Alignment;
+            heap.Size = texture.Offset + texture.Size;
+            blocks[heapIndex].push_back({ texture.Offset, texture.Size, index, index });
+        }
+
+        mStats.TransientTextures++;
+        mStats.TransientBytes += texture.Size;
+    }
+
+    // Next frame, the first owner of a shared block takes it back from the last one
+    for (auto& heapBlocks : blocks) {
+        for (auto& block : heapBlocks) {
+            if (block.First != block.Owner) {
+                mTextures[block.First].AliasedFrom = block.Owner;
+            }
+        }
+    }
+    for (auto& heap : mHeaps) {
+        mStats.HeapBytes += heap.Size;
+    }
+
+    for (UInt32 index : order) {
+        TextureNode& texture = mTextures[index];
+        PassNode& pass = mPasses[texture.FirstPass];
+        if (texture.AliasedFrom != -1) {
+            pass.Aliases.push_back(index);
+            mStats.AliasedTextures++;
+        }
+
+        // Placed targets start out undefined every frame, they need a clear, copy or discard before anything else.
+        // Passes that clear on their own get a discard too, it's free.
+        for (auto& access : pass.Accesses) {
+            if (access.TextureIndex != index || !access.Write || !IsTarget(texture.Desc)) {
+                continue;
+            }
+            if (access.Layout == ResourceLayout::ColorWrite || access.Layout == ResourceLayout::DepthWrite || access.Layout == ResourceLayout::Storage) {
+                pass.Discards.push_back(index);
+            }
+        }
+    }
+}
+
+void RenderGraph::Realize(RHI::Ref rhi)
+{
+    for (auto& heap : mHeaps) {
+        heap.Memory = heap.Size ? rhi->CreateHeap(heap.Size, heap.Usage, "Render Graph Heap") : nullptr;
+    }
+    for (auto& texture : mTextures) {
+        if (texture.Imported) {
+            continue;
+        }
+        texture.Texture = texture.HeapIndex != -1 ? rhi->CreatePlacedTexture(texture.Desc, mHeaps[texture.HeapIndex].Memory, texture.Offset) : nullptr;
+    }
+}
+
+void RenderGraph::Execute(const Frame& frame, Scene& scene)
+{
+    for (auto& pass : mPasses) {
+        if (pass.Culled) {
+            continue;
+        }
+        PROFILE_SCOPE(pass.ProfileName);
+        frame.CommandBuffer->BeginMarker(pass.Name);
+
+        BarrierGroup group;
+        for (UInt32 index : pass.Aliases) {
+            TextureNode& texture = mTextures[index];
+            group.Aliases.push_back({ mTextures[texture.AliasedFrom].Texture, texture.Texture });
+        }
+        for (auto& transition : pass.Transitions) {
+            ASSERT(mTextures[transition.TextureIndex].Texture != nullptr, "Render graph texture was never bound!");
+            group.Transitions.push_back({ mTextures[transition.TextureIndex].Texture, transition.After });
+        }
+        for (UInt32 index : pass.UAVs) {
+            group.UAVs.push_back(mTextures[index].Texture);
+        }
+        frame.CommandBuffer->Barrier(group);
+
+        for (UInt32 index : pass.Discards) {
+            frame.CommandBuffer->Discard(mTextures[index].Texture);
+        }
+
+        pass.Execute(frame, scene);
+
+        for (auto& transition : pass.SplitBegins) {
+            frame.CommandBuffer->BeginBarrier(mTextures[transition.TextureIndex].Texture, transition.After);
+        }
+        frame.CommandBuffer->EndMarker();
+    }
+
+    BarrierGroup exit;
+    for (auto& transition : mExitTransitions) {
+        exit.Transitions.push_back({ mTextures[transition.TextureIndex].Texture, transition.After });
+    }
+    frame.CommandBuffer->Barrier(exit);
+}
+
+String RenderGraph::Dump() const
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+
+    ss << "Render Graph: " << mStats.Passes << " passes (" << mStats.CulledPasses << " culled), "
+       << mStats.Transitions << " transitions in " << mStats.BarrierBatches << " batches, " << mStats.SplitBarriers << " split\n";
+    for (UInt32 i = 0; i < mPasses.size(); i++) {
+        const PassNode& pass = mPasses[i];
+        ss << "  [" << i << "] " << pass.Name << (pass.Culled ? " (culled)" : "") << "\n";
+        if (pass.Culled) {
+            continue;
+        }
+        for (UInt32 index : pass.Aliases) {
+            ss << "        alias   " << mTextures[mTextures[index].AliasedFrom].Name << " -> " << mTextures[index].Name << "\n";
+        }
+        for (auto& transition : pass.Transitions) {
+            ss << (transition.Split ? "        end     " : "        barrier ") << mTextures[transition.TextureIndex].Name << ": " << LayoutToString(transition.Before) << " -> " << LayoutToString(transition.After) << "\n";
+        }
+        for (UInt32 index : pass.UAVs) {
+            ss << "        uav     " << mTextures[index].Name << "\n";
+        }
+        for (UInt32 index : pass.Discards) {
+            ss << "        discard " << mTextures[index].Name << "\n";
+        }
+        for (auto& transition : pass.SplitBegins) {
+            ss << "        begin   " << mTextures[transition.TextureIndex].Name << ": " << LayoutToString(transition.Before) << " -> " << LayoutToString(transition.After) << " (after the pass)\n";
+        }
+    }
+    if (!mExitTransitions.empty()) {
+        ss << "  [exit]\n";
+        for (auto& transition : mExitTransitions) {
+            ss << (transition.Split ? "        end     " : "        barrier ") << mTextures[transition.TextureIndex].Name << ": " << LayoutToString(transition.Before) << " -> " << LayoutToString(transition.After) << "\n";
+        }
+    }
+
+    float requested = mStats.TransientBytes / 1024.0f / 1024.0f;
+    float allocated = mStats.HeapBytes / 1024.0f / 1024.0f;
+    ss << "Transient memory: " << mStats.TransientTextures << " textures, " << mStats.AliasedTextures << " aliased, "
+       << requested << " MB requested, " << allocated << " MB in " << mHeaps.size() << " heap(s), "
+       << (requested - allocated) << " MB saved\n";
+    for (auto& texture : mTextures) {
+        if (texture.HeapIndex == -1) {
+            continue;
+        }
+        ss << "  " << texture.Name << ": heap " << texture.HeapIndex << " @ " << (texture.Offset / 1024) << " KB, "
+           << (texture.Size / 1024.0f / 1024.0f) << " MB, passes " << texture.FirstPass << ".." << texture.LastPass << "\n";
+    }
+    return ss.str();
+}
+
+Texture::Ref RenderGraph::GetTexture(const String& name)
+{
+    auto it = mTextureLookup.find(name);
+    if (it == mTextureLookup.end()) {
+        return nullptr;
+    }
+    return mTextures[it->second].Texture;
+}
+
+void RenderGraph::EstimateSize(const TextureDesc& desc, UInt64& size, UInt64& alignment)
+{
+    // Bits per pixel, block compressed formats included
+    UInt64 bits = 32;
+    switch (desc.Format) {
+        case TextureFormat::RGBA16Float: bits = 64; break;
+        case TextureFormat::RGBA32Float: bits = 128; break;
+        case TextureFormat::RG8: bits = 16; break;
+        case TextureFormat::R8: bits = 8; break;
+        case TextureFormat::BC4: bits = 4; break;
+        case TextureFormat::BC5: bits = 8; break;
+        case TextureFormat::BC7: bits = 8; break;
+        default: break;
+    }
+
+    size = 0;
+    for (UInt32 mip = 0; mip < std::max(desc.Levels, 1u); mip++) {
+        UInt64 width = std::max(desc.Width >> mip, 1u);
+        UInt64 height = std::max(desc.Height >> mip, 1u);
+        size += width * height * std::max(desc.Depth, 1u) * bits / 8;
+    }
+    alignment = PLACEMENT_ALIGNMENT;
+    size = (size + alignment - 1) / alignment * alignment;
+}
+
+bool RenderGraph::SelfTest()
+{
+    Checks check("RenderGraph");
+
+    auto make = [](UInt32 extent, TextureFormat format, TextureUsage usage) {
+        return TextureDesc{ "", extent, extent, 1, 1, format, usage };
+    };
+    // Four bytes a pixel, so the sizes below are easy to follow
+    auto allocation = [](const TextureDesc& desc, UInt64& size, UInt64& alignment) {
+        alignment = PLACEMENT_ALIGNMENT;
+        size = (UInt64(desc.Width) * desc.Height * 4 + alignment - 1) / alignment * alignment;
+    };
+
+    // GBuffer -> Dead (nobody reads it) -> Lighting -> Blur -> Bloom -> Composite into the backbuffer
+    RenderGraph graph;
+    graph.Import("Backbuffer", make(256, TextureFormat::RGBA8, TextureUsage::RenderTarget), nullptr, ResourceLayout::Common);
+    graph.CreateTransient("GBuffer", make(256, TextureFormat::RGBA8, TextureUsage::RenderTarget | TextureUsage::ShaderResource));
+    graph.CreateTransient("Depth", make(512, TextureFormat::Depth32, TextureUsage::DepthTarget | TextureUsage::ShaderResource));
+    graph.CreateTransient("Unused", make(256, TextureFormat::RGBA8, TextureUsage::RenderTarget));
+    graph.CreateTransient("Lit", make(256, TextureFormat::RGBA16Float, TextureUsage::Storage | TextureUsage::ShaderResource));
+    graph.CreateTransient("Bloom", make(256, TextureFormat::RGBA8, TextureUsage::RenderTarget | TextureUsage::ShaderResource));
+
+    auto none = [](const Frame&, Scene&) {};
+    graph.AddPass("GBuffer", [](Builder& builder) {
+        builder.Write("GBuffer", ResourceLayout::ColorWrite);
+        builder.Write("Depth", ResourceLayout::DepthWrite);
+    }, none);
+    graph.AddPass("Dead", [](Builder& builder) {
+        builder.Write("Unused", ResourceLayout::ColorWrite);
+    }, none);
+    graph.AddPass("Lighting", [](Builder& builder) {
+        builder.Read("GBuffer");
+        builder.Read("Depth", ResourceLayout::DepthRead);
+        builder.Write("Lit", ResourceLayout::Storage);
+    }, none);
+    graph.AddPass("Blur", [](Builder& builder) {
+        builder.Read("Lit", ResourceLayout::Storage);
+        builder.Write("Lit", ResourceLayout::Storage);
+    }, none);
+    graph.AddPass("Bloom", [](Builder& builder) {
+        builder.Write("Bloom", ResourceLayout::ColorWrite);
+    }, none);
+    graph.AddPass("Composite", [](Builder& builder) {
+        builder.Read("Lit");
+        builder.Read("Bloom");
+        builder.Write("Backbuffer", ResourceLayout::ColorWrite);
+    }, none);
+
+    auto hasTransition = [&](UInt32 pass, const String& name, ResourceLayout before, ResourceLayout after, bool split) {
+        for (auto& transition : graph.mPasses[pass].Transitions) {
+            if (graph.mTextures[transition.TextureIndex].Name == name) {
+                return transition.Before == before && transition.After == after && transition.Split == split;
+            }
+        }
+        return false;
+    };
+    auto index = [&](const String& name) {
+        return graph.mTextureLookup[name];
+    };
+
+    // Culling, only passes that lead to the backbuffer are left
+    graph.Compile(false, allocation);
+    check(graph.GetStats().Passes == 6 && graph.GetStats().CulledPasses == 0, "nothing is culled when culling is off");
+    graph.Compile(true, allocation);
+    Stats stats = graph.GetStats();
+    check(graph.mPasses[1].Culled && stats.Passes == 5 && stats.CulledPasses == 1, "the pass nobody reads from is culled");
+    check(graph.mTextures[index("Unused")].HeapIndex == -1, "textures of culled passes get no memory");
+
+    // Transients start the frame in the layout the previous frame left them in
+    check(graph.mPasses[0].Transitions.size() == 2, "two transitions before the GBuffer pass");
+    check(hasTransition(0, "GBuffer", ResourceLayout::Shader, ResourceLayout::ColorWrite, false), "GBuffer goes back to a render target");
+    check(hasTransition(0, "Depth", ResourceLayout::DepthRead, ResourceLayout::DepthWrite, false), "depth goes back to writable");
+    check(hasTransition(2, "GBuffer", ResourceLayout::ColorWrite, ResourceLayout::Shader, false), "the culled pass in between doesn't split the GBuffer transition");
+    check(hasTransition(2, "Lit", ResourceLayout::Shader, ResourceLayout::Storage, false), "lighting output goes to storage");
+    check(graph.mPasses[3].Transitions.empty(), "the blur needs no transition");
+    check(hasTransition(5, "Bloom", ResourceLayout::ColorWrite, ResourceLayout::Shader, false), "bloom is read right after it's written");
+    check(hasTransition(5, "Backbuffer", ResourceLayout::Common, ResourceLayout::ColorWrite, false), "the backbuffer starts where it was imported");
+    check(graph.mExitTransitions.size() == 1 && graph.mExitTransitions[0].After == ResourceLayout::Common, "the backbuffer is restored at the end");
+    check(stats.Transitions == 10, "ten transitions in total");
+
+    // UAV barriers, only between two storage accesses after a write
+    check(graph.mPasses[2].UAVs.empty(), "the first storage write needs no UAV barrier");
+    check(graph.mPasses[3].UAVs.size() == 1 && graph.mPasses[3].UAVs[0] == index("Lit"), "the blur waits for the lighting writes");
+
+    // Split barriers, begun after the last user when a pass sits between it and the next one
+    check(stats.SplitBarriers == 1, "one split barrier");
+    check(graph.mPasses[3].SplitBegins.size() == 1 && graph.mPasses[3].SplitBegins[0].TextureIndex == index("Lit") && graph.mPasses[3].SplitBegins[0].After == ResourceLayout::Shader,
+          "the Lit transition begins after the blur");
+    check(hasTransition(5, "Lit", ResourceLayout::Storage, ResourceLayout::Shader, true), "and ends before the composite");
+
+    // Aliasing, bloom takes the GBuffer memory once lighting is done with it
+    const TextureNode& gbuffer = graph.mTextures[index("GBuffer")];
+    const TextureNode& depth = graph.mTextures[index("Depth")];
+    const TextureNode& lit = graph.mTextures[index("Lit")];
+    const TextureNode& bloom = graph.mTextures[index("Bloom")];
+    check(gbuffer.HeapIndex == depth.HeapIndex && gbuffer.HeapIndex == bloom.HeapIndex && lit.HeapIndex != gbuffer.HeapIndex, "targets and storage textures go to separate heaps");
+    check(gbuffer.Offset == 0 && depth.Offset == 256 * 1024 && lit.Offset == 0, "first users are packed at aligned offsets");
+    check(bloom.AliasedFrom == index("GBuffer") && bloom.Offset == gbuffer.Offset, "bloom aliases the GBuffer, the best fit");
+    check(gbuffer.AliasedFrom == index("Bloom"), "the GBuffer takes its memory back next frame");
+    check(graph.mPasses[4].Aliases.size() == 1 && graph.mPasses[4].Aliases[0] == index("Bloom"), "the aliasing barrier goes before the bloom pass");
+    check(stats.AliasedTextures == 2 && stats.TransientTextures == 4, "four transients, two of them aliased");
+    check(stats.TransientBytes == 1792 * 1024 && stats.HeapBytes == 1536 * 1024, "aliasing saves the bloom memory");
+
+    // Placed targets are discarded by their first writer
+    check(graph.mPasses[0].Discards.size() == 2 && graph.mPasses[4].Discards.size() == 1, "first writes of targets discard");
+    return check.Finish();
+}
@@ -0,0 +1,155 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 10:02:17
+//
+
+#pragma once
+
+#include <RHI/RHI.hpp>
+#include <World/Scene.hpp>
+
+#include <functional>
+
+// Passes declare which named textures they read and write, Compile() works out the rest: which passes can be skipped,
+// the transitions between them and where transient textures live in memory. Compile() never touches the GPU, so it can
+// run without a device. Realize() creates the memory and Execute() records the frame.
+class RenderGraph
+{
+public:
+    using Ref = ::Ref<RenderGraph>;
+    using ExecuteFunction = std::function<void(const Frame& frame, Scene& scene)>;
+    using SizeFunction = std::function<void(const TextureDesc& desc, UInt64& size, UInt64& alignment)>;
+
+    struct Access
+    {
+        UInt32 TextureIndex;
+        ResourceLayout Layout;
+        bool Write;
+    };
+
+    struct Transition
+    {
+        UInt32 TextureIndex;
+        ResourceLayout Before;
+        ResourceLayout After;
+        // Started early with a split barrier, this only ends it
+        bool Split = false;
+    };
+
+    struct TextureNode
+    {
+        String Name;
+        TextureDesc Desc;
+        ::Texture::Ref Texture = nullptr;
+
+        // Imported textures live outside the graph. With Restore they go back to Layout once the graph is done with them,
+        // otherwise Layout is only what they're in when the frame starts.
+        bool Imported = false;
+        bool Restore = true;
+        ResourceLayout Layout = ResourceLayout::Common;
+
+        // Filled by Compile()
+        Int32 FirstPass = -1;
+        Int32 LastPass = -1;
+        UInt64 Size = 0;
+        UInt64 Alignment = 0;
+        Int32 HeapIndex = -1;
+        UInt64 Offset = 0;
+        Int32 AliasedFrom = -1;
+    };
+
+    struct PassNode
+    {
+        String Name;
+        const char* ProfileName;
+        Vector<Access> Accesses;
+        bool SideEffect = false;
+        ExecuteFunction Execute;
+
+        // Filled by Compile(), everything here goes out as one barrier batch before the pass
+        bool Culled = false;
+        Vector<UInt32> Aliases;
+        Vector<Transition> Transitions;
+        Vector<UInt32> UAVs;
+        Vector<UInt32> Discards;
+        // Begun right after the pass runs, when the next user of the texture is more than one pass away
+        Vector<Transition> SplitBegins;
+    };
+
+    struct HeapNode
+    {
+        HeapUsage Usage;
+        UInt64 Size = 0;
+        Heap::Ref Memory = nullptr;
+    };
+
+    struct Stats
+    {
+        UInt32 Passes = 0;
+        UInt32 CulledPasses = 0;
+        UInt32 Transitions = 0;
+        UInt32 BarrierBatches = 0;
+        UInt32 SplitBarriers = 0;
+        UInt32 TransientTextures = 0;
+        UInt32 AliasedTextures = 0;
+        // What the transients would take as committed resources, and what the shared heaps actually take
+        UInt64 TransientBytes = 0;
+        UInt64 HeapBytes = 0;
+    };
+
+    class Builder
+    {
+    public:
+        Builder(RenderGraph* graph, UInt32 pass)
+            : mGraph(graph), mPass(pass) {}
+
+        void Read(const String& name, ResourceLayout layout = ResourceLayout::Shader);
+        void Write(const String& name, ResourceLayout layout);
+        // Keep the pass even if nothing reads what it writes
+        void SideEffect();
+    private:
+        void Add(const String& name, ResourceLayout layout, bool write);
+
+        RenderGraph* mGraph;
+        UInt32 mPass;
+    };
+
+    RenderGraph() = default;
+    ~RenderGraph() = default;
+
+    void Reset();
+
+    void Import(const String& name, const TextureDesc& desc, Texture::Ref texture, ResourceLayout layout, bool restore = true);
+    void CreateTransient(const String& name, const TextureDesc& desc);
+    // For imported textures that change every frame, like the backbuffer
+    void Bind(const String& name, Texture::Ref texture);
+
+    void AddPass(const String& name, const std::function<void(Builder& builder)>& setup, const ExecuteFunction& execute);
+
+    // Without a size function, transient sizes are estimated from their format
+    void Compile(bool cull = true, const SizeFunction& size = nullptr);
+    void Realize(RHI::Ref rhi);
+    void Execute(const Frame& frame, Scene& scene);
+
+    String Dump() const;
+    Stats GetStats() const { return mStats; }
+
+    Texture::Ref GetTexture(const String& name);
+    const Vector<TextureNode>& GetTextures() const { return mTextures; }
+    const Vector<PassNode>& GetPasses() const { return mPasses; }
+
+    static void EstimateSize(const TextureDesc& desc, UInt64& size, UInt64& alignment);
+
+    // Culling, transitions, UAV and split barriers and aliasing of a small graph against known results, without a device
+    static bool SelfTest();
+private:
+    UInt32 AddTexture(const String& name, const TextureDesc& desc);
+    void Allocate(const SizeFunction& size);
+
+    Vector<TextureNode> mTextures;
+    Vector<PassNode> mPasses;
+    Vector<HeapNode> mHeaps;
+    Vector<Transition> mExitTransitions;
+    UnorderedMap<String, UInt32> mTextureLookup;
+    Stats mStats;
+};
@@ -5,7 +5,50 @@
 
 #include <Renderer/RenderPass.hpp>
 
+#include <Core/Jobs.hpp>
+#include <Core/Timer.hpp>
+#include <Core/Profiler.hpp>
+#include <Settings.hpp>
+
+#include <algorithm>
+
 RenderPass::RenderPass(RHI::Ref rhi)
     : mRHI(rhi)
 {
 }
+
+void RenderPass::RecordParallel(const Frame& frame, const String& name, UInt32 count, const RecordFunction& record)
+{
+    Timer timer;
+
+    UInt32 threads = std::min({ (UInt32)std::max(Settings::Get().RecordingThreads, 1), Jobs::GetThreadCount(), count });
+    mRecordThreads = std::max(threads, 1u);
+    if (threads <= 1) {
+        frame.CommandBuffer->BeginMarker(name);
+        record(frame, 0, count);
+        frame.CommandBuffer->EndMarker();
+        mRecordTime = timer.GetElapsed();
+        return;
+    }
+
+    Vector<CommandBuffer::Ref> buffers = frame.CommandBuffer->Fork(threads);
+    Jobs::Counter counter;
+    const char* zone = Profiler::Intern("Record " + name);
+    for (UInt32 i = 0; i < threads; i++) {
+        Jobs::Kick([&, i]() {
+            PROFILE_SCOPE(zone);
+            Frame worker = frame;
+            worker.CommandBuffer = buffers[i];
+
+            UInt32 begin = count * i / threads;
+            UInt32 end = count * (i + 1) / threads;
+            worker.CommandBuffer->BeginMarker(name + " " + std::to_string(i));
+            record(worker, begin, end);
+            worker.CommandBuffer->EndMarker();
+        }, &counter);
+    }
+    Jobs::Wait(&counter);
+    frame.CommandBuffer->Join();
+
+    mRecordTime = timer.GetElapsed();
+}
@@ -8,18 +8,32 @@
 #include <RHI/RHI.hpp>
 #include <World/Scene.hpp>
 #include <Renderer/PassManager.hpp>
+#include <Renderer/RenderGraph.hpp>
 
 class RenderPass
 {
 public:
-    using Ref = Ref<RenderPass>;
+    using Ref = ::Ref<RenderPass>;
 
     RenderPass(RHI::Ref rhi);
     ~RenderPass() = default;
 
+    // Adds the pass' nodes to the graph, with the textures they read and write
+    virtual void Declare(RenderGraph& graph) = 0;
     virtual void Bake(Scene& scene) = 0;
     virtual void Render(const Frame& frame, Scene& scene) = 0;
     virtual void UI(const Frame& frame) = 0;
 protected:
+    using RecordFunction = std::function<void(const Frame& frame, UInt32 begin, UInt32 end)>;
+
+    // Splits count items in contiguous ranges over the job system, each range recorded into its own command buffer under
+    // the given marker. They execute in order, between what the frame recorded before the call and what it records after.
+    // Every range starts with nothing bound. With a single thread it all goes into the frame's command buffer.
+    void RecordParallel(const Frame& frame, const String& name, UInt32 count, const RecordFunction& record);
+
     RHI::Ref mRHI;
+
+    // Last RecordParallel() call
+    float mRecordTime = 0.0f;
+    UInt32 mRecordThreads = 1;
 };
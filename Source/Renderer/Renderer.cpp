@@ -14,10 +14,15 @@
 #include <Renderer/Techniques/Composite.hpp>
 #include <Renderer/Techniques/Debug.hpp>
 
+#include <Core/Logger.hpp>
+#include <Core/Jobs.hpp>
 #include <Settings.hpp>
 #include <imgui.h>
 
+#include <algorithm>
+
 Renderer::Renderer(RHI::Ref rhi)
+    : mRHI(rhi)
 {
     mPasses = {
         MakeRef<Shadows>(rhi),
@@ -27,13 +32,63 @@ Renderer::Renderer(RHI::Ref rhi)
         MakeRef<Composite>(rhi),
         MakeRef<Debug>(rhi)
     };
+
+    mGraph = MakeRef<RenderGraph>();
+    BuildGraph();
 }
 
 Renderer::~Renderer()
 {
+    mGraph.reset();
     mPasses.clear();
 }
 
+void Renderer::BuildGraph()
+{
+    mGraph->Reset();
+
+    // Render() binds it every frame. ImGui draws on top after the graph is done, so it doesn't get restored.
+    TextureDesc backbuffer = {};
+    backbuffer.Name = "Backbuffer";
+    mGraph->Import("Backbuffer", backbuffer, nullptr, ResourceLayout::Present, false);
+
+    // Sorted so the graph, and the memory layout, is the same every run
+    Vector<String> names;
+    for (auto& [name, io] : PassManager::GetAll()) {
+        names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+
+    for (auto& name : names) {
+        ::Ref<RenderPassIO> io = PassManager::Get(name);
+        if (io->Transient) {
+            mGraph->CreateTransient(name, io->Desc);
+        } else if (io->Texture) {
+            // Sampled outside the graph too (UI, lights), so they go back to being readable
+            mGraph->Import(name, io->Desc, io->Texture, ResourceLayout::Shader);
+        }
+    }
+
+    for (auto& pass : mPasses) {
+        pass->Declare(*mGraph);
+    }
+
+    mGraph->Compile(Settings::Get().CullUnusedPasses, [this](const TextureDesc& desc, UInt64& size, UInt64& alignment) {
+        mRHI->GetTextureAllocationInfo(desc, size, alignment);
+    });
+    mGraph->Realize(mRHI);
+    for (auto& texture : mGraph->GetTextures()) {
+        if (!texture.Imported) {
+            PassManager::Bind(mRHI, texture.Name, texture.Texture);
+        }
+    }
+
+    RenderGraph::Stats stats = mGraph->GetStats();
+    LOG_INFO("[Render Graph] {0} passes ({1} culled), {2} transitions in {3} batches, {4} transient textures in {5:.2f} MB instead of {6:.2f} MB",
+             stats.Passes, stats.CulledPasses, stats.Transitions, stats.BarrierBatches, stats.TransientTextures,
+             stats.HeapBytes / 1024.0f / 1024.0f, stats.TransientBytes / 1024.0f / 1024.0f);
+}
+
 void Renderer::Bake(Scene& scene)
 {
     for (auto& pass : mPasses) {
@@ -43,9 +98,15 @@ void Renderer::Bake(Scene& scene)
 
 void Renderer::Render(const Frame& frame, Scene& scene)
 {
-    for (auto& pass : mPasses) {
-        pass->Render(frame, scene);
+    // Nothing recorded this frame touches the graph's memory yet, and the GPU is done with the old one after the wait
+    if (mRebuildGraph) {
+        mRHI->Wait();
+        BuildGraph();
+        mRebuildGraph = false;
     }
+
+    mGraph->Bind("Backbuffer", frame.Backbuffer);
+    mGraph->Execute(frame, scene);
 }
 
 void Renderer::UI(const Frame& frame, bool *open)
@@ -54,9 +115,26 @@ void Renderer::UI(const Frame& frame, bool *open)
         ImGui::Begin("Renderer", open);
         if (ImGui::TreeNodeEx("Global Settings", ImGuiTreeNodeFlags_Framed)) {
             ImGui::Checkbox("Scene Use Sun", &Settings::Get().SceneUseSun);
+            ImGui::Checkbox("Baked Occlusion", &Settings::Get().BakedOcclusion);
             ImGui::Checkbox("Draw Scene OBB", &Settings::Get().DebugDrawSceneOOB);
             ImGui::Checkbox("Frustum Cull", &Settings::Get().FrustumCull);
             ImGui::Checkbox("Freeze Frustum", &Settings::Get().FreezeFrustum);
+            ImGui::SliderInt("Recording Threads", &Settings::Get().RecordingThreads, 1, Jobs::GetThreadCount());
+            ImGui::Checkbox("Pipeline Frames", &Settings::Get().PipelineFrames);
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNodeEx("Render Graph", ImGuiTreeNodeFlags_Framed)) {
+            RenderGraph::Stats stats = mGraph->GetStats();
+            if (ImGui::Checkbox("Cull Unused Passes", &Settings::Get().CullUnusedPasses)) {
+                mRebuildGraph = true;
+            }
+            ImGui::Text("Passes: %u (%u culled)", stats.Passes, stats.CulledPasses);
+            ImGui::Text("Transitions: %u in %u batches", stats.Transitions, stats.BarrierBatches);
+            ImGui::Text("Transient Textures: %u (%u aliased)", stats.TransientTextures, stats.AliasedTextures);
+            ImGui::Text("Transient Memory: %.2f MB (%.2f MB without aliasing)", stats.HeapBytes / 1024.0f / 1024.0f, stats.TransientBytes / 1024.0f / 1024.0f);
+            if (ImGui::Button("Dump to Log")) {
+                LOG_INFO("{0}", mGraph->Dump());
+            }
             ImGui::TreePop();
         }
         for (auto& pass : mPasses) {
@@ -10,7 +10,7 @@
 class Renderer
 {
 public:
-    using Ref = Ref<Renderer>;
+    using Ref = ::Ref<Renderer>;
 
     Renderer(RHI::Ref rhi);
     ~Renderer();
@@ -19,5 +19,11 @@ public:
     void Render(const Frame& frame, Scene& scene);
     void UI(const Frame& frame, bool *open);
 private:
+    void BuildGraph();
+
+    RHI::Ref mRHI;
     Vector<RenderPass::Ref> mPasses;
+
+    RenderGraph::Ref mGraph;
+    bool mRebuildGraph = false;
 };
@@ -0,0 +1,452 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:58:12
+//
+
+#include <Renderer/ShadowAtlas.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Checks.hpp>
+
+#include <algorithm>
+#include <random>
+
+ShadowAtlas::ShadowAtlas(UInt32 size, UInt32 minTile, UInt32 maxTile)
+    : mSize(size), mMinTile(minTile), mMaxTile(std::min(maxTile, size))
+{
+    // Level 0 is the whole atlas, the last one the smallest tile
+    mLevels = 1;
+    while ((mSize >> (mLevels - 1)) > mMinTile) {
+        mLevels++;
+    }
+
+    UInt32 count = 0;
+    mLevelOffsets.resize(mLevels);
+    for (UInt32 level = 0; level < mLevels; level++) {
+        mLevelOffsets[level] = count;
+        count += 1u << (level * 2);
+    }
+    mNodes.resize(count, NodeState::Free);
+    mFree.resize(mLevels);
+    mFree[0].insert(0);
+    UpdateStats();
+}
+
+void ShadowAtlas::Update(const Vector<Request>& requests, UInt32 maxResizes)
+{
+    mStats.Placed = 0;
+    mStats.Shrunk = 0;
+    mStats.Dropped = 0;
+    for (auto& [key, entry] : mEntries) {
+        entry.Placement.Fresh = false;
+    }
+
+    // Free the views nobody asked for
+    UnorderedMap<UInt64, UInt32> wanted;
+    for (UInt32 i = 0; i < requests.size(); i++) {
+        wanted[requests[i].Key] = i;
+    }
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if (!wanted.count(it->first)) {
+            Free(it->second.Node, it->second.Level);
+            it = mEntries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Wanted levels, then the least important views shrink one step at a time until the total area fits
+    Vector<UInt32> levels(requests.size());
+    UInt64 total = 0;
+    for (UInt32 i = 0; i < requests.size(); i++) {
+        levels[i] = GetLevel(requests[i].Size);
+
+        auto existing = mEntries.find(requests[i].Key);
+        if (existing != mEntries.end() && levels[i] > existing->second.Level && requests[i].Size * 5 > existing->second.Placement.Size * 2) {
+            levels[i] = existing->second.Level;
+        }
+        total += GetArea(levels[i]);
+    }
+
+    Vector<UInt32> order(requests.size());
+    for (UInt32 i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](UInt32 a, UInt32 b) {
+        if (requests[a].Importance != requests[b].Importance) {
+            return requests[a].Importance < requests[b].Importance;
+        }
+        return requests[a].Key < requests[b].Key;
+    });
+    while (total > GetArea(0)) {
+        bool shrunk = false;
+        for (UInt32 i : order) {
+            if (total <= GetArea(0)) {
+                break;
+            }
+            if (levels[i] < mLevels - 1) {
+                total -= GetArea(levels[i]) - GetArea(levels[i] + 1);
+                levels[i]++;
+                shrunk = true;
+            }
+        }
+        if (!shrunk) {
+            break;
+        }
+    }
+
+    // Views that already have a tile and want another size, the biggest changes first
+    Vector<UInt32> resizes;
+    Vector<UInt32> pending;
+    for (UInt32 i = 0; i < requests.size(); i++) {
+        auto existing = mEntries.find(requests[i].Key);
+        if (existing == mEntries.end()) {
+            pending.push_back(i);
+        } else if (existing->second.Level != levels[i]) {
+            resizes.push_back(i);
+        }
+    }
+    auto change = [&](UInt32 i) {
+        Int32 steps = Int32(levels[i]) - Int32(mEntries[requests[i].Key].Level);
+        return std::abs(steps) * requests[i].Importance;
+    };
+    std::stable_sort(resizes.begin(), resizes.end(), [&](UInt32 a, UInt32 b) {
+        return change(a) > change(b);
+    });
+    if (resizes.size() > maxResizes) {
+        resizes.resize(maxResizes);
+    }
+
+    auto place = [&](UInt32 i, Int32 node, UInt32 level) {
+        Entry entry = { (UInt32)node, level, GetTile(node, level) };
+        entry.Placement.Fresh = true;
+        mEntries[requests[i].Key] = entry;
+        mStats.Placed++;
+    };
+
+    // Shrinking frees room for the new views, growing only happens with what's left
+    for (UInt32 i : resizes) {
+        Entry& entry = mEntries[requests[i].Key];
+        if (levels[i] > entry.Level) {
+            Free(entry.Node, entry.Level);
+            place(i, Allocate(levels[i]), levels[i]);
+        }
+    }
+
+    // Biggest first so the small ones fill the gaps, anything that doesn't fit tries smaller tiles
+    std::stable_sort(pending.begin(), pending.end(), [&](UInt32 a, UInt32 b) {
+        if (levels[a] != levels[b]) {
+            return levels[a] < levels[b];
+        }
+        return requests[a].Importance > requests[b].Importance;
+    });
+    for (UInt32 i : pending) {
+        for (UInt32 level = levels[i]; level < mLevels; level++) {
+            Int32 node = Allocate(level);
+            if (node >= 0) {
+                place(i, node, level);
+                break;
+            }
+        }
+    }
+
+    // A view that can't grow keeps the tile it has
+    for (UInt32 i : resizes) {
+        Entry& entry = mEntries[requests[i].Key];
+        if (levels[i] < entry.Level) {
+            Int32 node = Allocate(levels[i]);
+            if (node >= 0) {
+                Free(entry.Node, entry.Level);
+                place(i, node, levels[i]);
+            }
+        }
+    }
+
+    for (const Request& request : requests) {
+        auto entry = mEntries.find(request.Key);
+        if (entry == mEntries.end()) {
+            mStats.Dropped++;
+        } else if (entry->second.Level > GetLevel(request.Size)) {
+            mStats.Shrunk++;
+        }
+    }
+    UpdateStats();
+}
+
+const ShadowAtlas::Tile* ShadowAtlas::Get(UInt64 key) const
+{
+    auto entry = mEntries.find(key);
+    if (entry == mEntries.end()) {
+        return nullptr;
+    }
+    return &entry->second.Placement;
+}
+
+UInt32 ShadowAtlas::GetLevel(UInt32 size) const
+{
+    size = std::clamp(size, mMinTile, mMaxTile);
+
+    UInt32 level = mLevels - 1;
+    while (level > 0 && (mSize >> level) < size) {
+        level--;
+    }
+    return level;
+}
+
+UInt32 ShadowAtlas::GetNode(UInt32 level, UInt32 x, UInt32 y) const
+{
+    return mLevelOffsets[level] + y * (1u << level) + x;
+}
+
+UInt64 ShadowAtlas::GetArea(UInt32 level) const
+{
+    return 1ull << ((mLevels - 1 - level) * 2);
+}
+
+ShadowAtlas::Tile ShadowAtlas::GetTile(UInt32 node, UInt32 level) const
+{
+    UInt32 index = node - mLevelOffsets[level];
+    UInt32 size = mSize >> level;
+    return { (index % (1u << level)) * size, (index / (1u << level)) * size, size, false };
+}
+
+Int32 ShadowAtlas::Allocate(UInt32 level)
+{
+    Int32 from = level;
+    while (from >= 0 && mFree[from].empty()) {
+        from--;
+    }
+    if (from < 0) {
+        return -1;
+    }
+
+    UInt32 node = *mFree[from].begin();
+    mFree[from].erase(mFree[from].begin());
+    for (UInt32 current = from; current < level; current++) {
+        UInt32 index = node - mLevelOffsets[current];
+        UInt32 x = (index % (1u << current)) * 2;
+        UInt32 y = (index / (1u << current)) * 2;
+
+        // Keep the top left child, the other three are free
+        mNodes[node] = NodeState::Split;
+        for (UInt32 child = 1; child < 4; child++) {
+            UInt32 sibling = GetNode(current + 1, x + (child & 1), y + (child >> 1));
+            mNodes[sibling] = NodeState::Free;
+            mFree[current + 1].insert(sibling);
+        }
+        node = GetNode(current + 1, x, y);
+    }
+    mNodes[node] = NodeState::Used;
+    return node;
+}
+
+void ShadowAtlas::Free(UInt32 node, UInt32 level)
+{
+    mNodes[node] = NodeState::Free;
+
+    // Merge back up while all four siblings are free
+    while (level > 0) {
+        UInt32 index = node - mLevelOffsets[level];
+        UInt32 x = (index % (1u << level)) & ~1u;
+        UInt32 y = (index / (1u << level)) & ~1u;
+
+        Array<UInt32, 4> siblings = {
+            GetNode(level, x, y),
+            GetNode(level, x + 1, y),
+            GetNode(level, x, y + 1),
+            GetNode(level, x + 1, y + 1)
+        };
+        bool merge = true;
+        for (UInt32 sibling : siblings) {
+            merge = merge && mNodes[sibling] == NodeState::Free;
+        }
+        if (!merge) {
+            break;
+        }
+
+        for (UInt32 sibling : siblings) {
+            mFree[level].erase(sibling);
+        }
+        level--;
+        node = GetNode(level, x / 2, y / 2);
+        mNodes[node] = NodeState::Free;
+    }
+    mFree[level].insert(node);
+}
+
+void ShadowAtlas::UpdateStats()
+{
+    UInt64 freeArea = 0;
+    UInt64 largest = 0;
+    for (UInt32 level = 0; level < mLevels; level++) {
+        freeArea += mFree[level].size() * GetArea(level);
+        if (!largest && !mFree[level].empty()) {
+            largest = GetArea(level);
+        }
+    }
+
+    mStats.Views = mEntries.size();
+    mStats.Usage = 1.0f - (float)freeArea / GetArea(0);
+    mStats.Fragmentation = freeArea ? 1.0f - (float)largest / freeArea : 0.0f;
+}
+
+bool ShadowAtlas::SelfTest()
+{
+    Checks check("ShadowAtlas");
+
+    // Every tile inside the atlas and on its own, checked on a grid of the smallest tiles
+    auto valid = [](const ShadowAtlas& atlas) {
+        UInt32 cells = atlas.mSize / atlas.mMinTile;
+        Vector<UInt8> grid(cells * cells, 0);
+        for (auto& [key, entry] : atlas.mEntries) {
+            const Tile& tile = entry.Placement;
+            if (tile.X + tile.Size > atlas.mSize || tile.Y + tile.Size > atlas.mSize) {
+                return false;
+            }
+            for (UInt32 y = tile.Y / atlas.mMinTile; y < (tile.Y + tile.Size) / atlas.mMinTile; y++) {
+                for (UInt32 x = tile.X / atlas.mMinTile; x < (tile.X + tile.Size) / atlas.mMinTile; x++) {
+                    if (grid[x + y * cells]++) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    };
+    auto snapshot = [](const ShadowAtlas& atlas) {
+        UnorderedMap<UInt64, Pair<UInt32, UInt32>> positions;
+        for (auto& [key, entry] : atlas.mEntries) {
+            positions[key] = { entry.Placement.X, entry.Placement.Y };
+        }
+        return positions;
+    };
+
+    // Everything fits at full size when the area does
+    {
+        ShadowAtlas atlas(4096, 64, 2048);
+        Vector<Request> requests;
+        UInt64 key = 0;
+        for (UInt32 size : { 2048u, 1024u, 1024u, 1024u, 512u, 512u, 512u, 512u, 256u, 256u, 128u, 64u, 64u, 2048u, 1024u }) {
+            requests.push_back({ key++, size, 1.0f });
+        }
+        atlas.Update(requests);
+        check(valid(atlas), "packed tiles overlap");
+        check(atlas.GetStats().Placed == requests.size() && atlas.GetStats().Shrunk == 0 && atlas.GetStats().Dropped == 0, "everything fits at full size");
+
+        // Same requests, nothing moves
+        auto before = snapshot(atlas);
+        atlas.Update(requests);
+        check(atlas.GetStats().Placed == 0 && snapshot(atlas) == before, "unchanged requests stay put");
+
+        // One view grows, it's the only one that moves
+        requests[8].Size = 512;
+        atlas.Update(requests);
+        auto after = snapshot(atlas);
+        UInt32 moved = 0;
+        for (auto& [view, position] : after) {
+            moved += before[view] != position;
+        }
+        check(atlas.GetStats().Placed == 1 && moved <= 1 && atlas.Get(8)->Size == 512 && atlas.Get(8)->Fresh, "only the resized view moves");
+
+        // A slightly smaller size isn't worth a move
+        requests[8].Size = 300;
+        atlas.Update(requests);
+        check(atlas.GetStats().Placed == 0 && atlas.Get(8)->Size == 512, "shrinking has hysteresis");
+
+        // Dropping views leaves the rest alone
+        before = snapshot(atlas);
+        requests.resize(6);
+        atlas.Update(requests);
+        after = snapshot(atlas);
+        bool kept = after.size() == 6;
+        for (auto& [view, position] : after) {
+            kept = kept && before[view] == position;
+        }
+        check(kept && atlas.GetStats().Placed == 0, "removing views keeps the others");
+
+        atlas.Update({});
+        check(atlas.GetStats().Usage == 0.0f && atlas.mFree[0].size() == 1, "freed atlas merges back into one tile");
+    }
+
+    // Four times the budget, everything still gets a tile and importance decides the sizes
+    {
+        ShadowAtlas atlas(4096, 64, 2048);
+        Vector<Request> requests;
+        for (UInt32 i = 0; i < 64; i++) {
+            requests.push_back({ i, 1024, (float)i });
+        }
+        atlas.Update(requests);
+        check(valid(atlas), "tiles overlap under budget pressure");
+        check(atlas.GetStats().Dropped == 0 && atlas.GetStats().Shrunk > 0, "budget shrinks instead of dropping");
+        check(atlas.Get(63)->Size >= atlas.Get(0)->Size, "important views keep more resolution");
+    }
+
+    // Churn: views come and go and change size, a few resizes per update
+    {
+        constexpr UInt32 UPDATES = 2000;
+        constexpr UInt32 MAX_RESIZES = 8;
+
+        ShadowAtlas atlas(4096, 64, 2048);
+        std::mt19937 generator(1234);
+        auto random = [&](UInt32 count) {
+            return std::uniform_int_distribution<UInt32>(0, count - 1)(generator);
+        };
+        auto randomSize = [&]() {
+            // Mostly small lights far away, a few big ones up close
+            static const UInt32 sizes[] = { 64, 64, 128, 128, 128, 256, 256, 512, 1024 };
+            return sizes[random(9)];
+        };
+
+        UnorderedMap<UInt64, Request> live;
+        UInt64 next = 0;
+        float usage = 0.0f;
+        float fragmentation = 0.0f;
+        float worst = 0.0f;
+        UInt64 placed = 0;
+        bool stable = true;
+        bool packed = true;
+        for (UInt32 update = 0; update < UPDATES; update++) {
+            UInt32 touched = 0;
+            for (UInt32 i = random(4); i > 0; i--) {
+                live[next] = { next, randomSize(), (float)random(100) };
+                next++;
+                touched++;
+            }
+            for (UInt32 i = random(3); i > 0 && !live.empty(); i--) {
+                auto it = live.begin();
+                std::advance(it, random(live.size()));
+                live.erase(it);
+            }
+            for (UInt32 i = random(3); i > 0 && !live.empty(); i--) {
+                auto it = live.begin();
+                std::advance(it, random(live.size()));
+                it->second.Size = randomSize();
+            }
+            while (live.size() > 96) {
+                live.erase(live.begin());
+            }
+
+            Vector<Request> requests;
+            for (auto& [key, request] : live) {
+                requests.push_back(request);
+            }
+            atlas.Update(requests, MAX_RESIZES);
+
+            packed = packed && valid(atlas);
+            stable = stable && atlas.GetStats().Placed <= touched + MAX_RESIZES;
+            usage += atlas.GetStats().Usage;
+            fragmentation += atlas.GetStats().Fragmentation;
+            worst = std::max(worst, atlas.GetStats().Fragmentation);
+            placed += atlas.GetStats().Placed;
+        }
+        check(packed, "tiles overlap under churn");
+        check(stable, "more views moved than were touched");
+
+        atlas.Update({});
+        check(atlas.mFree[0].size() == 1, "churned atlas merges back into one tile");
+
+        LOG_INFO("[ShadowAtlas] {0} updates of churn: {1}% used, {2}% fragmentation on average, {3}% at worst, {4} placements per update",
+                 UPDATES, usage / UPDATES * 100.0f, fragmentation / UPDATES * 100.0f, worst * 100.0f, (float)placed / UPDATES);
+    }
+
+    return check.Finish();
+}
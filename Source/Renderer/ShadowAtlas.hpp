@@ -0,0 +1,100 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:52:36
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+#include <set>
+
+// Packs square shadow views into one depth texture. It's a quadtree of power of two tiles handed out like a buddy allocator,
+// so a freed tile merges back with its siblings. Updates leave every view where it is unless its size has to change.
+// Pure CPU, the caller owns the texture.
+class ShadowAtlas
+{
+public:
+    struct Request
+    {
+        UInt64 Key;
+        // Wanted edge in texels, rounded up to a power of two between the smallest and largest tile
+        UInt32 Size;
+        // Who gets shrunk first when everything doesn't fit
+        float Importance;
+    };
+
+    struct Tile
+    {
+        UInt32 X;
+        UInt32 Y;
+        UInt32 Size;
+        // Placed by the last Update(), whatever was in there belongs to someone else
+        bool Fresh;
+    };
+
+    struct Stats
+    {
+        UInt32 Views = 0;
+        // Placed, moved or resized by the last Update()
+        UInt32 Placed = 0;
+        // Got less than they asked for because of the budget, or nothing at all
+        UInt32 Shrunk = 0;
+        UInt32 Dropped = 0;
+        // Used area over atlas area
+        float Usage = 0.0f;
+        // One minus the largest free tile over the free area
+        float Fragmentation = 0.0f;
+    };
+
+    ShadowAtlas(UInt32 size = 4096, UInt32 minTile = 64, UInt32 maxTile = 2048);
+
+    // Views missing from the requests are freed. At most maxResizes views that already have a tile change size, the rest
+    // wait for the next update. A view only shrinks once it wants less than 40% of its edge, so sizes don't flicker.
+    void Update(const Vector<Request>& requests, UInt32 maxResizes = UINT32_MAX);
+
+    // Null when the view didn't fit
+    const Tile* Get(UInt64 key) const;
+    const Stats& GetStats() const { return mStats; }
+    UInt32 GetSize() const { return mSize; }
+
+    // Overlaps, bounds, stability across updates, budget pressure and fragmentation under churn
+    static bool SelfTest();
+private:
+    struct Entry
+    {
+        UInt32 Node;
+        UInt32 Level;
+        Tile Placement;
+    };
+
+    enum class NodeState : UInt8
+    {
+        Free,
+        Used,
+        Split
+    };
+
+    UInt32 GetLevel(UInt32 size) const;
+    UInt32 GetNode(UInt32 level, UInt32 x, UInt32 y) const;
+    // In smallest tiles
+    UInt64 GetArea(UInt32 level) const;
+    Tile GetTile(UInt32 node, UInt32 level) const;
+    // Splits the smallest free tile that's big enough, -1 when there's none
+    Int32 Allocate(UInt32 level);
+    void Free(UInt32 node, UInt32 level);
+    void UpdateStats();
+
+    UInt32 mSize;
+    UInt32 mMinTile;
+    UInt32 mMaxTile;
+    UInt32 mLevels;
+
+    Vector<UInt32> mLevelOffsets;
+    Vector<NodeState> mNodes;
+    // Lowest index first, so tiles fill the atlas from the top left
+    Vector<std::set<UInt32>> mFree;
+
+    UnorderedMap<UInt64, Entry> mEntries;
+    Stats mStats;
+};
@@ -21,6 +21,16 @@ AutoExposure::AutoExposure(RHI::Ref rhi)
     }
 }
 
+void AutoExposure::Declare(RenderGraph& graph)
+{
+    // The histogram stays inside the pass and nothing consumes it yet, so this only runs with culling off
+    graph.AddPass("Auto Exposure", [](RenderGraph::Builder& builder) {
+        builder.Read("MainColorBuffer");
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
 void AutoExposure::Render(const Frame& frame, Scene& scene)
 {
     // Histogram pass
@@ -13,6 +13,7 @@ public:
     AutoExposure(RHI::Ref rhi);
     ~AutoExposure() = default;
 
+    void Declare(RenderGraph& graph) override;
     void Bake(Scene& scene) {}
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
@@ -60,6 +60,20 @@ BokehDOF::BokehDOF(RHI::Ref rhi)
     mLinearClampSampler = mRHI->CreateSampler(SamplerAddress::Clamp, SamplerFilter::Linear);
 }
 
+void BokehDOF::Declare(RenderGraph& graph)
+{
+    // The pass moves its intermediates between layouts on its own, the graph only gets them there and gives them memory
+    graph.AddPass("Bokeh DOF", [](RenderGraph::Builder& builder) {
+        builder.Read("GBufferDepth");
+        builder.Write("MainColorBuffer", ResourceLayout::Storage);
+        for (const char* name : { "COCTexture", "COCTextureX4", "DOFColorX4", "DOFMulFarColorX4", "DOFNearBlurX4", "DOFNearX4", "DOFFarX4" }) {
+            builder.Write(name, ResourceLayout::Storage);
+        }
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
 void BokehDOF::Render(const Frame& frame, Scene& scene)
 {
     if (!mEnable)
@@ -101,7 +115,7 @@ void BokehDOF::Render(const Frame& frame, Scene& scene)
             farBegin,
             farEnd,
 
-            glm::vec2(scene.Camera.Projection()[2][2], scene.Camera.Projection()[2][3]),
+            glm::vec2(scene.Current().Camera.Projection()[2][2], scene.Current().Camera.Projection()[2][3]),
             glm::vec2(0.0f)  
         };
 
@@ -13,6 +13,7 @@ public:
     BokehDOF(RHI::Ref rhi);
     ~BokehDOF() = default;
 
+    void Declare(RenderGraph& graph) override;
     void Bake(Scene& scene) {}
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
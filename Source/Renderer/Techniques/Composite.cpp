@@ -19,13 +19,36 @@ Composite::Composite(RHI::Ref rhi)
     mPipeline = mRHI->CreateComputePipeline(computeShader->Shader, mSignature);
 }
 
+void Composite::Declare(RenderGraph& graph)
+{
+    // Two nodes, OutputLDR is a UAV in the first and a copy source in the second
+    graph.AddPass("Tonemap", [](RenderGraph::Builder& builder) {
+        builder.Read("MainColorBuffer", ResourceLayout::Storage);
+        builder.Write("OutputLDR", ResourceLayout::Storage);
+    }, [this](const Frame& frame, Scene& scene) {
+        Tonemap(frame);
+    });
+    graph.AddPass("Copy to Backbuffer", [](RenderGraph::Builder& builder) {
+        builder.Read("OutputLDR", ResourceLayout::CopySource);
+        builder.Write("Backbuffer", ResourceLayout::CopyDest);
+    }, [this](const Frame& frame, Scene& scene) {
+        CopyToBackbuffer(frame);
+    });
+}
+
 void Composite::Render(const Frame& frame, Scene& scene)
+{
+    frame.CommandBuffer->BeginMarker("Composite");
+    Tonemap(frame);
+    CopyToBackbuffer(frame);
+    frame.CommandBuffer->EndMarker();
+}
+
+void Composite::Tonemap(const Frame& frame)
 {
     ::Ref<RenderPassIO> hdr = PassManager::Get("MainColorBuffer");
     ::Ref<RenderPassIO> ldr = PassManager::Get("OutputLDR");
 
-    frame.CommandBuffer->BeginMarker("Composite");
-    
     struct {
         int Input;
         int Output;
@@ -40,26 +63,19 @@ void Composite::Render(const Frame& frame, Scene& scene)
 
     // Tonemap color buffer
     frame.CommandBuffer->BeginMarker("Tonemap");
-    frame.CommandBuffer->Barrier(hdr->Texture, ResourceLayout::Storage);
-    frame.CommandBuffer->Barrier(ldr->Texture, ResourceLayout::Storage);
     frame.CommandBuffer->SetComputePipeline(mPipeline);
     frame.CommandBuffer->ComputePushConstants(&PushConstants, sizeof(PushConstants), 0);
     frame.CommandBuffer->Dispatch(hdr->Desc.Width / 8, hdr->Desc.Height / 8, 1);
-    frame.CommandBuffer->Barrier(hdr->Texture, ResourceLayout::Common);
-    frame.CommandBuffer->UAVBarrier(ldr->Texture);
     frame.CommandBuffer->EndMarker();
-    //
-    
+}
+
+void Composite::CopyToBackbuffer(const Frame& frame)
+{
+    ::Ref<RenderPassIO> ldr = PassManager::Get("OutputLDR");
+
     // Copy LDR to backbuffer
     frame.CommandBuffer->BeginMarker("Copy to Backbuffer");
-    frame.CommandBuffer->Barrier(ldr->Texture, ResourceLayout::CopySource);
-    frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::CopyDest);
     frame.CommandBuffer->CopyTextureToTexture(frame.Backbuffer, ldr->Texture);
-    frame.CommandBuffer->Barrier(ldr->Texture, ResourceLayout::Common);
-    frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::ColorWrite);
-    frame.CommandBuffer->EndMarker();
-    //
-
     frame.CommandBuffer->EndMarker();
 }
 
@@ -13,10 +13,14 @@ public:
     Composite(RHI::Ref rhi);
     ~Composite() = default;
 
+    void Declare(RenderGraph& graph) override;
     void Bake(Scene& scene) {}
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
 private:
+    void Tonemap(const Frame& frame);
+    void CopyToBackbuffer(const Frame& frame);
+
     ComputePipeline::Ref mPipeline;
     RootSignature::Ref mSignature;
 };
@@ -5,14 +5,43 @@
 
 #include <Renderer/Techniques/Debug.hpp>
 #include <Core/Math.hpp>
+#include <Core/Assert.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Profiler.hpp>
+#include <Core/Timer.hpp>
 #include <Settings.hpp>
 
 #include <imgui.h>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <chrono>
+#include <random>
 
 Debug::Data Debug::sData;
 
+static void AddUnitCube(Vector<glm::vec3>& vertices, float front)
+{
+    glm::vec3 corners[8] = {
+        glm::vec3(-1.0f,  1.0f, front),
+        glm::vec3( 1.0f,  1.0f, front),
+        glm::vec3( 1.0f, -1.0f, front),
+        glm::vec3(-1.0f, -1.0f, front),
+        glm::vec3(-1.0f,  1.0f, 1.0f),
+        glm::vec3( 1.0f,  1.0f, 1.0f),
+        glm::vec3( 1.0f, -1.0f, 1.0f),
+        glm::vec3(-1.0f, -1.0f, 1.0f),
+    };
+
+    for (int i = 0; i < 4; i++) {
+        vertices.push_back(corners[i]);
+        vertices.push_back(corners[(i + 1) % 4]);
+        vertices.push_back(corners[i]);
+        vertices.push_back(corners[i + 4]);
+        vertices.push_back(corners[i + 4]);
+        vertices.push_back(corners[(i + 1) % 4 + 4]);
+    }
+}
+
 Debug::Debug(RHI::Ref rhi)
     : RenderPass(rhi)
 {
@@ -27,69 +56,126 @@ Debug::Debug(RHI::Ref rhi)
     specs.Formats.push_back(TextureFormat::RGBA8);
     specs.Bytecodes[ShaderType::Vertex] = vertexShader->Shader;
     specs.Bytecodes[ShaderType::Fragment] = fragmentShader->Shader;
-    specs.Signature = mRHI->CreateRootSignature({ RootType::PushConstant }, sizeof(glm::mat4) * 2);
+    specs.Signature = mRHI->CreateRootSignature({ RootType::PushConstant }, sizeof(glm::mat4) * 2 + sizeof(int) * 4);
     
+    sData.Context = mRHI;
     sData.Pipeline = mRHI->CreateGraphicsPipeline(specs);
 
-    for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
-        sData.TransferBuffer[i] = mRHI->CreateBuffer(sizeof(LineVertex) * MAX_LINES, 0, BufferType::Constant, "Line Transfer Buffer");
-        sData.VertexBuffer[i] = mRHI->CreateBuffer(sizeof(LineVertex) * MAX_LINES, sizeof(LineVertex), BufferType::Vertex, "Line Vertex Buffer");
+    // The frustum is the NDC cube, boxes and spheres span -1 to 1
+    Vector<glm::vec3> vertices;
+    for (UInt32 shape = 0; shape < SHAPE_COUNT; shape++) {
+        sData.ShapeOffsets[shape] = vertices.size();
+        if (shape == SHAPE_BOX) {
+            AddUnitCube(vertices, -1.0f);
+        } else if (shape == SHAPE_FRUSTUM) {
+            AddUnitCube(vertices, 0.0f);
+        } else {
+            int level = shape - SHAPE_SPHERE;
+            for (int octant = 0; octant < 8; octant++) {
+                glm::vec3 x = glm::vec3(octant & 1 ? -1.0f : 1.0f, 0.0f, 0.0f);
+                glm::vec3 y = glm::vec3(0.0f, octant & 2 ? -1.0f : 1.0f, 0.0f);
+                glm::vec3 z = glm::vec3(0.0f, 0.0f, octant & 4 ? -1.0f : 1.0f);
+                BuildUnitSphere(vertices, x, y, z, level);
+            }
+        }
+        sData.ShapeSizes[shape] = vertices.size() - sData.ShapeOffsets[shape];
+    }
+    sData.ShapeVertices = mRHI->CreateBuffer(vertices.size() * sizeof(glm::vec3), sizeof(glm::vec3), BufferType::Constant, "Debug Shape Vertices");
+    sData.ShapeVertices->BuildSRV();
+    sData.ShapeVertices->CopyMapped(vertices.data(), vertices.size() * sizeof(glm::vec3));
+
+    InitStream(sData.Lines, "Debug Lines", sizeof(LineVertex), INITIAL_LINES * 2);
+    for (UInt32 shape = 0; shape < SHAPE_COUNT; shape++) {
+        InitStream(sData.Shapes[shape], "Debug Shapes", sizeof(ShapeInstance), INITIAL_SHAPES);
     }
 }
 
+void Debug::Declare(RenderGraph& graph)
+{
+    graph.AddPass("Debug", [](RenderGraph::Builder& builder) {
+        builder.Write("Backbuffer", ResourceLayout::ColorWrite);
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
 void Debug::Render(const Frame& frame, Scene& scene)
 {
-    ::Ref<RenderPassIO> cameraBuffer = PassManager::Get("CameraRingBuffer");
+    PROFILE_FUNCTION();
 
+    Timer timer;
     if (Settings::Get().DebugDraw) {
         if (Settings::Get().DebugDrawLights) {
-            for (PointLight light : scene.PointLights) {
+            for (PointLight light : scene.Current().PointLights) {
                 DrawRings(light.Position, light.Radius, light.Color, 16);
             }
-            DrawArrow(glm::vec3(0.0f), scene.Sun.Direction, scene.Sun.Color, 0.2f);
+            DrawArrow(glm::vec3(0.0f), scene.Current().Sun.Direction, scene.Current().Sun.Color, 0.2f);
         }
     }
 
-    if (!sData.Lines.empty()) {
-        if (Settings::Get().DebugDraw) {
-            mLineCount = sData.Lines.size();
+    UInt32 current = sData.Current;
+    mLineCount = 0;
+    mShapeCount = 0;
+    if (Settings::Get().DebugDraw) {
+        mLineCount = sData.Lines.Count / 2;
+        for (Stream& stream : sData.Shapes) {
+            mShapeCount += stream.Count;
+        }
+    }
 
-            Vector<LineVertex> vertices;
-            for (Line line : sData.Lines) {
-                vertices.push_back({ line.From, line.Color });
-                vertices.push_back({ line.To, line.Color });
+    if (mLineCount || mShapeCount) {
+        struct {
+            glm::mat4 Projection;
+            glm::mat4 View;
+            int Lines;
+            int Shapes;
+            int ShapeVertices;
+            int ShapeOffset;
+        } pushConstants = {
+            scene.Current().Camera.Projection(),
+            scene.Current().Camera.View(),
+            sData.Lines.Buffers[current]->SRV(),
+            -1,
+            sData.ShapeVertices->SRV(),
+            0
+        };
+
+        // Everything lives in upload memory, so there is nothing to copy or transition
+        frame.CommandBuffer->BeginMarker("Debug");
+        frame.CommandBuffer->SetRenderTargets({ frame.BackbufferView }, nullptr);
+        frame.CommandBuffer->SetViewport(0, 0, frame.Width, frame.Height);
+        frame.CommandBuffer->SetGraphicsPipeline(sData.Pipeline);
+        frame.CommandBuffer->SetTopology(Topology::LineList);
+        if (mLineCount) {
+            frame.CommandBuffer->GraphicsPushConstants(&pushConstants, sizeof(pushConstants), 0);
+            frame.CommandBuffer->Draw(sData.Lines.Count);
+        }
+        for (UInt32 shape = 0; shape < SHAPE_COUNT; shape++) {
+            Stream& stream = sData.Shapes[shape];
+            if (!stream.Count) {
+                continue;
             }
-    
-            sData.TransferBuffer[frame.FrameIndex]->CopyMapped(vertices.data(), vertices.size() * sizeof(LineVertex));
-    
-            glm::mat4 pushConstants[] = {
-                scene.Camera.Projection(),
-                scene.Camera.View()
-            };
-    
-            // Copy to the vertex buffer
-            frame.CommandBuffer->BeginMarker("Debug");
-            frame.CommandBuffer->Barrier(sData.TransferBuffer[frame.FrameIndex], ResourceLayout::CopySource);
-            frame.CommandBuffer->Barrier(sData.VertexBuffer[frame.FrameIndex], ResourceLayout::CopyDest);
-            frame.CommandBuffer->CopyBufferToBuffer(sData.VertexBuffer[frame.FrameIndex], sData.TransferBuffer[frame.FrameIndex]);
-            frame.CommandBuffer->Barrier(sData.VertexBuffer[frame.FrameIndex], ResourceLayout::Vertex);
-            frame.CommandBuffer->Barrier(sData.TransferBuffer[frame.FrameIndex], ResourceLayout::Common);
-        
-            // Render
-            frame.CommandBuffer->Barrier(frame.Backbuffer, ResourceLayout::ColorWrite);
-            frame.CommandBuffer->SetRenderTargets({ frame.BackbufferView }, nullptr);
-            frame.CommandBuffer->SetViewport(0, 0, frame.Width, frame.Height);
-            frame.CommandBuffer->SetGraphicsPipeline(sData.Pipeline);
-            frame.CommandBuffer->SetTopology(Topology::LineList);
-            frame.CommandBuffer->SetVertexBuffer(sData.VertexBuffer[frame.FrameIndex]);
-            frame.CommandBuffer->GraphicsPushConstants(pushConstants, sizeof(pushConstants), 0);
-            frame.CommandBuffer->Draw(vertices.size());
-            frame.CommandBuffer->EndMarker();
-        } else {
-            mLineCount = 0;
+            pushConstants.Shapes = stream.Buffers[current]->SRV();
+            pushConstants.ShapeOffset = sData.ShapeOffsets[shape];
+            frame.CommandBuffer->GraphicsPushConstants(&pushConstants, sizeof(pushConstants), 0);
+            frame.CommandBuffer->Draw(sData.ShapeSizes[shape], stream.Count);
+        }
+        frame.CommandBuffer->EndMarker();
+    }
+
+    // The next buffer was last read by the frame FRAMES_IN_FLIGHT ago, which Begin already waited on
+    sData.Current = (current + 1) % BUFFER_COUNT;
+    sData.Lines.Count = 0;
+    if (sData.Lines.Sizes[sData.Current] < sData.Lines.Capacity) {
+        ResizeStream(sData.Lines, sData.Current, 0);
+    }
+    for (Stream& stream : sData.Shapes) {
+        stream.Count = 0;
+        if (stream.Sizes[sData.Current] < stream.Capacity) {
+            ResizeStream(stream, sData.Current, 0);
         }
-        sData.Lines.clear();
     }
+    mRecordTime = timer.GetElapsed();
 }
 
 void Debug::UI(const Frame& frame)
@@ -98,30 +184,81 @@ void Debug::UI(const Frame& frame)
         ImGui::Checkbox("Enable", &Settings::Get().DebugDraw);
         ImGui::Checkbox("Draw Volumes", &Settings::Get().DebugDrawVolumes);
         ImGui::Checkbox("Draw Lights", &Settings::Get().DebugDrawLights);
-        if (Settings::Get().DebugDraw)
-            ImGui::Text("Line Count: %llu", mLineCount);
+        if (Settings::Get().DebugDraw) {
+            UInt64 capacity = sData.Lines.Capacity / 2;
+            ImGui::Text("Line Count: %llu (capacity %llu)", mLineCount, capacity);
+            ImGui::Text("Shape Count: %llu", mShapeCount);
+            ImGui::Text("Record Time: %.3f ms", mRecordTime);
+        }
         ImGui::TreePop();
     }
 }
 
+void Debug::InitStream(Stream& stream, const String& name, UInt32 stride, UInt32 capacity)
+{
+    stream.Name = name;
+    stream.Stride = stride;
+    stream.Capacity = capacity;
+    for (UInt32 i = 0; i < BUFFER_COUNT; i++) {
+        ResizeStream(stream, i, 0);
+    }
+}
+
+void Debug::ResizeStream(Stream& stream, UInt32 index, UInt32 keep)
+{
+    // Only ever called on the buffer being filled, no frame on the GPU reads it
+    Buffer::Ref buffer = sData.Context->CreateBuffer(UInt64(stream.Capacity) * stream.Stride, stream.Stride, BufferType::Constant, stream.Name);
+    buffer->BuildSRV();
+
+    void* mapped = nullptr;
+    buffer->Map(0, 0, &mapped);
+    if (keep) {
+        memcpy(mapped, stream.Mapped[index], UInt64(keep) * stream.Stride);
+    }
+
+    stream.Buffers[index] = buffer;
+    stream.Mapped[index] = reinterpret_cast<UInt8*>(mapped);
+    stream.Sizes[index] = stream.Capacity;
+}
+
+UInt8* Debug::Push(Stream& stream, UInt32 count)
+{
+    UInt32 current = sData.Current;
+    if (stream.Count + count > stream.Sizes[current]) {
+        stream.Capacity = glm::max(stream.Capacity * 2, stream.Count + count);
+        ResizeStream(stream, current, stream.Count);
+        LOG_INFO("[Debug] {0} grew to {1} elements", stream.Name, stream.Capacity);
+    }
+
+    UInt8* data = stream.Mapped[current] + UInt64(stream.Count) * stream.Stride;
+    stream.Count += count;
+    return data;
+}
+
+void Debug::DrawShape(UInt32 shape, const glm::mat4& transform, glm::vec3 color)
+{
+    ShapeInstance* instance = reinterpret_cast<ShapeInstance*>(Push(sData.Shapes[shape], 1));
+    instance->Transform = transform;
+    instance->Color = color;
+    instance->Pad = 0.0f;
+}
+
 void Debug::DrawLine(glm::vec3 from, glm::vec3 to, glm::vec3 color)
 {
-    sData.Lines.push_back(
-        { from, to, color }
-    );
+    LineVertex* vertices = reinterpret_cast<LineVertex*>(Push(sData.Lines, 2));
+    vertices[0] = { from, color };
+    vertices[1] = { to, color };
 }
 
 void Debug::DrawTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 color)
 {
-    sData.Lines.push_back(
-        { a, b, color }
-    );
-    sData.Lines.push_back(
-        { b, c, color }
-    );
-    sData.Lines.push_back(
-        { c, a, color }
-    );
+    LineVertex* vertices = reinterpret_cast<LineVertex*>(Push(sData.Lines, 6));
+    vertices[0] = { a, color };
+    vertices[1] = { b, color };
+    vertices[2] = { b, color };
+    vertices[3] = { c, color };
+    vertices[4] = { c, color };
+    vertices[5] = { a, color };
 }
 
 void Debug::DrawArrow(glm::vec3 from, glm::vec3 to, glm::vec3 color, float size)
@@ -148,29 +285,10 @@ void Debug::DrawUnitBox(glm::mat4 transform, glm::vec3 color)
 
 void Debug::DrawBox(glm::mat4 transform, glm::vec3 min, glm::vec3 max, glm::vec3 color)
 {
-    // Transform corners from local space to world space
-    glm::vec3 v1 = glm::vec3(transform * glm::vec4(min.x, min.y, min.z, 1.0));
-    glm::vec3 v2 = glm::vec3(transform * glm::vec4(min.x, min.y, max.z, 1.0));
-    glm::vec3 v3 = glm::vec3(transform * glm::vec4(min.x, max.y, min.z, 1.0));
-    glm::vec3 v4 = glm::vec3(transform * glm::vec4(min.x, max.y, max.z, 1.0));
-    glm::vec3 v5 = glm::vec3(transform * glm::vec4(max.x, min.y, min.z, 1.0));
-    glm::vec3 v6 = glm::vec3(transform * glm::vec4(max.x, min.y, max.z, 1.0));
-    glm::vec3 v7 = glm::vec3(transform * glm::vec4(max.x, max.y, min.z, 1.0));
-    glm::vec3 v8 = glm::vec3(transform * glm::vec4(max.x, max.y, max.z, 1.0));
-
-    // Draw 12 edges of the box
-    DrawLine(v1, v2, color); // Edge 1
-    DrawLine(v1, v3, color); // Edge 2
-    DrawLine(v1, v5, color); // Edge 3
-    DrawLine(v2, v4, color); // Edge 4
-    DrawLine(v2, v6, color); // Edge 5
-    DrawLine(v3, v4, color); // Edge 6
-    DrawLine(v3, v7, color); // Edge 7
-    DrawLine(v4, v8, color); // Edge 8
-    DrawLine(v5, v6, color); // Edge 9
-    DrawLine(v5, v7, color); // Edge 10
-    DrawLine(v6, v8, color); // Edge 11
-    DrawLine(v7, v8, color); // Edge 12
+    // Fit the unit cube to the box, the corners are transformed on the GPU
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    DrawShape(SHAPE_BOX, transform * glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), extent), color);
 }
 
 void Debug::DrawFrustum(glm::mat4 view, glm::mat4 projection, glm::vec3 color)
@@ -180,44 +298,13 @@ void Debug::DrawFrustum(glm::mat4 view, glm::mat4 projection, glm::vec3 color)
 
 void Debug::DrawFrustum(glm::mat4 projview, glm::vec3 color)
 {
-    glm::vec3 corners[8] = {
-        glm::vec3(-1.0f,  1.0f, 0.0f),
-        glm::vec3( 1.0f,  1.0f, 0.0f),
-        glm::vec3( 1.0f, -1.0f, 0.0f),
-        glm::vec3(-1.0f, -1.0f, 0.0f),
-        glm::vec3(-1.0f,  1.0f, 1.0f),
-        glm::vec3( 1.0f,  1.0f, 1.0f),
-        glm::vec3( 1.0f, -1.0f, 1.0f),
-        glm::vec3(-1.0f, -1.0f, 1.0f),
-    };
-
-    // To convert from world space to NDC space, multiply by the inverse of the camera matrix (projection * view) then perspective divide
-    // Not sure I 100% understand the math here, TODO: study
-    for (int i = 0; i < 8; i++) {
-        glm::vec4 v = glm::vec4(corners[i], 1.0);
-        glm::vec4 h = glm::inverse(projview) * v;
-        h.x /= h.w;
-        h.y /= h.w;
-        h.z /= h.w;
-        corners[i] = glm::vec3(h);
-    }
-
-    for (int i = 0; i < 4; i++) {
-        DrawLine(corners[i % 4],     corners[(i + 1) % 4],     color);
-        DrawLine(corners[i],         corners[i + 4],           color);
-        DrawLine(corners[i % 4 + 4], corners[(i + 1) % 4 + 4], color);
-    }
+    // The NDC cube taken back to world space, the shader does the perspective divide
+    DrawShape(SHAPE_FRUSTUM, glm::inverse(projview), color);
 }
 
 void Debug::DrawFrustum(Camera camera, glm::vec3 color)
 {
-    Vector<glm::vec4> corners = camera.Corners();
-
-    for (int i = 0; i < 4; i++) {
-        DrawLine(glm::vec3(corners[i % 4]),     glm::vec3(corners[(i + 1) % 4]),     color);
-        DrawLine(glm::vec3(corners[i]),         glm::vec3(corners[i + 4]),           color);
-        DrawLine(glm::vec3(corners[i % 4 + 4]), glm::vec3(corners[(i + 1) % 4 + 4]), color);
-    }
+    DrawFrustum(camera.Projection() * camera.View(), color);
 }
 
 void Debug::DrawCoordinateSystem(glm::mat4 transform, float size)
@@ -231,18 +318,7 @@ void Debug::DrawCoordinateSystem(glm::mat4 transform, float size)
 void Debug::DrawSphere(glm::vec3 center, float radius, glm::vec3 color, int level)
 {
     glm::mat4 matrix = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), glm::vec3(radius));
-    glm::vec3 xAxis = glm::vec3(1.0f, 0.0f, 0.0f);
-    glm::vec3 yAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-    glm::vec3 zAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-
-    DrawWireUnitSphereRecursive(matrix, color,  xAxis,  yAxis,  zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color, -xAxis,  yAxis,  zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color,  xAxis, -yAxis,  zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color, -xAxis, -yAxis,  zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color,  xAxis,  yAxis, -zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color, -xAxis,  yAxis, -zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color,  xAxis, -yAxis, -zAxis, level);
-	DrawWireUnitSphereRecursive(matrix, color, -xAxis, -yAxis, -zAxis, level);
+    DrawShape(SHAPE_SPHERE + glm::clamp(level, 0, int(SPHERE_LEVELS) - 1), matrix, color);
 }
 
 void Debug::DrawRing(glm::vec3 center, glm::vec3 normal, float radius, glm::vec3 color, int level)
@@ -263,7 +339,7 @@ void Debug::DrawRing(glm::vec3 center, glm::vec3 normal, float radius, glm::vec3
 
     for (int i = 1; i <= numSegments; ++i) {
         float angle = i * angleStep;
-        glm::vec3 nextPoint = center + radius * (cos(angle) * tangent + sin(angle) * bitangent);
+        glm::vec3 nextPoint = center + radius * (glm::cos(angle) * tangent + glm::sin(angle) * bitangent);
 
         Debug::DrawLine(prevPoint, nextPoint, color);
 
@@ -278,24 +354,84 @@ void Debug::DrawRings(glm::vec3 center, float radius, glm::vec3 color, int level
     DrawRing(center, glm::vec3(0.0f, 0.0f, 1.0f), radius, color, level);
 }
 
-void Debug::DrawWireUnitSphereRecursive(glm::mat4 matrix, glm::vec3 inColor, glm::vec3 inDir1, glm::vec3 inDir2, glm::vec3 inDir3, int inLevel)
+void Debug::Benchmark()
 {
-    if (inLevel == 0) {
-		glm::vec3 d1 = matrix * glm::vec4(inDir1, 1.0f);
-		glm::vec3 d2 = matrix * glm::vec4(inDir2, 1.0f);
-		glm::vec3 d3 = matrix * glm::vec4(inDir3, 1.0f);
-
-		DrawLine(d1, d2, inColor);
-		DrawLine(d2, d3, inColor);
-		DrawLine(d3, d1, inColor);
-	} else {
-		glm::vec3 center1 = glm::normalize(inDir1 + inDir2);
-		glm::vec3 center2 = glm::normalize(inDir2 + inDir3);
-		glm::vec3 center3 = glm::normalize(inDir3 + inDir1);
-
-		DrawWireUnitSphereRecursive(matrix, inColor, inDir1, center1, center3, inLevel - 1);
-		DrawWireUnitSphereRecursive(matrix, inColor, center1, center2, center3, inLevel - 1);
-		DrawWireUnitSphereRecursive(matrix, inColor, center1, inDir2, center2, inLevel - 1);
-		DrawWireUnitSphereRecursive(matrix, inColor, center3, center2, inDir3, inLevel - 1);
-	}
+    ASSERT(sData.Pipeline != nullptr, "The debug pass has to exist before benchmarking it!");
+
+    auto milliseconds = [](auto start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> unit(-50.0f, 50.0f);
+
+    Stream& boxes = sData.Shapes[SHAPE_BOX];
+    for (UInt32 count : { 1024u, 16384u, 65536u }) {
+        Vector<glm::mat4> transforms(count);
+        for (glm::mat4& transform : transforms) {
+            transform = glm::translate(glm::mat4(1.0f), glm::vec3(unit(generator), unit(generator), unit(generator)));
+        }
+
+        // What a box used to cost: twelve lines built on the CPU, expanded again into vertices and copied
+        auto start = std::chrono::steady_clock::now();
+        Vector<Line> lines;
+        for (const glm::mat4& transform : transforms) {
+            glm::vec3 corners[8];
+            for (int i = 0; i < 8; i++) {
+                corners[i] = glm::vec3(transform * glm::vec4(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f, 1.0f));
+            }
+            for (int i = 0; i < 8; i++) {
+                for (int axis = 1; axis < 8; axis <<= 1) {
+                    if (!(i & axis)) {
+                        lines.push_back({ corners[i], corners[i | axis], glm::vec3(1.0f) });
+                    }
+                }
+            }
+        }
+        Vector<LineVertex> vertices;
+        for (const Line& line : lines) {
+            vertices.push_back({ line.From, line.Color });
+            vertices.push_back({ line.To, line.Color });
+        }
+        Vector<UInt8> upload(vertices.size() * sizeof(LineVertex));
+        memcpy(upload.data(), vertices.data(), upload.size());
+        float legacy = milliseconds(start);
+
+        // Warm up once so the stream has already grown, then leave it as it was
+        UInt32 previous = boxes.Count;
+        for (const glm::mat4& transform : transforms) {
+            DrawBox(transform, glm::vec3(-0.5f), glm::vec3(0.5f));
+        }
+        boxes.Count = previous;
+
+        start = std::chrono::steady_clock::now();
+        for (const glm::mat4& transform : transforms) {
+            DrawBox(transform, glm::vec3(-0.5f), glm::vec3(0.5f));
+        }
+        float batched = milliseconds(start);
+        boxes.Count = previous;
+
+        LOG_INFO("[Debug] {0} boxes: {1:.3f} ms as CPU lines, {2:.3f} ms as shape instances ({3:.1f}x)", count, legacy, batched, legacy / glm::max(batched, 0.001f));
+    }
+}
+
+void Debug::BuildUnitSphere(Vector<glm::vec3>& vertices, glm::vec3 dir1, glm::vec3 dir2, glm::vec3 dir3, int level)
+{
+    if (level == 0) {
+        vertices.push_back(dir1);
+        vertices.push_back(dir2);
+        vertices.push_back(dir2);
+        vertices.push_back(dir3);
+        vertices.push_back(dir3);
+        vertices.push_back(dir1);
+    } else {
+        glm::vec3 center1 = glm::normalize(dir1 + dir2);
+        glm::vec3 center2 = glm::normalize(dir2 + dir3);
+        glm::vec3 center3 = glm::normalize(dir3 + dir1);
+
+        BuildUnitSphere(vertices, dir1, center1, center3, level - 1);
+        BuildUnitSphere(vertices, center1, center2, center3, level - 1);
+        BuildUnitSphere(vertices, center1, dir2, center2, level - 1);
+        BuildUnitSphere(vertices, center3, center2, dir3, level - 1);
+    }
 }
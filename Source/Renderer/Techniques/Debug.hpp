@@ -21,6 +21,7 @@ public:
     Debug(RHI::Ref rhi);
     ~Debug() = default;
 
+    void Declare(RenderGraph& graph) override;
     void Bake(Scene& scene) {}
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
@@ -37,10 +38,21 @@ public:
     static void DrawSphere(glm::vec3 center, float radius, glm::vec3 color = glm::vec3(1.0f), int level = 3);
     static void DrawRing(glm::vec3 center, glm::vec3 normal, float radius, glm::vec3 color = glm::vec3(1.0f), int level = 32);
     static void DrawRings(glm::vec3 center, float radius, glm::vec3 color = glm::vec3(1.0f), int level = 32);
+
+    static void Benchmark();
 private:
-    static constexpr UInt32 MAX_LINES = 5192 * 16;
+    // Starting sizes, the streams double when they fill up
+    static constexpr UInt32 INITIAL_LINES = 5192 * 16;
+    static constexpr UInt32 INITIAL_SHAPES = 1024;
+
+    // Lines drawn after the debug pass of a frame go to the next buffer, which must not be read by any frame still on the GPU
+    static constexpr UInt32 BUFFER_COUNT = FRAMES_IN_FLIGHT + 1;
 
-    static void DrawWireUnitSphereRecursive(glm::mat4 matrix, glm::vec3 inColor, glm::vec3 inDir1, glm::vec3 inDir2, glm::vec3 inDir3, int inLevel);
+    static constexpr UInt32 SPHERE_LEVELS = 5;
+    static constexpr UInt32 SHAPE_BOX = 0;
+    static constexpr UInt32 SHAPE_FRUSTUM = 1;
+    static constexpr UInt32 SHAPE_SPHERE = 2;
+    static constexpr UInt32 SHAPE_COUNT = SHAPE_SPHERE + SPHERE_LEVELS;
 
     struct LineVertex
     {
@@ -48,15 +60,49 @@ private:
         glm::vec3 Color;
     };
 
+    // Expanded against the shape's unit line list in the vertex shader
+    struct ShapeInstance
+    {
+        glm::mat4 Transform;
+        glm::vec3 Color;
+        float Pad;
+    };
+
+    // Persistently mapped upload buffers, written in place by the draw functions
+    struct Stream
+    {
+        String Name;
+        UInt32 Stride = 0;
+        UInt32 Count = 0;
+        UInt32 Capacity = 0;
+        Array<Buffer::Ref, BUFFER_COUNT> Buffers;
+        Array<UInt8*, BUFFER_COUNT> Mapped = {};
+        Array<UInt32, BUFFER_COUNT> Sizes = {};
+    };
+
+    static void InitStream(Stream& stream, const String& name, UInt32 stride, UInt32 capacity);
+    static void ResizeStream(Stream& stream, UInt32 index, UInt32 keep);
+    static UInt8* Push(Stream& stream, UInt32 count);
+    static void DrawShape(UInt32 shape, const glm::mat4& transform, glm::vec3 color);
+    static void BuildUnitSphere(Vector<glm::vec3>& vertices, glm::vec3 dir1, glm::vec3 dir2, glm::vec3 dir3, int level);
+
     static struct Data
     {
-        Vector<Line> Lines;
+        RHI::Ref Context;
         GraphicsPipeline::Ref Pipeline;
-        Array<Buffer::Ref, FRAMES_IN_FLIGHT> TransferBuffer;
-        Array<Buffer::Ref, FRAMES_IN_FLIGHT> VertexBuffer;
+        UInt32 Current = 0;
+        Stream Lines;
+        Array<Stream, SHAPE_COUNT> Shapes;
+
+        // Line lists of every shape in unit space, back to back
+        Buffer::Ref ShapeVertices;
+        Array<UInt32, SHAPE_COUNT> ShapeOffsets = {};
+        Array<UInt32, SHAPE_COUNT> ShapeSizes = {};
     } sData;
 
     UInt64 mLineCount = 0;
+    UInt64 mShapeCount = 0;
+    float mRecordTime = 0.0f;
 };
 
 
@@ -4,6 +4,7 @@
 //
 
 #include "Deferred.hpp"
+#include "Shadows.hpp"
 
 #include <imgui.h>
 
@@ -20,6 +21,19 @@ Deferred::Deferred(RHI::Ref rhi)
     mShadowSampler = mRHI->CreateSampler(SamplerAddress::Clamp, SamplerFilter::Nearest, false, 1, true);
 }
 
+void Deferred::Declare(RenderGraph& graph)
+{
+    // Doesn't write anything yet, so the graph culls it along with the GBuffer
+    graph.AddPass("Deferred", [](RenderGraph::Builder& builder) {
+        builder.Read("GBufferDepth");
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+            builder.Read("ShadowCascade" + std::to_string(i));
+        }
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
 void Deferred::Render(const Frame& frame, Scene& scene)
 {
 
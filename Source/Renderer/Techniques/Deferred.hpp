@@ -14,6 +14,7 @@ public:
     Deferred(RHI::Ref rhi);
     ~Deferred() = default;
 
+    void Declare(RenderGraph& graph) override;
     void Bake(Scene& scene) {}
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
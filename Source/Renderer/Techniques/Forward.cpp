@@ -30,11 +30,38 @@ Forward::Forward(RHI::Ref rhi)
     specs.DepthFormat = TextureFormat::Depth32;
     specs.DepthWrite = false;
     specs.Formats.push_back(color->Desc.Format);
-    specs.Signature = mRHI->CreateRootSignature({ RootType::PushConstant }, sizeof(int) * 10);
+    specs.Signature = mRHI->CreateRootSignature({ RootType::PushConstant }, sizeof(int) * 14);
     
-    mPipeline.Init(rhi, specs);
-    mPipeline.AddPermutation("Alpha", "Assets/Shaders/Forward/Vertex.hlsl", "Assets/Shaders/Forward/FragmentAlpha.hlsl");
-    mPipeline.AddPermutation("NoAlpha", "Assets/Shaders/Forward/Vertex.hlsl", "Assets/Shaders/Forward/FragmentNoAlpha.hlsl");
+    mPipeline.Init(rhi, specs, "Assets/Shaders/Forward/Vertex.hlsl", "Assets/Shaders/Forward/Fragment.hlsl", ShaderFeatures::AlphaTest | ShaderFeatures::NormalMap);
+}
+
+void Forward::Declare(RenderGraph& graph)
+{
+    graph.AddPass("Forward", [](RenderGraph::Builder& builder) {
+        builder.Write("MainColorBuffer", ResourceLayout::ColorWrite);
+        builder.Read("GBufferDepth", ResourceLayout::DepthRead);
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+            builder.Read("ShadowCascade" + std::to_string(i));
+        }
+        builder.Read("ShadowAtlas");
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
+void Forward::Bake(Scene& scene)
+{
+    if (Settings::Get().PrecompileAllPermutations) {
+        mPipeline.PrecompileAll();
+        return;
+    }
+
+    // Only what the loaded materials can reach, anything else compiles on first use
+    for (auto& model : scene.Models) {
+        for (auto& material : model->Model.Materials) {
+            mPipeline.Get(Permutation::GetMaterialFeatures(material), true);
+        }
+    }
 }
 
 void Forward::Render(const Frame& frame, Scene& scene)
@@ -44,8 +71,11 @@ void Forward::Render(const Frame& frame, Scene& scene)
     ::Ref<RenderPassIO> camera = PassManager::Get("CameraRingBuffer");
     ::Ref<RenderPassIO> white = PassManager::Get("WhiteTexture");
     ::Ref<RenderPassIO> cascade = PassManager::Get("CascadeRingBuffer");
+    ::Ref<RenderPassIO> shadowAtlas = PassManager::Get("ShadowAtlas");
+    ::Ref<RenderPassIO> shadowViews = PassManager::Get("ShadowViewRingBuffer");
 
-    mCulledOBBs = 0;
+    const SceneSnapshot& snapshot = scene.Current();
+    mCulledOBBs = snapshot.CulledInstances;
 
     struct UploadData {
         glm::mat4 View;
@@ -54,107 +84,124 @@ void Forward::Render(const Frame& frame, Scene& scene)
         glm::vec3 Position;
         float Pad;
     } Data = {
-        scene.Camera.View(),
-        scene.Camera.Projection(),
-        glm::inverse(scene.Camera.View()),
-        scene.Camera.Position(),
+        snapshot.Camera.View(),
+        snapshot.Camera.Projection(),
+        glm::inverse(snapshot.Camera.View()),
+        snapshot.Camera.Position(),
         0.0f,
     };
     camera->RingBuffer[frame.FrameIndex]->CopyMapped(&Data, sizeof(Data));
 
-    frame.CommandBuffer->BeginMarker("Forward");
-    frame.CommandBuffer->Barrier(color->Texture, ResourceLayout::ColorWrite);
-    frame.CommandBuffer->Barrier(depth->Texture, ResourceLayout::DepthRead);
-    frame.CommandBuffer->ClearRenderTarget(color->RenderTargetView, 0.0f, 0.0f, 0.0f);
-    frame.CommandBuffer->SetRenderTargets({ color->RenderTargetView }, depth->DepthTargetView);
-    frame.CommandBuffer->SetTopology(Topology::TriangleList);
-    frame.CommandBuffer->SetViewport(0, 0, (float)frame.Width, (float)frame.Height);
+    struct PushConstants {
+        int CameraIndex;
+        int ModelIndex;
+        int LightIndex;
+        int CascadeIndex;
+
+        int TextureIndex;
+        int NormalIndex;
+
+        int SamplerIndex;
+        int ClampSamplerIndex;
+        int ShadowSamplerIndex;
+
+        int Accel;
+
+        int ShadowAtlasIndex;
+        int ShadowViewIndex;
 
-    std::function<void(Frame frame, GLTFNode*, GLTF* model, glm::mat4 transform)> drawNode = [&](Frame frame, GLTFNode* node, GLTF* model, glm::mat4 transform) {
-        if (!node) {
-            return;
+        int OcclusionIndex;
+        int BakedOcclusion;
+    };
+    struct Draw {
+        GraphicsPipeline::Ref Pipeline;
+        PushConstants Constants;
+        GLTFPrimitive Primitive;
+    };
+
+    // Culling already happened while the previous frame recorded. Uploads, debug draws and pipeline lookups happen here, the
+    // workers only record.
+    Vector<Draw> draws;
+    draws.reserve(snapshot.Visible.size());
+    for (UInt32 index : snapshot.Visible) {
+        const SceneInstance& instance = snapshot.Instances[index];
+        const GLTFPrimitive& primitive = *instance.Primitive;
+        GLTFMaterial material = instance.Model->Materials[primitive.MaterialIndex];
+
+        struct ModelData {
+            glm::mat4 transform;
+            glm::mat4 invTransform;
+            glm::vec3 materialColor;
+        } modelData = {
+            instance.Transform,
+            instance.InvTransform,
+            glm::vec4(material.MaterialColor, 1.0)
+        };
+        instance.Node->ModelBuffer[frame.FrameIndex]->CopyMapped(&modelData, sizeof(modelData));
+
+        int albedoIndex = material.Albedo ? material.AlbedoView->GetDescriptor().Index : white->ShaderResourceView->GetDescriptor().Index;
+        int normalIndex = material.Normal ? material.NormalView->GetDescriptor().Index : -1;
+        int occlusionIndex = -1;
+        if (material.PackedOcclusion) {
+            occlusionIndex = material.PBRView->GetDescriptor().Index;
+        } else if (material.Occlusion) {
+            occlusionIndex = material.OcclusionView->GetDescriptor().Index;
         }
 
-        glm::mat4 globalTransform = transform * node->Transform;
-        glm::mat4 invTransform = glm::inverse(globalTransform);
-        for (GLTFPrimitive primitive : node->Primitives) {
-            // CPU cull
-            if (!scene.Camera.IsBoxInFrustum(primitive.AABB, globalTransform) && Settings::Get().FrustumCull) {
-                mCulledOBBs++;
-                continue;
-            }
+        PushConstants Constants = {
+            camera->RingBuffer[frame.FrameIndex]->CBV(),
+            instance.Node->ModelBuffer[frame.FrameIndex]->CBV(),
+            scene.LightBuffer[frame.FrameIndex]->CBV(),
+            cascade->RingBuffer[frame.FrameIndex]->CBV(),
 
-            GLTFMaterial material = model->Materials[primitive.MaterialIndex];
-
-            struct ModelData {
-                glm::mat4 transform;
-                glm::mat4 invTransform;
-                glm::vec3 materialColor;
-            } modelData = {
-                globalTransform,
-                invTransform,
-                glm::vec4(material.MaterialColor, 1.0)
-            };
-            node->ModelBuffer[frame.FrameIndex]->CopyMapped(&modelData, sizeof(modelData));
-            
-            int albedoIndex = material.Albedo ? material.AlbedoView->GetDescriptor().Index : white->ShaderResourceView->GetDescriptor().Index;
-            int normalIndex = material.Normal ? material.NormalView->GetDescriptor().Index : -1;
-
-            struct PushConstants {
-                int CameraIndex;
-                int ModelIndex;
-                int LightIndex;
-                int CascadeIndex;
-
-                int TextureIndex;
-                int NormalIndex;
-
-                int SamplerIndex;
-                int ClampSamplerIndex;
-                int ShadowSamplerIndex;
-
-                int Accel;
-            } Constants = {
-                camera->RingBuffer[frame.FrameIndex]->CBV(),
-                node->ModelBuffer[frame.FrameIndex]->CBV(),
-                scene.LightBuffer[frame.FrameIndex]->CBV(),
-                cascade->RingBuffer[frame.FrameIndex]->CBV(),
-
-                albedoIndex,
-                normalIndex,
-
-                mSampler->BindlesssSampler(),
-                mClampSampler->BindlesssSampler(),
-                mShadowSampler->BindlesssSampler(),
-
-                -1
-            };
-            frame.CommandBuffer->SetGraphicsPipeline(material.AlphaTested ? mPipeline.Get("Alpha") : mPipeline.Get("NoAlpha"));
-            frame.CommandBuffer->GraphicsPushConstants(&Constants, sizeof(Constants), 0);
-            frame.CommandBuffer->SetVertexBuffer(primitive.VertexBuffer);
-            frame.CommandBuffer->SetIndexBuffer(primitive.IndexBuffer);
-            frame.CommandBuffer->DrawIndexed(primitive.IndexCount);
-
-            if (Settings::Get().DebugDrawVolumes) {
-                Debug::DrawBox(globalTransform, primitive.AABB.Min, primitive.AABB.Max, glm::vec3(0.0f, 1.0, 0.0f));
-            }
+            albedoIndex,
+            normalIndex,
+
+            mSampler->BindlesssSampler(),
+            mClampSampler->BindlesssSampler(),
+            mShadowSampler->BindlesssSampler(),
+
+            -1,
+
+            shadowAtlas->ShaderResourceView->GetDescriptor().Index,
+            shadowViews->RingBuffer[frame.FrameIndex]->CBV(),
+
+            occlusionIndex,
+            Settings::Get().BakedOcclusion
+        };
+        draws.push_back({ mPipeline.Get(Permutation::GetMaterialFeatures(material)), Constants, primitive });
+
+        if (Settings::Get().DebugDrawVolumes) {
+            Debug::DrawBox(instance.Transform, primitive.AABB.Min, primitive.AABB.Max, glm::vec3(0.0f, 1.0, 0.0f));
         }
-        
-        if (!node->Children.empty()) {
-            for (GLTFNode* child : node->Children) {
-                drawNode(frame, child, model, globalTransform);
+    }
+
+    frame.CommandBuffer->ClearRenderTarget(color->RenderTargetView, 0.0f, 0.0f, 0.0f);
+
+    RecordParallel(frame, "Forward", draws.size(), [&](const Frame& frame, UInt32 begin, UInt32 end) {
+        frame.CommandBuffer->SetRenderTargets({ color->RenderTargetView }, depth->DepthTargetView);
+        frame.CommandBuffer->SetTopology(Topology::TriangleList);
+        frame.CommandBuffer->SetViewport(0, 0, (float)frame.Width, (float)frame.Height);
+
+        GraphicsPipeline::Ref bound = nullptr;
+        for (UInt32 i = begin; i < end; i++) {
+            const Draw& draw = draws[i];
+            if (draw.Pipeline != bound) {
+                frame.CommandBuffer->SetGraphicsPipeline(draw.Pipeline);
+                bound = draw.Pipeline;
             }
+            frame.CommandBuffer->GraphicsPushConstants(&draw.Constants, sizeof(draw.Constants), 0);
+            frame.CommandBuffer->SetVertexBuffer(draw.Primitive.VertexBuffer);
+            frame.CommandBuffer->SetIndexBuffer(draw.Primitive.IndexBuffer);
+            frame.CommandBuffer->DrawIndexed(draw.Primitive.IndexCount);
         }
-    };
-    for (auto& model : scene.Models) {
-        drawNode(frame, model->Model.Root, &model->Model, glm::mat4(1.0f));
-    }
-    frame.CommandBuffer->EndMarker();
+    });
 }
 
 void Forward::UI(const Frame& frame)
 {
     if (ImGui::TreeNodeEx("Forward", ImGuiTreeNodeFlags_Framed)) {
+        ImGui::Text("Recording: %.2f ms on %u threads", mRecordTime, mRecordThreads);
         ImGui::TreePop();
     }
 }
@@ -14,7 +14,8 @@ public:
     Forward(RHI::Ref rhi);
     ~Forward() = default;
 
-    void Bake(Scene& scene) {}
+    void Declare(RenderGraph& graph) override;
+    void Bake(Scene& scene) override;
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
 private:
@@ -8,6 +8,8 @@
 #include <Settings.hpp>
 #include <Statistics.hpp>
 
+#include <imgui.h>
+
 GBuffer::GBuffer(RHI::Ref rhi)
     : RenderPass(rhi)
 { 
@@ -22,9 +24,31 @@ GBuffer::GBuffer(RHI::Ref rhi)
     specs.DepthFormat = TextureFormat::Depth32;
     specs.Signature = mRHI->CreateRootSignature({ RootType::PushConstant }, sizeof(int) * 4);
     
-    mPipeline.Init(rhi, specs);
-    mPipeline.AddPermutation("NoAlpha", "Assets/Shaders/GBuffer/Vertex.hlsl", "Assets/Shaders/GBuffer/FragmentNoAlpha.hlsl");
-    mPipeline.AddPermutation("Alpha", "Assets/Shaders/GBuffer/Vertex.hlsl", "Assets/Shaders/GBuffer/FragmentAlpha.hlsl");
+    mPipeline.Init(rhi, specs, "Assets/Shaders/GBuffer/Vertex.hlsl", "Assets/Shaders/GBuffer/Fragment.hlsl", ShaderFeatures::AlphaTest);
+}
+
+void GBuffer::Declare(RenderGraph& graph)
+{
+    graph.AddPass("GBuffer", [](RenderGraph::Builder& builder) {
+        builder.Write("GBufferDepth", ResourceLayout::DepthWrite);
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
+void GBuffer::Bake(Scene& scene)
+{
+    if (Settings::Get().PrecompileAllPermutations) {
+        mPipeline.PrecompileAll();
+        return;
+    }
+
+    // Only what the loaded materials can reach, anything else compiles on first use
+    for (auto& model : scene.Models) {
+        for (auto& material : model->Model.Materials) {
+            mPipeline.Get(Permutation::GetMaterialFeatures(material), true);
+        }
+    }
 }
 
 void GBuffer::Render(const Frame& frame, Scene& scene)
@@ -32,6 +56,7 @@ void GBuffer::Render(const Frame& frame, Scene& scene)
     ::Ref<RenderPassIO> white = PassManager::Get("WhiteTexture");
     ::Ref<RenderPassIO> depth = PassManager::Get("GBufferDepth");
     ::Ref<RenderPassIO> camera = PassManager::Get("CameraRingBuffer");
+    const SceneSnapshot& snapshot = scene.Current();
 
     struct UploadData {
         glm::mat4 View;
@@ -40,82 +65,86 @@ void GBuffer::Render(const Frame& frame, Scene& scene)
         glm::vec3 Position;
         float Pad;
     } Data = {
-        scene.Camera.View(),
-        scene.Camera.Projection(),
-        glm::inverse(scene.Camera.View()),
-        scene.Camera.Position(),
+        snapshot.Camera.View(),
+        snapshot.Camera.Projection(),
+        glm::inverse(snapshot.Camera.View()),
+        snapshot.Camera.Position(),
         0.0f,
     };
     camera->RingBuffer[frame.FrameIndex]->CopyMapped(&Data, sizeof(Data));
 
-    frame.CommandBuffer->BeginMarker("GBuffer");
-    frame.CommandBuffer->Barrier(depth->Texture, ResourceLayout::DepthWrite);
+    struct PushConstants {
+        int CameraIndex;
+        int ModelIndex;
+        int TextureIndex;          
+        int SamplerIndex;
+    };
+    struct Draw {
+        GraphicsPipeline::Ref Pipeline;
+        PushConstants Constants;
+        GLTFPrimitive Primitive;
+    };
+
+    // Culling already happened while the previous frame recorded. Uploads and pipeline lookups happen here, the workers only record.
+    Statistics::Get().InstanceCount += snapshot.Visible.size();
+    Statistics::Get().CulledInstances += snapshot.CulledInstances;
+    Statistics::Get().CulledTriangles += snapshot.CulledTriangles;
+
+    Vector<Draw> draws;
+    draws.reserve(snapshot.Visible.size());
+    for (UInt32 index : snapshot.Visible) {
+        const SceneInstance& instance = snapshot.Instances[index];
+        const GLTFPrimitive& primitive = *instance.Primitive;
+        GLTFMaterial material = instance.Model->Materials[primitive.MaterialIndex];
+
+        struct ModelData {
+            glm::mat4 transform;
+            glm::mat4 invTransform;
+            glm::vec3 materialColor;
+        } modelData = {
+            instance.Transform,
+            instance.InvTransform,
+            glm::vec4(material.MaterialColor, 1.0)
+        };
+        instance.Node->ModelBuffer[frame.FrameIndex]->CopyMapped(&modelData, sizeof(modelData));
+
+        int albedoIndex = material.Albedo ? material.AlbedoView->GetDescriptor().Index : white->ShaderResourceView->GetDescriptor().Index;
+
+        PushConstants Constants = {
+            camera->RingBuffer[frame.FrameIndex]->CBV(),
+            instance.Node->ModelBuffer[frame.FrameIndex]->CBV(),
+            albedoIndex,
+            mSampler->BindlesssSampler(),
+        };
+        draws.push_back({ mPipeline.Get(Permutation::GetMaterialFeatures(material)), Constants, primitive });
+    }
+
     frame.CommandBuffer->ClearDepth(depth->DepthTargetView);
-    frame.CommandBuffer->SetRenderTargets({}, depth->DepthTargetView);
-    frame.CommandBuffer->SetTopology(Topology::TriangleList);
-    frame.CommandBuffer->SetViewport(0, 0, (float)frame.Width, (float)frame.Height);
 
-    std::function<void(Frame frame, GLTFNode*, GLTF* model, glm::mat4 transform)> drawNode = [&](Frame frame, GLTFNode* node, GLTF* model, glm::mat4 transform) {
-        if (!node) {
-            return;
-        }
+    RecordParallel(frame, "GBuffer", draws.size(), [&](const Frame& frame, UInt32 begin, UInt32 end) {
+        frame.CommandBuffer->SetRenderTargets({}, depth->DepthTargetView);
+        frame.CommandBuffer->SetTopology(Topology::TriangleList);
+        frame.CommandBuffer->SetViewport(0, 0, (float)frame.Width, (float)frame.Height);
 
-        glm::mat4 globalTransform = transform * node->Transform;
-        glm::mat4 invTransform = glm::inverse(globalTransform);
-        for (GLTFPrimitive primitive : node->Primitives) {
-            if (!scene.Camera.IsBoxInFrustum(primitive.AABB, globalTransform) && Settings::Get().FrustumCull) {
-                Statistics::Get().CulledInstances++;
-                Statistics::Get().CulledTriangles += primitive.IndexCount / 3;
-                continue;
+        GraphicsPipeline::Ref bound = nullptr;
+        for (UInt32 i = begin; i < end; i++) {
+            const Draw& draw = draws[i];
+            if (draw.Pipeline != bound) {
+                frame.CommandBuffer->SetGraphicsPipeline(draw.Pipeline);
+                bound = draw.Pipeline;
             }
-            Statistics::Get().InstanceCount++;
-
-            GLTFMaterial material = model->Materials[primitive.MaterialIndex];
-
-            struct ModelData {
-                glm::mat4 transform;
-                glm::mat4 invTransform;
-                glm::vec3 materialColor;
-            } modelData = {
-                globalTransform,
-                invTransform,
-                glm::vec4(material.MaterialColor, 1.0)
-            };
-            node->ModelBuffer[frame.FrameIndex]->CopyMapped(&modelData, sizeof(modelData));
-            
-            int albedoIndex = material.Albedo ? material.AlbedoView->GetDescriptor().Index : white->ShaderResourceView->GetDescriptor().Index;
-
-            struct PushConstants {
-                int CameraIndex;
-                int ModelIndex;
-                int TextureIndex;          
-                int SamplerIndex;
-            } Constants = {
-                camera->RingBuffer[frame.FrameIndex]->CBV(),
-                node->ModelBuffer[frame.FrameIndex]->CBV(),
-                albedoIndex,
-                mSampler->BindlesssSampler(),
-            };
-            frame.CommandBuffer->SetGraphicsPipeline(material.AlphaTested ? mPipeline.Get("Alpha") : mPipeline.Get("NoAlpha"));
-            frame.CommandBuffer->GraphicsPushConstants(&Constants, sizeof(Constants), 0);
-            frame.CommandBuffer->SetVertexBuffer(primitive.VertexBuffer);
-            frame.CommandBuffer->SetIndexBuffer(primitive.IndexBuffer);
-            frame.CommandBuffer->DrawIndexed(primitive.IndexCount);
+            frame.CommandBuffer->GraphicsPushConstants(&draw.Constants, sizeof(draw.Constants), 0);
+            frame.CommandBuffer->SetVertexBuffer(draw.Primitive.VertexBuffer);
+            frame.CommandBuffer->SetIndexBuffer(draw.Primitive.IndexBuffer);
+            frame.CommandBuffer->DrawIndexed(draw.Primitive.IndexCount);
         }
-        
-        if (!node->Children.empty()) {
-            for (GLTFNode* child : node->Children) {
-                drawNode(frame, child, model, globalTransform);
-            }
-        }
-    };
-    for (auto& model : scene.Models) {
-        drawNode(frame, model->Model.Root, &model->Model, glm::mat4(1.0f));
-    }
-    frame.CommandBuffer->EndMarker();
+    });
 }
 
 void GBuffer::UI(const Frame& frame)
 {
-
+    if (ImGui::TreeNodeEx("GBuffer", ImGuiTreeNodeFlags_Framed)) {
+        ImGui::Text("Recording: %.2f ms on %u threads", mRecordTime, mRecordThreads);
+        ImGui::TreePop();
+    }
 }
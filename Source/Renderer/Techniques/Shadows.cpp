@@ -4,14 +4,101 @@
 //
 
 #include <Renderer/Techniques/Shadows.hpp>
+#include <Core/TimingTree.hpp>
 #include <Core/Logger.hpp>
 #include <Renderer/Techniques/Debug.hpp>
 #include <Settings.hpp>
+#include <Statistics.hpp>
 
 #include <imgui.h>
 
+// Planes around everything that can shadow the inside of a hexahedron, it's swept back towards the light. Corners come in
+// the order Camera::FrustumCorners() gives them.
+static void AddCasterPlanes(Vector<Plane>& planes, const Array<glm::vec3, 8>& corners, const glm::vec3& direction)
+{
+    static const int faces[6][4] = {
+        { 0, 1, 2, 3 }, { 4, 5, 6, 7 }, { 0, 1, 5, 4 }, { 1, 2, 6, 5 }, { 2, 3, 7, 6 }, { 3, 0, 4, 7 }
+    };
+    static const int edges[12][2] = {
+        { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+    };
+
+    glm::vec3 center(0.0f);
+    for (const glm::vec3& corner : corners) {
+        center += corner;
+    }
+    center /= 8.0f;
+
+    auto makePlane = [&](glm::vec3 normal, const glm::vec3& point) {
+        if (glm::dot(normal, center - point) < 0.0f) {
+            normal = -normal;
+        }
+        return Plane{ normal, -glm::dot(normal, point) };
+    };
+
+    // Faces the light goes in through get swept away, the ones it leaves through still bound the casters
+    Array<bool, 6> kept;
+    for (int i = 0; i < 6; i++) {
+        const glm::vec3& a = corners[faces[i][0]];
+        glm::vec3 normal = glm::cross(corners[faces[i][2]] - a, corners[faces[i][1]] - corners[faces[i][3]]);
+        Plane plane = makePlane(normal, a);
+        kept[i] = glm::dot(plane.Normal, direction) <= 0.0f;
+        if (kept[i]) {
+            planes.push_back(plane);
+        }
+    }
+
+    // Edges between a kept and a swept face are the silhouette, their planes run along the light
+    auto hasEdge = [&](int face, int a, int b) {
+        bool foundA = false, foundB = false;
+        for (int i = 0; i < 4; i++) {
+            foundA = foundA || faces[face][i] == a;
+            foundB = foundB || faces[face][i] == b;
+        }
+        return foundA && foundB;
+    };
+    for (auto& edge : edges) {
+        int adjacent[2] = { -1, -1 };
+        for (int i = 0, found = 0; i < 6 && found < 2; i++) {
+            if (hasEdge(i, edge[0], edge[1])) {
+                adjacent[found++] = i;
+            }
+        }
+        if (kept[adjacent[0]] == kept[adjacent[1]])
+            continue;
+
+        glm::vec3 normal = glm::cross(corners[edge[1]] - corners[edge[0]], direction);
+        if (glm::dot(normal, normal) < 1e-10f)
+            continue;
+        planes.push_back(makePlane(normal, corners[edge[0]]));
+    }
+}
+
+// In the order Camera::FrustumCorners() gives them
+static Array<glm::vec3, 8> GetBoxCorners(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform)
+{
+    Array<glm::vec3, 8> corners;
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner((i == 1 || i == 2 || i == 5 || i == 6) ? max.x : min.x,
+                         (i == 0 || i == 1 || i == 4 || i == 5) ? max.y : min.y,
+                         i >= 4 ? max.z : min.z);
+        corners[i] = glm::vec3(transform * glm::vec4(corner, 1.0f));
+    }
+    return corners;
+}
+
+static bool IsBoxInVolume(const Vector<Plane>& planes, const Box& box)
+{
+    for (const Plane& plane : planes) {
+        if (Camera::IsBoxOutsidePlane(plane, box)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 Shadows::Shadows(RHI::Ref rhi)
-    : RenderPass(rhi)
+    : RenderPass(rhi), mAtlas(PassManager::Get("ShadowAtlas")->Desc.Width, 64, SPOT_LIGHT_SHADOW_DIMENSION)
 {
     {
         Asset::Handle vertexShader = AssetManager::Get("Assets/Shaders/Shadow/Vertex.hlsl",     AssetType::Shader);
@@ -61,72 +148,109 @@ Shadows::Shadows(RHI::Ref rhi)
     }
 }
 
+void Shadows::Declare(RenderGraph& graph)
+{
+    // The cache atlas is created and transitioned by the pass itself
+    graph.AddPass("Shadows", [](RenderGraph::Builder& builder) {
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+            builder.Write("ShadowCascade" + std::to_string(i), ResourceLayout::DepthWrite);
+        }
+        builder.Write("ShadowAtlas", ResourceLayout::DepthWrite);
+    }, [this](const Frame& frame, Scene& scene) {
+        Render(frame, scene);
+    });
+}
+
 void Shadows::Bake(Scene& scene)
 {
+    // Every light gets fixed view slots, the atlas decides where and how big they are each frame
+    UInt32 slot = 0;
     for (int i = 0; i < scene.PointLights.size(); i++) {
         if (scene.PointLights[i].CastShadows) {
+            if (slot + 6 > MAX_SHADOW_VIEWS) {
+                LOG_WARN("Out of shadow views, point light {0} won't cast shadows", i);
+                scene.PointLights[i].CastShadows = false;
+                continue;
+            }
+
             PointLightShadow shadow;
             shadow.Parent = &scene.PointLights[i];
+            shadow.View = slot;
+            slot += 6;
 
-            TextureDesc desc;
-            desc.Name = "Point Light Shadow Map";
-            desc.Usage = TextureUsage::DepthTarget;
-            desc.Width = POINT_LIGHT_SHADOW_DIMENSION;
-            desc.Height = POINT_LIGHT_SHADOW_DIMENSION;
-            desc.Depth = 6;
-            desc.Format = TextureFormat::Depth32;
-            desc.Levels = 1;
-            shadow.ShadowMap = mRHI->CreateTexture(desc);
-
-            shadow.SRV = mRHI->CreateView(shadow.ShadowMap, ViewType::ShaderResource, ViewDimension::TextureCube, TextureFormat::R32Float);
-            for (int i = 0; i < 6; i++) {
-                shadow.DepthViews[i] = mRHI->CreateView(shadow.ShadowMap, ViewType::DepthTarget, ViewDimension::TextureCube, TextureFormat::Depth32, VIEW_ALL_MIPS, i);
-            }
-            
-            scene.PointLights[i].ShadowCubemap = shadow.SRV->GetDescriptor().Index;
+            scene.PointLights[i].ShadowView = shadow.View;
             mPointLightShadows.push_back(shadow);
         }
     }
     for (int i = 0; i < scene.SpotLights.size(); i++) {
         if (scene.SpotLights[i].CastShadows) {
+            if (slot + 1 > MAX_SHADOW_VIEWS) {
+                LOG_WARN("Out of shadow views, spot light {0} won't cast shadows", i);
+                scene.SpotLights[i].CastShadows = false;
+                continue;
+            }
+
             SpotLightShadow shadow;
             shadow.Parent = &scene.SpotLights[i];
-        
-            TextureDesc desc;
-            desc.Name = "Spot Light Shadow Map";
-            desc.Usage = TextureUsage::DepthTarget;
-            desc.Width = SPOT_LIGHT_SHADOW_DIMENSION;
-            desc.Height = SPOT_LIGHT_SHADOW_DIMENSION;
-            desc.Depth = 1;
-            desc.Format = TextureFormat::Depth32;
-            desc.Levels = 1;
-            shadow.ShadowMap = mRHI->CreateTexture(desc);
-
-            shadow.SRV = mRHI->CreateView(shadow.ShadowMap, ViewType::ShaderResource, ViewDimension::Texture, TextureFormat::R32Float);
-            shadow.DSV = mRHI->CreateView(shadow.ShadowMap, ViewType::DepthTarget, ViewDimension::Texture);
-            
-            scene.SpotLights[i].ShadowMap = shadow.SRV->GetDescriptor().Index;
+            shadow.View = slot;
+            slot += 1;
+
+            scene.SpotLights[i].ShadowView = shadow.View;
             mSpotLightShadows.push_back(shadow);
         }
     }
+    mAtlasViewCount = slot;
+
+    if (!mAtlasCache) {
+        TextureDesc desc = PassManager::Get("ShadowAtlas")->Desc;
+        desc.Name = "Shadow Atlas Cache";
+        desc.Usage = TextureUsage::DepthTarget;
+        mAtlasCache = mRHI->CreateTexture(desc);
+        mAtlasCacheDSV = mRHI->CreateView(mAtlasCache, ViewType::DepthTarget, ViewDimension::Texture);
+    }
 }
 
 void Shadows::Render(const Frame& frame, Scene& scene)
 {
-    frame.CommandBuffer->BeginMarker("Shadows");
+    const SceneSnapshot& snapshot = scene.Current();
+
+    // Every cascade, point light face and spot light is a view of its own, so they can be recorded on different threads.
+    // Cascades and stale caches go first, then the caches are copied and dynamic casters drawn on top.
+    Vector<ShadowView> views;
+    Vector<ShadowView> composites;
+    Vector<Pair<Texture::Ref, Texture::Ref>> copies;
+    UInt32 reused = 0;
+
+    auto invalidated = [&](const glm::mat4& lightMatrix) {
+        for (const Box& box : snapshot.ShadowInvalidations) {
+            if (Camera::IsBoxInFrustum(lightMatrix, box, glm::mat4(1.0f))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto hasDynamic = [&](const glm::mat4& lightMatrix) {
+        for (UInt32 index : snapshot.Dynamic) {
+            const SceneInstance& instance = snapshot.Instances[index];
+            if (Camera::IsBoxInFrustum(lightMatrix, instance.Primitive->AABB, instance.Transform)) {
+                return true;
+            }
+        }
+        return false;
+    };
 
     // CSM
-    if (Settings::Get().SceneUseSun)
+    if (scene.Current().UseSun)
     {
         if (!mFreezeCascades) {
-            UpdateCascades(scene);
+            UpdateCascades(scene.Current());
         } else {
             for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
                 Debug::DrawFrustum(mCascades[i].View, mCascades[i].Proj, glm::vec3(0.3f, 0.5f, 0.8f));
+                mCascadeUpdates[i] = true;
             }
         }
 
-        // Draw
         Vector<::Ref<RenderPassIO>> cascades = {
             PassManager::Get("ShadowCascade0"),
             PassManager::Get("ShadowCascade1"),
@@ -144,180 +268,236 @@ void Shadows::Render(const Frame& frame, Scene& scene)
             cascadeRingBuffer->RingBuffer[frame.FrameIndex]->CopyMapped(mCascades.data(), sizeof(Cascade) * SHADOW_CASCADE_COUNT);
         }
 
-        frame.CommandBuffer->BeginMarker("Cascaded Shadow Maps");
-        frame.CommandBuffer->SetGraphicsPipeline(mCascadePipeline);
+        mCascadesRendered = 0;
         for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
-            frame.CommandBuffer->BeginMarker("Cascade " + std::to_string(i));
-            frame.CommandBuffer->Barrier(cascades[i]->Texture, ResourceLayout::DepthWrite);
-            frame.CommandBuffer->SetRenderTargets({}, cascades[i]->DepthTargetView);
-            frame.CommandBuffer->ClearDepth(cascades[i]->DepthTargetView);
-            frame.CommandBuffer->SetViewport(0, 0, cascades[i]->Desc.Width, cascades[i]->Desc.Height);
-            frame.CommandBuffer->SetTopology(Topology::TriangleList);
-            std::function<void(Frame frame, GLTFNode*, GLTF* model, glm::mat4 transform)> drawNode = [&](Frame frame, GLTFNode* node, GLTF* model, glm::mat4 transform) {
-                if (!node) {
-                    return;
-                }
-
-                glm::mat4 globalTransform = transform * node->Transform;
-                for (GLTFPrimitive primitive : node->Primitives) {
-                    if (!Camera::IsBoxInFrustum(mCascades[i].Proj * mCascades[i].View, primitive.AABB, globalTransform))
-                        continue;
-
-                    struct PushConstants {
-                        glm::mat4 transform;
-                        glm::mat4 view;
-                        glm::mat4 proj;
-                    } Constants = {
-                        globalTransform,
-                        mCascades[i].View,
-                        mCascades[i].Proj
-                    };
-                    frame.CommandBuffer->GraphicsPushConstants(&Constants, sizeof(Constants), 0);
-                    frame.CommandBuffer->SetVertexBuffer(primitive.VertexBuffer);
-                    frame.CommandBuffer->SetIndexBuffer(primitive.IndexBuffer);
-                    frame.CommandBuffer->DrawIndexed(primitive.IndexCount);
-                }
-
-                if (!node->Children.empty()) {
-                    for (GLTFNode* child : node->Children) {
-                        drawNode(frame, child, model, globalTransform);
-                    }
-                }
-            };
-            for (auto& model : scene.Models) {
-                drawNode(frame, model->Model.Root, &model->Model, glm::mat4(1.0f));
-            }
+            if (!mCascadeUpdates[i])
+                continue;
+            mCascadesRendered++;
+
+            ShadowView view = { "Cascade " + std::to_string(i), mCascadePipeline, cascades[i]->DepthTargetView, cascades[i]->Desc.Width, cascades[i]->Desc.Height, mCascades[i].View, mCascades[i].Proj };
+            view.CasterVolume = mCullCasters ? &mCasterVolumes[i] : nullptr;
+            view.Cascade = i;
+            views.push_back(view);
+        }
+    } else {
+        mCascadeCasters = {};
+        mCascadesRendered = 0;
+    }
 
-            frame.CommandBuffer->Barrier(cascades[i]->Texture, ResourceLayout::Shader);
-            frame.CommandBuffer->EndMarker();
+    // Point and spot shadows. Every view asks for a tile as big as its light is on screen, the ones that don't fit in the
+    // atlas shrink, least important first.
+    ::Ref<RenderPassIO> atlas = PassManager::Get("ShadowAtlas");
+    float atlasSize = (float)mAtlas.GetSize();
+    float focal = snapshot.Camera.Projection()[1][1] * 0.5f * frame.Height;
+    auto coverage = [&](const glm::vec3& center, float radius) {
+        if (!snapshot.Camera.IsBoxInFrustum(Box{ center - radius, center + radius }))
+            return 0.0f;
+        float distance = glm::length(center - snapshot.Camera.Position());
+        if (distance <= radius)
+            return (float)frame.Height;
+        return 2.0f * focal * radius / std::sqrt(distance * distance - radius * radius);
+    };
+
+    struct AtlasView {
+        String Name;
+        UInt32 Slot;
+        GraphicsPipeline::Ref Pipeline;
+        glm::mat4 View;
+        glm::mat4 Proj;
+        glm::vec4 LightPosition;
+        bool Point;
+        bool Moved;
+    };
+    Vector<AtlasView> atlasViews;
+    Vector<ShadowAtlas::Request> requests;
+
+    for (auto& light : mPointLightShadows) {
+        float nearPlane = 1.0f;
+        float farPlane = 25.0f;
+        glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane); 
+
+        Vector<glm::mat4> shadowTransforms;
+        shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
+        shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
+        shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0, 1.0, 0.0), glm::vec3(0.0, 0.0,  1.0)));
+        shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0,-1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
+        shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
+        shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0, 0.0,-1.0), glm::vec3(0.0, -1.0, 0.0)));
+
+        // A face covers about half of what the light does on screen
+        float pixels = coverage(light.Parent->Position, light.Parent->Radius);
+        UInt32 size = (UInt32)std::min(pixels * 0.5f, (float)POINT_LIGHT_SHADOW_DIMENSION);
+
+        bool moved = !mCacheShadows || !light.Cached || light.CachedPosition != light.Parent->Position;
+        for (int i = 0; i < 6; i++) {
+            atlasViews.push_back({ "Point Face " + std::to_string(i), light.View + i, mPointPipeline, shadowTransforms[i], shadowProj, glm::vec4(light.Parent->Position, 1.0), true, moved });
+            requests.push_back({ light.View + i, size, pixels });
         }
-        frame.CommandBuffer->EndMarker();
+        light.Cached = true;
+        light.CachedPosition = light.Parent->Position;
     }
 
-    // Point shadows
-    {
-        frame.CommandBuffer->BeginMarker("Point Shadows");
-        frame.CommandBuffer->SetGraphicsPipeline(mPointPipeline);
-        for (auto& light : mPointLightShadows) {
-            float aspect = (float)POINT_LIGHT_SHADOW_DIMENSION / (float)POINT_LIGHT_SHADOW_DIMENSION;
-            float nearPlane = 1.0f;
-            float farPlane = 25.0f;
-            glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), aspect, nearPlane, farPlane); 
-
-            Vector<glm::mat4> shadowTransforms;
-            shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-            shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-            shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0, 1.0, 0.0), glm::vec3(0.0, 0.0,  1.0)));
-            shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0,-1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
-            shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
-            shadowTransforms.push_back(glm::lookAt(light.Parent->Position, light.Parent->Position + glm::vec3( 0.0, 0.0,-1.0), glm::vec3(0.0, -1.0, 0.0)));
-
-            for (int i = 0; i < 6; i++) {
-                frame.CommandBuffer->Barrier(light.ShadowMap, ResourceLayout::DepthWrite);
-                frame.CommandBuffer->SetRenderTargets({}, light.DepthViews[i]);
-                frame.CommandBuffer->ClearDepth(light.DepthViews[i]);
-                frame.CommandBuffer->SetViewport(0, 0, POINT_LIGHT_SHADOW_DIMENSION, POINT_LIGHT_SHADOW_DIMENSION);
-                frame.CommandBuffer->SetTopology(Topology::TriangleList);
-                std::function<void(Frame frame, GLTFNode*, GLTF* model, glm::mat4 transform)> drawNode = [&](Frame frame, GLTFNode* node, GLTF* model, glm::mat4 transform) {
-                    if (!node) {
-                        return;
-                    }
-
-                    glm::mat4 globalTransform = transform * node->Transform;
-                    for (GLTFPrimitive primitive : node->Primitives) {
-                        if (!Camera::IsBoxInFrustum(shadowProj * shadowTransforms[i], primitive.AABB, globalTransform))
-                            continue;
-
-                        struct PushConstants {
-                            glm::mat4 transform;
-                            glm::mat4 view;
-                            glm::mat4 proj;
-                            glm::vec4 lightPos;
-                        } Constants = {
-                            globalTransform,
-                            shadowTransforms[i],
-                            shadowProj,
-                            glm::vec4(light.Parent->Position, 1.0)
-                        };
-                        frame.CommandBuffer->GraphicsPushConstants(&Constants, sizeof(Constants), 0);
-                        frame.CommandBuffer->SetVertexBuffer(primitive.VertexBuffer);
-                        frame.CommandBuffer->SetIndexBuffer(primitive.IndexBuffer);
-                        frame.CommandBuffer->DrawIndexed(primitive.IndexCount);
-                    }
-
-                    if (!node->Children.empty()) {
-                        for (GLTFNode* child : node->Children) {
-                            drawNode(frame, child, model, globalTransform);
-                        }
-                    }
-                };
-                for (auto& model : scene.Models) {
-                    drawNode(frame, model->Model.Root, &model->Model, glm::mat4(1.0f));
-                }
-
-                frame.CommandBuffer->Barrier(light.ShadowMap, ResourceLayout::Shader);
-            }
+    for (auto& light : mSpotLightShadows) {
+        float nearPlane = 1.0f;
+        float farPlane = 25.0f;
+
+        glm::mat4 shadowProj = glm::perspective(light.Parent->OuterRadius * 2, 1.0f, nearPlane, farPlane); 
+        glm::mat4 shadowView = glm::lookAt(light.Parent->Position, light.Parent->Position + light.Parent->Direction, glm::vec3(0.0f, 1.0f, 0.0f));
+        light.Parent->LightView = shadowView;
+        light.Parent->LightProj = shadowProj;
+
+        // Bounded by the sphere around the middle of the cone
+        float radius = SPOT_LIGHT_RANGE * 0.5f;
+        float pixels = coverage(light.Parent->Position + light.Parent->Direction * radius, radius);
+        UInt32 size = (UInt32)std::min(pixels, (float)SPOT_LIGHT_SHADOW_DIMENSION);
+
+        bool moved = !mCacheShadows || !light.Cached || light.CachedPosition != light.Parent->Position || light.CachedDirection != light.Parent->Direction || light.CachedAngle != light.Parent->OuterRadius;
+        atlasViews.push_back({ "Spot Light", light.View, mSpotPipeline, shadowView, shadowProj, glm::vec4(0.0f), false, moved });
+        requests.push_back({ light.View, size, pixels });
+
+        light.Cached = true;
+        light.CachedPosition = light.Parent->Position;
+        light.CachedDirection = light.Parent->Direction;
+        light.CachedAngle = light.Parent->OuterRadius;
+    }
+
+    mAtlas.Update(requests, mAtlasResizesPerFrame);
+
+    bool copy = false;
+    bool cacheWritten = false;
+    for (const AtlasView& view : atlasViews) {
+        glm::mat4 lightMatrix = view.Proj * view.View;
+        const ShadowAtlas::Tile* tile = mAtlas.Get(view.Slot);
+        mAtlasViews[view.Slot].ViewProj = lightMatrix;
+        if (!tile) {
+            mAtlasViews[view.Slot].Rect = glm::vec4(0.0f);
+            mHadDynamic[view.Slot] = false;
+            continue;
+        }
+        mAtlasViews[view.Slot].Rect = glm::vec4(tile->X, tile->Y, tile->Size, tile->Size) / atlasSize;
+
+        // Whatever was in a fresh tile belongs to another view
+        bool stale = view.Moved || tile->Fresh || invalidated(lightMatrix);
+        if (stale) {
+            ShadowView cached = { view.Name, view.Pipeline, mAtlasCacheDSV, tile->Size, tile->Size, view.View, view.Proj, view.LightPosition, view.Point, ShadowCasters::Static };
+            cached.X = tile->X;
+            cached.Y = tile->Y;
+            views.push_back(cached);
+            cacheWritten = true;
+        }
+
+        // Last frame's dynamic casters have to be wiped too
+        bool dynamic = hasDynamic(lightMatrix);
+        copy = copy || stale || dynamic || mHadDynamic[view.Slot];
+        mHadDynamic[view.Slot] = dynamic;
+        if (dynamic) {
+            ShadowView composite = { view.Name + " Dynamic", view.Pipeline, atlas->DepthTargetView, tile->Size, tile->Size, view.View, view.Proj, view.LightPosition, view.Point, ShadowCasters::Dynamic, false };
+            composite.X = tile->X;
+            composite.Y = tile->Y;
+            composites.push_back(composite);
         }
-        frame.CommandBuffer->EndMarker();
+        if (!stale && !dynamic) {
+            reused++;
+        }
+    }
+    if (cacheWritten) {
+        frame.CommandBuffer->Barrier(mAtlasCache, ResourceLayout::DepthWrite);
+    }
+    if (mAtlasViewCount) {
+        ::Ref<RenderPassIO> viewRingBuffer = PassManager::Get("ShadowViewRingBuffer");
+        viewRingBuffer->RingBuffer[frame.FrameIndex]->CopyMapped(mAtlasViews.data(), sizeof(ShadowAtlasView) * mAtlasViewCount);
     }
 
-    // Spot shadows
-    {
-        frame.CommandBuffer->BeginMarker("Spot Shadows");
-        frame.CommandBuffer->SetGraphicsPipeline(mSpotPipeline);
-        for (auto& light : mSpotLightShadows) {
-            float aspect = (float)SPOT_LIGHT_SHADOW_DIMENSION / (float)SPOT_LIGHT_SHADOW_DIMENSION;
-            float nearPlane = 1.0f;
-            float farPlane = 25.0f;
-
-            glm::mat4 shadowProj = glm::perspective(light.Parent->OuterRadius * 2, aspect, nearPlane, farPlane); 
-            glm::mat4 shadowView = glm::lookAt(light.Parent->Position, light.Parent->Position + light.Parent->Direction, glm::vec3(0.0f, 1.0f, 0.0f));
-            light.Parent->LightView = shadowView;
-            light.Parent->LightProj = shadowProj;
-
-            frame.CommandBuffer->Barrier(light.ShadowMap, ResourceLayout::DepthWrite);
-            frame.CommandBuffer->SetRenderTargets({}, light.DSV);
-            frame.CommandBuffer->ClearDepth(light.DSV);
-            frame.CommandBuffer->SetViewport(0, 0, SPOT_LIGHT_SHADOW_DIMENSION, SPOT_LIGHT_SHADOW_DIMENSION);
-            frame.CommandBuffer->SetTopology(Topology::TriangleList);
-            std::function<void(Frame frame, GLTFNode*, GLTF* model, glm::mat4 transform)> drawNode = [&](Frame frame, GLTFNode* node, GLTF* model, glm::mat4 transform) {
-                if (!node) {
-                    return;
-                }
-
-                glm::mat4 globalTransform = transform * node->Transform;
-                for (GLTFPrimitive primitive : node->Primitives) {
-                    if (!Camera::IsBoxInFrustum(shadowProj * shadowView, primitive.AABB, globalTransform))
-                        continue;
-                    struct PushConstants {
-                        glm::mat4 transform;
-                        glm::mat4 view;
-                        glm::mat4 proj;
-                    } Constants = {
-                        globalTransform,
-                        shadowView,
-                        shadowProj
-                    };
-                    frame.CommandBuffer->GraphicsPushConstants(&Constants, sizeof(Constants), 0);
-                    frame.CommandBuffer->SetVertexBuffer(primitive.VertexBuffer);
-                    frame.CommandBuffer->SetIndexBuffer(primitive.IndexBuffer);
-                    frame.CommandBuffer->DrawIndexed(primitive.IndexCount);
-                }
-                if (!node->Children.empty()) {
-                    for (GLTFNode* child : node->Children) {
-                        drawNode(frame, child, model, globalTransform);
-                    }
-                }
-            };
-            for (auto& model : scene.Models) {
-                drawNode(frame, model->Model.Root, &model->Model, glm::mat4(1.0f));
+    RecordViews(frame, scene, "Shadows", views);
+    float recordTime = mRecordTime;
+
+    // Depth textures can only be copied whole, so the cache goes over the entire atlas and every tile with dynamic casters
+    // is drawn again
+    if (copy) {
+        frame.CommandBuffer->Barrier(mAtlasCache, ResourceLayout::CopySource);
+        frame.CommandBuffer->Barrier(atlas->Texture, ResourceLayout::CopyDest);
+        frame.CommandBuffer->CopyTextureToTexture(atlas->Texture, mAtlasCache);
+        frame.CommandBuffer->Barrier(atlas->Texture, ResourceLayout::DepthWrite);
+    }
+
+    if (!composites.empty()) {
+        RecordViews(frame, scene, "Dynamic Shadows", composites);
+        mRecordTime += recordTime;
+    }
+
+    mViewCount = views.size() + composites.size();
+    mReusedCount = reused;
+    Statistics::Get().ShadowViewsRendered += mViewCount;
+    Statistics::Get().ShadowViewsReused += mReusedCount;
+}
+
+void Shadows::RecordViews(const Frame& frame, Scene& scene, const String& name, const Vector<ShadowView>& views)
+{
+    // Workers only touch their own views, every shared barrier stays on this thread
+    RecordParallel(frame, name, views.size(), [&](const Frame& frame, UInt32 begin, UInt32 end) {
+        GraphicsPipeline::Ref bound = nullptr;
+        frame.CommandBuffer->SetTopology(Topology::TriangleList);
+        for (UInt32 i = begin; i < end; i++) {
+            if (views[i].Pipeline != bound) {
+                frame.CommandBuffer->SetGraphicsPipeline(views[i].Pipeline);
+                bound = views[i].Pipeline;
             }
-            frame.CommandBuffer->Barrier(light.ShadowMap, ResourceLayout::Shader);
+            RenderView(frame, scene, views[i]);
         }
-        frame.CommandBuffer->EndMarker();
-    }
+    });
+}
 
+void Shadows::RenderView(const Frame& frame, Scene& scene, const ShadowView& view)
+{
+    const SceneSnapshot& snapshot = scene.Current();
+
+    frame.CommandBuffer->BeginMarker(view.Name);
+    frame.CommandBuffer->SetRenderTargets({}, view.Target);
+    if (view.Clear) {
+        frame.CommandBuffer->ClearDepth(view.Target, view.X, view.Y, view.Width, view.Height);
+    }
+    frame.CommandBuffer->SetViewport(view.X, view.Y, view.Width, view.Height);
+
+    // Cascades and spot lights don't take the light position
+    UInt32 constantsSize = view.Point ? sizeof(glm::mat4) * 3 + sizeof(glm::vec4) : sizeof(glm::mat4) * 3;
+    glm::mat4 lightMatrix = view.LightProj * view.LightView;
+    UInt32 count = view.Casters == ShadowCasters::Dynamic ? snapshot.Dynamic.size() : snapshot.Instances.size();
+    CascadeCasters casters;
+    for (UInt32 i = 0; i < count; i++) {
+        const SceneInstance& instance = view.Casters == ShadowCasters::Dynamic ? snapshot.Instances[snapshot.Dynamic[i]] : snapshot.Instances[i];
+        if (view.Casters == ShadowCasters::Static && instance.Dynamic)
+            continue;
+
+        const GLTFPrimitive& primitive = *instance.Primitive;
+        if (!Camera::IsBoxInFrustum(lightMatrix, primitive.AABB, instance.Transform))
+            continue;
+        casters.InFrustum++;
+        if (view.CasterVolume && !IsBoxInVolume(*view.CasterVolume, instance.Bounds))
+            continue;
+        casters.Drawn++;
+
+        struct PushConstants {
+            glm::mat4 transform;
+            glm::mat4 view;
+            glm::mat4 proj;
+            glm::vec4 lightPos;
+        } Constants = {
+            instance.Transform,
+            view.LightView,
+            view.LightProj,
+            view.LightPosition
+        };
+        frame.CommandBuffer->GraphicsPushConstants(&Constants, constantsSize, 0);
+        frame.CommandBuffer->SetVertexBuffer(primitive.VertexBuffer);
+        frame.CommandBuffer->SetIndexBuffer(primitive.IndexBuffer);
+        frame.CommandBuffer->DrawIndexed(primitive.IndexCount);
+    }
     frame.CommandBuffer->EndMarker();
+
+    // A cascade is only ever recorded by one worker
+    if (view.Cascade >= 0) {
+        mCascadeCasters[view.Cascade] = casters;
+    }
 }
 
 void Shadows::UI(const Frame& frame)
@@ -332,9 +512,38 @@ void Shadows::UI(const Frame& frame)
     if (ImGui::TreeNodeEx("Shadows", ImGuiTreeNodeFlags_Framed)) {
         ImGui::SliderFloat("Shadow Split Lambda", &mShadowSplitLambda, 0.0f, 1.0f, "%.2f");
         ImGui::Checkbox("Freeze Cascades", &mFreezeCascades);
+        ImGui::Checkbox("Fit Cascades To Receivers", &mTightCascades);
+        ImGui::Checkbox("Cull Casters Outside Receivers", &mCullCasters);
+        bool rescheduled = ImGui::Checkbox("Schedule Cascades", &mScheduleCascades);
+        rescheduled |= ImGui::SliderFloat("Cascade Guard Band", &mCascadeGuardBand, 0.0f, 0.5f, "%.2f");
+        if (rescheduled) {
+            mCascadeWindows = {};
+        }
+        ImGui::Checkbox("Cache Static Shadows", &mCacheShadows);
+        ImGui::Text("Recording: %.2f ms for %u views (%zu point, %zu spot lights) on %u threads", mRecordTime, mViewCount, mPointLightShadows.size(), mSpotLightShadows.size(), mRecordThreads);
+        ImGui::Text("Cached: %u views reused", mReusedCount);
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+            ImGui::Text("Cascade %d: %u casters in frustum, %u drawn, every %u frames, %s", i, mCascadeCasters[i].InFrustum, mCascadeCasters[i].Drawn,
+                        mScheduleCascades ? mCascadeSchedule.GetPeriod(i) : 1, mCascadeUpdates[i] ? "rendered" : "cached");
+        }
+
+        // What the cached cascades save shows up in the pass time
+        for (const TimingTree::Node& node : mRHI->GetGPUTimings().GetNodes()) {
+            if (node.Name == "Shadows") {
+                ImGui::Text("GPU: %.3f ms last, %.3f ms average with %u cascades rendered", node.History.GetLast(), node.History.GetAverage(), mCascadesRendered);
+                break;
+            }
+        }
+        if (ImGui::TreeNodeEx("Shadow Atlas", ImGuiTreeNodeFlags_Framed)) {
+            const ShadowAtlas::Stats& stats = mAtlas.GetStats();
+            ImGui::SliderInt("Resizes Per Frame", &mAtlasResizesPerFrame, 1, 64);
+            ImGui::Text("Usage: %.1f%%, fragmentation: %.1f%%", stats.Usage * 100.0f, stats.Fragmentation * 100.0f);
+            ImGui::Text("Views: %u (%u placed, %u shrunk, %u dropped)", stats.Views, stats.Placed, stats.Shrunk, stats.Dropped);
+            ImGui::Image((ImTextureID)PassManager::Get("ShadowAtlas")->ShaderResourceView->GetDescriptor().GPU.ptr, ImVec2(256, 256));
+            ImGui::TreePop();
+        }
         for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
             if (ImGui::TreeNodeEx(("Cascade " + std::to_string(i)).data(), ImGuiTreeNodeFlags_Framed)) {
-                frame.CommandBuffer->Barrier(cascades[i]->Texture, ResourceLayout::Shader);
                 ImGui::Image((ImTextureID)cascades[i]->ShaderResourceView->GetDescriptor().GPU.ptr, ImVec2(128, 128));
                 ImGui::TreePop();
             }
@@ -343,9 +552,31 @@ void Shadows::UI(const Frame& frame)
     }
 }
 
-void Shadows::UpdateCascades(const Scene& scene)
+bool Shadows::IsCascadeDirty(const SceneSnapshot& snapshot, UInt32 cascade) const
+{
+    // Cached depth can't follow dynamic casters, and goes stale when a static one leaves
+    for (UInt32 index : snapshot.Dynamic) {
+        if (IsBoxInVolume(mCasterVolumes[cascade], snapshot.Instances[index].Bounds)) {
+            return true;
+        }
+    }
+    for (const Box& box : snapshot.ShadowInvalidations) {
+        if (IsBoxInVolume(mCasterVolumes[cascade], box)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Shadows::UpdateCascades(const SceneSnapshot& snapshot)
 {
     UInt32 cascadeSize = PassManager::Get("ShadowCascade0")->Desc.Width;
+
+    // Cached cascades only hold for the sun they were rendered with
+    bool sunMoved = snapshot.Sun.Direction != mCascadeSunDirection;
+    mCascadeSunDirection = snapshot.Sun.Direction;
+    mCascadeUpdates = {};
+    mCascadeFrame++;
     Vector<float> splits(SHADOW_CASCADE_COUNT + 1);
 
     // Precompute cascade splits using logarithmic split
@@ -361,7 +592,7 @@ void Shadows::UpdateCascades(const Scene& scene)
 
     for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i) {
         // Get frustum corners for the cascade in view space
-        Vector<glm::vec4> corners = scene.Camera.CornersForCascade(splits[i], splits[i + 1]);
+        Vector<glm::vec4> corners = snapshot.Camera.CornersForCascade(splits[i], splits[i + 1]);
 
         // Calculate center
         glm::vec3 center(0.0f);
@@ -372,7 +603,7 @@ void Shadows::UpdateCascades(const Scene& scene)
 
         // Adjust light's up vector
         glm::vec3 up(0.0f, 1.0f, 0.0f);
-        if (glm::abs(glm::dot(scene.Sun.Direction, up)) > 0.999f) {
+        if (glm::abs(glm::dot(snapshot.Sun.Direction, up)) > 0.999f) {
             up = glm::vec3(1.0f, 0.0f, 0.0f);
         }
 
@@ -387,9 +618,76 @@ void Shadows::UpdateCascades(const Scene& scene)
         maxBounds = glm::vec3(sphereRadius);
         minBounds = -maxBounds;
 
+        // Receivers are whatever part of the scene is inside the slice. Padded so a flat floor still has a volume.
+        Array<glm::vec3, 8> sliceCorners;
+        Box slice = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+        for (int j = 0; j < 8; j++) {
+            sliceCorners[j] = glm::vec3(corners[j]);
+            slice.Min = glm::min(slice.Min, sliceCorners[j]);
+            slice.Max = glm::max(slice.Max, sliceCorners[j]);
+        }
+        Box receivers = { glm::max(slice.Min, snapshot.Bounds.Min) - 0.01f, glm::min(slice.Max, snapshot.Bounds.Max) + 0.01f };
+        bool hasReceivers = receivers.Min.x < receivers.Max.x && receivers.Min.y < receivers.Max.y && receivers.Min.z < receivers.Max.z;
+        Array<glm::vec3, 8> receiverCorners = GetBoxCorners(receivers.Min, receivers.Max, glm::mat4(1.0f));
+
+        mCascades[i].Split = splits[i + 1];
+        if (mTightCascades && hasReceivers) {
+            // Anchored at the world origin, so snapping to texels in light space snaps to a grid that doesn't move
+            glm::mat4 lightView = glm::lookAt(-snapshot.Sun.Direction, glm::vec3(0.0f), up);
+
+            glm::vec3 sliceMin(FLT_MAX), sliceMax(-FLT_MAX);
+            glm::vec3 receiverMin(FLT_MAX), receiverMax(-FLT_MAX);
+            for (int j = 0; j < 8; j++) {
+                glm::vec3 slicePoint = glm::vec3(lightView * glm::vec4(sliceCorners[j], 1.0f));
+                glm::vec3 receiverPoint = glm::vec3(lightView * glm::vec4(receiverCorners[j], 1.0f));
+                sliceMin = glm::min(sliceMin, slicePoint);
+                sliceMax = glm::max(sliceMax, slicePoint);
+                receiverMin = glm::min(receiverMin, receiverPoint);
+                receiverMax = glm::max(receiverMax, receiverPoint);
+            }
+            glm::vec3 fitMin = glm::max(sliceMin, receiverMin);
+            glm::vec3 fitMax = glm::min(sliceMax, receiverMax);
+
+            // Off schedule, the cascade keeps the depth and matrices it has while they still cover the receivers
+            bool due = !mScheduleCascades || sunMoved || mCascadeSchedule.IsDue(i, mCascadeFrame) || IsCascadeDirty(snapshot, i);
+            if (!due && CascadeSchedule::Covers(mCascadeWindows[i], fitMin, fitMax, sphereRadius)) {
+                continue;
+            }
+
+            // Depth starts at the receivers, casters in front of them get clamped to the near plane. It keeps the sphere's
+            // range so the bias in the shader still means the same thing.
+            CascadeSchedule::Window window = CascadeSchedule::Fit(fitMin, fitMax, sphereRadius, cascadeSize, mScheduleCascades ? mCascadeGuardBand : 0.0f);
+            mCascadeWindows[i] = window;
+            mCascadeUpdates[i] = true;
+            mCascades[i].View = lightView;
+            mCascades[i].Proj = glm::ortho(window.Origin.x, window.Origin.x + window.Extent, window.Origin.y, window.Origin.y + window.Extent, window.Near, window.Far);
+
+            // Cached depth gets sampled for anything in the window later on, so the casters for all of it go in
+            mCasterVolumes[i].clear();
+            if (mScheduleCascades) {
+                glm::mat4 toWorld = glm::inverse(lightView);
+                glm::vec3 windowMin = glm::vec3(window.Origin.x, window.Origin.y, -window.Far);
+                glm::vec3 windowMax = glm::vec3(window.Origin.x + window.Extent, window.Origin.y + window.Extent, -window.Near);
+                AddCasterPlanes(mCasterVolumes[i], GetBoxCorners(windowMin, windowMax, toWorld), snapshot.Sun.Direction);
+                AddCasterPlanes(mCasterVolumes[i], GetBoxCorners(snapshot.Bounds.Min, snapshot.Bounds.Max, glm::mat4(1.0f)), snapshot.Sun.Direction);
+            } else {
+                AddCasterPlanes(mCasterVolumes[i], sliceCorners, snapshot.Sun.Direction);
+                AddCasterPlanes(mCasterVolumes[i], receiverCorners, snapshot.Sun.Direction);
+            }
+            continue;
+        }
+
+        mCascadeWindows[i] = {};
+        mCascadeUpdates[i] = true;
+        mCasterVolumes[i].clear();
+        if (hasReceivers) {
+            AddCasterPlanes(mCasterVolumes[i], sliceCorners, snapshot.Sun.Direction);
+            AddCasterPlanes(mCasterVolumes[i], receiverCorners, snapshot.Sun.Direction);
+        }
+
         // Get extents and create view matrix
         glm::vec3 cascadeExtents = maxBounds - minBounds;
-        glm::vec3 shadowCameraPos = center - scene.Sun.Direction;
+        glm::vec3 shadowCameraPos = center - snapshot.Sun.Direction;
 
         glm::mat4 lightView = glm::lookAt(shadowCameraPos, center, up);
         glm::mat4 lightProjection = glm::ortho(
@@ -417,7 +715,6 @@ void Shadows::UpdateCascades(const Scene& scene)
         }
 
         // Store results
-        mCascades[i].Split = splits[i + 1];
         mCascades[i].View = lightView;
         mCascades[i].Proj = lightProjection;
     }
@@ -6,10 +6,15 @@
 #pragma once
 
 #include <Renderer/RenderPass.hpp>
+#include <Renderer/ShadowAtlas.hpp>
+#include <Renderer/CascadeSchedule.hpp>
 
+// Largest tiles a point light face and a spot light can get in the atlas
 constexpr int POINT_LIGHT_SHADOW_DIMENSION = 1024;
 constexpr int SPOT_LIGHT_SHADOW_DIMENSION = 2048;
 constexpr int SHADOW_CASCADE_COUNT = 4;
+// Matches Shadow.hlsl
+constexpr int MAX_SHADOW_VIEWS = 512;
 
 struct Cascade
 {
@@ -21,22 +26,74 @@ struct Cascade
     glm::mat4 Proj;
 };
 
+// Casters of a cascade before and after culling against its receivers
+struct CascadeCasters
+{
+    UInt32 InFrustum = 0;
+    UInt32 Drawn = 0;
+};
+
+struct ShadowAtlasView
+{
+    glm::mat4 ViewProj;
+    // Offset in xy, scale in zw, in atlas UVs. The scale is zero when the view didn't fit
+    glm::vec4 Rect;
+};
+
+// Point and spot lights render into tiles of the shadow atlas. The cache atlas has the same layout and holds static casters
+// only. It's copied over the shadow atlas whenever dynamic casters have to go on top, or to wipe the ones from last frame, and
+// a tile is only redrawn when its light moves, it gets a new place in the atlas or a static caster it saw goes away.
 struct PointLightShadow
 {
     PointLight* Parent;
-    Texture::Ref ShadowMap;
+    // First of six, also their atlas keys
+    UInt32 View;
 
-    View::Ref SRV;
-    Array<View::Ref, 6> DepthViews;
+    bool Cached = false;
+    glm::vec3 CachedPosition = glm::vec3(0.0f);
 };
 
 struct SpotLightShadow
 {
     SpotLight* Parent;
-    Texture::Ref ShadowMap;
-    
-    View::Ref SRV;
-    View::Ref DSV;
+    UInt32 View;
+
+    bool Cached = false;
+    glm::vec3 CachedPosition = glm::vec3(0.0f);
+    glm::vec3 CachedDirection = glm::vec3(0.0f);
+    float CachedAngle = 0.0f;
+};
+
+// Which instances a view draws
+enum class ShadowCasters
+{
+    All,
+    Static,
+    Dynamic
+};
+
+struct ShadowView
+{
+    String Name;
+    GraphicsPipeline::Ref Pipeline;
+    View::Ref Target;
+    UInt32 Width;
+    UInt32 Height;
+
+    glm::mat4 LightView;
+    glm::mat4 LightProj;
+    glm::vec4 LightPosition = glm::vec4(0.0f);
+    bool Point = false;
+    ShadowCasters Casters = ShadowCasters::All;
+    // Dynamic casters draw over what the cache left in the target
+    bool Clear = true;
+    // Where the view sits in its target
+    UInt32 X = 0;
+    UInt32 Y = 0;
+    // Casters outside it can't shadow anything the camera sees
+    const Vector<Plane>* CasterVolume = nullptr;
+    // Casters get counted into mCascadeCasters
+    Int32 Cascade = -1;
 };
 
 class Shadows : public RenderPass
@@ -45,21 +102,51 @@ public:
     Shadows(RHI::Ref rhi);
     ~Shadows() = default;
 
+    void Declare(RenderGraph& graph) override;
     void Bake(Scene& scene) override;
     void Render(const Frame& frame, Scene& scene) override;
     void UI(const Frame& frame) override;
 private:
-    void UpdateCascades(const Scene& scene);
+    void UpdateCascades(const SceneSnapshot& snapshot);
+    bool IsCascadeDirty(const SceneSnapshot& snapshot, UInt32 cascade) const;
+    void RenderView(const Frame& frame, Scene& scene, const ShadowView& view);
+    void RecordViews(const Frame& frame, Scene& scene, const String& name, const Vector<ShadowView>& views);
 
     float mShadowSplitLambda = 0.95f;
     bool mFreezeCascades = false;
+    bool mCacheShadows = true;
+    bool mTightCascades = true;
+    bool mCullCasters = true;
+    bool mScheduleCascades = true;
+    float mCascadeGuardBand = 0.1f;
 
     GraphicsPipeline::Ref mCascadePipeline = nullptr;
     Array<Cascade, SHADOW_CASCADE_COUNT> mCascades;
+    Array<Vector<Plane>, SHADOW_CASCADE_COUNT> mCasterVolumes;
+    Array<CascadeCasters, SHADOW_CASCADE_COUNT> mCascadeCasters;
+
+    // Far cascades render less often and keep their depth in between, see CascadeSchedule
+    CascadeSchedule mCascadeSchedule = CascadeSchedule(SHADOW_CASCADE_COUNT);
+    Array<CascadeSchedule::Window, SHADOW_CASCADE_COUNT> mCascadeWindows;
+    Array<bool, SHADOW_CASCADE_COUNT> mCascadeUpdates = {};
+    glm::vec3 mCascadeSunDirection = glm::vec3(0.0f);
+    UInt64 mCascadeFrame = 0;
+    UInt32 mCascadesRendered = 0;
 
     Vector<SpotLightShadow> mSpotLightShadows;
     GraphicsPipeline::Ref mSpotPipeline = nullptr;
 
     Vector<PointLightShadow> mPointLightShadows;
     GraphicsPipeline::Ref mPointPipeline = nullptr;
+
+    ShadowAtlas mAtlas;
+    Texture::Ref mAtlasCache = nullptr;
+    View::Ref mAtlasCacheDSV = nullptr;
+    Array<ShadowAtlasView, MAX_SHADOW_VIEWS> mAtlasViews = {};
+    Array<bool, MAX_SHADOW_VIEWS> mHadDynamic = {};
+    UInt32 mAtlasViewCount = 0;
+    int mAtlasResizesPerFrame = 8;
+
+    UInt32 mViewCount = 0;
+    UInt32 mReusedCount = 0;
 };
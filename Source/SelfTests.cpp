@@ -0,0 +1,55 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:37:05
+//
+
+#include <SelfTests.hpp>
+#include <Core/Logger.hpp>
+#include <Core/TimingTree.hpp>
+#include <Core/Jobs.hpp>
+
+#include <RHI/CommandStream.hpp>
+#include <RHI/PipelineCache.hpp>
+
+#include <Renderer/RenderGraph.hpp>
+#include <Renderer/ShadowAtlas.hpp>
+#include <Renderer/CascadeSchedule.hpp>
+
+#include <Physics/SceneBVH.hpp>
+#include <Physics/OcclusionBaker.hpp>
+
+bool SelfTests::Run()
+{
+    struct Test
+    {
+        const char* Name;
+        bool (*Function)();
+    };
+    const Test tests[] = {
+        { "TimingTree", TimingTree::SelfTest },
+        { "Jobs", Jobs::SelfTest },
+        { "CommandStream", CommandStream::SelfTest },
+        { "PipelineCache", PipelineCache::SelfTest },
+        { "RenderGraph", RenderGraph::SelfTest },
+        { "ShadowAtlas", ShadowAtlas::SelfTest },
+        { "CascadeSchedule", CascadeSchedule::SelfTest },
+        { "SceneBVH", SceneBVH::SelfTest },
+        { "OcclusionBaker", OcclusionBaker::SelfTest }
+    };
+
+    UInt32 failed = 0;
+    for (const Test& test : tests) {
+        if (!test.Function()) {
+            LOG_ERROR("[SelfTests] {0} failed", test.Name);
+            failed++;
+        }
+    }
+
+    UInt32 count = sizeof(tests) / sizeof(tests[0]);
+    if (failed) {
+        LOG_ERROR("[SelfTests] {0} of {1} tests failed", failed, count);
+    } else {
+        LOG_INFO("[SelfTests] All {0} tests passed", count);
+    }
+    return failed == 0;
+}
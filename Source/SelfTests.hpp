@@ -0,0 +1,16 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:36:52
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+
+// Every SelfTest() in one place. None of them need a window or a GPU, so the BeachedTests target runs them headless too.
+class SelfTests
+{
+public:
+    // Keeps going past failures, true when every test passed
+    static bool Run();
+};
@@ -12,6 +12,7 @@ struct Settings
     // Culling
     bool FrustumCull = true;
     bool FreezeFrustum = false;
+    bool CullUnusedPasses = true;
 
     // Debug
     bool DebugDrawSceneOOB = false;
@@ -21,6 +22,14 @@ struct Settings
 
     // Lighting
     bool SceneUseSun = false;
+    bool BakedOcclusion = true;
+
+    // Shaders
+    bool PrecompileAllPermutations = false;
+
+    // Threading
+    int RecordingThreads = 8;
+    bool PipelineFrames = true;
     
     // Composite
     float Gamma = 2.2f;
@@ -4,13 +4,21 @@
 //
 
 #include <Statistics.hpp>
-#include <Windows.h>
-#include <Psapi.h>
+#include <Core/Logger.hpp>
+
+#if defined(_WIN32)
+    #include <Windows.h>
+    #include <Psapi.h>
+#else
+    #include <unistd.h>
+#endif
+#include <fstream>
 
 void Statistics::Update()
 {
     Statistics& stats = Get();
 
+#if defined(_WIN32)
     // Ram
     {
         HANDLE hProcess = GetCurrentProcess();
@@ -32,4 +40,159 @@ void Statistics::Update()
 
         stats.Battery = status.BatteryLifePercent;
     }
+#else
+    // Ram, statm is in pages and the second field is what's resident
+    {
+        UInt64 pageSize = sysconf(_SC_PAGESIZE);
+        UInt64 pages = 0;
+        UInt64 resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        if (statm >> pages >> resident) {
+            stats.UsedRAM = resident * pageSize;
+        }
+        stats.MaxRAM = UInt64(sysconf(_SC_PHYS_PAGES)) * pageSize;
+    }
+
+    // Battery, machines without one keep the last value
+    {
+        std::ifstream capacity("/sys/class/power_supply/BAT0/capacity");
+        int battery = 0;
+        if (capacity >> battery) {
+            stats.Battery = battery;
+        }
+    }
+#endif
+}
+
+void Statistics::EndFrame(float cpuTime, float gpuTime)
+{
+    Statistics& stats = Get();
+
+    FrameRecord record;
+    record.Frame = stats.FrameCount++;
+    record.CPUTime = cpuTime;
+    record.GPUTime = gpuTime;
+    record.DrawCalls = stats.DrawCallCount;
+    record.Dispatches = stats.DispatchCount;
+    record.Triangles = stats.TriangleCount;
+    record.Barriers = stats.BarrierCount;
+    record.Copies = stats.CopyCount;
+    record.UploadBytes = stats.UploadBytes;
+
+    // Against the frames before it, and only once there's enough of them to mean something
+    if (stats.CPUTimes.GetCount() >= 30) {
+        float median = stats.CPUTimes.GetPercentile(50.0f);
+        if (cpuTime > median * stats.HitchFactor && cpuTime > median + stats.HitchMargin) {
+            record.Hitch = true;
+            stats.HitchCount++;
+            stats.LastHitch = record.Frame;
+        }
+    }
+
+    stats.CPUTimes.Push(cpuTime);
+    stats.GPUTimes.Push(gpuTime);
+
+    stats.mRecords[stats.mRecordHead] = record;
+    stats.mRecordHead = (stats.mRecordHead + 1) % HISTORY_SIZE;
+    stats.mRecordCount = std::min(stats.mRecordCount + 1, HISTORY_SIZE);
+}
+
+void Statistics::ClearHistory()
+{
+    Statistics& stats = Get();
+    stats.CPUTimes.Clear();
+    stats.GPUTimes.Clear();
+    stats.HitchCount = 0;
+    stats.LastHitch = 0;
+    stats.mRecordHead = 0;
+    stats.mRecordCount = 0;
+}
+
+Vector<Statistics::FrameRecord> Statistics::GetHistory()
+{
+    Statistics& stats = Get();
+
+    Vector<FrameRecord> records;
+    records.reserve(stats.mRecordCount);
+    UInt32 start = (stats.mRecordHead + HISTORY_SIZE - stats.mRecordCount) % HISTORY_SIZE;
+    for (UInt32 i = 0; i < stats.mRecordCount; i++) {
+        records.push_back(stats.mRecords[(start + i) % HISTORY_SIZE]);
+    }
+    return records;
+}
+
+bool Statistics::ExportCSV(const String& path)
+{
+    std::ofstream stream(path);
+    if (!stream.is_open()) {
+        LOG_ERROR("[Statistics] Failed to open {0}", path);
+        return false;
+    }
+
+    Vector<FrameRecord> records = GetHistory();
+    stream << "frame,cpu_ms,gpu_ms,draw_calls,dispatches,triangles,barriers,copies,upload_bytes,hitch\n";
+    for (const FrameRecord& record : records) {
+        stream << record.Frame << ","
+               << record.CPUTime << ","
+               << record.GPUTime << ","
+               << record.DrawCalls << ","
+               << record.Dispatches << ","
+               << record.Triangles << ","
+               << record.Barriers << ","
+               << record.Copies << ","
+               << record.UploadBytes << ","
+               << (record.Hitch ? 1 : 0) << "\n";
+    }
+
+    LOG_INFO("[Statistics] Exported {0} frames to {1}", records.size(), path);
+    return true;
+}
+
+bool Statistics::ExportJSON(const String& path)
+{
+    std::ofstream stream(path);
+    if (!stream.is_open()) {
+        LOG_ERROR("[Statistics] Failed to open {0}", path);
+        return false;
+    }
+
+    Statistics& stats = Get();
+    auto summary = [&](const char* name, const SampleHistory& history) {
+        stream << "\"" << name << "\":{"
+               << "\"mean\":" << history.GetAverage()
+               << ",\"p50\":" << history.GetPercentile(50.0f)
+               << ",\"p95\":" << history.GetPercentile(95.0f)
+               << ",\"p99\":" << history.GetPercentile(99.0f)
+               << ",\"min\":" << history.GetMin()
+               << ",\"max\":" << history.GetMax() << "}";
+    };
+
+    Vector<FrameRecord> records = GetHistory();
+    stream << "{\"summary\":{";
+    stream << "\"frames\":" << records.size() << ",\"hitches\":" << stats.HitchCount << ",";
+    summary("cpu_ms", stats.CPUTimes);
+    stream << ",";
+    summary("gpu_ms", stats.GPUTimes);
+    stream << "},\n\"frames\":[\n";
+    for (UInt32 i = 0; i < records.size(); i++) {
+        const FrameRecord& record = records[i];
+        stream << "{\"frame\":" << record.Frame
+               << ",\"cpu_ms\":" << record.CPUTime
+               << ",\"gpu_ms\":" << record.GPUTime
+               << ",\"draw_calls\":" << record.DrawCalls
+               << ",\"dispatches\":" << record.Dispatches
+               << ",\"triangles\":" << record.Triangles
+               << ",\"barriers\":" << record.Barriers
+               << ",\"copies\":" << record.Copies
+               << ",\"upload_bytes\":" << record.UploadBytes
+               << ",\"hitch\":" << (record.Hitch ? "true" : "false") << "}";
+        if (i + 1 < records.size()) {
+            stream << ",";
+        }
+        stream << "\n";
+    }
+    stream << "]}\n";
+
+    LOG_INFO("[Statistics] Exported {0} frames to {1}", records.size(), path);
+    return true;
 }
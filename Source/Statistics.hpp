@@ -6,15 +6,51 @@
 #pragma once
 
 #include <Core/Common.hpp>
+#include <Core/SampleHistory.hpp>
+
+#include <atomic>
 
 struct Statistics
 {
-    UInt64 InstanceCount = 0;
-    UInt64 TriangleCount = 0;
-    UInt64 CulledInstances = 0;
-    UInt64 CulledTriangles = 0;
-    UInt64 DispatchCount = 0;
-    UInt64 DrawCallCount = 0;
+    static constexpr UInt32 HISTORY_SIZE = 1024;
+
+    // What EndFrame() keeps of every frame
+    struct FrameRecord
+    {
+        UInt64 Frame = 0;
+        float CPUTime = 0.0f;
+        float GPUTime = 0.0f;
+        UInt64 DrawCalls = 0;
+        UInt64 Dispatches = 0;
+        UInt64 Triangles = 0;
+        UInt64 Barriers = 0;
+        UInt64 Copies = 0;
+        UInt64 UploadBytes = 0;
+        bool Hitch = false;
+    };
+
+    // Per frame, commands can be recorded from several threads at once
+    std::atomic<UInt64> InstanceCount = 0;
+    std::atomic<UInt64> TriangleCount = 0;
+    std::atomic<UInt64> CulledInstances = 0;
+    std::atomic<UInt64> CulledTriangles = 0;
+    std::atomic<UInt64> DispatchCount = 0;
+    std::atomic<UInt64> DrawCallCount = 0;
+    std::atomic<UInt64> BarrierCount = 0;
+    std::atomic<UInt64> BarrierCalls = 0;
+    std::atomic<UInt64> CopyCount = 0;
+    std::atomic<UInt64> UploadBytes = 0;
+    std::atomic<UInt64> ShadowViewsRendered = 0;
+    std::atomic<UInt64> ShadowViewsReused = 0;
+
+    // Per frame CPU stages in milliseconds. Simulate runs on a worker, so only the wait on it lands on the main thread.
+    float SimulateTime = 0.0f;
+    float SimulateWait = 0.0f;
+    float RecordTime = 0.0f;
+    float SubmitTime = 0.0f;
+    float GPUWait = 0.0f;
+    float PresentTime = 0.0f;
+    float CriticalPath = 0.0f;
 
     UInt64 UsedVRAM = 0;
     UInt64 MaxVRAM = 0;
@@ -24,6 +60,16 @@ struct Statistics
 
     int Battery = 0;
 
+    // Rolling frame times in milliseconds. A frame is a hitch when its CPU time goes over HitchFactor times the median
+    // and over the median plus HitchMargin, so a steady 2ms frame going to 5ms doesn't count.
+    SampleHistory CPUTimes = SampleHistory(HISTORY_SIZE);
+    SampleHistory GPUTimes = SampleHistory(HISTORY_SIZE);
+    float HitchFactor = 2.0f;
+    float HitchMargin = 4.0f;
+    UInt64 HitchCount = 0;
+    UInt64 LastHitch = 0;
+    UInt64 FrameCount = 0;
+
     static void Reset()
     {
         Statistics& stats = Get();
@@ -33,6 +79,12 @@ struct Statistics
         stats.DispatchCount = 0;
         stats.CulledInstances = 0;
         stats.CulledTriangles = 0;
+        stats.BarrierCount = 0;
+        stats.BarrierCalls = 0;
+        stats.CopyCount = 0;
+        stats.UploadBytes = 0;
+        stats.ShadowViewsRendered = 0;
+        stats.ShadowViewsReused = 0;
     }
 
     static Statistics& Get()
@@ -42,4 +94,18 @@ struct Statistics
     }
 
     static void Update();
+
+    // Closes the frame: records its timings along with the counters, before the next Reset()
+    static void EndFrame(float cpuTime, float gpuTime);
+    static void ClearHistory();
+    // Oldest first
+    static Vector<FrameRecord> GetHistory();
+
+    // The recorded frames, for regression tracking. JSON also gets the summary up top.
+    static bool ExportCSV(const String& path);
+    static bool ExportJSON(const String& path);
+private:
+    Vector<FrameRecord> mRecords = Vector<FrameRecord>(HISTORY_SIZE);
+    UInt32 mRecordHead = 0;
+    UInt32 mRecordCount = 0;
 };
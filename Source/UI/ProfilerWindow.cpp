@@ -0,0 +1,127 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 18:47:44
+//
+
+#include <UI/ProfilerWindow.hpp>
+#include <Core/Hash.hpp>
+
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+
+ProfilerWindow::Data ProfilerWindow::sData;
+
+void ProfilerWindow::Draw(bool* open)
+{
+    if (!*open) {
+        return;
+    }
+
+    ImGui::Begin("Profiler", open);
+
+    bool paused = Profiler::IsPaused();
+    if (ImGui::Checkbox("Pause", &paused)) {
+        Profiler::SetPaused(paused);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace")) {
+        Profiler::ExportChromeTrace("profile.json");
+    }
+
+    UInt32 count = Profiler::GetFrameCount();
+    if (count == 0) {
+        ImGui::End();
+        return;
+    }
+    sData.Age = std::min(sData.Age, int(count) - 1);
+
+    // Oldest on the left, like every other frame graph
+    Vector<float> times(count);
+    for (UInt32 i = 0; i < count; i++) {
+        const Profiler::FrameCapture& frame = Profiler::GetFrame(count - 1 - i);
+        times[i] = (frame.End - frame.Begin) / 1000000.0f;
+    }
+    ImGui::PlotHistogram("##Frames", times.data(), count, 0, nullptr, 0.0f, 33.3f, ImVec2(ImGui::GetContentRegionAvail().x, 60.0f));
+    ImGui::SliderInt("Frames Ago", &sData.Age, 0, count - 1);
+
+    const Profiler::FrameCapture& frame = Profiler::GetFrame(sData.Age);
+    ImGui::Text("Frame %llu: %.2f ms, %zu zones", frame.Index, (frame.End - frame.Begin) / 1000000.0f, frame.Zones.size());
+
+    if (ImGui::TreeNodeEx("Timeline", ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_DefaultOpen)) {
+        DrawTimeline(frame);
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNodeEx("Call Tree", ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_DefaultOpen)) {
+        for (UInt32 root : frame.Roots) {
+            DrawNode(frame, root);
+        }
+        ImGui::TreePop();
+    }
+    ImGui::End();
+}
+
+void ProfilerWindow::DrawTimeline(const Profiler::FrameCapture& frame)
+{
+    ImDrawList* draw = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvail().x;
+    float duration = std::max<float>(frame.End - frame.Begin, 1.0f);
+    ImVec2 mouse = ImGui::GetMousePos();
+
+    // Zones come sorted by thread, one lane each, deep enough for its deepest zone
+    float y = origin.y;
+    UInt64 i = 0;
+    while (i < frame.Zones.size()) {
+        UInt32 thread = frame.Zones[i].Thread;
+        UInt64 end = i;
+        UInt32 depth = 0;
+        while (end < frame.Zones.size() && frame.Zones[end].Thread == thread) {
+            depth = std::max(depth, frame.Zones[end].Depth);
+            end++;
+        }
+
+        draw->AddText(ImVec2(origin.x, y), IM_COL32(200, 200, 200, 255), Profiler::GetThreadName(thread).c_str());
+        y += sData.RowHeight;
+
+        for (; i < end; i++) {
+            const Profiler::Zone& zone = frame.Zones[i];
+            float x0 = origin.x + std::max(0.0f, (float(zone.Begin) - float(frame.Begin)) / duration) * width;
+            float x1 = origin.x + std::min(1.0f, (float(zone.End) - float(frame.Begin)) / duration) * width;
+            x1 = std::max(x1, x0 + 1.0f);
+            float y0 = y + zone.Depth * sData.RowHeight;
+            float y1 = y0 + sData.RowHeight - 1.0f;
+
+            UInt64 hash = HashBytes(zone.Name, strlen(zone.Name));
+            ImU32 color = IM_COL32(96 + (hash & 0x7F), 96 + ((hash >> 8) & 0x7F), 96 + ((hash >> 16) & 0x7F), 255);
+            draw->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), color);
+            if (x1 - x0 > 40.0f) {
+                draw->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+                draw->AddText(ImVec2(x0 + 2.0f, y0 + 1.0f), IM_COL32(0, 0, 0, 255), zone.Name);
+                draw->PopClipRect();
+            }
+
+            if (mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1) {
+                ImGui::SetTooltip("%s\n%.3f ms", zone.Name, (zone.End - zone.Begin) / 1000000.0f);
+            }
+        }
+        y += (depth + 1) * sData.RowHeight + 4.0f;
+    }
+
+    ImGui::Dummy(ImVec2(width, y - origin.y));
+}
+
+void ProfilerWindow::DrawNode(const Profiler::FrameCapture& frame, Int32 index)
+{
+    const Profiler::Node& node = frame.Tree[index];
+    ImGuiTreeNodeFlags flags = node.FirstChild == -1 ? ImGuiTreeNodeFlags_Leaf : ImGuiTreeNodeFlags_DefaultOpen;
+    bool open = node.Depth == 0
+        ? ImGui::TreeNodeEx((void*)(intptr_t)index, flags, "%s: %.3f ms", node.Name, node.Milliseconds)
+        : ImGui::TreeNodeEx((void*)(intptr_t)index, flags, "%s: %.3f ms (%u calls)", node.Name, node.Milliseconds, node.Calls);
+    if (open) {
+        for (Int32 child = node.FirstChild; child != -1; child = frame.Tree[child].NextSibling) {
+            DrawNode(frame, child);
+        }
+        ImGui::TreePop();
+    }
+}
@@ -0,0 +1,24 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 18:47:10
+//
+
+#pragma once
+
+#include <Core/Profiler.hpp>
+
+// Frame time graph, per-thread timeline and call tree of the profiler's captures
+class ProfilerWindow
+{
+public:
+    static void Draw(bool* open);
+private:
+    static void DrawTimeline(const Profiler::FrameCapture& frame);
+    static void DrawNode(const Profiler::FrameCapture& frame, Int32 index);
+
+    static struct Data
+    {
+        int Age = 0;
+        float RowHeight = 18.0f;
+    } sData;
+};
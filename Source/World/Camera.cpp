@@ -43,6 +43,23 @@ void Camera::Update(float dt, int width, int height)
         mPitch -= dy;
     }
 
+    UpdateMatrices(width, height);
+}
+
+void Camera::SetPose(glm::vec3 position, float yaw, float pitch, int width, int height)
+{
+    mWidth = width;
+    mHeight = height;
+    mSavedFrustum = Planes();
+
+    mPosition = position;
+    mYaw = yaw;
+    mPitch = pitch;
+    UpdateMatrices(width, height);
+}
+
+void Camera::UpdateMatrices(int width, int height)
+{
     // Calculate vectors
     mForward.x = glm::cos(glm::radians(mYaw)) * glm::cos(glm::radians(mPitch));
     mForward.y = glm::sin(glm::radians(mPitch));
@@ -202,23 +219,18 @@ Array<Plane, 6> Camera::Planes() const
 bool Camera::IsBoxOutsidePlane(const Plane& plane, const Box& box)
 {
     glm::vec3 positiveVertex = box.Min;
-    glm::vec3 negativeVertex = box.Max;
-
     if (plane.Normal.x >= 0) {
         positiveVertex.x = box.Max.x;
-        negativeVertex.x = box.Min.x;
     }
     if (plane.Normal.y >= 0) {
         positiveVertex.y = box.Max.y;
-        negativeVertex.y = box.Min.y;
     }
     if (plane.Normal.z >= 0) {
         positiveVertex.z = box.Max.z;
-        negativeVertex.z = box.Min.z;
     }
 
-    // Test the negative vertex against the plane
-    if (glm::dot(plane.Normal, negativeVertex) + plane.Distance > 0) {
+    // The planes face inwards, the box is out when even its most inside corner is behind one
+    if (glm::dot(plane.Normal, positiveVertex) + plane.Distance <= 0) {
         return true;
     }
     return false;
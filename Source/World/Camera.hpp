@@ -28,10 +28,14 @@ public:
 
     void Begin();
     void Update(float dt, int width, int height);
+    // Places the camera without going through input, for scripted paths
+    void SetPose(glm::vec3 position, float yaw, float pitch, int width, int height);
 
     glm::mat4 View() const { return mView; }
     glm::mat4 Projection() const { return mProjection; }
     glm::vec3 Position() const { return mPosition; }
+    float Yaw() const { return mYaw; }
+    float Pitch() const { return mPitch; }
     
     Vector<glm::vec4> Corners() const;
     Vector<glm::vec4> CornersForCascade(float near, float far) const;
@@ -48,6 +52,8 @@ public:
 
     void FreezeFrustum(bool freeze);
 private:
+    void UpdateMatrices(int width, int height);
+
     glm::mat4 mView = glm::mat4(1.0f);
     glm::mat4 mProjection = glm::mat4(1.0f);
     glm::vec3 mPosition = glm::vec3(0.0f, 0.0f, 1.0f);
@@ -0,0 +1,136 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:55:40
+//
+
+#include <World/CameraPath.hpp>
+#include <Core/Logger.hpp>
+
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+template<typename T>
+static T CatmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+void CameraPath::AddKey(float time, glm::vec3 position, float yaw, float pitch)
+{
+    mKeys.push_back({ time, position, yaw, pitch });
+}
+
+CameraPath::Key CameraPath::Evaluate(float time) const
+{
+    if (mKeys.empty()) {
+        return { time, glm::vec3(0.0f), -90.0f, 0.0f };
+    }
+    if (time <= mKeys.front().Time) {
+        return mKeys.front();
+    }
+    if (time >= mKeys.back().Time) {
+        return mKeys.back();
+    }
+
+    // First key strictly after the time, the segment is the one before it
+    auto next = std::upper_bound(mKeys.begin(), mKeys.end(), time, [](float t, const Key& key) { return t < key.Time; });
+    Int32 i2 = next - mKeys.begin();
+    Int32 i1 = i2 - 1;
+    Int32 i0 = std::max(i1 - 1, 0);
+    Int32 i3 = std::min<Int32>(i2 + 1, mKeys.size() - 1);
+
+    const Key& k0 = mKeys[i0];
+    const Key& k1 = mKeys[i1];
+    const Key& k2 = mKeys[i2];
+    const Key& k3 = mKeys[i3];
+
+    float span = k2.Time - k1.Time;
+    float t = span > 0.0f ? (time - k1.Time) / span : 0.0f;
+
+    Key key;
+    key.Time = time;
+    key.Position = CatmullRom(k0.Position, k1.Position, k2.Position, k3.Position, t);
+    key.Yaw = CatmullRom(k0.Yaw, k1.Yaw, k2.Yaw, k3.Yaw, t);
+    key.Pitch = glm::clamp(CatmullRom(k0.Pitch, k1.Pitch, k2.Pitch, k3.Pitch, t), -89.0f, 89.0f);
+    return key;
+}
+
+bool CameraPath::Load(const String& path)
+{
+    std::ifstream stream(path);
+    if (!stream.is_open()) {
+        LOG_ERROR("[CameraPath] Failed to open {0}", path);
+        return false;
+    }
+
+    mKeys.clear();
+    String line;
+    while (std::getline(stream, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        Key key;
+        std::istringstream fields(line);
+        if (!(fields >> key.Time >> key.Position.x >> key.Position.y >> key.Position.z >> key.Yaw >> key.Pitch)) {
+            LOG_WARN("[CameraPath] Skipping malformed line in {0}: {1}", path, line);
+            continue;
+        }
+        if (!mKeys.empty() && key.Time < mKeys.back().Time) {
+            LOG_WARN("[CameraPath] Skipping key at {0}s in {1}, it goes back in time", key.Time, path);
+            continue;
+        }
+        mKeys.push_back(key);
+    }
+
+    LOG_INFO("[CameraPath] Loaded {0} keys ({1}s) from {2}", mKeys.size(), GetDuration(), path);
+    return !mKeys.empty();
+}
+
+bool CameraPath::Save(const String& path) const
+{
+    std::ofstream stream(path);
+    if (!stream.is_open()) {
+        LOG_ERROR("[CameraPath] Failed to open {0}", path);
+        return false;
+    }
+
+    stream << "# time x y z yaw pitch\n";
+    for (const Key& key : mKeys) {
+        stream << key.Time << " " << key.Position.x << " " << key.Position.y << " " << key.Position.z << " " << key.Yaw << " " << key.Pitch << "\n";
+    }
+
+    LOG_INFO("[CameraPath] Saved {0} keys ({1}s) to {2}", mKeys.size(), GetDuration(), path);
+    return true;
+}
+
+CameraPath CameraPath::Orbit(const Box& bounds, float duration, UInt32 keys)
+{
+    glm::vec3 center = (bounds.Min + bounds.Max) * 0.5f;
+    glm::vec3 extent = (bounds.Max - bounds.Min) * 0.5f;
+    glm::vec3 target = center - glm::vec3(0.0f, extent.y * 0.5f, 0.0f);
+    keys = std::max(keys, 2u);
+
+    CameraPath path;
+    float lastYaw = 0.0f;
+    for (UInt32 i = 0; i <= keys; i++) {
+        float angle = glm::two_pi<float>() * float(i) / float(keys);
+        glm::vec3 position = target + glm::vec3(glm::cos(angle) * extent.x * 0.6f, extent.y * 0.2f, glm::sin(angle) * extent.z * 0.6f);
+        glm::vec3 direction = glm::normalize(target - position);
+
+        // Keep the yaw continuous so the spline doesn't spin the long way around
+        float yaw = glm::degrees(glm::atan(direction.z, direction.x));
+        if (i > 0) {
+            while (yaw - lastYaw > 180.0f) yaw -= 360.0f;
+            while (yaw - lastYaw < -180.0f) yaw += 360.0f;
+        }
+        lastYaw = yaw;
+
+        path.AddKey(duration * float(i) / float(keys), position, yaw, glm::degrees(glm::asin(direction.y)));
+    }
+    return path;
+}
@@ -0,0 +1,44 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 19:52:17
+//
+
+#pragma once
+
+#include <Core/Common.hpp>
+#include <Physics/Volume.hpp>
+
+#include <glm/glm.hpp>
+
+// Camera poses over time, played back through a Catmull-Rom spline. Recorded paths are plain text, one key per line:
+// time x y z yaw pitch, with # starting a comment.
+class CameraPath
+{
+public:
+    struct Key
+    {
+        float Time;
+        glm::vec3 Position;
+        float Yaw;
+        float Pitch;
+    };
+
+    // Keys have to come in time order
+    void AddKey(float time, glm::vec3 position, float yaw, float pitch);
+    void Clear() { mKeys.clear(); }
+
+    // Clamps to the ends of the path
+    Key Evaluate(float time) const;
+
+    bool Load(const String& path);
+    bool Save(const String& path) const;
+
+    float GetDuration() const { return mKeys.empty() ? 0.0f : mKeys.back().Time; }
+    const Vector<Key>& GetKeys() const { return mKeys; }
+    bool IsEmpty() const { return mKeys.empty(); }
+
+    // A loop around the middle of the bounds looking at the center, for when nothing was recorded
+    static CameraPath Orbit(const Box& bounds, float duration, UInt32 keys = 16);
+private:
+    Vector<Key> mKeys;
+};
@@ -0,0 +1,349 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:41:07
+//
+
+#include <World/LightClusters.hpp>
+#include <World/Scene.hpp>
+
+#include <Core/Jobs.hpp>
+#include <Core/Logger.hpp>
+#include <Core/Profiler.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <random>
+
+void LightClusters::Build(const Camera& camera, const Vector<PointLight>& points, const Vector<SpotLight>& spots)
+{
+    PROFILE_SCOPE("Light Clusters");
+
+    if (camera.Projection() != mProjection) {
+        BuildGrid(camera.Projection());
+    }
+    glm::mat4 view = camera.View();
+
+    // Bounds of every light in view space
+    mPointBounds.resize(points.size());
+    Jobs::ParallelFor(points.size(), [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            glm::vec3 center = glm::vec3(view * glm::vec4(points[i].Position, 1.0f));
+            mPointBounds[i] = GetBounds(center, points[i].Radius);
+        }
+    });
+
+    mSpotBounds.resize(spots.size());
+    Jobs::ParallelFor(spots.size(), [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            const SpotLight& light = spots[i];
+            glm::vec3 apex = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+            glm::vec3 direction = glm::normalize(glm::mat3(view) * light.Direction);
+            float angle = light.OuterRadius;
+
+            // Smallest sphere around the cone
+            glm::vec3 center = apex;
+            float radius = SPOT_LIGHT_RANGE;
+            if (angle < glm::radians(45.0f)) {
+                radius = SPOT_LIGHT_RANGE / (2.0f * glm::cos(angle));
+                center = apex + direction * radius;
+            } else if (angle < glm::radians(90.0f)) {
+                radius = SPOT_LIGHT_RANGE * glm::sin(angle);
+                center = apex + direction * SPOT_LIGHT_RANGE * glm::cos(angle);
+            }
+
+            Bounds bounds = GetBounds(center, radius);
+            bounds.Cone = true;
+            bounds.Apex = apex;
+            bounds.Range = SPOT_LIGHT_RANGE;
+            bounds.Direction = direction;
+            bounds.Cos = glm::cos(angle);
+            bounds.Sin = glm::sin(angle);
+            mSpotBounds[i] = bounds;
+        }
+    });
+
+    // Every job owns whole depth slices, so nothing else writes to the lists it fills
+    mPointLists.resize(CLUSTER_COUNT);
+    mSpotLists.resize(CLUSTER_COUNT);
+    Jobs::ParallelFor(CLUSTER_Z, [&](UInt32 begin, UInt32 end) {
+        PROFILE_SCOPE("Bin Lights");
+
+        auto bin = [&](UInt32 z, const Vector<Bounds>& lights, Vector<Vector<UInt32>>& lists) {
+            for (UInt32 i = 0; i < lights.size(); i++) {
+                const Bounds& bounds = lights[i];
+                if (!bounds.Visible || z < bounds.MinSlice || z > bounds.MaxSlice) {
+                    continue;
+                }
+
+                // Only the part of the sphere inside the slice, it's a lot narrower than the whole sphere at its edges
+                float minDepth = std::max(mSliceDepths[z], -bounds.Center.z - bounds.Radius);
+                float maxDepth = std::min(mSliceDepths[z + 1], -bounds.Center.z + bounds.Radius);
+                float offset = std::max({ minDepth + bounds.Center.z, -bounds.Center.z - maxDepth, 0.0f });
+                float radius = glm::sqrt(std::max(bounds.Radius * bounds.Radius - offset * offset, 0.0f));
+
+                glm::uvec2 min, max;
+                if (!GetTiles(bounds.Center, radius, minDepth, maxDepth, min, max)) {
+                    continue;
+                }
+                for (UInt32 y = min.y; y <= max.y; y++) {
+                    for (UInt32 x = min.x; x <= max.x; x++) {
+                        UInt32 cluster = x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y;
+                        if (Intersects(bounds, cluster)) {
+                            lists[cluster].push_back(i);
+                        }
+                    }
+                }
+            }
+        };
+
+        for (UInt32 z = begin; z < end; z++) {
+            for (UInt32 cluster = z * CLUSTER_X * CLUSTER_Y; cluster < (z + 1) * CLUSTER_X * CLUSTER_Y; cluster++) {
+                mPointLists[cluster].clear();
+                mSpotLists[cluster].clear();
+            }
+            bin(z, mPointBounds, mPointLists);
+            bin(z, mSpotBounds, mSpotLists);
+        }
+    }, 1);
+
+    // Prefix sum over the list sizes, then every cluster copies its lists into place
+    mClusters.resize(CLUSTER_COUNT);
+    UInt32 offset = 0;
+    for (UInt32 i = 0; i < CLUSTER_COUNT; i++) {
+        mClusters[i] = { offset, (UInt32)mPointLists[i].size(), (UInt32)mSpotLists[i].size(), 0 };
+        offset += mClusters[i].PointCount + mClusters[i].SpotCount;
+    }
+
+    mIndices.resize(offset);
+    Jobs::ParallelFor(CLUSTER_COUNT, [&](UInt32 begin, UInt32 end) {
+        for (UInt32 i = begin; i < end; i++) {
+            UInt32* destination = mIndices.data() + mClusters[i].Offset;
+            destination = std::copy(mPointLists[i].begin(), mPointLists[i].end(), destination);
+            std::copy(mSpotLists[i].begin(), mSpotLists[i].end(), destination);
+        }
+    });
+}
+
+void LightClusters::BuildGrid(const glm::mat4& projection)
+{
+    mProjection = projection;
+    mBoxes.resize(CLUSTER_COUNT);
+
+    float logRatio = glm::log(CAMERA_FAR / CAMERA_NEAR);
+    mSliceScale = CLUSTER_Z / logRatio;
+    mSliceBias = -(CLUSTER_Z * glm::log(CAMERA_NEAR)) / logRatio;
+    for (UInt32 z = 0; z <= CLUSTER_Z; z++) {
+        mSliceDepths[z] = CAMERA_NEAR * glm::pow(CAMERA_FAR / CAMERA_NEAR, (float)z / CLUSTER_Z);
+    }
+
+    // A point at NDC (x, y) and depth d sits at (x * d / P00, y * d / P11, -d) in view space
+    for (UInt32 z = 0; z < CLUSTER_Z; z++) {
+        for (UInt32 y = 0; y < CLUSTER_Y; y++) {
+            // Tiles go down the screen, NDC goes up
+            float top = 1.0f - 2.0f * y / CLUSTER_Y;
+            float bottom = 1.0f - 2.0f * (y + 1) / CLUSTER_Y;
+            for (UInt32 x = 0; x < CLUSTER_X; x++) {
+                float left = -1.0f + 2.0f * x / CLUSTER_X;
+                float right = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+
+                Box& box = mBoxes[x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y];
+                box.Min = glm::vec3(FLT_MAX);
+                box.Max = glm::vec3(-FLT_MAX);
+                for (float depth : { mSliceDepths[z], mSliceDepths[z + 1] }) {
+                    for (float ndcX : { left, right }) {
+                        for (float ndcY : { bottom, top }) {
+                            glm::vec3 corner(ndcX * depth / projection[0][0], ndcY * depth / projection[1][1], -depth);
+                            box.Min = glm::min(box.Min, corner);
+                            box.Max = glm::max(box.Max, corner);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+LightClusters::Bounds LightClusters::GetBounds(glm::vec3 center, float radius) const
+{
+    Bounds bounds = {};
+    bounds.Center = center;
+    bounds.Radius = radius;
+
+    float minDepth = -center.z - radius;
+    float maxDepth = -center.z + radius;
+    if (maxDepth < CAMERA_NEAR || minDepth > CAMERA_FAR) {
+        return bounds;
+    }
+    minDepth = std::max(minDepth, CAMERA_NEAR);
+    maxDepth = std::min(maxDepth, CAMERA_FAR);
+
+    glm::uvec2 min, max;
+    bounds.Visible = GetTiles(center, radius, minDepth, maxDepth, min, max);
+    bounds.MinSlice = Slice(minDepth);
+    bounds.MaxSlice = Slice(maxDepth);
+    return bounds;
+}
+
+bool LightClusters::GetTiles(glm::vec3 center, float radius, float minDepth, float maxDepth, glm::uvec2& min, glm::uvec2& max) const
+{
+    // x / depth only grows or shrinks along each axis, so the projected box of the sphere is spanned by its corners
+    glm::vec2 ndcMin(FLT_MAX);
+    glm::vec2 ndcMax(-FLT_MAX);
+    for (float depth : { minDepth, maxDepth }) {
+        for (float x : { center.x - radius, center.x + radius }) {
+            for (float y : { center.y - radius, center.y + radius }) {
+                glm::vec2 ndc(x * mProjection[0][0] / depth, y * mProjection[1][1] / depth);
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+        }
+    }
+    if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+        return false;
+    }
+    ndcMin = glm::clamp(ndcMin, glm::vec2(-1.0f), glm::vec2(1.0f));
+    ndcMax = glm::clamp(ndcMax, glm::vec2(-1.0f), glm::vec2(1.0f));
+
+    min.x = std::min(UInt32((ndcMin.x * 0.5f + 0.5f) * CLUSTER_X), CLUSTER_X - 1);
+    max.x = std::min(UInt32((ndcMax.x * 0.5f + 0.5f) * CLUSTER_X), CLUSTER_X - 1);
+    min.y = std::min(UInt32((0.5f - ndcMax.y * 0.5f) * CLUSTER_Y), CLUSTER_Y - 1);
+    max.y = std::min(UInt32((0.5f - ndcMin.y * 0.5f) * CLUSTER_Y), CLUSTER_Y - 1);
+    return true;
+}
+
+bool LightClusters::Intersects(const Bounds& bounds, UInt32 cluster) const
+{
+    const Box& box = mBoxes[cluster];
+
+    glm::vec3 closest = glm::clamp(bounds.Center, box.Min, box.Max);
+    glm::vec3 delta = closest - bounds.Center;
+    if (glm::dot(delta, delta) > bounds.Radius * bounds.Radius) {
+        return false;
+    }
+    if (!bounds.Cone) {
+        return true;
+    }
+
+    // Cone against the sphere around the cluster
+    glm::vec3 center = (box.Min + box.Max) * 0.5f;
+    float radius = glm::length(box.Max - box.Min) * 0.5f;
+    glm::vec3 v = center - bounds.Apex;
+    float lengthSquared = glm::dot(v, v);
+    float along = glm::dot(v, bounds.Direction);
+    float distance = bounds.Cos * glm::sqrt(std::max(lengthSquared - along * along, 0.0f)) - along * bounds.Sin;
+    return distance <= radius && along <= radius + bounds.Range && along >= -radius;
+}
+
+UInt32 LightClusters::Slice(float depth) const
+{
+    float slice = glm::log(std::max(depth, CAMERA_NEAR)) * mSliceScale + mSliceBias;
+    return (UInt32)glm::clamp(slice, 0.0f, (float)(CLUSTER_Z - 1));
+}
+
+void LightClusters::Benchmark()
+{
+    auto milliseconds = [](auto start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    Camera camera;
+    camera.SetPose(glm::vec3(0.0f, 4.0f, 0.0f), -90.0f, -10.0f, 1920, 1080);
+    glm::mat4 view = camera.View();
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto random = [&](float min, float max) {
+        return min + (max - min) * unit(generator);
+    };
+
+    bool passed = true;
+    for (UInt32 count : { 1024u, 4096u, 16384u, 65536u }) {
+        // Scattered around the camera in a volume about the size of Sponza, one spot light for every four point lights
+        Vector<PointLight> points(count);
+        for (PointLight& light : points) {
+            light = {};
+            light.Position = glm::vec3(random(-60.0f, 60.0f), random(0.0f, 20.0f), random(-60.0f, 60.0f));
+            light.Radius = random(0.5f, 4.0f);
+            light.Color = glm::vec3(1.0f);
+        }
+        Vector<SpotLight> spots(count / 4);
+        for (SpotLight& light : spots) {
+            light = {};
+            light.Position = glm::vec3(random(-60.0f, 60.0f), random(0.0f, 20.0f), random(-60.0f, 60.0f));
+            light.Direction = glm::normalize(glm::vec3(random(-1.0f, 1.0f), random(-1.0f, -0.2f), random(-1.0f, 1.0f)));
+            light.OuterRadius = random(0.2f, 0.8f);
+            light.Radius = light.OuterRadius * 0.8f;
+            light.Color = glm::vec3(1.0f);
+        }
+
+        // The first build also makes the grid
+        LightClusters clusters;
+        clusters.Build(camera, points, spots);
+
+        constexpr UInt32 RUNS = 16;
+        auto start = std::chrono::steady_clock::now();
+        for (UInt32 i = 0; i < RUNS; i++) {
+            clusters.Build(camera, points, spots);
+        }
+        float time = milliseconds(start) / RUNS;
+
+        // Any point a light reaches has to find the light in its cluster, the same way the shader looks it up
+        auto contains = [&](glm::vec3 world, UInt32 light, bool spot) {
+            glm::vec3 position = glm::vec3(view * glm::vec4(world, 1.0f));
+            float depth = -position.z;
+            glm::vec2 ndc(position.x * clusters.mProjection[0][0] / depth, position.y * clusters.mProjection[1][1] / depth);
+            if (depth < CAMERA_NEAR || depth > CAMERA_FAR || glm::abs(ndc.x) > 1.0f || glm::abs(ndc.y) > 1.0f) {
+                return true;
+            }
+            UInt32 x = std::min(UInt32((ndc.x * 0.5f + 0.5f) * CLUSTER_X), CLUSTER_X - 1);
+            UInt32 y = std::min(UInt32((0.5f - ndc.y * 0.5f) * CLUSTER_Y), CLUSTER_Y - 1);
+            const LightCluster& cluster = clusters.mClusters[x + y * CLUSTER_X + clusters.Slice(depth) * CLUSTER_X * CLUSTER_Y];
+
+            auto first = clusters.mIndices.begin() + cluster.Offset + (spot ? cluster.PointCount : 0);
+            auto last = first + (spot ? cluster.SpotCount : cluster.PointCount);
+            return std::find(first, last, light) != last;
+        };
+
+        UInt32 missed = 0;
+        for (UInt32 i = 0; i < std::min(count, 1024u); i++) {
+            for (UInt32 sample = 0; sample < 16; sample++) {
+                glm::vec3 offset = glm::vec3(random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f));
+                if (glm::length(offset) > 1.0f) {
+                    continue;
+                }
+                if (!contains(points[i].Position + offset * points[i].Radius * 0.99f, i, false)) {
+                    missed++;
+                }
+            }
+        }
+        for (UInt32 i = 0; i < std::min((UInt32)spots.size(), 1024u); i++) {
+            const SpotLight& light = spots[i];
+            for (UInt32 sample = 0; sample < 16; sample++) {
+                glm::vec3 offset = glm::vec3(random(-1.0f, 1.0f), random(-1.0f, 1.0f), random(-1.0f, 1.0f)) * SPOT_LIGHT_RANGE * 0.99f;
+                float distance = glm::length(offset);
+                if (distance > SPOT_LIGHT_RANGE * 0.99f || glm::dot(offset / distance, light.Direction) < glm::cos(light.OuterRadius * 0.99f)) {
+                    continue;
+                }
+                if (!contains(light.Position + offset, i, true)) {
+                    missed++;
+                }
+            }
+        }
+        passed = passed && missed == 0;
+
+        UInt32 used = 0;
+        for (const LightCluster& cluster : clusters.mClusters) {
+            used += (cluster.PointCount + cluster.SpotCount) > 0;
+        }
+        LOG_INFO("[Light Clusters] {0} point + {1} spot lights on {2} threads: {3} ms, {4} indices, {5} per used cluster, {6} missed",
+                 count, spots.size(), Jobs::GetThreadCount(), time, clusters.mIndices.size(),
+                 used ? (float)clusters.mIndices.size() / used : 0.0f, missed);
+    }
+
+    if (passed) {
+        LOG_INFO("[Light Clusters] Every sampled point found its lights");
+    } else {
+        LOG_ERROR("[Light Clusters] Some sampled points are missing lights from their cluster!");
+    }
+}
@@ -0,0 +1,86 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 20:34:51
+//
+
+#pragma once
+
+#include <World/Camera.hpp>
+
+struct PointLight;
+struct SpotLight;
+
+// The froxel grid, in screen tiles and exponential depth slices so clusters stay roughly cubic
+constexpr UInt32 CLUSTER_X = 16;
+constexpr UInt32 CLUSTER_Y = 9;
+constexpr UInt32 CLUSTER_Z = 24;
+constexpr UInt32 CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+// Spot lights don't have a range of their own, they stop where their shadow map does
+constexpr float SPOT_LIGHT_RANGE = 25.0f;
+
+// Where a cluster's lights start in the index list. Its point lights come first, then its spot lights.
+struct LightCluster
+{
+    UInt32 Offset;
+    UInt32 PointCount;
+    UInt32 SpotCount;
+    UInt32 Pad;
+};
+
+// Bins point and spot lights into the clusters of the camera frustum. Laid out the way the compute version would be: a pass
+// over the lights to get their bounds, a pass over the depth slices where every job owns its clusters, and a prefix sum
+// that packs the per-cluster lists into one index list.
+class LightClusters
+{
+public:
+    void Build(const Camera& camera, const Vector<PointLight>& points, const Vector<SpotLight>& spots);
+
+    const Vector<LightCluster>& GetClusters() const { return mClusters; }
+    const Vector<UInt32>& GetIndices() const { return mIndices; }
+
+    // slice = log(depth) * scale + bias
+    float GetSliceScale() const { return mSliceScale; }
+    float GetSliceBias() const { return mSliceBias; }
+
+    // Bins 1k to 64k random lights and logs the timings. Checks that random points inside the first 1024 point and spot lights
+    // find the light in their cluster, so a light is never missing where it shines. Extra lights in a cluster aren't caught.
+    static void Benchmark();
+private:
+    // View space sphere around a light and the depth slices it can touch. A cone is set for spot lights.
+    struct Bounds
+    {
+        glm::vec3 Center;
+        float Radius;
+        glm::vec3 Apex;
+        float Range;
+        glm::vec3 Direction;
+        float Cos;
+        float Sin;
+        bool Cone;
+        bool Visible;
+        UInt32 MinSlice;
+        UInt32 MaxSlice;
+    };
+
+    void BuildGrid(const glm::mat4& projection);
+    Bounds GetBounds(glm::vec3 center, float radius) const;
+    // Screen tiles covered by the part of a sphere between two depths, false when it's off screen
+    bool GetTiles(glm::vec3 center, float radius, float minDepth, float maxDepth, glm::uvec2& min, glm::uvec2& max) const;
+    bool Intersects(const Bounds& bounds, UInt32 cluster) const;
+    UInt32 Slice(float depth) const;
+
+    glm::mat4 mProjection = glm::mat4(0.0f);
+    Vector<Box> mBoxes;
+    Array<float, CLUSTER_Z + 1> mSliceDepths;
+    float mSliceScale = 0.0f;
+    float mSliceBias = 0.0f;
+
+    Vector<Bounds> mPointBounds;
+    Vector<Bounds> mSpotBounds;
+    Vector<Vector<UInt32>> mPointLists;
+    Vector<Vector<UInt32>> mSpotLists;
+
+    Vector<LightCluster> mClusters;
+    Vector<UInt32> mIndices;
+};
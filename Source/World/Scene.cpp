@@ -6,47 +6,35 @@
 #include <World/Scene.hpp>
 #include <Settings.hpp>
 
-#include <RHI/Uploader.hpp>
+#include <Core/Jobs.hpp>
+#include <Core/Timer.hpp>
+#include <Core/Profiler.hpp>
 
-void Scene::BakeBLAS(RHI::Ref rhi)
-{
-    for (auto& model : Models) {
-        model->Model.TraverseNode(model->Model.Root, [&](GLTFNode* node){
-            for (auto& primitive : node->Primitives) {
-                Uploader::EnqueueAccelerationStructureBuild(primitive.GeometryStructure);
-            }
-        });
-    }
-}
+#include <cfloat>
 
-void Scene::BakeTLAS(RHI::Ref rhi)
+static Box TransformBox(const Box& box, const glm::mat4& transform)
 {
-    for (auto& model : Models) {
-        model->Model.TraverseNode(model->Model.Root, [&](GLTFNode* node){
-            for (auto& primitive : node->Primitives) {
-                Instances.push_back(primitive.Instance);
-            }
-        });
+    Box result = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner(i & 1 ? box.Max.x : box.Min.x, i & 2 ? box.Max.y : box.Min.y, i & 4 ? box.Max.z : box.Min.z);
+        corner = glm::vec3(transform * glm::vec4(corner, 1.0f));
+        result.Min = glm::min(result.Min, corner);
+        result.Max = glm::max(result.Max, corner);
     }
-
-    InstanceBuffer = rhi->CreateBuffer(Instances.size() * sizeof(RaytracingInstance), sizeof(RaytracingInstance), BufferType::Constant, "Scene Instance Buffers");
-    InstanceBuffer->CopyMapped(Instances.data(), Instances.size() * sizeof(RaytracingInstance));
-
-    TLAS = rhi->CreateTLAS(InstanceBuffer, Instances.size(), "Scene TLAS");
-    Uploader::EnqueueAccelerationStructureBuild(TLAS);
+    return result;
 }
 
 void Scene::Init(RHI::Ref rhi)
 {
+    mRHI = rhi;
     for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
         LightBuffer[i] = rhi->CreateBuffer(256, 0, BufferType::Constant, "Light CBV");
         LightBuffer[i]->BuildCBV();
 
-        PointLightBuffer[i] = rhi->CreateBuffer(16384, sizeof(PointLight), BufferType::Constant, "Point Light UAV");
-        PointLightBuffer[i]->BuildSRV();
-
-        SpotLightBuffer[i] = rhi->CreateBuffer(16384, sizeof(SpotLight), BufferType::Constant, "Spot Light UAV");
-        SpotLightBuffer[i]->BuildSRV();
+        Reserve(PointLightBuffer[i], 0, sizeof(PointLight), "Point Light UAV");
+        Reserve(SpotLightBuffer[i], 0, sizeof(SpotLight), "Spot Light UAV");
+        Reserve(ClusterBuffer[i], CLUSTER_COUNT * sizeof(LightCluster), sizeof(LightCluster), "Light Cluster UAV");
+        Reserve(LightIndexBuffer[i], 0, sizeof(UInt32), "Light Index UAV");
     }
 
     std::function<void(GLTFNode*, glm::mat4 transform)> traverseScene = [&](GLTFNode* node, glm::mat4 transform) {
@@ -90,15 +78,163 @@ void Scene::Init(RHI::Ref rhi)
 
 void Scene::Update(const Frame& frame, UInt32 frameIndex)
 {
+    const SceneSnapshot& snapshot = Current();
+    const LightClusters& clusters = snapshot.Clusters;
+
+    Reserve(PointLightBuffer[frameIndex], snapshot.PointLights.size() * sizeof(PointLight), sizeof(PointLight), "Point Light UAV");
+    Reserve(SpotLightBuffer[frameIndex], snapshot.SpotLights.size() * sizeof(SpotLight), sizeof(SpotLight), "Spot Light UAV");
+    Reserve(LightIndexBuffer[frameIndex], clusters.GetIndices().size() * sizeof(UInt32), sizeof(UInt32), "Light Index UAV");
+
     // Update light buffer
-    mData.Sun = Sun;
+    mData.Sun = snapshot.Sun;
     mData.PointLightSRV = PointLightBuffer[frameIndex]->SRV();
-    mData.PointLightCount = PointLights.size();
+    mData.PointLightCount = snapshot.PointLights.size();
     mData.SpotLightSRV = SpotLightBuffer[frameIndex]->SRV();
-    mData.SpotLightCount = SpotLights.size();
-    mData.UseSun = Settings::Get().SceneUseSun;
+    mData.SpotLightCount = snapshot.SpotLights.size();
+    mData.UseSun = snapshot.UseSun;
+    mData.ClusterSRV = ClusterBuffer[frameIndex]->SRV();
+    mData.LightIndexSRV = LightIndexBuffer[frameIndex]->SRV();
+    mData.ClusterScale = clusters.GetSliceScale();
+    mData.ClusterBias = clusters.GetSliceBias();
+    mData.ClusterTileScale = glm::vec2((float)CLUSTER_X / frame.Width, (float)CLUSTER_Y / frame.Height);
 
-    PointLightBuffer[frameIndex]->CopyMapped(PointLights.data(), PointLights.size() * sizeof(PointLight));
-    SpotLightBuffer[frameIndex]->CopyMapped(SpotLights.data(), SpotLights.size() * sizeof(SpotLight));
+    PointLightBuffer[frameIndex]->CopyMapped((void*)snapshot.PointLights.data(), snapshot.PointLights.size() * sizeof(PointLight));
+    SpotLightBuffer[frameIndex]->CopyMapped((void*)snapshot.SpotLights.data(), snapshot.SpotLights.size() * sizeof(SpotLight));
+    ClusterBuffer[frameIndex]->CopyMapped((void*)clusters.GetClusters().data(), clusters.GetClusters().size() * sizeof(LightCluster));
+    LightIndexBuffer[frameIndex]->CopyMapped((void*)clusters.GetIndices().data(), clusters.GetIndices().size() * sizeof(UInt32));
     LightBuffer[frameIndex]->CopyMapped(&mData, sizeof(LightData));
 }
+
+void Scene::Reserve(Buffer::Ref& buffer, UInt64 size, UInt64 stride, const String& name)
+{
+    if (buffer && buffer->GetSize() >= size) {
+        return;
+    }
+
+    // Powers of two, so a light count that creeps up doesn't reallocate every frame
+    UInt64 capacity = 16384;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    buffer = mRHI->CreateBuffer(capacity, stride, BufferType::Constant, name);
+    buffer->BuildSRV();
+}
+
+void Scene::CaptureState(SceneSnapshot& snapshot)
+{
+    snapshot.Camera = Camera;
+    snapshot.Sun = Sun;
+    snapshot.PointLights = PointLights;
+    snapshot.SpotLights = SpotLights;
+    snapshot.UseSun = Settings::Get().SceneUseSun;
+}
+
+void Scene::Capture()
+{
+    SceneSnapshot& snapshot = mSnapshots[1 - mCurrent];
+    CaptureState(snapshot);
+    snapshot.FrustumCull = Settings::Get().FrustumCull;
+}
+
+void Scene::Simulate()
+{
+    PROFILE_SCOPE("Simulate");
+
+    Timer timer;
+    SceneSnapshot& snapshot = mSnapshots[1 - mCurrent];
+
+    // Flatten the hierarchy, the vectors keep their capacity from two frames ago
+    snapshot.Instances.clear();
+    std::function<void(GLTFNode*, GLTF*, glm::mat4)> flatten = [&](GLTFNode* node, GLTF* model, glm::mat4 transform) {
+        if (!node) {
+            return;
+        }
+
+        glm::mat4 globalTransform = transform * node->Transform;
+        glm::mat4 invTransform = glm::inverse(globalTransform);
+        for (const GLTFPrimitive& primitive : node->Primitives) {
+            snapshot.Instances.push_back({ node, model, &primitive, globalTransform, invTransform });
+        }
+        for (GLTFNode* child : node->Children) {
+            flatten(child, model, globalTransform);
+        }
+    };
+    for (auto& model : Models) {
+        flatten(model->Model.Root, &model->Model, glm::mat4(1.0f));
+    }
+
+    // Anything that moved since the snapshot on screen stays dynamic from then on. The one on screen is only read.
+    const SceneSnapshot& previous = mSnapshots[mCurrent];
+    bool comparable = previous.Instances.size() == snapshot.Instances.size();
+    if (mDynamic.size() != snapshot.Instances.size()) {
+        mDynamic.assign(snapshot.Instances.size(), 0);
+    }
+    snapshot.Dynamic.clear();
+    snapshot.ShadowInvalidations.clear();
+    for (UInt32 i = 0; i < snapshot.Instances.size(); i++) {
+        SceneInstance& instance = snapshot.Instances[i];
+        if (!mDynamic[i] && comparable && previous.Instances[i].Transform != instance.Transform) {
+            mDynamic[i] = 1;
+            snapshot.ShadowInvalidations.push_back(TransformBox(instance.Primitive->AABB, previous.Instances[i].Transform));
+        }
+        instance.Dynamic = mDynamic[i];
+        if (instance.Dynamic) {
+            snapshot.Dynamic.push_back(i);
+        }
+    }
+
+    Vector<UInt8> inside(snapshot.Instances.size(), 1);
+    Jobs::ParallelFor(snapshot.Instances.size(), [&](UInt32 begin, UInt32 end) {
+        PROFILE_SCOPE("Frustum Cull");
+        for (UInt32 i = begin; i < end; i++) {
+            SceneInstance& instance = snapshot.Instances[i];
+            instance.Bounds = TransformBox(instance.Primitive->AABB, instance.Transform);
+            if (snapshot.FrustumCull) {
+                inside[i] = snapshot.Camera.IsBoxInFrustum(instance.Primitive->AABB, instance.Transform);
+            }
+        }
+    });
+
+    snapshot.Visible.clear();
+    snapshot.CulledInstances = 0;
+    snapshot.CulledTriangles = 0;
+    snapshot.Bounds = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    for (UInt32 i = 0; i < snapshot.Instances.size(); i++) {
+        snapshot.Bounds.Min = glm::min(snapshot.Bounds.Min, snapshot.Instances[i].Bounds.Min);
+        snapshot.Bounds.Max = glm::max(snapshot.Bounds.Max, snapshot.Instances[i].Bounds.Max);
+        if (inside[i]) {
+            snapshot.Visible.push_back(i);
+        } else {
+            snapshot.CulledInstances++;
+            snapshot.CulledTriangles += snapshot.Instances[i].Primitive->IndexCount / 3;
+        }
+    }
+
+    // The top level is only instance boxes, rebuilding it beats tracking what moved
+    {
+        PROFILE_SCOPE("Build Scene BVH");
+        mRayInstances.resize(snapshot.Instances.size());
+        for (UInt32 i = 0; i < snapshot.Instances.size(); i++) {
+            const SceneInstance& instance = snapshot.Instances[i];
+            mRayInstances[i] = { instance.Primitive->Geometry.get(), instance.Transform, instance.InvTransform };
+        }
+        snapshot.Rays.Build(mRayInstances);
+    }
+
+    snapshot.SimulateTime = timer.GetElapsed();
+}
+
+void Scene::Swap()
+{
+    mCurrent = 1 - mCurrent;
+}
+
+void Scene::Refresh()
+{
+    PROFILE_SCOPE("Refresh Snapshot");
+
+    // Simulate() only reads the instances of this one, never the camera or lights
+    SceneSnapshot& snapshot = mSnapshots[mCurrent];
+    CaptureState(snapshot);
+    snapshot.Clusters.Build(snapshot.Camera, snapshot.PointLights, snapshot.SpotLights);
+}
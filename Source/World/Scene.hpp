@@ -7,13 +7,16 @@
 
 #include <Asset/AssetManager.hpp>
 #include <World/Camera.hpp>
+#include <World/LightClusters.hpp>
+#include <Physics/SceneBVH.hpp>
 
 struct PointLight
 {
     glm::vec3 Position;
     float Radius;
     glm::vec3 Color;
-    int ShadowCubemap;
+    // First of six in the shadow atlas, +X -X +Y -Y +Z -Z
+    int ShadowView;
     bool CastShadows;
     glm::ivec3 Pad;
 };
@@ -23,7 +26,7 @@ struct SpotLight
     glm::vec3 Position;
     float Radius;
     glm::vec3 Direction;
-    int ShadowMap;
+    int ShadowView;
     glm::vec3 Color;
     bool CastShadows;
     float OuterRadius;
@@ -50,32 +53,103 @@ struct LightData
     int SpotLightCount;
 
     int UseSun;
-    glm::ivec3 Pad;
+    int ClusterSRV;
+    int LightIndexSRV;
+    float ClusterScale;
+
+    float ClusterBias;
+    // Pixels to cluster tiles
+    glm::vec2 ClusterTileScale;
+    float Pad;
+};
+
+// A primitive placed in the world
+struct SceneInstance
+{
+    GLTFNode* Node;
+    GLTF* Model;
+    const GLTFPrimitive* Primitive;
+
+    glm::mat4 Transform;
+    glm::mat4 InvTransform;
+    // Moved at some point since the scene loaded
+    bool Dynamic = false;
+    // World space
+    Box Bounds;
+};
+
+// Everything a frame renders from. The main thread captures the mutable state, a worker fills in the rest, and the renderer
+// only ever reads the snapshot that isn't being built. The instance lists can be a frame old, the camera and lights never are.
+struct SceneSnapshot
+{
+    ::Camera Camera;
+    DirectionalLight Sun;
+    Vector<PointLight> PointLights;
+    Vector<SpotLight> SpotLights;
+    bool UseSun = false;
+    bool FrustumCull = true;
+    // Point and spot lights binned into the camera's froxels
+    LightClusters Clusters;
+
+    Vector<SceneInstance> Instances;
+    // Union of the instance bounds, empty when Min > Max
+    Box Bounds;
+    // Instances for CPU ray queries, hits index into Instances
+    SceneBVH Rays;
+    // Indices into Instances inside the camera frustum
+    Vector<UInt32> Visible;
+    UInt64 CulledInstances = 0;
+    UInt64 CulledTriangles = 0;
+
+    // Indices into Instances that are dynamic, cached shadows draw them on top every frame
+    Vector<UInt32> Dynamic;
+    // World bounds where instances used to be before they turned dynamic, cached shadows that saw them are stale
+    Vector<Box> ShadowInvalidations;
+
+    // Milliseconds spent in Simulate()
+    float SimulateTime = 0.0f;
 };
 
 class Scene
 {
 public:
-    Camera Camera;
+    ::Camera Camera;
     Box SceneOBB;
 
     Vector<SpotLight> SpotLights;
     Vector<PointLight> PointLights;
     DirectionalLight Sun;
 
-    Vector<RaytracingInstance> Instances;
-    Buffer::Ref InstanceBuffer;
-    TLAS::Ref TLAS;
-
     Vector<Asset::Handle> Models;
     Array<Buffer::Ref, FRAMES_IN_FLIGHT> LightBuffer;
     Array<Buffer::Ref, FRAMES_IN_FLIGHT> PointLightBuffer;
     Array<Buffer::Ref, FRAMES_IN_FLIGHT> SpotLightBuffer;
+    Array<Buffer::Ref, FRAMES_IN_FLIGHT> ClusterBuffer;
+    Array<Buffer::Ref, FRAMES_IN_FLIGHT> LightIndexBuffer;
 
     void Init(RHI::Ref rhi);
-    void BakeBLAS(RHI::Ref rhi);
-    void BakeTLAS(RHI::Ref rhi);
     void Update(const Frame& frame, UInt32 frameIndex);
+
+    // Copies the camera, lights and settings into the snapshot being built. Main thread only.
+    void Capture();
+    // Transforms and culls the snapshot being built. Safe on a worker while the other one renders.
+    void Simulate();
+    // The built snapshot becomes the one that renders
+    void Swap();
+    // Puts this tick's camera and lights into the snapshot that renders and bins the lights for that camera. Main thread only.
+    void Refresh();
+
+    const SceneSnapshot& Current() const { return mSnapshots[mCurrent]; }
 private:
+    void CaptureState(SceneSnapshot& snapshot);
+    // Grows a structured buffer to fit size bytes, the frame that used it last is done with it
+    void Reserve(Buffer::Ref& buffer, UInt64 size, UInt64 stride, const String& name);
+
+    RHI::Ref mRHI;
     LightData mData;
+    Vector<UInt8> mDynamic;
+    Vector<SceneBVH::Instance> mRayInstances;
+
+    Array<SceneSnapshot, 2> mSnapshots;
+    UInt32 mCurrent = 0;
 };
@@ -5,9 +5,14 @@
 
 #include <Beached.hpp>
 
-int main(void)
+int main(int argc, char** argv)
 {
-    Beached beached;
+    Benchmark::Options benchmark = Benchmark::Parse(argc, argv);
+
+    Beached beached(benchmark);
+    if (benchmark.Enabled) {
+        return beached.RunBenchmark() ? 0 : 1;
+    }
     beached.Run();
     return 0;
 }
@@ -0,0 +1,22 @@
+//
+// > Notice: Amélie Heinrich @ 2025
+// > Create Time: 2025-03-23 21:39:14
+//
+
+#include <Core/Logger.hpp>
+#include <Core/Profiler.hpp>
+#include <Core/Jobs.hpp>
+
+#include <SelfTests.hpp>
+
+int main()
+{
+    Logger::Init();
+    Profiler::Init();
+    Jobs::Init();
+
+    bool passed = SelfTests::Run();
+
+    Jobs::Shutdown();
+    return passed ? 0 : 1;
+}
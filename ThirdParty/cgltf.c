@@ -4,4 +4,4 @@
 //
 
 #define CGLTF_IMPLEMENTATION
-#include "cgltf/cgltf.h"
+#include "CGLTF/cgltf.h"
@@ -12,8 +12,12 @@ target("spdlog")
 
 target("ImGui")
     set_kind("static")
-    add_files("imgui/*.cpp", "imgui/backends/imgui_impl_win32.cpp", "imgui/backends/imgui_impl_dx12.cpp")
-    add_includedirs("imgui/")
+    add_files("ImGui/*.cpp")
+    -- The RHI only drives the Win32 and D3D12 backends, the null one has ImGui build draw data and nothing more
+    if is_plat("windows") then
+        add_files("ImGui/backends/imgui_impl_win32.cpp", "ImGui/backends/imgui_impl_dx12.cpp")
+    end
+    add_includedirs("ImGui/")
 
 target("STB")
     set_kind("static")
@@ -7,11 +7,17 @@ includes("ThirdParty")
 
 add_rules("mode.debug", "mode.release", "mode.releasedbg")
 
-target("Beached")
+-- No D3D12 runtime off Windows: the RHI compiles against DirectX-Headers and only the null backend runs. DXC has Linux
+-- builds, so shaders still compile.
+if is_plat("linux") then
+    add_requires("directx-headers", "directxshadercompiler")
+end
+
+-- Everything Beached and BeachedTests share, which is all of Source except the entry point
+function add_beached_sources()
     set_rundir(".")
     set_languages("c++20")
     set_encodings("utf-8")
-    -- set_policy("build.sanitizer.address", true)
 
     if is_plat("windows") then
         add_syslinks("user32",
@@ -22,6 +28,11 @@ target("Beached")
                      "ThirdParty/DXC/lib/dxcompiler.lib",
                      "ThirdParty/nvtt/lib64/nvtt30205.lib",
                      "ThirdParty/PIX/lib/WinPixEventRuntime.lib")
+        add_defines("USE_PIX")
+    end
+    if is_plat("linux") then
+        add_packages("directx-headers", "directxshadercompiler")
+        add_syslinks("pthread", "dl")
     end
 
     if is_mode("debug") then
@@ -40,6 +51,25 @@ target("Beached")
         set_strip("all")
     end
 
+    add_files("Source/**.cpp|main.cpp")
+    add_includedirs("Source",
+                    "ThirdParty/",
+                    "ThirdParty/spdlog/include",
+                    "ThirdParty/DirectX/include",
+                    "ThirdParty/ImGui",
+                    "ThirdParty/ImGui/backends",
+                    "ThirdParty/DXC/Include",
+                    "ThirdParty/glm",
+                    "ThirdParty/nvtt/",
+                    "ThirdParty/PIX/include")
+    add_deps("spdlog", "ImGui", "STB", "CGLTF")
+    add_defines("GLM_ENABLE_EXPERIMENTAL", "GLM_FORCE_DEPTH_ZERO_TO_ONE")
+end
+
+target("Beached")
+    add_beached_sources()
+    -- set_policy("build.sanitizer.address", true)
+
     -- Copy DLLs in build folder
     before_link(function (target)
         if not os.exists("$(buildir)/$(plat)/$(arch)/$(mode)/Assets/") then
@@ -53,16 +83,10 @@ target("Beached")
         os.cp(".cache/*", "$(buildir)/$(plat)/$(arch)/$(mode)/.cache/")
     end)
 
-    add_files("Source/**.cpp")
-    add_includedirs("Source",
-                    "ThirdParty/",
-                    "ThirdParty/spdlog/include",
-                    "ThirdParty/DirectX/include",
-                    "ThirdParty/imgui",
-                    "ThirdParty/imgui/backends",
-                    "ThirdParty/DXC/Include",
-                    "ThirdParty/glm",
-                    "ThirdParty/nvtt/",
-                    "ThirdParty/PIX/include")
-    add_deps("spdlog", "ImGui", "STB", "CGLTF")
-    add_defines("GLM_ENABLE_EXPERIMENTAL", "USE_PIX", "GLM_FORCE_DEPTH_ZERO_TO_ONE")
+    add_files("Source/main.cpp")
+
+-- Runs every self test without a window or a GPU, on Windows and Linux. Exits with 1 when one fails.
+target("BeachedTests")
+    set_kind("binary")
+    add_beached_sources()
+    add_files("Tests/main.cpp")